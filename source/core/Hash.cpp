@@ -0,0 +1,113 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "Hash.h"
+
+#include <cstring>
+
+using namespace flow;
+
+
+namespace
+{
+	const uint64_t _PRIME1 = 11400714785074694791ULL;
+	const uint64_t _PRIME2 = 14029467366897019727ULL;
+	const uint64_t _PRIME3 = 1609587929392839161ULL;
+	const uint64_t _PRIME4 = 9650029242287828579ULL;
+	const uint64_t _PRIME5 = 2870177450012600261ULL;
+
+	inline uint64_t _rotl(uint64_t x, int r)
+	{
+		return (x << r) | (x >> (64 - r));
+	}
+
+	// unaligned little endian reads
+	inline uint64_t _read64(const uint8_t* p)
+	{
+		uint64_t v;
+		std::memcpy(&v, p, 8);
+		return v;
+	}
+
+	inline uint32_t _read32(const uint8_t* p)
+	{
+		uint32_t v;
+		std::memcpy(&v, p, 4);
+		return v;
+	}
+
+	inline uint64_t _round(uint64_t acc, uint64_t input)
+	{
+		acc += input * _PRIME2;
+		acc = _rotl(acc, 31);
+		return acc * _PRIME1;
+	}
+
+	inline uint64_t _mergeRound(uint64_t acc, uint64_t value)
+	{
+		acc ^= _round(0, value);
+		return acc * _PRIME1 + _PRIME4;
+	}
+}
+
+uint64_t Hash::xxh64(const void* pData, size_t byteLength, uint64_t seed /* = 0 */)
+{
+	const uint8_t* p = static_cast<const uint8_t*>(pData);
+	const uint8_t* pEnd = p + byteLength;
+	uint64_t h;
+
+	if (byteLength >= 32) {
+		uint64_t v1 = seed + _PRIME1 + _PRIME2;
+		uint64_t v2 = seed + _PRIME2;
+		uint64_t v3 = seed;
+		uint64_t v4 = seed - _PRIME1;
+
+		const uint8_t* pLimit = pEnd - 32;
+		do {
+			v1 = _round(v1, _read64(p));
+			v2 = _round(v2, _read64(p + 8));
+			v3 = _round(v3, _read64(p + 16));
+			v4 = _round(v4, _read64(p + 24));
+			p += 32;
+		} while (p <= pLimit);
+
+		h = _rotl(v1, 1) + _rotl(v2, 7) + _rotl(v3, 12) + _rotl(v4, 18);
+		h = _mergeRound(h, v1);
+		h = _mergeRound(h, v2);
+		h = _mergeRound(h, v3);
+		h = _mergeRound(h, v4);
+	}
+	else {
+		h = seed + _PRIME5;
+	}
+
+	h += uint64_t(byteLength);
+
+	// remaining bytes
+	for (; p + 8 <= pEnd; p += 8) {
+		h ^= _round(0, _read64(p));
+		h = _rotl(h, 27) * _PRIME1 + _PRIME4;
+	}
+	if (p + 4 <= pEnd) {
+		h ^= uint64_t(_read32(p)) * _PRIME1;
+		h = _rotl(h, 23) * _PRIME2 + _PRIME3;
+		p += 4;
+	}
+	for (; p < pEnd; ++p) {
+		h ^= (*p) * _PRIME5;
+		h = _rotl(h, 11) * _PRIME1;
+	}
+
+	// avalanche
+	h ^= h >> 33;
+	h *= _PRIME2;
+	h ^= h >> 29;
+	h *= _PRIME3;
+	h ^= h >> 32;
+
+	return h;
+}
@@ -0,0 +1,32 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_CORE_HASH_H
+#define _FLOWLIBS_CORE_HASH_H
+
+#include "library.h"
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace flow
+{
+	/// Fast non-cryptographic hash functions.
+	class F_CORE_EXPORT Hash
+	{
+	public:
+		/// Deleted constructor. Class provides only static methods.
+		Hash() = delete;
+
+		/// Returns the 64 bit xxHash (XXH64) of the given data. Processes 32 bytes per
+		/// iteration in four independent lanes.
+		static uint64_t xxh64(const void* pData, size_t byteLength, uint64_t seed = 0);
+	};
+}
+
+#endif // _FLOWLIBS_CORE_HASH_H
@@ -0,0 +1,344 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "JsonWriter.h"
+
+#include <cstdio>
+#include <clocale>
+#include <cstring>
+#include <cmath>
+#include <limits>
+
+using namespace flow;
+using std::string;
+
+
+JsonWriter::JsonWriter(std::ostream& stream, int indent /* = -1 */) :
+	_pStream(&stream),
+	_pTarget(nullptr),
+	_indent(indent),
+	_hasKey(false),
+	_byteCount(0)
+{
+	_buffer.reserve(_BUFFER_SIZE);
+}
+
+JsonWriter::JsonWriter(string& target, int indent /* = -1 */) :
+	_pStream(nullptr),
+	_pTarget(&target),
+	_indent(indent),
+	_hasKey(false),
+	_byteCount(0)
+{
+}
+
+JsonWriter::~JsonWriter()
+{
+	flush();
+}
+
+JsonWriter& JsonWriter::beginObject()
+{
+	_beginValue();
+	_write('{');
+	_scopes.push_back({ true, 0 });
+	return *this;
+}
+
+JsonWriter& JsonWriter::endObject()
+{
+	F_ASSERT(!_scopes.empty() && _scopes.back().isObject && !_hasKey);
+
+	if (_scopes.back().count > 0) {
+		_newline(_scopes.size() - 1);
+	}
+
+	_scopes.pop_back();
+	_write('}');
+	return *this;
+}
+
+JsonWriter& JsonWriter::beginArray()
+{
+	_beginValue();
+	_write('[');
+	_scopes.push_back({ false, 0 });
+	return *this;
+}
+
+JsonWriter& JsonWriter::endArray()
+{
+	F_ASSERT(!_scopes.empty() && !_scopes.back().isObject);
+
+	if (_scopes.back().count > 0) {
+		_newline(_scopes.size() - 1);
+	}
+
+	_scopes.pop_back();
+	_write(']');
+	return *this;
+}
+
+JsonWriter& JsonWriter::key(const char* pKey)
+{
+	F_ASSERT(!_scopes.empty() && _scopes.back().isObject && !_hasKey);
+
+	scope_t& scope = _scopes.back();
+	if (scope.count++ > 0) {
+		_write(',');
+	}
+
+	_newline(_scopes.size());
+	_writeString(pKey, std::strlen(pKey));
+
+	if (_indent >= 0) {
+		_write(": ", 2);
+	}
+	else {
+		_write(':');
+	}
+
+	_hasKey = true;
+	return *this;
+}
+
+JsonWriter& JsonWriter::key(const string& key)
+{
+	return this->key(key.c_str());
+}
+
+JsonWriter& JsonWriter::null()
+{
+	_beginValue();
+	_write("null", 4);
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(bool value)
+{
+	_beginValue();
+	if (value) {
+		_write("true", 4);
+	}
+	else {
+		_write("false", 5);
+	}
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(int32_t value)
+{
+	return this->value(int64_t(value));
+}
+
+JsonWriter& JsonWriter::value(uint32_t value)
+{
+	return this->value(uint64_t(value));
+}
+
+JsonWriter& JsonWriter::value(int64_t value)
+{
+	_beginValue();
+	char text[24];
+	int length = snprintf(text, sizeof(text), "%lld", (long long)value);
+	_write(text, size_t(length));
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(uint64_t value)
+{
+	_beginValue();
+	char text[24];
+	int length = snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+	_write(text, size_t(length));
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(float value)
+{
+	// 9 significant digits are enough to read back the exact float
+	_writeNumber(value, std::numeric_limits<float>::max_digits10);
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(double value)
+{
+	// 17 significant digits are enough to read back the exact double
+	_writeNumber(value, std::numeric_limits<double>::max_digits10);
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* pValue)
+{
+	_beginValue();
+	_writeString(pValue, std::strlen(pValue));
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(const string& value)
+{
+	_beginValue();
+	_writeString(value.data(), value.size());
+	return *this;
+}
+
+JsonWriter& JsonWriter::value(const json& value)
+{
+	switch (value.type()) {
+	case json::value_t::null:
+		return null();
+	case json::value_t::boolean:
+		return this->value(value.get<bool>());
+	case json::value_t::number_integer:
+		return this->value(value.get<int64_t>());
+	case json::value_t::number_unsigned:
+		return this->value(value.get<uint64_t>());
+	case json::value_t::number_float:
+		return this->value(value.get<double>());
+	case json::value_t::string:
+		return this->value(value.get_ref<const string&>());
+	case json::value_t::array:
+		beginArray();
+		for (auto it = value.begin(); it != value.end(); ++it) {
+			this->value(*it);
+		}
+		return endArray();
+	case json::value_t::object:
+		beginObject();
+		for (auto it = value.begin(); it != value.end(); ++it) {
+			key(it.key());
+			this->value(it.value());
+		}
+		return endObject();
+	default:
+		return null();
+	}
+}
+
+void JsonWriter::flush()
+{
+	if (_pStream && !_buffer.empty()) {
+		_pStream->write(_buffer.data(), _buffer.size());
+		_buffer.clear();
+	}
+}
+
+void JsonWriter::_beginValue()
+{
+	if (_hasKey) {
+		_hasKey = false;
+		return;
+	}
+
+	if (!_scopes.empty()) {
+		F_ASSERT(!_scopes.back().isObject);
+
+		if (_scopes.back().count++ > 0) {
+			_write(',');
+		}
+		_newline(_scopes.size());
+	}
+}
+
+void JsonWriter::_writeNumber(double value, int digits)
+{
+	_beginValue();
+
+	if (!std::isfinite(value)) {
+		_write("null", 4);
+		return;
+	}
+
+	char text[32];
+	int length = snprintf(text, sizeof(text), "%.*g", digits, value);
+
+	// snprintf uses the decimal point of the current locale, JSON requires '.'
+	const char decimalPoint = *std::localeconv()->decimal_point;
+	if (decimalPoint != '.' && decimalPoint != '\0') {
+		char* pPoint = std::strchr(text, decimalPoint);
+		if (pPoint) {
+			*pPoint = '.';
+		}
+	}
+
+	_write(text, size_t(length));
+
+	// ".0" suffix for values written as plain digits, as json::dump() does
+	size_t signLength = text[0] == '-' ? 1 : 0;
+	if (std::strspn(text + signLength, "0123456789") == size_t(length) - signLength) {
+		_write(".0", 2);
+	}
+}
+
+void JsonWriter::_newline(size_t depth)
+{
+	if (_indent < 0) {
+		return;
+	}
+
+	_write('\n');
+	for (size_t i = 0, n = depth * _indent; i < n; ++i) {
+		_write(' ');
+	}
+}
+
+void JsonWriter::_writeString(const char* pText, size_t length)
+{
+	static const char hexDigits[] = "0123456789abcdef";
+
+	_write('"');
+
+	// copy runs of characters which don't need escaping in one go
+	size_t start = 0;
+	for (size_t i = 0; i < length; ++i) {
+		unsigned char c = (unsigned char)pText[i];
+		if (c >= 0x20 && c != '"' && c != '\\') {
+			continue;
+		}
+
+		_write(pText + start, i - start);
+		start = i + 1;
+
+		switch (c) {
+		case '"': _write("\\\"", 2); break;
+		case '\\': _write("\\\\", 2); break;
+		case '\b': _write("\\b", 2); break;
+		case '\f': _write("\\f", 2); break;
+		case '\n': _write("\\n", 2); break;
+		case '\r': _write("\\r", 2); break;
+		case '\t': _write("\\t", 2); break;
+		default: {
+			char escaped[6] = { '\\', 'u', '0', '0', hexDigits[c >> 4], hexDigits[c & 0xf] };
+			_write(escaped, 6);
+		}
+		}
+	}
+
+	_write(pText + start, length - start);
+	_write('"');
+}
+
+void JsonWriter::_write(const char* pData, size_t length)
+{
+	_byteCount += length;
+
+	if (!_pStream) {
+		_pTarget->append(pData, length);
+		return;
+	}
+
+	if (_buffer.size() + length > _BUFFER_SIZE) {
+		flush();
+
+		if (length > _BUFFER_SIZE) {
+			_pStream->write(pData, length);
+			return;
+		}
+	}
+
+	_buffer.append(pData, length);
+}
@@ -0,0 +1,112 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_CORE_JSONWRITER_H
+#define _FLOWLIBS_CORE_JSONWRITER_H
+
+#include "library.h"
+#include "json.h"
+
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdint>
+
+
+namespace flow
+{
+	/// Streaming JSON writer. Tokens are written straight to the output without building
+	/// a DOM. Output to a stream is buffered in a fixed-size block, memory use is bounded
+	/// by the buffer size and the nesting depth. Numbers and strings are formatted
+	/// like json::dump().
+	class F_CORE_EXPORT JsonWriter
+	{
+		F_DISABLE_COPY(JsonWriter);
+
+	public:
+		/// Creates a writer emitting to the given stream. Indent < 0 writes compact JSON.
+		JsonWriter(std::ostream& stream, int indent = -1);
+		/// Creates a writer appending to the given string.
+		JsonWriter(std::string& target, int indent = -1);
+		/// Flushes buffered output.
+		virtual ~JsonWriter();
+
+		JsonWriter& beginObject();
+		JsonWriter& endObject();
+		JsonWriter& beginArray();
+		JsonWriter& endArray();
+
+		/// Writes an object key. Must be followed by a value or a container.
+		JsonWriter& key(const char* pKey);
+		JsonWriter& key(const std::string& key);
+
+		JsonWriter& null();
+		JsonWriter& value(bool value);
+		JsonWriter& value(int32_t value);
+		JsonWriter& value(uint32_t value);
+		JsonWriter& value(int64_t value);
+		JsonWriter& value(uint64_t value);
+		JsonWriter& value(float value);
+		JsonWriter& value(double value);
+		JsonWriter& value(const char* pValue);
+		JsonWriter& value(const std::string& value);
+		/// Writes a JSON DOM value, e.g. extras or extension payloads.
+		JsonWriter& value(const json& value);
+
+		/// Writes an array of the given values.
+		template<typename T>
+		JsonWriter& array(const T* pValues, size_t count);
+		template<typename T>
+		JsonWriter& array(const std::vector<T>& values) { return array(values.data(), values.size()); }
+
+		/// Writes a key-value pair.
+		template<typename T>
+		JsonWriter& member(const char* pKey, const T& value) { key(pKey); return this->value(value); }
+
+		/// Writes buffered output to the stream.
+		void flush();
+
+		/// Returns the total number of bytes written, including buffered bytes.
+		size_t byteCount() const { return _byteCount; }
+
+	private:
+		struct scope_t
+		{
+			bool isObject;
+			size_t count;
+		};
+
+		void _beginValue();
+		void _newline(size_t depth);
+		void _writeString(const char* pText, size_t length);
+		void _writeNumber(double value, int digits);
+		void _write(const char* pData, size_t length);
+		void _write(char c) { _write(&c, 1); }
+
+		static const size_t _BUFFER_SIZE = 64 * 1024;
+
+		std::ostream* _pStream;
+		std::string* _pTarget;
+		std::string _buffer;
+		std::vector<scope_t> _scopes;
+		int _indent;
+		bool _hasKey;
+		size_t _byteCount;
+	};
+
+	template<typename T>
+	JsonWriter& JsonWriter::array(const T* pValues, size_t count)
+	{
+		beginArray();
+		for (size_t i = 0; i < count; ++i) {
+			value(pValues[i]);
+		}
+		return endArray();
+	}
+}
+
+#endif // _FLOWLIBS_CORE_JSONWRITER_H
@@ -0,0 +1,145 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "MappedFile.h"
+
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+#  include <Windows.h>
+#else
+#  include <sys/mman.h>
+#  include <sys/stat.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#endif
+
+
+using namespace flow;
+using std::string;
+
+
+std::shared_ptr<MappedFile> MappedFile::open(const string& filePath)
+{
+	std::shared_ptr<MappedFile> pFile(new MappedFile(filePath));
+	if (!pFile->_map()) {
+		return nullptr;
+	}
+
+	return pFile;
+}
+
+MappedFile::MappedFile(const string& filePath) :
+	_filePath(filePath),
+	_pData(nullptr),
+	_byteLength(0)
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+	, _hFile(INVALID_HANDLE_VALUE),
+	_hMapping(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile()
+{
+	_unmap();
+}
+
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+
+bool MappedFile::_map()
+{
+	_hFile = CreateFileA(_filePath.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+	if (_hFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(_hFile, &fileSize) || fileSize.QuadPart == 0) {
+		_unmap();
+		return false;
+	}
+
+	_byteLength = size_t(fileSize.QuadPart);
+
+	// PAGE_WRITECOPY / FILE_MAP_COPY: pages are private to the process once written
+	_hMapping = CreateFileMappingA(_hFile, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+	if (!_hMapping) {
+		_unmap();
+		return false;
+	}
+
+	_pData = static_cast<char*>(MapViewOfFile(_hMapping, FILE_MAP_COPY, 0, 0, 0));
+	if (!_pData) {
+		_unmap();
+		return false;
+	}
+
+	return true;
+}
+
+void MappedFile::_unmap()
+{
+	if (_pData) {
+		UnmapViewOfFile(_pData);
+		_pData = nullptr;
+	}
+	if (_hMapping) {
+		CloseHandle(_hMapping);
+		_hMapping = nullptr;
+	}
+	if (_hFile != INVALID_HANDLE_VALUE) {
+		CloseHandle(_hFile);
+		_hFile = INVALID_HANDLE_VALUE;
+	}
+
+	_byteLength = 0;
+}
+
+#else
+
+bool MappedFile::_map()
+{
+	int fd = ::open(_filePath.c_str(), O_RDONLY);
+	if (fd < 0) {
+		return false;
+	}
+
+	struct stat fileStat;
+	if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0) {
+		::close(fd);
+		return false;
+	}
+
+	_byteLength = size_t(fileStat.st_size);
+
+	// MAP_PRIVATE: pages are copied on write, the file itself is never modified
+	void* pData = mmap(nullptr, _byteLength, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+
+	// the mapping stays valid after the descriptor is closed
+	::close(fd);
+
+	if (pData == MAP_FAILED) {
+		_byteLength = 0;
+		return false;
+	}
+
+	_pData = static_cast<char*>(pData);
+	return true;
+}
+
+void MappedFile::_unmap()
+{
+	if (_pData) {
+		munmap(_pData, _byteLength);
+		_pData = nullptr;
+	}
+
+	_byteLength = 0;
+}
+
+#endif
@@ -0,0 +1,57 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_CORE_MAPPEDFILE_H
+#define _FLOWLIBS_CORE_MAPPEDFILE_H
+
+#include "library.h"
+
+#include <string>
+#include <memory>
+
+
+namespace flow
+{
+	/// Read-only memory mapping of an entire file. Pages are mapped copy-on-write,
+	/// writing to the mapped memory never modifies the file on disk. Pages are
+	/// loaded on first access, so mapping a file is cheap regardless of its size.
+	class F_CORE_EXPORT MappedFile
+	{
+		F_DISABLE_COPY(MappedFile);
+
+	public:
+		/// Maps the file at the given path. Returns nullptr if the file can't be opened or mapped.
+		static std::shared_ptr<MappedFile> open(const std::string& filePath);
+
+		virtual ~MappedFile();
+
+		/// Returns a pointer to the first byte of the mapped file.
+		char* data() const { return _pData; }
+		/// Returns the size of the mapped file in bytes.
+		size_t byteLength() const { return _byteLength; }
+		/// Returns the path of the mapped file.
+		const std::string& filePath() const { return _filePath; }
+
+	protected:
+		MappedFile(const std::string& filePath);
+
+	private:
+		bool _map();
+		void _unmap();
+
+		std::string _filePath;
+		char* _pData;
+		size_t _byteLength;
+
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+		void* _hFile;
+		void* _hMapping;
+#endif
+	};
+}
+
+#endif // _FLOWLIBS_CORE_MAPPEDFILE_H
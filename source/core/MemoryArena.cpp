@@ -0,0 +1,84 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "MemoryArena.h"
+
+#include <cstdlib>
+#include <cstdint>
+#include <new>
+
+using namespace flow;
+
+
+MemoryArena::MemoryArena(size_t initialBlockSize /* = 4096 */, size_t maxBlockSize /* = 1024 * 1024 */) :
+	_pCursor(nullptr),
+	_pEnd(nullptr),
+	_nextBlockSize(initialBlockSize),
+	_maxBlockSize(maxBlockSize),
+	_size(0),
+	_capacity(0)
+{
+}
+
+MemoryArena::~MemoryArena()
+{
+	clear();
+}
+
+void* MemoryArena::allocate(size_t byteSize, size_t alignment /* = alignof(std::max_align_t) */)
+{
+	size_t padding = size_t(-reinterpret_cast<uintptr_t>(_pCursor)) & (alignment - 1);
+
+	if (!_pCursor || padding + byteSize > size_t(_pEnd - _pCursor)) {
+		// blocks come from malloc, aligned for any fundamental type
+		_addBlock(byteSize + (alignment > alignof(std::max_align_t) ? alignment : 0));
+		padding = size_t(-reinterpret_cast<uintptr_t>(_pCursor)) & (alignment - 1);
+	}
+
+	char* pData = _pCursor + padding;
+	_pCursor = pData + byteSize;
+	_size += padding + byteSize;
+
+	return pData;
+}
+
+void MemoryArena::reserve(size_t byteSize)
+{
+	if (byteSize > 0 && (!_pCursor || byteSize > size_t(_pEnd - _pCursor))) {
+		_addBlock(byteSize);
+	}
+}
+
+void MemoryArena::clear()
+{
+	for (auto it = _blocks.begin(); it != _blocks.end(); ++it) {
+		std::free(*it);
+	}
+
+	_blocks.clear();
+	_pCursor = nullptr;
+	_pEnd = nullptr;
+	_size = 0;
+	_capacity = 0;
+}
+
+void MemoryArena::_addBlock(size_t minByteSize)
+{
+	// the remainder of the current block is abandoned
+	size_t blockSize = _nextBlockSize > minByteSize ? _nextBlockSize : minByteSize;
+	_nextBlockSize = _nextBlockSize * 2 < _maxBlockSize ? _nextBlockSize * 2 : _maxBlockSize;
+
+	char* pBlock = static_cast<char*>(std::malloc(blockSize));
+	if (!pBlock) {
+		throw std::bad_alloc();
+	}
+
+	_blocks.push_back(pBlock);
+	_pCursor = pBlock;
+	_pEnd = pBlock + blockSize;
+	_capacity += blockSize;
+}
@@ -0,0 +1,58 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_CORE_MEMORYARENA_H
+#define _FLOWLIBS_CORE_MEMORYARENA_H
+
+#include "library.h"
+
+#include <vector>
+#include <cstddef>
+
+
+namespace flow
+{
+	/// Bump allocator handing out memory from a list of contiguous blocks. Allocations
+	/// can't be freed individually, all blocks are released at once by clear() or when
+	/// the arena is destroyed. Objects placed in arena memory must be destructed explicitly.
+	/// Block sizes start small and double with each new block up to maxBlockSize,
+	/// so arenas holding few objects stay cheap.
+	class F_CORE_EXPORT MemoryArena
+	{
+		F_DISABLE_COPY(MemoryArena);
+
+	public:
+		explicit MemoryArena(size_t initialBlockSize = 4096, size_t maxBlockSize = 1024 * 1024);
+		virtual ~MemoryArena();
+
+		/// Returns uninitialized memory of the given size. Alignment must be a power of two.
+		void* allocate(size_t byteSize, size_t alignment = alignof(std::max_align_t));
+		/// Makes sure the next allocations totalling byteSize bytes fit into a single block
+		/// and don't allocate further memory, apart from padding due to alignment.
+		void reserve(size_t byteSize);
+		/// Releases all blocks. Memory handed out before becomes invalid.
+		void clear();
+
+		/// Returns the number of bytes handed out, including alignment padding.
+		size_t size() const { return _size; }
+		/// Returns the total size of all blocks.
+		size_t capacity() const { return _capacity; }
+
+	private:
+		void _addBlock(size_t minByteSize);
+
+		std::vector<char*> _blocks;
+		char* _pCursor;
+		char* _pEnd;
+		size_t _nextBlockSize;
+		size_t _maxBlockSize;
+		size_t _size;
+		size_t _capacity;
+	};
+}
+
+#endif // _FLOWLIBS_CORE_MEMORYARENA_H
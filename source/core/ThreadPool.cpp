@@ -0,0 +1,219 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "ThreadPool.h"
+
+using namespace flow;
+
+
+namespace
+{
+	// pool and deque index of the worker running on the current thread
+	thread_local ThreadPool* t_pPool = nullptr;
+	thread_local size_t t_workerIndex = 0;
+}
+
+ThreadPool* ThreadPool::instance()
+{
+	static ThreadPool pool;
+	return &pool;
+}
+
+ThreadPool::ThreadPool(size_t threadCount /* = 0 */) :
+	_queuedCount(0),
+	_nextWorker(0),
+	_isStopping(false)
+{
+	if (threadCount == 0) {
+		threadCount = flow::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+	}
+
+	// create all deques before the first worker may try to steal from them
+	for (size_t i = 0; i < threadCount; ++i) {
+		_workers.emplace_back(new worker_t);
+	}
+
+	for (size_t i = 0; i < threadCount; ++i) {
+		_workers[i]->thread = std::thread(&ThreadPool::_workerLoop, this, i);
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		_isStopping = true;
+	}
+
+	_sleepCondition.notify_all();
+
+	for (auto& pWorker : _workers) {
+		pWorker->thread.join();
+	}
+}
+
+void ThreadPool::_submit(task_t&& task)
+{
+	// workers push to their own deque, other threads distribute round-robin
+	size_t index = t_pPool == this ? t_workerIndex : _nextWorker++ % _workers.size();
+	worker_t* pWorker = _workers[index].get();
+
+	// count first, so the count never drops below zero when the task is taken right away
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+		++_queuedCount;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pWorker->mutex);
+		pWorker->tasks.push_back(std::move(task));
+	}
+
+	_sleepCondition.notify_one();
+}
+
+bool ThreadPool::_runPendingTask()
+{
+	task_t task;
+	bool isWorker = t_pPool == this;
+
+	if ((isWorker && _popTask(t_workerIndex, task))
+			|| _stealTask(isWorker ? t_workerIndex : _nextWorker % _workers.size(), task)) {
+		task();
+		return true;
+	}
+
+	return false;
+}
+
+bool ThreadPool::_popTask(size_t index, task_t& task)
+{
+	worker_t* pWorker = _workers[index].get();
+	std::lock_guard<std::mutex> lock(pWorker->mutex);
+
+	if (pWorker->tasks.empty()) {
+		return false;
+	}
+
+	task = std::move(pWorker->tasks.back());
+	pWorker->tasks.pop_back();
+	--_queuedCount;
+	return true;
+}
+
+bool ThreadPool::_stealTask(size_t thiefIndex, task_t& task)
+{
+	// take the oldest task, starting with the thief's neighbour
+	size_t count = _workers.size();
+	for (size_t i = 1; i <= count; ++i) {
+		worker_t* pWorker = _workers[(thiefIndex + i) % count].get();
+		std::lock_guard<std::mutex> lock(pWorker->mutex);
+
+		if (!pWorker->tasks.empty()) {
+			task = std::move(pWorker->tasks.front());
+			pWorker->tasks.pop_front();
+			--_queuedCount;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void ThreadPool::_workerLoop(size_t index)
+{
+	t_pPool = this;
+	t_workerIndex = index;
+
+	for (;;) {
+		if (_runPendingTask()) {
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(_sleepMutex);
+		_sleepCondition.wait(lock, [this]() { return _isStopping || _queuedCount > 0; });
+
+		if (_isStopping && _queuedCount == 0) {
+			return;
+		}
+	}
+}
+
+void ThreadPool::_notifyAll()
+{
+	// locking ensures a thread can't miss the notification between testing its predicate and sleeping
+	{
+		std::lock_guard<std::mutex> lock(_sleepMutex);
+	}
+
+	_sleepCondition.notify_all();
+}
+
+TaskGroup::TaskGroup(ThreadPool* pPool /* = ThreadPool::instance() */) :
+	_pPool(pPool),
+	_pendingCount(0)
+{
+}
+
+TaskGroup::~TaskGroup()
+{
+	_wait();
+}
+
+void TaskGroup::run(ThreadPool::task_t task)
+{
+	++_pendingCount;
+
+	ThreadPool* pPool = _pPool;
+	pPool->_submit([this, pPool, task]() {
+		try {
+			task();
+		}
+		catch (...) {
+			std::lock_guard<std::mutex> lock(_exceptionMutex);
+			if (!_pException) {
+				_pException = std::current_exception();
+			}
+		}
+
+		// the group may be destroyed as soon as the count drops to zero
+		if (--_pendingCount == 0) {
+			pPool->_notifyAll();
+		}
+	});
+}
+
+void TaskGroup::wait()
+{
+	_wait();
+
+	std::exception_ptr pException;
+	{
+		std::lock_guard<std::mutex> lock(_exceptionMutex);
+		std::swap(pException, _pException);
+	}
+
+	if (pException) {
+		std::rethrow_exception(pException);
+	}
+}
+
+void TaskGroup::_wait()
+{
+	while (_pendingCount > 0) {
+		if (_pPool->_runPendingTask()) {
+			continue;
+		}
+
+		// all remaining tasks are running on other threads, sleep until one finishes
+		// or new tasks are queued
+		std::unique_lock<std::mutex> lock(_pPool->_sleepMutex);
+		_pPool->_sleepCondition.wait(lock, [this]() {
+			return _pendingCount == 0 || _pPool->_queuedCount > 0;
+		});
+	}
+}
@@ -0,0 +1,146 @@
+/**
+* Flow Libs - Core
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_CORE_THREADPOOL_H
+#define _FLOWLIBS_CORE_THREADPOOL_H
+
+#include "library.h"
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+
+namespace flow
+{
+	class TaskGroup;
+
+	/// Work-stealing thread pool. Each worker owns a task deque: it pushes and pops its
+	/// own tasks at the back, idle workers steal from the front of other workers' deques.
+	/// Tasks submitted from outside the pool are distributed round-robin. Threads waiting
+	/// for a task group execute pending tasks instead of blocking, so groups can be nested.
+	class F_CORE_EXPORT ThreadPool
+	{
+		F_DISABLE_COPY(ThreadPool);
+		friend class TaskGroup;
+
+	public:
+		typedef std::function<void()> task_t;
+
+		/// Returns the shared pool, created on first use with one worker per hardware thread.
+		static ThreadPool* instance();
+
+		/// Creates a pool with the given number of worker threads, 0 = hardware concurrency.
+		explicit ThreadPool(size_t threadCount = 0);
+		/// Finishes all queued tasks and joins the worker threads.
+		virtual ~ThreadPool();
+
+		/// Splits [begin, end) into ranges of at most grainSize indices and calls
+		/// fn(rangeBegin, rangeEnd) for each range in parallel. The calling thread
+		/// takes part in the work. Returns when all ranges are done.
+		template<typename F>
+		void parallelFor(size_t begin, size_t end, size_t grainSize, const F& fn);
+		/// Same as above, chooses a grain size yielding a few ranges per thread.
+		template<typename F>
+		void parallelFor(size_t begin, size_t end, const F& fn);
+
+		/// Returns the number of worker threads.
+		size_t threadCount() const { return _workers.size(); }
+
+	private:
+		struct worker_t
+		{
+			std::mutex mutex;
+			std::deque<task_t> tasks;
+			std::thread thread;
+		};
+
+		void _submit(task_t&& task);
+		bool _runPendingTask();
+		bool _popTask(size_t index, task_t& task);
+		bool _stealTask(size_t thiefIndex, task_t& task);
+		void _workerLoop(size_t index);
+		void _notifyAll();
+
+		std::vector<std::unique_ptr<worker_t>> _workers;
+		std::atomic<size_t> _queuedCount;
+		std::atomic<size_t> _nextWorker;
+
+		std::mutex _sleepMutex;
+		std::condition_variable _sleepCondition;
+		bool _isStopping;
+	};
+
+	/// Group of tasks executed by a thread pool. wait() returns when all tasks of the
+	/// group are done and rethrows the first exception thrown by a task.
+	class F_CORE_EXPORT TaskGroup
+	{
+		F_DISABLE_COPY(TaskGroup);
+
+	public:
+		TaskGroup(ThreadPool* pPool = ThreadPool::instance());
+		/// Waits for all tasks, exceptions are discarded.
+		virtual ~TaskGroup();
+
+		/// Submits a task to the pool.
+		void run(ThreadPool::task_t task);
+		/// Waits for all tasks submitted so far. The calling thread executes pending tasks while waiting.
+		void wait();
+
+	private:
+		void _wait();
+
+		ThreadPool* _pPool;
+		std::atomic<size_t> _pendingCount;
+		std::mutex _exceptionMutex;
+		std::exception_ptr _pException;
+	};
+
+	template<typename F>
+	void ThreadPool::parallelFor(size_t begin, size_t end, size_t grainSize, const F& fn)
+	{
+		if (begin >= end) {
+			return;
+		}
+
+		grainSize = flow::max(grainSize, size_t(1));
+
+		if (end - begin <= grainSize || _workers.empty()) {
+			fn(begin, end);
+			return;
+		}
+
+		TaskGroup group(this);
+
+		// the calling thread takes the first range
+		size_t first = begin + grainSize;
+		while (first < end) {
+			size_t last = first + flow::min(grainSize, end - first);
+			group.run([&fn, first, last]() { fn(first, last); });
+			first = last;
+		}
+
+		fn(begin, begin + grainSize);
+		group.wait();
+	}
+
+	template<typename F>
+	void ThreadPool::parallelFor(size_t begin, size_t end, const F& fn)
+	{
+		size_t rangeCount = 4 * (_workers.size() + 1);
+		size_t count = end > begin ? end - begin : 0;
+		parallelFor(begin, end, (count + rangeCount - 1) / rangeCount, fn);
+	}
+}
+
+#endif // _FLOWLIBS_CORE_THREADPOOL_H
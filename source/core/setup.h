@@ -308,6 +308,13 @@
 #	define FLOW_INTRINSICS FLOW_INTRINSICS_NONE
 #endif
 
+// SSE4.1 code paths. GCC and Clang define __SSE4_1__ if enabled (-msse4). MSVC has no
+// such macro, and SSE2 targets may run on CPUs without SSE4.1, so it is enabled with
+// /arch:AVX or higher, or explicitly by the FLOW_ENABLE_SSE41 build option.
+#if defined(__SSE4_1__) || defined(__AVX__) || defined(FLOW_ENABLE_SSE41)
+#  define FLOW_SSE41
+#endif
+
 // -----------------------------------------------------------------------------
 //  Build 
 // -----------------------------------------------------------------------------
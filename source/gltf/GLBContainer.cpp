@@ -9,11 +9,29 @@
 
 #include "GLTFAsset.h"
 #include "GLTFBuffer.h"
+#include "GLTFReader.h"
+#include "GLTFWriteContext.h"
+
+#include "../core/MappedFile.h"
+#include "../core/JsonWriter.h"
 
 #include "../core/Bit.h"
 
 #include <iostream>
 #include <fstream>
+#include <cstring>
+#include <algorithm>
+
+#if !(FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS)
+#  include <sys/uio.h>
+#  include <fcntl.h>
+#  include <unistd.h>
+#  include <climits>
+#  include <cerrno>
+#  ifndef IOV_MAX
+#    define IOV_MAX 1024
+#  endif
+#endif
 
 using namespace flow;
 using std::string;
@@ -23,57 +41,360 @@ using std::ios;
 
 
 GLBContainer::GLBContainer(const GLTFAsset* pAsset) :
-	_pAsset(pAsset)
+	_pAsset(pAsset),
+	_pTargetAsset(nullptr)
+{
+}
+
+GLBContainer::GLBContainer(GLTFAsset* pAsset) :
+	_pAsset(pAsset),
+	_pTargetAsset(pAsset)
 {
 }
 
 bool GLBContainer::save(const string& filePath) const
+{
+	_error.clear();
+	_writeStats = GLBWriteStats();
+
+	// external buffer files are mapped here at the latest, fallback buffers have no data
+	for (auto pBuffer : _pAsset->buffers()) {
+		if (pBuffer->isFallback()) {
+			continue;
+		}
+		for (auto& segment : pBuffer->segments()) {
+			if (!segment.pData) {
+				_error = "buffer data not available: " + pBuffer->uri();
+				return false;
+			}
+		}
+	}
+
+	auto startTime = clock::now();
+
+#if FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS
+	bool success = _saveStream(filePath);
+#else
+	bool success = _writeMode == GLBWriteMode::VECTORED
+		? _saveVectored(filePath) : _saveStream(filePath);
+#endif
+
+	double totalSeconds = std::chrono::duration<double>(clock::now() - startTime).count();
+	_writeStats.writeSeconds = totalSeconds - _writeStats.syncSeconds;
+
+	return success;
+}
+
+bool GLBContainer::_saveStream(const string& filePath) const
 {
 	ofstream stream(filePath, ios::out | ios::binary);
 	if (!stream.is_open()) {
+		_error = "failed to open file: " + filePath;
 		return false;
 	}
 
-	// get first binary buffer
-	const GLTFAsset::bufferVec_t& buffers = _pAsset->buffers();
-	if (buffers.empty()) {
-		return false;
-	}
+	const bufferVec_t binaryBuffers = _binaryBuffers();
 
-	const GLTFBuffer* pBinaryBuffer = buffers[0];
+	size_t jsonHeaderLength = sizeof(_jsonChunkHeader);
+	size_t binHeaderLength = binaryBuffers.empty() ? 0 : sizeof(_binChunkHeader);
 
-	// stringify json
-	string json = _pAsset->toJSON().dump(-1, ' ', true);
+	// stream JSON chunk, the headers are written once its length is known
+	stream.seekp(sizeof(_glbHeader) + jsonHeaderLength);
 
-	// size calculations
-	size_t jsonHeaderLength = sizeof(_jsonChunkHeader);
-	size_t binHeaderLength = sizeof(_binChunkHeader);
+	size_t bufferLength = 0;
+	size_t jsonLength = 0;
+	{
+		JsonWriter writer(stream);
+		bufferLength = _writeDocument(writer, binaryBuffers);
+		jsonLength = writer.byteCount();
+	}
 
-	size_t jsonLength = json.size();
 	size_t jsonPaddedLength = Bit::ceil4(jsonLength);
+	stream.write((char*)&_spaces, jsonPaddedLength - jsonLength);
+
+	// add binary chunk, buffer contents are written in place, each starting at a 4 byte boundary
+	size_t bufferPaddedLength = Bit::ceil4(bufferLength);
+	_binChunkHeader.length = uint32_t(bufferPaddedLength);
+	stream.write((char*)&_binChunkHeader, binHeaderLength);
+
+	for (auto pBuffer : binaryBuffers) {
+		size_t byteOffset = 0;
+		for (auto& segment : pBuffer->segments()) {
+			stream.write((char*)&_null, segment.byteOffset - byteOffset);
+			stream.write(segment.pData, segment.byteLength);
+			byteOffset = segment.byteOffset + segment.byteLength;
+		}
+		stream.write((char*)&_null, Bit::ceil4(byteOffset) - byteOffset);
+	}
 
-	size_t binaryPaddedLength = Bit::ceil4(pBinaryBuffer->byteLength());
 	size_t glbTotalLength = sizeof(_glbHeader)
-		+ jsonPaddedLength + jsonHeaderLength + binaryPaddedLength + binHeaderLength;
+		+ jsonPaddedLength + jsonHeaderLength + bufferPaddedLength + binHeaderLength;
 
 	// header
+	stream.seekp(0);
 	_glbHeader.length = uint32_t(glbTotalLength);
 	stream.write((char*)&_glbHeader, sizeof(_glbHeader));
 
-	// add JSON chunk
+	// JSON chunk header
 	_jsonChunkHeader.length = uint32_t(jsonPaddedLength);
 	stream.write((char*)&_jsonChunkHeader, jsonHeaderLength);
-	stream.write(json.data(), jsonLength);
-	stream.write((char*)&_spaces, jsonPaddedLength - jsonLength);
 
-	// add binary chunk
-	size_t bufferLength = pBinaryBuffer->byteLength();
+	bool success = stream.good();
+	stream.close();
+
+	if (!success) {
+		_error = "failed to write file: " + filePath;
+		return false;
+	}
+
+	_writeStats.byteLength = glbTotalLength;
+	return true;
+}
+
+#if !(FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS)
+
+bool GLBContainer::_saveVectored(const string& filePath) const
+{
+	const bufferVec_t binaryBuffers = _binaryBuffers();
+
+	// the JSON chunk is serialized into memory, buffer contents are referenced in place
+	string jsonText;
+	size_t bufferLength = 0;
+	{
+		JsonWriter writer(jsonText);
+		bufferLength = _writeDocument(writer, binaryBuffers);
+	}
+
+	size_t jsonLength = jsonText.size();
+	size_t jsonPaddedLength = Bit::ceil4(jsonLength);
+	size_t binHeaderLength = binaryBuffers.empty() ? 0 : sizeof(_binChunkHeader);
 	size_t bufferPaddedLength = Bit::ceil4(bufferLength);
+
+	size_t glbTotalLength = sizeof(_glbHeader) + sizeof(_jsonChunkHeader)
+		+ jsonPaddedLength + binHeaderLength + bufferPaddedLength;
+
+	_glbHeader.length = uint32_t(glbTotalLength);
+	_jsonChunkHeader.length = uint32_t(jsonPaddedLength);
 	_binChunkHeader.length = uint32_t(bufferPaddedLength);
-	stream.write((char*)&_binChunkHeader, binHeaderLength);
-	stream.write(pBinaryBuffer->data(), bufferLength);
-	stream.write((char*)&_null, bufferPaddedLength - bufferLength);
 
-	stream.close();
+	size_t segmentCount = 0;
+	for (auto pBuffer : binaryBuffers) {
+		segmentCount += pBuffer->segments().size();
+	}
+
+	vector<iovec> ioVecs;
+	ioVecs.reserve(5 + binaryBuffers.size() + 2 * segmentCount);
+
+	auto append = [&ioVecs](const void* pData, size_t length) {
+		if (length > 0) {
+			iovec ioVec = { const_cast<void*>(pData), length };
+			ioVecs.push_back(ioVec);
+		}
+	};
+
+	append(&_glbHeader, sizeof(_glbHeader));
+	append(&_jsonChunkHeader, sizeof(_jsonChunkHeader));
+	append(jsonText.data(), jsonLength);
+	append(&_spaces, jsonPaddedLength - jsonLength);
+	append(&_binChunkHeader, binHeaderLength);
+
+	for (auto pBuffer : binaryBuffers) {
+		size_t byteOffset = 0;
+		for (auto& segment : pBuffer->segments()) {
+			append(&_null, segment.byteOffset - byteOffset);
+			append(segment.pData, segment.byteLength);
+			byteOffset = segment.byteOffset + segment.byteLength;
+		}
+		append(&_null, Bit::ceil4(byteOffset) - byteOffset);
+	}
+
+	int fd = ::open(filePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0) {
+		_error = "failed to open file: " + filePath;
+		return false;
+	}
+
+	bool success = _writeVectors(fd, ioVecs.data(), ioVecs.size());
+	if (!success) {
+		_error = "failed to write file: " + filePath;
+	}
+
+	if (success && _syncMode != GLBSyncMode::NONE) {
+		auto startTime = clock::now();
+
+#if FLOW_PLATFORM & FLOW_PLATFORM_LINUX
+		int result = _syncMode == GLBSyncMode::DATA ? fdatasync(fd) : fsync(fd);
+#else
+		int result = fsync(fd);
+#endif
+
+		_writeStats.syncSeconds = std::chrono::duration<double>(clock::now() - startTime).count();
+
+		if (result != 0) {
+			_error = "failed to sync file: " + filePath;
+			success = false;
+		}
+	}
+
+	if (::close(fd) != 0 && success) {
+		_error = "failed to close file: " + filePath;
+		success = false;
+	}
+
+	if (success) {
+		_writeStats.byteLength = glbTotalLength;
+	}
+
+	return success;
+}
+
+bool GLBContainer::_writeVectors(int fd, iovec* pVecs, size_t count)
+{
+	while (count > 0) {
+		int batchCount = int(std::min(count, size_t(IOV_MAX)));
+		ssize_t written = ::writev(fd, pVecs, batchCount);
+
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+		if (written == 0) {
+			return false;
+		}
+
+		// skip completely written vectors, advance into a partially written one
+		size_t remaining = size_t(written);
+		while (count > 0 && remaining >= pVecs->iov_len) {
+			remaining -= pVecs->iov_len;
+			++pVecs;
+			--count;
+		}
+
+		if (remaining > 0) {
+			pVecs->iov_base = static_cast<char*>(pVecs->iov_base) + remaining;
+			pVecs->iov_len -= remaining;
+		}
+	}
+
 	return true;
-}
\ No newline at end of file
+}
+
+#endif
+
+GLBContainer::bufferVec_t GLBContainer::_binaryBuffers() const
+{
+	// fallback buffers have no data, the reader binds the chunk to the first other buffer
+	bufferVec_t binaryBuffers;
+
+	for (auto pBuffer : _pAsset->buffers()) {
+		if (!pBuffer->isFallback()) {
+			binaryBuffers.push_back(pBuffer);
+			if (!_mergeBuffers) {
+				break;
+			}
+		}
+	}
+
+	return binaryBuffers;
+}
+
+size_t GLBContainer::_writeDocument(JsonWriter& writer, const bufferVec_t& binaryBuffers) const
+{
+	// buffers are bound to their location in the binary chunk while the JSON is written
+	GLTFWriteContext context;
+
+	// without a binary chunk there is no merged buffer, all buffers keep their index
+	size_t bufferLength = 0;
+	if (!binaryBuffers.empty()) {
+		bufferLength = _mergeBuffers
+			? context.mergeBuffers(_pAsset->buffers()) : binaryBuffers[0]->byteLength();
+	}
+
+	_pAsset->toJSON(writer, context);
+	writer.flush();
+
+	return bufferLength;
+}
+
+bool GLBContainer::load(const string& filePath)
+{
+	_error.clear();
+
+	if (!_pTargetAsset) {
+		_error = "container has no target asset";
+		return false;
+	}
+
+	auto pFile = MappedFile::open(filePath);
+	if (!pFile) {
+		_error = "failed to open file: " + filePath;
+		return false;
+	}
+
+	const char* pData = pFile->data();
+	size_t fileLength = pFile->byteLength();
+
+	// header
+	uint32_t header[3];
+	if (fileLength < sizeof(header) + sizeof(_jsonChunkHeader)) {
+		_error = "file too short";
+		return false;
+	}
+
+	std::memcpy(header, pData, sizeof(header));
+	if (header[0] != _glbHeader.magic || header[1] != 2 || header[2] > fileLength) {
+		_error = "invalid GLB header";
+		return false;
+	}
+
+	// JSON chunk, must be the first chunk
+	size_t offset = sizeof(header);
+	uint32_t chunkHeader[2];
+	std::memcpy(chunkHeader, pData + offset, sizeof(chunkHeader));
+	offset += sizeof(chunkHeader);
+
+	if (chunkHeader[1] != _jsonChunkHeader.type || offset + chunkHeader[0] > header[2]) {
+		_error = "invalid JSON chunk";
+		return false;
+	}
+
+	json document;
+	try {
+		document = json::parse(pData + offset, pData + offset + chunkHeader[0]);
+	}
+	catch (const std::exception& e) {
+		_error = string("failed to parse JSON chunk: ") + e.what();
+		return false;
+	}
+
+	offset += Bit::ceil4(chunkHeader[0]);
+
+	GLTFReader reader(_pTargetAsset);
+	reader.setBasePath(filePath.substr(0, filePath.find_last_of("/\\") + 1));
+
+	// optional BIN chunk; chunks of unknown type are skipped
+	while (offset + sizeof(chunkHeader) <= header[2]) {
+		std::memcpy(chunkHeader, pData + offset, sizeof(chunkHeader));
+		offset += sizeof(chunkHeader);
+
+		if (offset + chunkHeader[0] > header[2]) {
+			_error = "invalid chunk length";
+			return false;
+		}
+		if (chunkHeader[1] == _binChunkHeader.type) {
+			reader.setBinaryChunk(pFile, offset, chunkHeader[0]);
+			break;
+		}
+
+		offset += Bit::ceil4(chunkHeader[0]);
+	}
+
+	if (!reader.read(document)) {
+		_error = reader.error();
+		return false;
+	}
+
+	return true;
+}
@@ -9,22 +9,86 @@
 #define _FLOWLIBS_GLTF_GLBCONTAINER_H
 
 #include "library.h"
+#include "GLTFConstants.h"
+
 #include <string>
+#include <vector>
+#include <chrono>
+
+#if !(FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS)
+struct iovec;
+#endif
 
 
 namespace flow
 {
 	class GLTFAsset;
+	class GLTFBuffer;
+	class JsonWriter;
+
+	/// Statistics of the last GLB save operation.
+	struct GLBWriteStats
+	{
+		/// Total number of bytes written.
+		size_t byteLength = 0;
+		/// Time spent serializing and writing, in seconds.
+		double writeSeconds = 0.0;
+		/// Time spent syncing the file to the storage device, in seconds.
+		double syncSeconds = 0.0;
+
+		/// Returns the achieved write bandwidth in bytes per second, including sync time.
+		double bandwidth() const {
+			double seconds = writeSeconds + syncSeconds;
+			return seconds > 0.0 ? double(byteLength) / seconds : 0.0;
+		}
+	};
 
 	class F_GLTF_EXPORT GLBContainer
 	{
 	public:
+		/// Creates a container for saving the given asset.
 		GLBContainer(const GLTFAsset* pAsset);
+		/// Creates a container for saving or loading the given asset.
+		GLBContainer(GLTFAsset* pAsset);
 		virtual ~GLBContainer() {};
 
+		/// If true (default), all buffers of the asset are written back to back into the
+		/// binary chunk and buffer view offsets are rebased. Otherwise only the first
+		/// buffer which isn't a fallback buffer is written. Without such a buffer the
+		/// file has no binary chunk.
+		void setMergeBuffers(bool merge) { _mergeBuffers = merge; }
+		/// STREAM writes through a file stream. VECTORED gathers headers, JSON and buffer
+		/// memory in a single writev() call sequence without intermediate copies
+		/// (POSIX only, falls back to STREAM on Windows).
+		void setWriteMode(GLBWriteMode mode) { _writeMode = mode; }
+		/// Flushes the written file to the storage device: DATA uses fdatasync(),
+		/// FULL uses fsync(). Applies to VECTORED write mode only.
+		void setSyncMode(GLBSyncMode mode) { _syncMode = mode; }
+
 		bool save(const std::string& fileName) const;
+		/// Memory-maps the given GLB file and reads its content into the asset.
+		/// The binary chunk is referenced by the asset's buffer, not copied.
+		bool load(const std::string& fileName);
+
+		/// Returns a description of the last error.
+		const std::string& error() const { return _error; }
+		/// Returns byte count, timings and bandwidth of the last save operation.
+		const GLBWriteStats& writeStats() const { return _writeStats; }
 
 	private:
+		typedef std::chrono::steady_clock clock;
+		typedef std::vector<const GLTFBuffer*> bufferVec_t;
+
+		/// Returns the buffers written to the binary chunk, in order.
+		bufferVec_t _binaryBuffers() const;
+
+		bool _saveStream(const std::string& filePath) const;
+		size_t _writeDocument(JsonWriter& writer, const bufferVec_t& binaryBuffers) const;
+#if !(FLOW_PLATFORM & FLOW_PLATFORM_WINDOWS)
+		bool _saveVectored(const std::string& filePath) const;
+		static bool _writeVectors(int fd, iovec* pVecs, size_t count);
+#endif
+
 		uint32_t _spaces = 0x20202020;
 		uint32_t _null = 0;
 
@@ -48,6 +112,13 @@ namespace flow
 		} _binChunkHeader;
 
 		const GLTFAsset* _pAsset;
+		GLTFAsset* _pTargetAsset;
+		bool _mergeBuffers = true;
+		GLBWriteMode _writeMode = GLBWriteMode::STREAM;
+		GLBSyncMode _syncMode = GLBSyncMode::NONE;
+
+		mutable GLBWriteStats _writeStats;
+		mutable std::string _error;
 	};
 }
 
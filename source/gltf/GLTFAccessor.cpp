@@ -10,6 +10,8 @@
 #include "GLTFBuffer.h"
 #include "GLTFBufferView.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 using std::vector;
@@ -36,20 +38,30 @@ void GLTFAccessor::setInterleaved(size_t byteOffset, size_t byteStride)
 	// if offset is given, stride must be given as well
 	F_ASSERT((byteStride == 0 && byteOffset == 0) || byteStride != 0);
 
-	_byteOffset = _byteOffset;
-	_byteStride = _byteStride;
+	_byteOffset = byteOffset;
+	_byteStride = byteStride;
+	_applyStride();
+}
+
+void GLTFAccessor::setBufferView(GLTFBufferView* pBufferView, size_t byteOffset /* = 0 */)
+{
+	_pBufferView = pBufferView;
+	_byteOffset = byteOffset;
+	_applyStride();
 }
 
 void GLTFAccessor::addData(GLTFBuffer* pBuffer, const char* pData, size_t byteLength, GLTFBufferViewTarget target)
 {
 	_pBufferView = pBuffer->addData(pData, byteLength);
 	_pBufferView->setTarget(target);
+	_applyStride();
 }
 
 char* GLTFAccessor::allocateData(GLTFBuffer* pBuffer, size_t byteLength, GLTFBufferViewTarget target)
 {
 	_pBufferView = pBuffer->allocate(byteLength);
 	_pBufferView->setTarget(target);
+	_applyStride();
 
 	return _pBufferView->data();
 }
@@ -65,28 +77,46 @@ const char* GLTFAccessor::data() const
 		return nullptr;
 	}
 
-	return _pBufferView->data();
+	const char* pData = _pBufferView->data();
+	return pData ? pData + _byteOffset : nullptr;
 }
 
-json GLTFAccessor::toJSON() const
+size_t GLTFAccessor::elementStride() const
 {
-	json result = GLTFMainElement::toJSON();
+	if (_byteStride > 0) {
+		return _byteStride;
+	}
+	if (_pBufferView && _pBufferView->byteStride() > 0) {
+		return _pBufferView->byteStride();
+	}
 
-	result["type"] = _type.name();
-	result["count"] = _count;
+	return elementByteSize();
+}
+
+void GLTFAccessor::_applyStride()
+{
+	// glTF stores the stride with the buffer view, all accessors of a view must agree on it
+	if (_pBufferView && _byteStride > 0) {
+		F_ASSERT(_pBufferView->byteStride() == 0 || _pBufferView->byteStride() == _byteStride);
+		_pBufferView->setByteStride(_byteStride);
+	}
+}
+
+void GLTFAccessor::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
+{
+	GLTFMainElement::_writeProperties(writer, context);
+
+	writer.member("type", _type.name());
+	writer.member("count", _count);
 
 	if (_pBufferView) {
-		result["bufferView"] = _pBufferView->index();
+		writer.member("bufferView", _pBufferView->index());
 	}
 	if (_byteOffset > 0) {
-		result["byteOffset"] = _byteOffset;
-	}
-	if (_byteStride > 0) {
-		result["byteStride"] = _byteStride;
+		writer.member("byteOffset", _byteOffset);
 	}
+	// the stride of interleaved data is a property of the buffer view
 	if (_normalized) {
-		result["normalized"] = true;
+		writer.member("normalized", true);
 	}
-
-	return result;
 }
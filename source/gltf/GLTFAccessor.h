@@ -34,10 +34,16 @@ namespace flow
 		virtual ~GLTFAccessor() {}
 
 		void setNormalized(bool normalized);
+		/// Sets offset and stride of the accessor's elements in its buffer view.
+		/// The stride is copied to the buffer view once the accessor has one.
 		void setInterleaved(size_t byteOffset, size_t byteStride);
+		/// Points the accessor to existing data in the given buffer view.
+		void setBufferView(GLTFBufferView* pBufferView, size_t byteOffset = 0);
 		void addData(GLTFBuffer* pBuffer, const char* pData, size_t byteLength, GLTFBufferViewTarget target);
 		char* allocateData(GLTFBuffer* pBuffer, size_t byteLength, GLTFBufferViewTarget target);
 		void setElementCount(size_t elementCount);
+		/// Updates min and max values from the accessor's data.
+		virtual void updateBounds() = 0;
 
 		const char* data() const;
 
@@ -48,11 +54,15 @@ namespace flow
 		size_t elementByteSize() const { return component().byteSize() * _type.componentCount(); }
 		size_t byteOffset() const { return _byteOffset; }
 		size_t byteStride() const { return _byteStride; }
+		/// Distance in bytes between consecutive elements: the accessor's interleaved stride,
+		/// the buffer view's stride, or the element size if the data is tightly packed.
+		size_t elementStride() const;
 		bool normalized() const { return _normalized; }
 
-		virtual json toJSON() const;
-
 	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
+		/// Copies the interleaved stride to the buffer view.
+		void _applyStride();
 
 		GLTFBufferView* _pBufferView;
 		GLTFAccessorType _type;
@@ -11,8 +11,13 @@
 #include "library.h"
 #include "GLTFAccessor.h"
 #include "GLTFConstants.h"
+#include "GLTFBounds.h"
+
+#include "../core/JsonWriter.h"
 
 #include <string>
+#include <vector>
+#include <cstring>
 #include <limits>
 
 namespace flow
@@ -35,19 +40,21 @@ namespace flow
 		T * allocateIndexData(GLTFBuffer* pBuffer, size_t elementCount);
 		void addVertexData(GLTFBuffer* pBuffer, const T* pData, size_t elementCount);
 		void addIndexData(GLTFBuffer* pBuffer, const T* pData, size_t elementCount);
-		void updateBounds(const T* pData = nullptr);
+		/// Updates min and max values from the given data, or the accessor's data if null.
+		void updateBounds(const T* pData);
+		virtual void updateBounds() { updateBounds(nullptr); }
 
 		std::vector<T>& min() { return _min; }
 		const std::vector<T>& min() const { return _min; }
 
-		std::vector<T>& max() { return _max }
-		const std::vector<T>& max() const { return _max }
+		std::vector<T>& max() { return _max; }
+		const std::vector<T>& max() const { return _max; }
 
 		virtual GLTFAccessorComponent component() const { return GLTFAccessorComponent::type<T>(); }
-		
-		virtual json toJSON() const;
 
 	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
+
 		std::vector<T> _min;
 		std::vector<T> _max;
 	};
@@ -89,50 +96,43 @@ namespace flow
 	}
 
 	template<typename T>
-	void GLTFAccessorT<T>::updateBounds(const T* pData /* = nullptr */)
+	void GLTFAccessorT<T>::updateBounds(const T* pData)
 	{
+		size_t cc = _type.componentCount();
+		size_t stride = cc * sizeof(T);
+
 		if (!pData) {
 			pData = (const T*)data();
 			if (!pData) {
 				throw std::exception("no data source specified");
 			}
+			stride = elementStride();
 		}
 
-		size_t n = _count;
-		size_t cc = _type.componentCount();
-
 		_max.resize(cc);
 		_min.resize(cc);
 
-		for (size_t j = 0; j < cc; ++j) {
-			_max[j] = std::numeric_limits<T>::lowest();
-			_min[j] = std::numeric_limits<T>::max();
+		if (stride == cc * sizeof(T)) {
+			GLTFBounds::compute(pData, _count, cc, _min.data(), _max.data());
 		}
-
-		for (size_t i = 0; i < n; ++i) {
-			const T* pElem = pData + i * cc;
-			for (size_t j = 0; j < cc; ++j) {
-				_max[j] = flow::max(_max[j], pElem[j]);
-				_min[j] = flow::min(_min[j], pElem[j]);
-			}
+		else {
+			GLTFBounds::computeInterleaved(pData, _count, cc, stride, _min.data(), _max.data());
 		}
 	}
 
 	template<typename T>
-	json GLTFAccessorT<T>::toJSON() const
+	void GLTFAccessorT<T>::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 	{
-		json result = GLTFAccessor::toJSON();
-		
-		result["componentType"] = (int)component();
+		GLTFAccessor::_writeProperties(writer, context);
+
+		writer.member("componentType", (int)component());
 
 		if (!_min.empty()) {
-			result["min"] = _min;
+			writer.key("min").array(_min);
 		}
 		if (!_max.empty()) {
-			result["max"] = _max;
+			writer.key("max").array(_max);
 		}
-
-		return result;
 	}
 }
 
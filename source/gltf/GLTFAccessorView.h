@@ -0,0 +1,224 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_ACCESSORVIEW_H
+#define _FLOWLIBS_GLTF_ACCESSORVIEW_H
+
+#include "library.h"
+#include "GLTFAccessor.h"
+#include "GLTFConstants.h"
+
+#include <cstring>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+
+
+namespace flow
+{
+	/// Typed, strided read view on an accessor's data with N components of type T per
+	/// element. The view refers to the accessor's buffer in place and honours the
+	/// accessor's byte offset, element stride, component type and normalization.
+	/// If the accessor's component type is T, elements can be accessed directly through
+	/// ptr(); otherwise values are converted on read, normalized integers are mapped
+	/// to [0, 1] or [-1, 1] as defined by the glTF specification.
+	template<typename T, size_t N>
+	class GLTFAccessorView
+	{
+	public:
+		/// Number of elements decoded per chunk if the data can't be used in place.
+		static const size_t CHUNK_SIZE = 256;
+
+		GLTFAccessorView(const GLTFAccessor* pAccessor);
+
+		/// Returns true if the accessor has data with N components per element.
+		bool isValid() const { return _pData != nullptr; }
+		/// Returns true if the elements are stored as T and can be accessed in place.
+		bool isDirect() const { return _isDirect; }
+		/// Returns true if the elements are stored as T and tightly packed.
+		bool isContiguous() const { return _isDirect && _byteStride == N * sizeof(T); }
+
+		/// Returns the number of elements.
+		size_t size() const { return _count; }
+		/// Returns the distance in bytes between consecutive elements.
+		size_t byteStride() const { return _byteStride; }
+		/// Returns a pointer to the first byte of the first element.
+		const char* data() const { return _pData; }
+
+		/// Returns a pointer to the components of the given element. The view must be direct.
+		const T* ptr(size_t index) const;
+		/// Returns the given component of the given element, converted to T.
+		T value(size_t index, size_t component) const;
+		/// Copies the N components of the given element to pValues, converted to T.
+		void get(size_t index, T* pValues) const;
+
+		/// Calls fn(const T* pData, size_t count, size_t byteStride) for consecutive chunks
+		/// of elements. Direct views are passed in place as a single chunk with the view's
+		/// stride. Otherwise elements are converted into a packed chunk of at most
+		/// CHUNK_SIZE elements, with byteStride equal to N * sizeof(T).
+		template<typename F>
+		void forEachChunk(const F& fn) const;
+
+	private:
+		template<typename S>
+		void _convert(size_t first, size_t count, T* pValues) const;
+		void _convert(size_t first, size_t count, T* pValues) const;
+
+		template<typename S>
+		static T _value(S value, bool normalized);
+		static bool _isStoredAs(GLTFAccessorComponent component);
+
+		const char* _pData;
+		size_t _count;
+		size_t _byteStride;
+		GLTFAccessorComponent _component;
+		bool _normalized;
+		bool _isDirect;
+	};
+
+	template<typename T, size_t N>
+	const size_t GLTFAccessorView<T, N>::CHUNK_SIZE;
+
+	template<typename T, size_t N>
+	GLTFAccessorView<T, N>::GLTFAccessorView(const GLTFAccessor* pAccessor) :
+		_pData(nullptr),
+		_count(0),
+		_byteStride(0),
+		_normalized(false),
+		_isDirect(false)
+	{
+		if (!pAccessor || pAccessor->type().componentCount() != N) {
+			return;
+		}
+
+		_component = pAccessor->component();
+
+		// columns of 2 by 2 and 3 by 3 matrices with 1 or 2 byte components are padded
+		GLTFAccessorType type = pAccessor->type();
+		if ((type == GLTFAccessorType::MAT2 && _component.byteSize() == 1)
+				|| (type == GLTFAccessorType::MAT3 && _component.byteSize() < 4)) {
+			return;
+		}
+
+		_pData = pAccessor->data();
+		_count = pAccessor->elementCount();
+		_byteStride = pAccessor->elementStride();
+		_normalized = pAccessor->normalized();
+
+		// normalized integers read as integers must be converted as well
+		_isDirect = _isStoredAs(_component) && !(_normalized && std::numeric_limits<T>::is_integer);
+	}
+
+	template<typename T, size_t N>
+	inline const T* GLTFAccessorView<T, N>::ptr(size_t index) const
+	{
+		F_ASSERT(_isDirect && index < _count);
+		return (const T*)(_pData + index * _byteStride);
+	}
+
+	template<typename T, size_t N>
+	inline T GLTFAccessorView<T, N>::value(size_t index, size_t component) const
+	{
+		T values[N];
+		get(index, values);
+		return values[component];
+	}
+
+	template<typename T, size_t N>
+	inline void GLTFAccessorView<T, N>::get(size_t index, T* pValues) const
+	{
+		F_ASSERT(index < _count);
+
+		if (_isDirect) {
+			std::memcpy(pValues, _pData + index * _byteStride, N * sizeof(T));
+		}
+		else {
+			_convert(index, 1, pValues);
+		}
+	}
+
+	template<typename T, size_t N>
+	template<typename F>
+	void GLTFAccessorView<T, N>::forEachChunk(const F& fn) const
+	{
+		if (!_pData || _count == 0) {
+			return;
+		}
+
+		if (_isDirect) {
+			fn((const T*)_pData, _count, _byteStride);
+			return;
+		}
+
+		T values[CHUNK_SIZE * N];
+		for (size_t first = 0; first < _count; first += CHUNK_SIZE) {
+			size_t count = flow::min(CHUNK_SIZE, _count - first);
+			_convert(first, count, values);
+			fn((const T*)values, count, N * sizeof(T));
+		}
+	}
+
+	template<typename T, size_t N>
+	template<typename S>
+	void GLTFAccessorView<T, N>::_convert(size_t first, size_t count, T* pValues) const
+	{
+		const char* pElement = _pData + first * _byteStride;
+
+		for (size_t i = 0; i < count; ++i, pElement += _byteStride) {
+			S source[N];
+			std::memcpy(source, pElement, N * sizeof(S));
+			for (size_t j = 0; j < N; ++j) {
+				*pValues++ = _value(source[j], _normalized);
+			}
+		}
+	}
+
+	template<typename T, size_t N>
+	void GLTFAccessorView<T, N>::_convert(size_t first, size_t count, T* pValues) const
+	{
+		switch (_component) {
+		case GLTFAccessorComponent::BYTE: _convert<int8_t>(first, count, pValues); return;
+		case GLTFAccessorComponent::UNSIGNED_BYTE: _convert<uint8_t>(first, count, pValues); return;
+		case GLTFAccessorComponent::SHORT: _convert<int16_t>(first, count, pValues); return;
+		case GLTFAccessorComponent::UNSIGNED_SHORT: _convert<uint16_t>(first, count, pValues); return;
+		case GLTFAccessorComponent::INT: _convert<int32_t>(first, count, pValues); return;
+		case GLTFAccessorComponent::UNSIGNED_INT: _convert<uint32_t>(first, count, pValues); return;
+		case GLTFAccessorComponent::FLOAT: _convert<float>(first, count, pValues); return;
+		default: F_ASSERT(false); return;
+		}
+	}
+
+	template<typename T, size_t N>
+	bool GLTFAccessorView<T, N>::_isStoredAs(GLTFAccessorComponent component)
+	{
+		switch (component) {
+		case GLTFAccessorComponent::BYTE: return std::is_same<T, int8_t>::value;
+		case GLTFAccessorComponent::UNSIGNED_BYTE: return std::is_same<T, uint8_t>::value;
+		case GLTFAccessorComponent::SHORT: return std::is_same<T, int16_t>::value;
+		case GLTFAccessorComponent::UNSIGNED_SHORT: return std::is_same<T, uint16_t>::value;
+		case GLTFAccessorComponent::INT: return std::is_same<T, int32_t>::value;
+		case GLTFAccessorComponent::UNSIGNED_INT: return std::is_same<T, uint32_t>::value;
+		case GLTFAccessorComponent::FLOAT: return std::is_same<T, float>::value;
+		default: return false;
+		}
+	}
+
+	template<typename T, size_t N>
+	template<typename S>
+	inline T GLTFAccessorView<T, N>::_value(S value, bool normalized)
+	{
+		if (!normalized || !std::numeric_limits<S>::is_integer) {
+			return T(value);
+		}
+
+		// glTF 2.0 normalization, signed values are clamped to -1
+		double v = double(value) / double(std::numeric_limits<S>::max());
+		return T(v < -1.0 ? -1.0 : v);
+	}
+}
+
+#endif // _FLOWLIBS_GLTF_ACCESSORVIEW_H
@@ -7,6 +7,8 @@
 
 #include "GLTFAnimation.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -16,9 +18,7 @@ GLTFAnimation::GLTFAnimation(size_t index, const string& name /* = std::string *
 {
 }
 
-json GLTFAnimation::toJSON() const
+void GLTFAnimation::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
-
-	return result;
+	GLTFMainElement::_writeProperties(writer, context);
 }
\ No newline at end of file
@@ -25,8 +25,7 @@ namespace flow
 		GLTFAnimation(size_t index, const std::string& name = std::string{});
 		virtual ~GLTFAnimation() {}
 
-	public:
-		virtual json toJSON() const;
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 	};
@@ -20,13 +20,27 @@
 #include "GLTFImage.h"
 #include "GLTFSampler.h"
 #include "GLTFAnimation.h"
+#include "GLTFGenericExtension.h"
+#include "GLTFDracoExtension.h"
+#include "GLTFMeshoptExtension.h"
+#include "GLTFMeshletExtension.h"
 
 #include "GLTFConstants.h"
 #include "GLBContainer.h"
+#include "GLTFReader.h"
+#include "GLTFWriteContext.h"
 
 #include "../core/Bit.h"
+#include "../core/Hash.h"
+#include "../core/JsonWriter.h"
+#include "../core/MappedFile.h"
+#include "../core/ThreadPool.h"
 
 #include <fstream>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <unordered_map>
 
 using namespace flow;
 using std::string;
@@ -36,6 +50,46 @@ using std::ofstream;
 using std::ios;
 
 
+namespace
+{
+	// glTF properties holding indices of accessors, buffer views or buffers
+	const char* const _bufferReferenceKeys[] = {
+		"accessor", "accessors", "attributes", "indices", "buffer", "bufferView", "bufferViews"
+	};
+
+	bool _refersToBufferData(const json& data)
+	{
+		if (data.is_array()) {
+			for (auto& item : data) {
+				if (_refersToBufferData(item)) {
+					return true;
+				}
+			}
+		}
+		else if (data.is_object()) {
+			for (auto it = data.begin(); it != data.end(); ++it) {
+				for (auto pKey : _bufferReferenceKeys) {
+					if (it.key() == pKey) {
+						return true;
+					}
+				}
+				if (_refersToBufferData(it.value())) {
+					return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// upper bounds of the element sizes stored in the polymorphic arenas, used by reserve()
+	const size_t _maxNodeSize = std::max({ sizeof(GLTFNode), sizeof(GLTFMeshNode),
+		sizeof(GLTFSkinNode), sizeof(GLTFCameraNode) });
+	const size_t _maxCameraSize = std::max({ sizeof(GLTFCamera),
+		sizeof(GLTFPerspectiveCamera), sizeof(GLTFOrthographicCamera) });
+	const size_t _maxAccessorSize = std::max({ sizeof(GLTFAccessorT<float>),
+		sizeof(GLTFAccessorT<uint32_t>), sizeof(GLTFAccessorT<uint16_t>), sizeof(GLTFAccessorT<uint8_t>) });
+}
+
 GLTFAsset::GLTFAsset() :
 	_pMainScene(nullptr)
 {
@@ -44,19 +98,20 @@ GLTFAsset::GLTFAsset() :
 GLTFAsset::~GLTFAsset()
 {
 	_deleteVectorOfPointers(_extensionsUsed);
-	_deleteVectorOfPointers(_scenes);
-	_deleteVectorOfPointers(_nodes);
-	_deleteVectorOfPointers(_meshes);
-	_deleteVectorOfPointers(_skins);
-	_deleteVectorOfPointers(_cameras);
-	_deleteVectorOfPointers(_buffers);
-	_deleteVectorOfPointers(_bufferViews);
-	_deleteVectorOfPointers(_accessors);
-	_deleteVectorOfPointers(_materials);
-	_deleteVectorOfPointers(_textures);
-	_deleteVectorOfPointers(_images);
-	_deleteVectorOfPointers(_samplers);
-	_deleteVectorOfPointers(_animations);
+	_deleteVectorOfPointers(_ownedExtensions);
+	_destructVectorOfPointers(_scenes);
+	_destructVectorOfPointers(_nodes);
+	_destructVectorOfPointers(_meshes);
+	_destructVectorOfPointers(_skins);
+	_destructVectorOfPointers(_cameras);
+	_destructVectorOfPointers(_buffers);
+	_destructVectorOfPointers(_bufferViews);
+	_destructVectorOfPointers(_accessors);
+	_destructVectorOfPointers(_materials);
+	_destructVectorOfPointers(_textures);
+	_destructVectorOfPointers(_images);
+	_destructVectorOfPointers(_samplers);
+	_destructVectorOfPointers(_animations);
 }
 
 bool GLTFAsset::saveGLTF(const std::string& gltfFilePath, int indent /*= -1 */)
@@ -66,7 +121,11 @@ bool GLTFAsset::saveGLTF(const std::string& gltfFilePath, int indent /*= -1 */)
 		return false;
 	}
 
-	stream << toJSON().dump(indent);
+	{
+		JsonWriter writer(stream, indent);
+		toJSON(writer);
+	}
+
 	stream.close();
 
 	return true;
@@ -78,6 +137,53 @@ bool GLTFAsset::saveGLB(const std::string& glbFilePath)
 	return glb.save(glbFilePath);
 }
 
+bool GLTFAsset::loadGLB(const std::string& glbFilePath)
+{
+	loadState_t state = _saveLoadState();
+
+	GLBContainer glb(this);
+	if (!glb.load(glbFilePath)) {
+		_loadError = glb.error();
+		_restoreLoadState(state);
+		return false;
+	}
+
+	_loadError.clear();
+	return true;
+}
+
+bool GLTFAsset::loadGLTF(const std::string& gltfFilePath)
+{
+	auto pFile = MappedFile::open(gltfFilePath);
+	if (!pFile) {
+		_loadError = "failed to open file: " + gltfFilePath;
+		return false;
+	}
+
+	json document;
+	try {
+		document = json::parse(pFile->data(), pFile->data() + pFile->byteLength());
+	}
+	catch (const std::exception& e) {
+		_loadError = string("failed to parse JSON: ") + e.what();
+		return false;
+	}
+
+	loadState_t state = _saveLoadState();
+
+	// uris are relative to the directory of the document
+	GLTFReader reader(this);
+	reader.setBasePath(gltfFilePath.substr(0, gltfFilePath.find_last_of("/\\") + 1));
+	if (!reader.read(document)) {
+		_loadError = reader.error();
+		_restoreLoadState(state);
+		return false;
+	}
+
+	_loadError.clear();
+	return true;
+}
+
 void GLTFAsset::setMainScene(const GLTFScene* pScene)
 {
 	_pMainScene = pScene;
@@ -108,79 +214,125 @@ void GLTFAsset::addExtension(const GLTFExtension* pExtension, bool isRequired)
 	}
 }
 
+void GLTFAsset::useExtension(const char* pName, bool isRequired)
+{
+	for (auto pExtension : _extensionsUsed) {
+		if (string(pExtension->name()) == pName) {
+			auto it = std::find(_extensionsRequired.begin(), _extensionsRequired.end(), pName);
+			if (isRequired && it == _extensionsRequired.end()) {
+				_extensionsRequired.emplace_back(pName);
+			}
+			return;
+		}
+	}
+
+	addExtension(new GLTFGenericExtension(pName), isRequired);
+}
+
+void GLTFAsset::reserve(const elementCounts_t& counts)
+{
+	_reserveElements(_scenes, _sceneArena, counts.scenes, sizeof(GLTFScene));
+	_reserveElements(_nodes, _nodeArena, counts.nodes, _maxNodeSize);
+	_reserveElements(_meshes, _meshArena, counts.meshes, sizeof(GLTFMesh));
+	_reserveElements(_skins, _skinArena, counts.skins, sizeof(GLTFSkin));
+	_reserveElements(_cameras, _cameraArena, counts.cameras, _maxCameraSize);
+	_reserveElements(_buffers, _bufferArena, counts.buffers, sizeof(GLTFBuffer));
+	_reserveElements(_bufferViews, _bufferViewArena, counts.bufferViews, sizeof(GLTFBufferView));
+	_reserveElements(_accessors, _accessorArena, counts.accessors, _maxAccessorSize);
+	_reserveElements(_materials, _materialArena, counts.materials, sizeof(GLTFMaterial));
+	_reserveElements(_textures, _textureArena, counts.textures, sizeof(GLTFTexture));
+	_reserveElements(_images, _imageArena, counts.images, sizeof(GLTFImage));
+	_reserveElements(_samplers, _samplerArena, counts.samplers, sizeof(GLTFSampler));
+	_reserveElements(_animations, _animationArena, counts.animations, sizeof(GLTFAnimation));
+}
+
 GLTFScene* GLTFAsset::createScene(const string& name /* = string{} */)
 {
-	auto pScene = new GLTFScene(_scenes.size(), name);
+	auto pScene = _construct<GLTFScene>(_sceneArena, _scenes.size(), name);
 	_scenes.push_back(pScene);
 	return pScene;
 }
 
 GLTFNode* GLTFAsset::createNode(const string& name /* = string{} */)
 {
-	auto pNode = new GLTFNode(_nodes.size(), name);
+	auto pNode = _construct<GLTFNode>(_nodeArena, _nodes.size(), name);
 	_nodes.push_back(pNode);
 	return pNode;
 }
 
 GLTFMeshNode* GLTFAsset::createMeshNode(const GLTFMesh* pMesh, const string& name /* = string{} */)
 {
-	auto pNode = new GLTFMeshNode(_nodes.size(), pMesh, name);
+	auto pNode = _construct<GLTFMeshNode>(_nodeArena, _nodes.size(), pMesh, name);
 	_nodes.push_back(pNode);
 	return pNode;
 }
 
 GLTFSkinNode* GLTFAsset::createSkinNode(const GLTFSkin* pSkin, const string& name /* = string{} */)
 {
-	auto pNode = new GLTFSkinNode(_nodes.size(), pSkin, name);
+	auto pNode = _construct<GLTFSkinNode>(_nodeArena, _nodes.size(), pSkin, name);
 	_nodes.push_back(pNode);
 	return pNode;
 }
 
 GLTFCameraNode* GLTFAsset::createCameraNode(const GLTFCamera* pCamera, const string& name /* = string{} */)
 {
-	auto pNode = new GLTFCameraNode(_nodes.size(), pCamera, name);
+	auto pNode = _construct<GLTFCameraNode>(_nodeArena, _nodes.size(), pCamera, name);
 	_nodes.push_back(pNode);
 	return pNode;
 }
 
 GLTFMesh* GLTFAsset::createMesh(const string& name /* = string{} */)
 {
-	auto pMesh = new GLTFMesh(_meshes.size(), name);
+	auto pMesh = _construct<GLTFMesh>(_meshArena, _meshes.size(), name);
 	_meshes.push_back(pMesh);
 	return pMesh;
 }
 
 GLTFSkin* GLTFAsset::createSkin(const string& name /* = string{} */)
 {
-	auto pSkin = new GLTFSkin(_skins.size(), name);
+	auto pSkin = _construct<GLTFSkin>(_skinArena, _skins.size(), name);
 	_skins.push_back(pSkin);
 	return pSkin;
 }
 
 GLTFCamera* GLTFAsset::createCamera(const string& name /* = string{} */)
 {
-	auto pCamera = new GLTFCamera(_cameras.size(), name);
+	auto pCamera = _construct<GLTFCamera>(_cameraArena, _cameras.size(), name);
+	_cameras.push_back(pCamera);
+	return pCamera;
+}
+
+GLTFPerspectiveCamera* GLTFAsset::createPerspectiveCamera(const string& name /* = string{} */)
+{
+	auto pCamera = _construct<GLTFPerspectiveCamera>(_cameraArena, _cameras.size(), name);
+	_cameras.push_back(pCamera);
+	return pCamera;
+}
+
+GLTFOrthographicCamera* GLTFAsset::createOrthographicCamera(const string& name /* = string{} */)
+{
+	auto pCamera = _construct<GLTFOrthographicCamera>(_cameraArena, _cameras.size(), name);
 	_cameras.push_back(pCamera);
 	return pCamera;
 }
 
 GLTFBuffer* GLTFAsset::createBuffer(const string& name /* = string{} */)
 {
-	auto pBuffer = new GLTFBuffer(this, _buffers.size(), name);
+	auto pBuffer = _construct<GLTFBuffer>(_bufferArena, this, _buffers.size(), name);
 	_buffers.push_back(pBuffer);
 	return pBuffer;
 }
 
 GLTFMaterial* GLTFAsset::createMaterial(const string& name /* = string{} */)
 {
-	auto pMaterial = new GLTFMaterial(_materials.size(), name);
+	auto pMaterial = _construct<GLTFMaterial>(_materialArena, _materials.size(), name);
 	_materials.push_back(pMaterial);
 	return pMaterial;
 }
 
 GLTFTexture* GLTFAsset::createTexture(const GLTFImage* pImage, const GLTFSampler* pSampler /* = nullptr */)
 {
-	auto pTexture = new GLTFTexture(_textures.size());
+	auto pTexture = _construct<GLTFTexture>(_textureArena, _textures.size());
 	pTexture->setSource(pImage, pSampler);
 	_textures.push_back(pTexture);
 	return pTexture;
@@ -188,11 +340,11 @@ GLTFTexture* GLTFAsset::createTexture(const GLTFImage* pImage, const GLTFSampler
 
 GLTFTexture* GLTFAsset::createTexture(const std::string& imageUri, const GLTFSampler* pSampler /* = nullptr */)
 {
-	auto pImage = new GLTFImage(_images.size());
+	auto pImage = _construct<GLTFImage>(_imageArena, _images.size());
 	pImage->setUri(imageUri);
 	_images.push_back(pImage);
 
-	auto pTexture = new GLTFTexture(_textures.size());
+	auto pTexture = _construct<GLTFTexture>(_textureArena, _textures.size());
 	pTexture->setSource(pImage, pSampler);
 	_textures.push_back(pTexture);
 
@@ -215,11 +367,11 @@ GLTFTexture* GLTFAsset::createTexture(GLTFBuffer* pBuffer, const string& imageFi
 	auto mimeType = (ext == "png" || ext == "PNG")
 		? GLTFMimeType::IMAGE_PNG : GLTFMimeType::IMAGE_JPEG;
 
-	auto pImage = new GLTFImage(_images.size());
+	auto pImage = _construct<GLTFImage>(_imageArena, _images.size());
 	pImage->setBufferView(pBufferView, mimeType);
 	_images.push_back(pImage);
 
-	auto pTexture = new GLTFTexture(_textures.size());
+	auto pTexture = _construct<GLTFTexture>(_textureArena, _textures.size());
 	pTexture->setSource(pImage, pSampler);
 	_textures.push_back(pTexture);
 
@@ -229,11 +381,11 @@ GLTFTexture* GLTFAsset::createTexture(GLTFBuffer* pBuffer, const string& imageFi
 
 GLTFTexture* GLTFAsset::createTexture(const GLTFBufferView* pBufferView, GLTFMimeType mimeType, const GLTFSampler* pSampler /* = nullptr */)
 {
-	auto pImage = new GLTFImage(_images.size());
+	auto pImage = _construct<GLTFImage>(_imageArena, _images.size());
 	pImage->setBufferView(pBufferView, mimeType);
 	_images.push_back(pImage);
 
-	auto pTexture = new GLTFTexture(_textures.size());
+	auto pTexture = _construct<GLTFTexture>(_textureArena, _textures.size());
 	pTexture->setSource(pImage, pSampler);
 	_textures.push_back(pTexture);
 
@@ -242,7 +394,7 @@ GLTFTexture* GLTFAsset::createTexture(const GLTFBufferView* pBufferView, GLTFMim
 
 GLTFImage* GLTFAsset::createImage(const std::string& imageUri)
 {
-	auto pImage = new GLTFImage(_images.size());
+	auto pImage = _construct<GLTFImage>(_imageArena, _images.size());
 	pImage->setUri(imageUri);
 	_images.push_back(pImage);
 	return pImage;
@@ -250,7 +402,7 @@ GLTFImage* GLTFAsset::createImage(const std::string& imageUri)
 
 GLTFImage* GLTFAsset::createImage(const GLTFBufferView* pBufferView, GLTFMimeType mimeType)
 {
-	auto pImage = new GLTFImage(_images.size());
+	auto pImage = _construct<GLTFImage>(_imageArena, _images.size());
 	pImage->setBufferView(pBufferView, mimeType);
 	_images.push_back(pImage);
 	return pImage;
@@ -258,7 +410,7 @@ GLTFImage* GLTFAsset::createImage(const GLTFBufferView* pBufferView, GLTFMimeTyp
 
 GLTFSampler* GLTFAsset::createSampler()
 {
-	auto pSampler = new GLTFSampler(_samplers.size());
+	auto pSampler = _construct<GLTFSampler>(_samplerArena, _samplers.size());
 	_samplers.push_back(pSampler);
 	return pSampler;
 }
@@ -269,69 +421,669 @@ GLTFAnimation* GLTFAsset::createAnimation()
 	throw exception("not implemented yet");
 }
 
-json GLTFAsset::toJSON() const
+GLTFAsset::boundsTimingVec_t GLTFAsset::updateAllBounds(bool allAccessors /* = false */)
+{
+	vector<bool> isRequired(_accessors.size(), allAccessors);
+
+	if (!allAccessors) {
+		for (auto pMesh : _meshes) {
+			for (auto& primitive : pMesh->primitives()) {
+				for (auto& attribute : primitive.attributes()) {
+					if (attribute.type == GLTFAttributeType::POSITION && attribute.pAccessor) {
+						isRequired[attribute.pAccessor->index()] = true;
+					}
+				}
+				for (auto& target : primitive.targets()) {
+					for (auto& attribute : target) {
+						if (attribute.type == GLTFAttributeType::POSITION && attribute.pAccessor) {
+							isRequired[attribute.pAccessor->index()] = true;
+						}
+					}
+				}
+			}
+		}
+	}
+
+	vector<GLTFAccessor*> accessors;
+	for (auto pAccessor : _accessors) {
+		if (isRequired[pAccessor->index()] && pAccessor->data()) {
+			accessors.push_back(const_cast<GLTFAccessor*>(pAccessor));
+		}
+	}
+
+	// process largest accessors first, so the batch doesn't end with a single long task
+	vector<size_t> order(accessors.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [&accessors](size_t a, size_t b) {
+		const GLTFAccessor* pA = accessors[a];
+		const GLTFAccessor* pB = accessors[b];
+		return pA->elementCount() * pA->elementByteSize() > pB->elementCount() * pB->elementByteSize();
+	});
+
+	boundsTimingVec_t timings(accessors.size());
+
+	// large accessors split themselves into further tasks on the same pool
+	TaskGroup group;
+	for (size_t i : order) {
+		group.run([&accessors, &timings, i]() {
+			auto startTime = std::chrono::steady_clock::now();
+			accessors[i]->updateBounds();
+			auto duration = std::chrono::steady_clock::now() - startTime;
+
+			timings[i].pAccessor = accessors[i];
+			timings[i].seconds = std::chrono::duration<double>(duration).count();
+		});
+	}
+
+	group.wait();
+	return timings;
+}
+
+bool GLTFAsset::compact()
+{
+	if (_hasGenericBufferReferences()) {
+		return false;
+	}
+
+	vector<bool> isUsed(_accessors.size(), false);
+	for (auto pMesh : _meshes) {
+		for (auto& primitive : pMesh->primitives()) {
+			if (primitive.indices()) {
+				isUsed[primitive.indices()->index()] = true;
+			}
+			for (auto& attribute : primitive.attributes()) {
+				if (attribute.pAccessor) {
+					isUsed[attribute.pAccessor->index()] = true;
+				}
+			}
+			for (auto& target : primitive.targets()) {
+				for (auto& attribute : target) {
+					if (attribute.pAccessor) {
+						isUsed[attribute.pAccessor->index()] = true;
+					}
+				}
+			}
+		}
+	}
+
+	_removeUnused(_accessors, isUsed);
+
+	isUsed.assign(_bufferViews.size(), false);
+	for (auto pAccessor : _accessors) {
+		if (pAccessor->bufferView()) {
+			isUsed[pAccessor->bufferView()->index()] = true;
+		}
+	}
+	for (auto pImage : _images) {
+		if (pImage->bufferView()) {
+			isUsed[pImage->bufferView()->index()] = true;
+		}
+	}
+	for (auto pExtension : _ownedExtensions) {
+		auto pDraco = dynamic_cast<const GLTFDracoExtension*>(pExtension);
+		if (pDraco && pDraco->bufferView()) {
+			isUsed[pDraco->bufferView()->index()] = true;
+		}
+		auto pMeshlets = dynamic_cast<const GLTFMeshletExtension*>(pExtension);
+		if (pMeshlets) {
+			isUsed[pMeshlets->bufferView()->index()] = true;
+		}
+	}
+
+	_removeUnused(_bufferViews, isUsed);
+
+	// compressed data is referenced by meshopt extensions directly, not by a view
+	vector<vector<GLTFBufferView*>> views(_buffers.size());
+	vector<vector<GLTFMeshoptExtension*>> encoded(_buffers.size());
+	for (auto pBufferView : _bufferViews) {
+		views[pBufferView->buffer()->index()].push_back(const_cast<GLTFBufferView*>(pBufferView));
+	}
+	for (auto pExtension : _ownedExtensions) {
+		auto pMeshopt = dynamic_cast<const GLTFMeshoptExtension*>(pExtension);
+		if (pMeshopt && !pMeshopt->isFallback()) {
+			encoded[pMeshopt->buffer()->index()].push_back(const_cast<GLTFMeshoptExtension*>(pMeshopt));
+		}
+	}
+
+	isUsed.assign(_buffers.size(), false);
+	for (size_t i = 0; i < _buffers.size(); ++i) {
+		if (views[i].empty() && encoded[i].empty()) {
+			continue;
+		}
+
+		GLTFBuffer::rangeVec_t ranges;
+		for (auto pBufferView : views[i]) {
+			ranges.push_back({ pBufferView->byteOffset(), pBufferView->byteLength() });
+		}
+		for (auto pMeshopt : encoded[i]) {
+			ranges.push_back({ pMeshopt->byteOffset(), pMeshopt->byteLength() });
+		}
+
+		isUsed[i] = true;
+		auto pBuffer = const_cast<GLTFBuffer*>(_buffers[i]);
+		vector<size_t> offsets;
+		if (!pBuffer->_repack(ranges, offsets)) {
+			continue;
+		}
+
+		size_t rangeIndex = 0;
+		for (auto pBufferView : views[i]) {
+			pBufferView->_set(pBuffer, offsets[rangeIndex++], pBufferView->byteLength(), pBufferView->byteStride());
+		}
+		for (auto pMeshopt : encoded[i]) {
+			pMeshopt->_setByteOffset(offsets[rangeIndex++]);
+		}
+	}
+
+	_removeUnused(_buffers, isUsed);
+	return true;
+}
+
+bool GLTFAsset::deduplicate()
+{
+	if (_hasGenericBufferReferences()) {
+		return false;
+	}
+
+	// views referenced by compression extensions keep their identity
+	size_t viewCount = _bufferViews.size();
+	vector<char> isCandidate(viewCount, 1);
+	_excludeCompressedViews(isCandidate);
+
+	// hash largest views first, so the batch doesn't end with a single long task
+	vector<size_t> order;
+	for (size_t i = 0; i < viewCount; ++i) {
+		if (isCandidate[i]) {
+			order.push_back(i);
+		}
+	}
+
+	std::sort(order.begin(), order.end(), [this](size_t a, size_t b) {
+		return _bufferViews[a]->byteLength() > _bufferViews[b]->byteLength();
+	});
+
+	vector<uint64_t> hashes(viewCount, 0);
+
+	TaskGroup group;
+	for (size_t i : order) {
+		group.run([this, &hashes, &isCandidate, i]() {
+			const char* pData = _bufferViews[i]->data();
+			if (pData) {
+				hashes[i] = Hash::xxh64(pData, _bufferViews[i]->byteLength());
+			}
+			else {
+				isCandidate[i] = 0;
+			}
+		});
+	}
+
+	group.wait();
+
+	// the first view with given contents is canonical, equal hashes are confirmed by comparison
+	vector<size_t> canonical(viewCount);
+	std::unordered_map<uint64_t, vector<size_t>> canonicalByHash;
+	bool hasDuplicates = false;
+
+	for (size_t i = 0; i < viewCount; ++i) {
+		canonical[i] = i;
+		if (!isCandidate[i]) {
+			continue;
+		}
+
+		const GLTFBufferView* pView = _bufferViews[i];
+		vector<size_t>& candidates = canonicalByHash[hashes[i]];
+
+		for (size_t j : candidates) {
+			const GLTFBufferView* pOther = _bufferViews[j];
+			if (pOther->byteLength() == pView->byteLength()
+					&& pOther->byteStride() == pView->byteStride()
+					&& pOther->target() == pView->target()
+					&& std::memcmp(pOther->data(), pView->data(), pView->byteLength()) == 0) {
+				canonical[i] = j;
+				hasDuplicates = true;
+				break;
+			}
+		}
+
+		if (canonical[i] == i) {
+			candidates.push_back(i);
+		}
+	}
+
+	if (hasDuplicates) {
+		for (auto pAccessor : _accessors) {
+			GLTFBufferView* pBufferView = pAccessor->bufferView();
+			if (pBufferView && canonical[pBufferView->index()] != pBufferView->index()) {
+				auto pCanonical = const_cast<GLTFBufferView*>(_bufferViews[canonical[pBufferView->index()]]);
+				const_cast<GLTFAccessor*>(pAccessor)->setBufferView(pCanonical, pAccessor->byteOffset());
+			}
+		}
+		for (auto pImage : _images) {
+			const GLTFBufferView* pBufferView = pImage->bufferView();
+			if (pBufferView && canonical[pBufferView->index()] != pBufferView->index()) {
+				const_cast<GLTFImage*>(pImage)->setBufferView(
+					_bufferViews[canonical[pBufferView->index()]], pImage->mimeType());
+			}
+		}
+	}
+
+	return compact();
+}
+
+size_t GLTFAsset::narrowIndices(bool allowUnsignedByte /* = true */)
+{
+	size_t accessorCount = _accessors.size();
+	size_t viewCount = _bufferViews.size();
+
+	// accessors used as primitive indices and nothing else
+	vector<char> isIndices(accessorCount, 0);
+	vector<char> isAttribute(accessorCount, 0);
+	for (auto pMesh : _meshes) {
+		for (auto& primitive : pMesh->primitives()) {
+			if (primitive.indices()) {
+				isIndices[primitive.indices()->index()] = 1;
+			}
+			for (auto& attribute : primitive.attributes()) {
+				if (attribute.pAccessor) {
+					isAttribute[attribute.pAccessor->index()] = 1;
+				}
+			}
+			for (auto& target : primitive.targets()) {
+				for (auto& attribute : target) {
+					if (attribute.pAccessor) {
+						isAttribute[attribute.pAccessor->index()] = 1;
+					}
+				}
+			}
+		}
+	}
+
+	// views holding only tightly packed index data
+	vector<char> isCandidate(viewCount, 1);
+	_excludeCompressedViews(isCandidate);
+
+	for (auto pImage : _images) {
+		if (pImage->bufferView()) {
+			isCandidate[pImage->bufferView()->index()] = 0;
+		}
+	}
+	for (auto pBufferView : _bufferViews) {
+		if (pBufferView->byteStride() != 0 || !pBufferView->data()) {
+			isCandidate[pBufferView->index()] = 0;
+		}
+	}
+
+	// accessors are referred to by index, sorting pointers would pick up flow::swap
+	vector<vector<size_t>> viewAccessors(viewCount);
+	for (auto pAccessor : _accessors) {
+		GLTFBufferView* pBufferView = pAccessor->bufferView();
+		if (!pBufferView) {
+			continue;
+		}
+
+		GLTFAccessorComponent component = pAccessor->component();
+		size_t i = pAccessor->index();
+		if (!isIndices[i] || isAttribute[i] || !pAccessor->extensions().empty()
+				|| pAccessor->byteStride() != 0 || pAccessor->type() != GLTFAccessorType::SCALAR
+				|| (component != GLTFAccessorComponent::UNSIGNED_BYTE
+					&& component != GLTFAccessorComponent::UNSIGNED_SHORT
+					&& component != GLTFAccessorComponent::UNSIGNED_INT)) {
+			isCandidate[pBufferView->index()] = 0;
+		}
+
+		viewAccessors[pBufferView->index()].push_back(i);
+	}
+
+	// accessors within a view must not overlap, as each is repacked separately
+	vector<size_t> scanned;
+	for (size_t v = 0; v < viewCount; ++v) {
+		vector<size_t>& accessors = viewAccessors[v];
+		if (!isCandidate[v] || accessors.empty()) {
+			isCandidate[v] = 0;
+			continue;
+		}
+
+		std::sort(accessors.begin(), accessors.end(), [this](size_t a, size_t b) {
+			return _accessors[a]->byteOffset() < _accessors[b]->byteOffset();
+		});
+
+		size_t byteEnd = 0;
+		for (size_t a : accessors) {
+			const GLTFAccessor* pAccessor = _accessors[a];
+			isCandidate[v] = isCandidate[v] && pAccessor->byteOffset() >= byteEnd;
+			byteEnd = pAccessor->byteOffset() + pAccessor->elementCount() * pAccessor->elementByteSize();
+		}
+		isCandidate[v] = isCandidate[v] && byteEnd <= _bufferViews[v]->byteLength();
+
+		if (isCandidate[v]) {
+			scanned.insert(scanned.end(), accessors.begin(), accessors.end());
+		}
+	}
+
+	// scan largest accessors first, large accessors split themselves into further tasks
+	std::sort(scanned.begin(), scanned.end(), [this](size_t a, size_t b) {
+		const GLTFAccessor* pA = _accessors[a];
+		const GLTFAccessor* pB = _accessors[b];
+		return pA->elementCount() * pA->elementByteSize() > pB->elementCount() * pB->elementByteSize();
+	});
+
+	vector<uint32_t> minIndex(accessorCount, 0);
+	vector<uint32_t> maxIndex(accessorCount, 0);
+
+	TaskGroup group;
+	for (size_t a : scanned) {
+		const GLTFAccessor* pAccessor = _accessors[a];
+		if (pAccessor->component() == GLTFAccessorComponent::UNSIGNED_BYTE || pAccessor->elementCount() == 0) {
+			continue;
+		}
+
+		group.run([pAccessor, &minIndex, &maxIndex]() {
+			size_t i = pAccessor->index();
+			if (pAccessor->component() == GLTFAccessorComponent::UNSIGNED_SHORT) {
+				uint16_t min, max;
+				GLTFBounds::compute((const uint16_t*)pAccessor->data(), pAccessor->elementCount(), 1, &min, &max);
+				minIndex[i] = min;
+				maxIndex[i] = max;
+			}
+			else {
+				GLTFBounds::compute((const uint32_t*)pAccessor->data(), pAccessor->elementCount(), 1,
+					&minIndex[i], &maxIndex[i]);
+			}
+		});
+	}
+
+	group.wait();
+
+	// the largest value of a component type is reserved for primitive restart
+	auto narrowedSize = [allowUnsignedByte, &maxIndex](const GLTFAccessor* pAccessor) -> size_t {
+		size_t byteSize = pAccessor->elementByteSize();
+		uint32_t max = maxIndex[pAccessor->index()];
+		if (allowUnsignedByte && max < 0xff) {
+			return 1;
+		}
+		return flow::min(byteSize, size_t(max < 0xffff ? 2 : 4));
+	};
+
+	size_t narrowedCount = 0;
+	vector<char> packed;
+
+	for (size_t v = 0; v < viewCount; ++v) {
+		const vector<size_t>& accessors = viewAccessors[v];
+		if (!isCandidate[v]) {
+			continue;
+		}
+
+		bool isNarrowing = false;
+		for (size_t a : accessors) {
+			isNarrowing = isNarrowing || narrowedSize(_accessors[a]) < _accessors[a]->elementByteSize();
+		}
+		if (!isNarrowing) {
+			continue;
+		}
+
+		// repack all accessors of the view, each aligned to its new component size
+		packed.clear();
+		vector<size_t> offsets;
+
+		for (size_t a : accessors) {
+			const GLTFAccessor* pAccessor = _accessors[a];
+			size_t sourceSize = pAccessor->elementByteSize();
+			size_t size = narrowedSize(pAccessor);
+			size_t count = pAccessor->elementCount();
+			size_t offset = (packed.size() + size - 1) / size * size;
+			offsets.push_back(offset);
+			packed.resize(offset + count * size, 0);
+
+			const char* pSource = pAccessor->data();
+			char* pDest = packed.data() + offset;
+
+			for (size_t i = 0; i < count; ++i) {
+				uint32_t index = 0;
+				switch (sourceSize) {
+				case 1: index = uint8_t(pSource[i]); break;
+				case 2: { uint16_t value; std::memcpy(&value, pSource + i * 2, 2); index = value; break; }
+				default: std::memcpy(&index, pSource + i * 4, 4); break;
+				}
+
+				switch (size) {
+				case 1: pDest[i] = char(index); break;
+				case 2: { uint16_t value = uint16_t(index); std::memcpy(pDest + i * 2, &value, 2); break; }
+				default: std::memcpy(pDest + i * 4, &index, 4); break;
+				}
+			}
+		}
+
+		auto pBufferView = const_cast<GLTFBufferView*>(_bufferViews[v]);
+		std::memcpy(pBufferView->data(), packed.data(), packed.size());
+		pBufferView->_set(pBufferView->_pBuffer, pBufferView->byteOffset(), packed.size());
+
+		for (size_t a = 0; a < accessors.size(); ++a) {
+			auto pAccessor = const_cast<GLTFAccessor*>(_accessors[accessors[a]]);
+			size_t size = narrowedSize(pAccessor);
+
+			if (size == pAccessor->elementByteSize()) {
+				pAccessor->setBufferView(pBufferView, offsets[a]);
+				continue;
+			}
+
+			size_t i = pAccessor->index();
+			string name = pAccessor->name();
+			GLTFAccessor* pNarrowed;
+
+			if (size == 1) {
+				auto pAccessorT = _construct<GLTFAccessorT<uint8_t>>(_accessorArena, i, GLTFAccessorType::SCALAR, name);
+				pAccessorT->_min.assign(1, uint8_t(minIndex[i]));
+				pAccessorT->_max.assign(1, uint8_t(maxIndex[i]));
+				pNarrowed = pAccessorT;
+			}
+			else {
+				auto pAccessorT = _construct<GLTFAccessorT<uint16_t>>(_accessorArena, i, GLTFAccessorType::SCALAR, name);
+				pAccessorT->_min.assign(1, uint16_t(minIndex[i]));
+				pAccessorT->_max.assign(1, uint16_t(maxIndex[i]));
+				pNarrowed = pAccessorT;
+			}
+
+			pNarrowed->setBufferView(pBufferView, offsets[a]);
+			pNarrowed->setElementCount(pAccessor->elementCount());
+
+			// accessors with extensions aren't narrowed, extras are carried over
+			const json extras = pAccessor->extras();
+			if (!extras.is_null()) {
+				pNarrowed->setExtras(extras);
+			}
+
+			for (auto pMesh : _meshes) {
+				for (auto& primitive : const_cast<GLTFMesh*>(pMesh)->primitives()) {
+					if (primitive.indices() == pAccessor) {
+						primitive.setIndices(pNarrowed);
+					}
+				}
+			}
+
+			_accessors[i] = pNarrowed;
+			_destruct(pAccessor);
+			narrowedCount++;
+		}
+	}
+
+	return narrowedCount;
+}
+
+void GLTFAsset::_excludeCompressedViews(vector<char>& isCandidate) const
+{
+	for (auto pExtension : _ownedExtensions) {
+		auto pDraco = dynamic_cast<const GLTFDracoExtension*>(pExtension);
+		if (pDraco && pDraco->bufferView()) {
+			isCandidate[pDraco->bufferView()->index()] = 0;
+		}
+	}
+	for (auto pBufferView : _bufferViews) {
+		if (!pBufferView->extensions().empty() || pBufferView->buffer()->isFallback()) {
+			isCandidate[pBufferView->index()] = 0;
+		}
+	}
+}
+
+void GLTFAsset::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFElement::toJSON();
+	GLTFElement::_writeProperties(writer, context);
 
-	result["asset"] = _asset.toJSON();
+	writer.key("asset");
+	_asset.toJSON(writer, context);
 
 	if (_pMainScene) {
-		result["scene"] = _pMainScene->index();
+		writer.member("scene", _pMainScene->index());
 	}
 
 	if (!_extensionsUsed.empty()) {
-		json extensions = json::array();
+		writer.key("extensionsUsed").beginArray();
 		for (size_t i = 0; i < _extensionsUsed.size(); ++i) {
-			extensions.push_back(_extensionsUsed[i]->name());
+			writer.value(_extensionsUsed[i]->name());
 		}
-		result["extensionsUsed"] = extensions;
+		writer.endArray();
 	}
 	if (!_extensionsRequired.empty()) {
-		result["extensionsRequired"] = _extensionsRequired;
+		writer.key("extensionsRequired").array(_extensionsRequired);
 	}
 
-	_insertElements(result, "scenes", _scenes);
-	_insertElements(result, "nodes", _nodes);
-	_insertElements(result, "meshes", _meshes);
-	_insertElements(result, "skins", _skins);
-	_insertElements(result, "cameras", _cameras);
-	_insertElements(result, "buffers", _buffers);
-	_insertElements(result, "bufferViews", _bufferViews);
-	_insertElements(result, "accessors", _accessors);
-	_insertElements(result, "materials", _materials);
-	_insertElements(result, "textures", _textures);
-	_insertElements(result, "images", _images);
-	_insertElements(result, "samplers", _samplers);
-	_insertElements(result, "animations", _animations);
-	
-	return result;
+	_writeElements(writer, context, "scenes", _scenes);
+	_writeElements(writer, context, "nodes", _nodes);
+	_writeElements(writer, context, "meshes", _meshes);
+	_writeElements(writer, context, "skins", _skins);
+	_writeElements(writer, context, "cameras", _cameras);
+	if (context.isMergingBuffers()) {
+		writer.key("buffers").beginArray().beginObject();
+		writer.member("byteLength", context.mergedBufferLength());
+		writer.endObject();
+		for (auto pBuffer : _buffers) {
+			if (pBuffer->isFallback()) {
+				pBuffer->toJSON(writer, context);
+			}
+		}
+		writer.endArray();
+	}
+	else {
+		_writeElements(writer, context, "buffers", _buffers);
+	}
+	_writeElements(writer, context, "bufferViews", _bufferViews);
+	_writeElements(writer, context, "accessors", _accessors);
+	_writeElements(writer, context, "materials", _materials);
+	_writeElements(writer, context, "textures", _textures);
+	_writeElements(writer, context, "images", _images);
+	_writeElements(writer, context, "samplers", _samplers);
+	_writeElements(writer, context, "animations", _animations);
 }
 
-std::string GLTFAsset::toString(int indent /* = -1 */) const
+GLTFAsset::loadState_t GLTFAsset::_saveLoadState() const
 {
-	return toJSON().dump(indent);
+	loadState_t state;
+	state.element = *this;
+	state.asset = _asset;
+	state.pMainScene = _pMainScene;
+	state.extensionsUsed = _extensionsUsed.size();
+	state.extensionsRequired = _extensionsRequired.size();
+	state.ownedExtensions = _ownedExtensions.size();
+	state.scenes = _scenes.size();
+	state.nodes = _nodes.size();
+	state.meshes = _meshes.size();
+	state.skins = _skins.size();
+	state.cameras = _cameras.size();
+	state.buffers = _buffers.size();
+	state.bufferViews = _bufferViews.size();
+	state.accessors = _accessors.size();
+	state.materials = _materials.size();
+	state.textures = _textures.size();
+	state.images = _images.size();
+	state.samplers = _samplers.size();
+	state.animations = _animations.size();
+	return state;
+}
+
+void GLTFAsset::_restoreLoadState(const loadState_t& state)
+{
+	// the reader only appends elements, existing elements are unchanged;
+	// the arena memory of removed elements is reclaimed with the asset
+	GLTFElement::operator=(state.element);
+	_asset = state.asset;
+	_pMainScene = state.pMainScene;
+
+	_truncateVectorOfPointers(_extensionsUsed, state.extensionsUsed);
+	_extensionsRequired.resize(state.extensionsRequired);
+	_truncateVectorOfPointers(_ownedExtensions, state.ownedExtensions);
+	_destructVectorOfPointers(_scenes, state.scenes);
+	_destructVectorOfPointers(_nodes, state.nodes);
+	_destructVectorOfPointers(_meshes, state.meshes);
+	_destructVectorOfPointers(_skins, state.skins);
+	_destructVectorOfPointers(_cameras, state.cameras);
+	_destructVectorOfPointers(_buffers, state.buffers);
+	_destructVectorOfPointers(_bufferViews, state.bufferViews);
+	_destructVectorOfPointers(_accessors, state.accessors);
+	_destructVectorOfPointers(_materials, state.materials);
+	_destructVectorOfPointers(_textures, state.textures);
+	_destructVectorOfPointers(_images, state.images);
+	_destructVectorOfPointers(_samplers, state.samplers);
+	_destructVectorOfPointers(_animations, state.animations);
 }
 
 GLTFBufferView* GLTFAsset::_createBufferView(const string& name /* = string{} */)
 {
-	auto pBufferView = new GLTFBufferView(_bufferViews.size(), name);
+	auto pBufferView = _construct<GLTFBufferView>(_bufferViewArena, _bufferViews.size(), name);
 	_bufferViews.push_back(pBufferView);
 	return pBufferView;
 }
 
 template<typename T>
-void GLTFAsset::_insertElements(json& jsonObj, const string& propName, const vector<T*>& vector) const
+void GLTFAsset::_writeElements(JsonWriter& writer, const GLTFWriteContext& context,
+	const char* pPropName, const vector<T*>& vector) const
 {
 	if (vector.empty()) {
 		return;
 	}
 
-	auto arr = json::array();
+	writer.key(pPropName).beginArray();
 	for (auto it = vector.begin(); it != vector.end(); ++it) {
-		arr.emplace_back((*it)->toJSON());
+		(*it)->toJSON(writer, context);
+	}
+	writer.endArray();
+}
+
+bool GLTFAsset::_hasGenericBufferReferences() const
+{
+	for (auto pExtension : _ownedExtensions) {
+		auto pGeneric = dynamic_cast<const GLTFGenericExtension*>(pExtension);
+		if (pGeneric && _refersToBufferData(pGeneric->data())) {
+			return true;
+		}
+	}
+	return false;
+}
+
+template<typename T>
+void GLTFAsset::_removeUnused(vector<T*>& vector, const std::vector<bool>& isUsed)
+{
+	// remaining elements are renumbered, references are written using their new index
+	size_t count = 0;
+	for (size_t i = 0; i < vector.size(); ++i) {
+		if (isUsed[i]) {
+			const_cast<GLTFMainElement*>(static_cast<const GLTFMainElement*>(vector[i]))->_setIndex(count);
+			vector[count++] = vector[i];
+		}
+		else {
+			_destruct(vector[i]);
+		}
 	}
 
-	jsonObj[propName] = arr;
+	vector.resize(count);
+}
+
+template<typename T>
+void GLTFAsset::_reserveElements(vector<T*>& vector, MemoryArena& arena, size_t count, size_t elementSize)
+{
+	vector.reserve(vector.size() + count);
+	arena.reserve(count * elementSize);
 }
 
 template<typename T>
@@ -342,3 +1094,12 @@ void GLTFAsset::_deleteVectorOfPointers(vector<T*>& vector)
 	}
 }
 
+template<typename T>
+void GLTFAsset::_truncateVectorOfPointers(vector<T*>& vector, size_t size)
+{
+	for (size_t i = size; i < vector.size(); ++i) {
+		delete vector[i];
+	}
+
+	vector.resize(size);
+}
@@ -16,9 +16,12 @@
 #include "GLTFExtension.h"
 
 #include "../core/json.h"
+#include "../core/MemoryArena.h"
 
 #include <vector>
 #include <string>
+#include <utility>
+#include <new>
 
 
 namespace flow
@@ -29,6 +32,8 @@ namespace flow
 	class GLTFSkinNode;
 	class GLTFCameraNode;
 	class GLTFCamera;
+	class GLTFPerspectiveCamera;
+	class GLTFOrthographicCamera;
 	class GLTFMesh;
 	class GLTFBuffer;
 	class GLTFBufferView;
@@ -42,6 +47,12 @@ namespace flow
 	class F_GLTF_EXPORT GLTFAsset : public GLTFElement
 	{
 		friend class GLTFBuffer;
+		friend class GLBContainer;
+		friend class GLTFMeshQuantizer;
+		friend class GLTFMeshoptEncoder;
+		friend class GLTFDracoEncoder;
+		friend class GLTFMeshOptimizer;
+		friend class GLTFMeshletBuilder;
 
 	public:
 		// Types
@@ -64,11 +75,48 @@ namespace flow
 
 		typedef std::vector<const GLTFAnimation*> animationVec_t;
 
+		/// Time spent updating the bounds of an accessor.
+		struct boundsTiming_t
+		{
+			const GLTFAccessor* pAccessor;
+			double seconds;
+		};
+
+		typedef std::vector<boundsTiming_t> boundsTimingVec_t;
+
+		/// Numbers of elements to reserve storage for, see reserve().
+		struct elementCounts_t
+		{
+			size_t scenes = 0;
+			size_t nodes = 0;
+			size_t meshes = 0;
+			size_t skins = 0;
+			size_t cameras = 0;
+			size_t buffers = 0;
+			size_t bufferViews = 0;
+			size_t accessors = 0;
+			size_t materials = 0;
+			size_t textures = 0;
+			size_t images = 0;
+			size_t samplers = 0;
+			size_t animations = 0;
+		};
+
 		GLTFAsset();
 		virtual ~GLTFAsset();
 
 		bool saveGLTF(const std::string& gltfFilePath, int indent = -1);
 		bool saveGLB(const std::string& glbFilePath);
+		/// Loads a binary glTF file. The file is memory-mapped, buffer data is not copied.
+		/// If loading fails, all elements and settings read from the file are removed again
+		/// and loadError() describes the problem.
+		bool loadGLB(const std::string& glbFilePath);
+		/// Loads a glTF JSON file. Buffers referring to external files are memory-mapped
+		/// on first access to their data, loading doesn't touch any buffer contents.
+		/// Failed loads are undone as for loadGLB().
+		bool loadGLTF(const std::string& gltfFilePath);
+		/// Returns a description of the error of the last failed load.
+		const std::string& loadError() const { return _loadError; }
 
 		void setMainScene(const GLTFScene* pScene);
 		void setVersion(GLTFVersion version, GLTFVersion minVersion = GLTFVersion::UNDEFINED);
@@ -76,6 +124,18 @@ namespace flow
 		void setCopyright(const std::string& copyright);
 
 		void addExtension(const GLTFExtension* pExtension, bool isRequired);
+		/// Registers the extension with the given name as used, and as required if isRequired
+		/// is set. Nothing is added if the extension is already registered.
+		void useExtension(const char* pName, bool isRequired);
+
+		/// Reserves storage for the given numbers of additional elements, so creating them
+		/// doesn't allocate memory. Elements of each kind are stored contiguously in an
+		/// arena owned by the asset and released in bulk when the asset is destroyed.
+		void reserve(const elementCounts_t& counts);
+
+		/// Creates an extension which is owned by the asset and can be attached to its elements.
+		template<typename T, typename... Args>
+		T* createExtension(Args&&... args);
 
 		GLTFScene* createScene(const std::string& name = std::string{});
 
@@ -87,6 +147,8 @@ namespace flow
 		GLTFMesh* createMesh(const std::string& name = std::string{});
 		GLTFSkin* createSkin(const std::string& name = std::string{});
 		GLTFCamera* createCamera(const std::string& name = std::string{});
+		GLTFPerspectiveCamera* createPerspectiveCamera(const std::string& name = std::string{});
+		GLTFOrthographicCamera* createOrthographicCamera(const std::string& name = std::string{});
 
 		GLTFBuffer* createBuffer(const std::string& name = std::string{});
 		
@@ -106,19 +168,98 @@ namespace flow
 		GLTFSampler* createSampler();
 		GLTFAnimation* createAnimation();
 
+		/// Updates min and max of all accessors requiring bounds, i.e. accessors used as
+		/// POSITION attribute or morph target, or of all accessors with data if allAccessors
+		/// is true. Accessors are processed in parallel. Returns timings in accessor order.
+		boundsTimingVec_t updateAllBounds(bool allAccessors = false);
+
+		/// Removes accessors not used by any primitive, buffer views not used by any accessor,
+		/// image, compression or meshlet extension, and buffers without views. The data of
+		/// the remaining views is copied to a single segment per buffer, dropping unreferenced bytes.
+		/// Returns false without changes if an element carries a generic extension whose payload
+		/// refers to accessors, buffer views or buffers, as these indices can't be remapped.
+		bool compact();
+		/// Points accessors and images using buffer views with identical contents to a single
+		/// view, then compacts the asset. Views are compared by a hash of their data, computed
+		/// in parallel, and confirmed byte by byte. Views with compression extensions or
+		/// referenced by one are kept. Returns false without changes if compact() would fail.
+		bool deduplicate();
+		/// Rewrites index accessors to the smallest component type holding their largest
+		/// index, UNSIGNED_SHORT or, if allowUnsignedByte is true, UNSIGNED_BYTE. The maximum
+		/// is found with the vectorized GLTFBounds kernels. Narrowed indices are repacked in
+		/// place and the buffer view is shrunk; the freed bytes are dropped by compact().
+		/// Only views holding nothing but tightly packed index data are processed.
+		/// Narrowed accessors are replaced by new objects with the same index, pointers to
+		/// the old accessors become invalid. Returns the number of narrowed accessors.
+		size_t narrowIndices(bool allowUnsignedByte = true);
+
 		const bufferVec_t& buffers() const { return _buffers; }
 
-		virtual json toJSON() const;
-		virtual std::string toString(int indent = -1) const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
+		/// Asset settings and element counts, used to undo a failed load.
+		struct loadState_t
+		{
+			GLTFElement element;
+			GLTFAssetInfo asset;
+			const GLTFScene* pMainScene;
+			size_t extensionsUsed;
+			size_t extensionsRequired;
+			size_t ownedExtensions;
+			size_t scenes;
+			size_t nodes;
+			size_t meshes;
+			size_t skins;
+			size_t cameras;
+			size_t buffers;
+			size_t bufferViews;
+			size_t accessors;
+			size_t materials;
+			size_t textures;
+			size_t images;
+			size_t samplers;
+			size_t animations;
+		};
+
+		loadState_t _saveLoadState() const;
+		/// Deletes all elements created after the state was saved and restores the settings.
+		void _restoreLoadState(const loadState_t& state);
+
 		GLTFBufferView* _createBufferView(const std::string& name = std::string{});
+		/// True if a generic extension payload contains accessor, buffer view or buffer properties.
+		bool _hasGenericBufferReferences() const;
+		/// Clears the flag of views that are compressed, hold compressed data or fallback data.
+		void _excludeCompressedViews(std::vector<char>& isCandidate) const;
 
 		template<typename T>
-		void _insertElements(json& jsonObj, const std::string& propName, const std::vector<T*>& vector) const;
+		void _writeElements(JsonWriter& writer, const GLTFWriteContext& context,
+			const char* pPropName, const std::vector<T*>& vector) const;
+
+		template<typename T>
+		void _reserveElements(std::vector<T*>& vector, MemoryArena& arena, size_t count, size_t elementSize);
 
 		template<typename T>
 		void _deleteVectorOfPointers(std::vector<T*>& vector);
+		/// Deletes the elements beyond the given size and shrinks the vector to it.
+		template<typename T>
+		void _truncateVectorOfPointers(std::vector<T*>& vector, size_t size);
+
+		/// Constructs an element in the given arena.
+		template<typename T, typename... Args>
+		T* _construct(MemoryArena& arena, Args&&... args);
+		/// Destructs an element constructed in an arena, its memory is reclaimed with the arena.
+		template<typename T>
+		void _destruct(T* pElement);
+		template<typename T>
+		void _destructVectorOfPointers(std::vector<T*>& vector);
+		/// Destructs the elements beyond the given size and shrinks the vector to it.
+		template<typename T>
+		void _destructVectorOfPointers(std::vector<T*>& vector, size_t size);
+
+		template<typename T>
+		void _removeUnused(std::vector<T*>& vector, const std::vector<bool>& isUsed);
 
 		GLTFAssetInfo _asset;
 
@@ -126,6 +267,7 @@ namespace flow
 
 		extensionVec_t _extensionsUsed;
 		stringVec_t _extensionsRequired;
+		extensionVec_t _ownedExtensions;
 
 		sceneVec_t _scenes;
 		nodeVec_t _nodes;
@@ -144,15 +286,70 @@ namespace flow
 		samplerVec_t _samplers;
 
 		animationVec_t _animations;
+
+		std::string _loadError;
+
+		MemoryArena _sceneArena;
+		MemoryArena _nodeArena;
+		MemoryArena _meshArena;
+		MemoryArena _skinArena;
+		MemoryArena _cameraArena;
+		MemoryArena _bufferArena;
+		MemoryArena _bufferViewArena;
+		MemoryArena _accessorArena;
+		MemoryArena _materialArena;
+		MemoryArena _textureArena;
+		MemoryArena _imageArena;
+		MemoryArena _samplerArena;
+		MemoryArena _animationArena;
 	};
 
 	template<typename T>
 	GLTFAccessorT<T>* GLTFAsset::createAccessor(GLTFAccessorType type, std::string& name)
 	{
-		auto pAccessor = new GLTFAccessorT<T>(_accessors.size(), type, name);
+		auto pAccessor = _construct<GLTFAccessorT<T>>(_accessorArena, _accessors.size(), type, name);
 		_accessors.push_back(pAccessor);
 		return pAccessor;
 	}
+
+	template<typename T, typename... Args>
+	T* GLTFAsset::createExtension(Args&&... args)
+	{
+		auto pExtension = new T(std::forward<Args>(args)...);
+		_ownedExtensions.push_back(pExtension);
+		return pExtension;
+	}
+
+	template<typename T, typename... Args>
+	T* GLTFAsset::_construct(MemoryArena& arena, Args&&... args)
+	{
+		return new (arena.allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+	}
+
+	template<typename T>
+	void GLTFAsset::_destruct(T* pElement)
+	{
+		// destructors are virtual, this runs the destructor of the most derived type
+		pElement->~T();
+	}
+
+	template<typename T>
+	void GLTFAsset::_destructVectorOfPointers(std::vector<T*>& vector)
+	{
+		for (auto it = vector.begin(); it != vector.end(); ++it) {
+			_destruct(*it);
+		}
+	}
+
+	template<typename T>
+	void GLTFAsset::_destructVectorOfPointers(std::vector<T*>& vector, size_t size)
+	{
+		for (size_t i = size; i < vector.size(); ++i) {
+			_destruct(vector[i]);
+		}
+
+		vector.resize(size);
+	}
 }
 
 #endif // _FLOWLIBS_GLTF_OBJECT_H
@@ -7,6 +7,8 @@
 
 #include "GLTFAssetInfo.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -36,23 +38,21 @@ void GLTFAssetInfo::setMinVersion(GLTFVersion minVersion)
 	_minVersion = minVersion;
 }
 
-json GLTFAssetInfo::toJSON() const
+void GLTFAssetInfo::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFElement::toJSON();
+	GLTFElement::_writeProperties(writer, context);
 
-	result["version"] = _getVersionText(_version);
+	writer.member("version", _getVersionText(_version));
 
 	if (!_copyright.empty()) {
-		result["copyright"] = _copyright;
+		writer.member("copyright", _copyright);
 	}
 	if (!_generator.empty()) {
-		result["generator"] = _generator;
+		writer.member("generator", _generator);
 	}
 	if (_minVersion != GLTFVersion::UNDEFINED) {
-		result["minVersion"] = _getVersionText(_minVersion);
+		writer.member("minVersion", _getVersionText(_minVersion));
 	}
-
-	return result;
 }
 
 const char* GLTFAssetInfo::_getVersionText(GLTFVersion version) const
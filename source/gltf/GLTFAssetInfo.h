@@ -32,7 +32,8 @@ namespace flow
 		GLTFVersion version() const { return _version; }
 		GLTFVersion minVersion() const { return _minVersion; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		const char* _getVersionText(GLTFVersion version) const;
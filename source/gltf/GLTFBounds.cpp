@@ -0,0 +1,320 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFBounds.h"
+
+#include "../core/ThreadPool.h"
+
+#include <vector>
+#include <cstring>
+
+#if defined(__AVX2__)
+#  include <immintrin.h>
+#  define F_BOUNDS_AVX2
+#elif defined(FLOW_SSE41)
+#  include <smmintrin.h>
+#  define F_BOUNDS_SSE41
+#endif
+
+using namespace flow;
+
+
+const size_t GLTFBounds::PARALLEL_THRESHOLD;
+
+namespace
+{
+	constexpr size_t _gcd(size_t a, size_t b) { return b == 0 ? a : _gcd(b, a % b); }
+	constexpr size_t _lcm(size_t a, size_t b) { return a / _gcd(a, b) * b; }
+
+#if defined(F_BOUNDS_AVX2) || defined(F_BOUNDS_SSE41)
+
+	template<typename T>
+	struct _Ops;
+
+#  if defined(F_BOUNDS_AVX2)
+
+#    define F_BOUNDS_INT_OPS(TYPE, MINMAX, SET1, SET1TYPE) \
+	template<> struct _Ops<TYPE> { \
+		typedef __m256i vec_t; \
+		static vec_t load(const TYPE* p) { return _mm256_loadu_si256((const __m256i*)p); } \
+		static void store(TYPE* p, vec_t v) { _mm256_storeu_si256((__m256i*)p, v); } \
+		static vec_t set1(TYPE v) { return _mm256_set1_##SET1(SET1TYPE(v)); } \
+		static vec_t min(vec_t a, vec_t b) { return _mm256_min_##MINMAX(a, b); } \
+		static vec_t max(vec_t a, vec_t b) { return _mm256_max_##MINMAX(a, b); } \
+	};
+
+	template<> struct _Ops<float>
+	{
+		typedef __m256 vec_t;
+		static vec_t load(const float* p) { return _mm256_loadu_ps(p); }
+		static void store(float* p, vec_t v) { _mm256_storeu_ps(p, v); }
+		static vec_t set1(float v) { return _mm256_set1_ps(v); }
+		static vec_t min(vec_t a, vec_t b) { return _mm256_min_ps(a, b); }
+		static vec_t max(vec_t a, vec_t b) { return _mm256_max_ps(a, b); }
+	};
+
+#  else
+
+#    define F_BOUNDS_INT_OPS(TYPE, MINMAX, SET1, SET1TYPE) \
+	template<> struct _Ops<TYPE> { \
+		typedef __m128i vec_t; \
+		static vec_t load(const TYPE* p) { return _mm_loadu_si128((const __m128i*)p); } \
+		static void store(TYPE* p, vec_t v) { _mm_storeu_si128((__m128i*)p, v); } \
+		static vec_t set1(TYPE v) { return _mm_set1_##SET1(SET1TYPE(v)); } \
+		static vec_t min(vec_t a, vec_t b) { return _mm_min_##MINMAX(a, b); } \
+		static vec_t max(vec_t a, vec_t b) { return _mm_max_##MINMAX(a, b); } \
+	};
+
+	template<> struct _Ops<float>
+	{
+		typedef __m128 vec_t;
+		static vec_t load(const float* p) { return _mm_loadu_ps(p); }
+		static void store(float* p, vec_t v) { _mm_storeu_ps(p, v); }
+		static vec_t set1(float v) { return _mm_set1_ps(v); }
+		static vec_t min(vec_t a, vec_t b) { return _mm_min_ps(a, b); }
+		static vec_t max(vec_t a, vec_t b) { return _mm_max_ps(a, b); }
+	};
+
+#  endif
+
+	F_BOUNDS_INT_OPS(int8_t, epi8, epi8, char)
+	F_BOUNDS_INT_OPS(uint8_t, epu8, epi8, char)
+	F_BOUNDS_INT_OPS(int16_t, epi16, epi16, short)
+	F_BOUNDS_INT_OPS(uint16_t, epu16, epi16, short)
+	F_BOUNDS_INT_OPS(int32_t, epi32, epi32, int)
+	F_BOUNDS_INT_OPS(uint32_t, epu32, epi32, int)
+
+#  undef F_BOUNDS_INT_OPS
+
+	/// Vectorized kernel. Elements are processed in periods of VC vectors, the smallest
+	/// multiple of both the lane count and the component count, so lane k of a period
+	/// always holds component k % CC and can be accumulated without shuffling.
+	template<typename T, size_t CC>
+	void _computeVectorized(const T* pData, size_t elementCount, T* pMin, T* pMax)
+	{
+		typedef _Ops<T> ops_t;
+		typedef typename ops_t::vec_t vec_t;
+
+		const size_t LC = sizeof(vec_t) / sizeof(T);
+		const size_t VC = _lcm(CC, LC) / LC;
+		const size_t PERIOD = VC * LC;
+
+		vec_t vMin[VC], vMax[VC];
+		for (size_t v = 0; v < VC; ++v) {
+			vMin[v] = ops_t::set1(std::numeric_limits<T>::max());
+			vMax[v] = ops_t::set1(std::numeric_limits<T>::lowest());
+		}
+
+		size_t periodCount = elementCount / (PERIOD / CC);
+		const T* p = pData;
+
+		for (size_t i = 0; i < periodCount; ++i, p += PERIOD) {
+			for (size_t v = 0; v < VC; ++v) {
+				vec_t x = ops_t::load(p + v * LC);
+				vMin[v] = ops_t::min(vMin[v], x);
+				vMax[v] = ops_t::max(vMax[v], x);
+			}
+		}
+
+		// remaining elements
+		size_t tailCount = elementCount - periodCount * (PERIOD / CC);
+		GLTFBounds::computeScalar(p, tailCount, CC, pMin, pMax);
+
+		// reduce lanes to components
+		T laneMin[PERIOD], laneMax[PERIOD];
+		for (size_t v = 0; v < VC; ++v) {
+			ops_t::store(laneMin + v * LC, vMin[v]);
+			ops_t::store(laneMax + v * LC, vMax[v]);
+		}
+
+		for (size_t k = 0; k < PERIOD; ++k) {
+			pMin[k % CC] = flow::min(pMin[k % CC], laneMin[k]);
+			pMax[k % CC] = flow::max(pMax[k % CC], laneMax[k]);
+		}
+	}
+
+	template<typename T>
+	void _computeRange(const T* pData, size_t elementCount, size_t componentCount, T* pMin, T* pMax)
+	{
+		// component counts of the glTF accessor types
+		switch (componentCount) {
+		case 1: _computeVectorized<T, 1>(pData, elementCount, pMin, pMax); return;
+		case 2: _computeVectorized<T, 2>(pData, elementCount, pMin, pMax); return;
+		case 3: _computeVectorized<T, 3>(pData, elementCount, pMin, pMax); return;
+		case 4: _computeVectorized<T, 4>(pData, elementCount, pMin, pMax); return;
+		case 9: _computeVectorized<T, 9>(pData, elementCount, pMin, pMax); return;
+		case 16: _computeVectorized<T, 16>(pData, elementCount, pMin, pMax); return;
+		default: GLTFBounds::computeScalar(pData, elementCount, componentCount, pMin, pMax); return;
+		}
+	}
+
+#else
+
+	template<typename T>
+	void _computeRange(const T* pData, size_t elementCount, size_t componentCount, T* pMin, T* pMax)
+	{
+		GLTFBounds::computeScalar(pData, elementCount, componentCount, pMin, pMax);
+	}
+
+#endif
+
+	template<typename T>
+	void _compute(const T* pData, size_t elementCount, size_t componentCount, T* pMin, T* pMax)
+	{
+		if (elementCount * componentCount < 2 * GLTFBounds::PARALLEL_THRESHOLD) {
+			_computeRange(pData, elementCount, componentCount, pMin, pMax);
+			return;
+		}
+
+		// split into contiguous element ranges, each range writes its own partial result
+		size_t grainSize = GLTFBounds::PARALLEL_THRESHOLD / componentCount;
+		size_t rangeCount = (elementCount + grainSize - 1) / grainSize;
+		std::vector<T> partials(2 * rangeCount * componentCount);
+
+		ThreadPool::instance()->parallelFor(0, elementCount, grainSize, [&](size_t first, size_t last) {
+			T* pPartial = &partials[2 * (first / grainSize) * componentCount];
+			_computeRange(pData + first * componentCount, last - first, componentCount,
+				pPartial, pPartial + componentCount);
+		});
+
+		// initialize min and max
+		GLTFBounds::computeScalar(pData, 0, componentCount, pMin, pMax);
+
+		for (size_t r = 0; r < rangeCount; ++r) {
+			const T* pPartial = &partials[2 * r * componentCount];
+			for (size_t j = 0; j < componentCount; ++j) {
+				pMin[j] = flow::min(pMin[j], pPartial[j]);
+				pMax[j] = flow::max(pMax[j], pPartial[componentCount + j]);
+			}
+		}
+	}
+
+	template<typename T>
+	void _computeInterleaved(const T* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+		T* pMin, T* pMax)
+	{
+		// each range gathers chunks of elements for the packed kernels, and writes its own partial result
+		const size_t chunkSize = 1024;
+		size_t grainSize = elementCount;
+		if (elementCount * componentCount >= 2 * GLTFBounds::PARALLEL_THRESHOLD) {
+			grainSize = flow::max(GLTFBounds::PARALLEL_THRESHOLD / componentCount, chunkSize);
+		}
+
+		size_t rangeCount = elementCount > 0 ? (elementCount + grainSize - 1) / grainSize : 0;
+		std::vector<T> partials(2 * rangeCount * componentCount);
+
+		ThreadPool::instance()->parallelFor(0, elementCount, grainSize, [&](size_t first, size_t last) {
+			T* pPartial = &partials[2 * (first / grainSize) * componentCount];
+			T* pPartialMax = pPartial + componentCount;
+			GLTFBounds::computeScalar(pData, 0, componentCount, pPartial, pPartialMax);
+
+			std::vector<T> chunk(chunkSize * componentCount);
+			std::vector<T> chunkMin(componentCount), chunkMax(componentCount);
+			const char* pElement = (const char*)pData + first * byteStride;
+
+			for (size_t i = first; i < last; i += chunkSize) {
+				size_t count = flow::min(chunkSize, last - i);
+				for (size_t k = 0; k < count; ++k, pElement += byteStride) {
+					std::memcpy(&chunk[k * componentCount], pElement, componentCount * sizeof(T));
+				}
+
+				_computeRange(chunk.data(), count, componentCount, chunkMin.data(), chunkMax.data());
+				for (size_t j = 0; j < componentCount; ++j) {
+					pPartial[j] = flow::min(pPartial[j], chunkMin[j]);
+					pPartialMax[j] = flow::max(pPartialMax[j], chunkMax[j]);
+				}
+			}
+		});
+
+		GLTFBounds::computeScalar(pData, 0, componentCount, pMin, pMax);
+
+		for (size_t r = 0; r < rangeCount; ++r) {
+			const T* pPartial = &partials[2 * r * componentCount];
+			for (size_t j = 0; j < componentCount; ++j) {
+				pMin[j] = flow::min(pMin[j], pPartial[j]);
+				pMax[j] = flow::max(pMax[j], pPartial[componentCount + j]);
+			}
+		}
+	}
+}
+
+void GLTFBounds::compute(const int8_t* pData, size_t elementCount, size_t componentCount, int8_t* pMin, int8_t* pMax)
+{
+	_compute(pData, elementCount, componentCount, pMin, pMax);
+}
+
+void GLTFBounds::compute(const uint8_t* pData, size_t elementCount, size_t componentCount, uint8_t* pMin, uint8_t* pMax)
+{
+	_compute(pData, elementCount, componentCount, pMin, pMax);
+}
+
+void GLTFBounds::compute(const int16_t* pData, size_t elementCount, size_t componentCount, int16_t* pMin, int16_t* pMax)
+{
+	_compute(pData, elementCount, componentCount, pMin, pMax);
+}
+
+void GLTFBounds::compute(const uint16_t* pData, size_t elementCount, size_t componentCount, uint16_t* pMin, uint16_t* pMax)
+{
+	_compute(pData, elementCount, componentCount, pMin, pMax);
+}
+
+void GLTFBounds::compute(const int32_t* pData, size_t elementCount, size_t componentCount, int32_t* pMin, int32_t* pMax)
+{
+	_compute(pData, elementCount, componentCount, pMin, pMax);
+}
+
+void GLTFBounds::compute(const uint32_t* pData, size_t elementCount, size_t componentCount, uint32_t* pMin, uint32_t* pMax)
+{
+	_compute(pData, elementCount, componentCount, pMin, pMax);
+}
+
+void GLTFBounds::compute(const float* pData, size_t elementCount, size_t componentCount, float* pMin, float* pMax)
+{
+	_compute(pData, elementCount, componentCount, pMin, pMax);
+}
+
+void GLTFBounds::computeInterleaved(const int8_t* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	int8_t* pMin, int8_t* pMax)
+{
+	_computeInterleaved(pData, elementCount, componentCount, byteStride, pMin, pMax);
+}
+
+void GLTFBounds::computeInterleaved(const uint8_t* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	uint8_t* pMin, uint8_t* pMax)
+{
+	_computeInterleaved(pData, elementCount, componentCount, byteStride, pMin, pMax);
+}
+
+void GLTFBounds::computeInterleaved(const int16_t* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	int16_t* pMin, int16_t* pMax)
+{
+	_computeInterleaved(pData, elementCount, componentCount, byteStride, pMin, pMax);
+}
+
+void GLTFBounds::computeInterleaved(const uint16_t* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	uint16_t* pMin, uint16_t* pMax)
+{
+	_computeInterleaved(pData, elementCount, componentCount, byteStride, pMin, pMax);
+}
+
+void GLTFBounds::computeInterleaved(const int32_t* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	int32_t* pMin, int32_t* pMax)
+{
+	_computeInterleaved(pData, elementCount, componentCount, byteStride, pMin, pMax);
+}
+
+void GLTFBounds::computeInterleaved(const uint32_t* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	uint32_t* pMin, uint32_t* pMax)
+{
+	_computeInterleaved(pData, elementCount, componentCount, byteStride, pMin, pMax);
+}
+
+void GLTFBounds::computeInterleaved(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	float* pMin, float* pMax)
+{
+	_computeInterleaved(pData, elementCount, componentCount, byteStride, pMin, pMax);
+}
@@ -0,0 +1,103 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_BOUNDS_H
+#define _FLOWLIBS_GLTF_BOUNDS_H
+
+#include "library.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+
+namespace flow
+{
+	/// Computes per-component minimum and maximum values of accessor data. Kernels for all
+	/// glTF component types are vectorized with SSE4.1, or AVX2 if enabled at compile time.
+	/// Interleaved data is gathered in chunks for the same kernels. Large inputs are split
+	/// across threads and the partial results reduced.
+	class F_GLTF_EXPORT GLTFBounds
+	{
+	public:
+		/// Deleted constructor. Class provides only static methods.
+		GLTFBounds() = delete;
+
+		/// Computes min and max of each component over elementCount elements with
+		/// componentCount components each. pMin and pMax receive componentCount values.
+		static void compute(const int8_t* pData, size_t elementCount, size_t componentCount, int8_t* pMin, int8_t* pMax);
+		static void compute(const uint8_t* pData, size_t elementCount, size_t componentCount, uint8_t* pMin, uint8_t* pMax);
+		static void compute(const int16_t* pData, size_t elementCount, size_t componentCount, int16_t* pMin, int16_t* pMax);
+		static void compute(const uint16_t* pData, size_t elementCount, size_t componentCount, uint16_t* pMin, uint16_t* pMax);
+		static void compute(const int32_t* pData, size_t elementCount, size_t componentCount, int32_t* pMin, int32_t* pMax);
+		static void compute(const uint32_t* pData, size_t elementCount, size_t componentCount, uint32_t* pMin, uint32_t* pMax);
+		static void compute(const float* pData, size_t elementCount, size_t componentCount, float* pMin, float* pMax);
+
+		/// Fallback for component types without a vectorized kernel.
+		template<typename T>
+		static void compute(const T* pData, size_t elementCount, size_t componentCount, T* pMin, T* pMax) {
+			computeScalar(pData, elementCount, componentCount, pMin, pMax);
+		}
+
+		/// Computes min and max of interleaved elements, whose starts are byteStride bytes apart.
+		/// Each thread gathers chunks of elements into a packed array for the kernels above.
+		static void computeInterleaved(const int8_t* pData, size_t elementCount, size_t componentCount, size_t byteStride, int8_t* pMin, int8_t* pMax);
+		static void computeInterleaved(const uint8_t* pData, size_t elementCount, size_t componentCount, size_t byteStride, uint8_t* pMin, uint8_t* pMax);
+		static void computeInterleaved(const int16_t* pData, size_t elementCount, size_t componentCount, size_t byteStride, int16_t* pMin, int16_t* pMax);
+		static void computeInterleaved(const uint16_t* pData, size_t elementCount, size_t componentCount, size_t byteStride, uint16_t* pMin, uint16_t* pMax);
+		static void computeInterleaved(const int32_t* pData, size_t elementCount, size_t componentCount, size_t byteStride, int32_t* pMin, int32_t* pMax);
+		static void computeInterleaved(const uint32_t* pData, size_t elementCount, size_t componentCount, size_t byteStride, uint32_t* pMin, uint32_t* pMax);
+		static void computeInterleaved(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride, float* pMin, float* pMax);
+
+		/// Fallback for component types without a vectorized kernel.
+		template<typename T>
+		static void computeInterleaved(const T* pData, size_t elementCount, size_t componentCount, size_t byteStride, T* pMin, T* pMax);
+
+		/// Single-threaded scalar reference implementation.
+		template<typename T>
+		static void computeScalar(const T* pData, size_t elementCount, size_t componentCount, T* pMin, T* pMax);
+
+		/// Number of components processed per parallel task, smaller inputs are not split.
+		static const size_t PARALLEL_THRESHOLD = 1 << 20;
+	};
+
+	template<typename T>
+	void GLTFBounds::computeInterleaved(const T* pData, size_t elementCount, size_t componentCount, size_t byteStride, T* pMin, T* pMax)
+	{
+		computeScalar(pData, 0, componentCount, pMin, pMax);
+
+		const char* pElement = (const char*)pData;
+		for (size_t i = 0; i < elementCount; ++i, pElement += byteStride) {
+			for (size_t j = 0; j < componentCount; ++j) {
+				T value;
+				std::memcpy(&value, pElement + j * sizeof(T), sizeof(T));
+				pMin[j] = flow::min(pMin[j], value);
+				pMax[j] = flow::max(pMax[j], value);
+			}
+		}
+	}
+
+	template<typename T>
+	void GLTFBounds::computeScalar(const T* pData, size_t elementCount, size_t componentCount, T* pMin, T* pMax)
+	{
+		for (size_t j = 0; j < componentCount; ++j) {
+			pMin[j] = std::numeric_limits<T>::max();
+			pMax[j] = std::numeric_limits<T>::lowest();
+		}
+
+		for (size_t i = 0; i < elementCount; ++i) {
+			const T* pElem = pData + i * componentCount;
+			for (size_t j = 0; j < componentCount; ++j) {
+				pMin[j] = flow::min(pMin[j], pElem[j]);
+				pMax[j] = flow::max(pMax[j], pElem[j]);
+			}
+		}
+	}
+}
+
+#endif // _FLOWLIBS_GLTF_BOUNDS_H
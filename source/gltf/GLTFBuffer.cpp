@@ -11,9 +11,12 @@
 #include "GLTFAsset.h"
 
 #include "../core/Bit.h"
+#include "../core/MappedFile.h"
+#include "../core/JsonWriter.h"
 
 #include <fstream>
 #include <cstring>
+#include <algorithm>
 
 using namespace flow;
 using std::string;
@@ -22,9 +25,15 @@ using std::ofstream;
 using std::ios;
 
 
+const size_t GLTFBuffer::_MIN_SEGMENT_SIZE;
+const size_t GLTFBuffer::_MAX_SEGMENT_SIZE;
+
+
 GLTFBuffer::GLTFBuffer(GLTFAsset* pAsset, size_t index, const string& name /* = string{} */) :
 	GLTFMainElement(index, name),
-	_pAsset(pAsset)
+	_pAsset(pAsset),
+	_isPending(false),
+	_isFallback(false)
 {
 }
 
@@ -36,6 +45,14 @@ GLTFBufferView* GLTFBuffer::addData(const char* pData, size_t byteLength, bool a
 	return pBufferView;
 }
 
+size_t GLTFBuffer::appendData(const char* pData, size_t byteLength, bool align /* = true */)
+{
+	size_t byteOffset = _allocate(byteLength, align);
+	std::memcpy(data(byteOffset), pData, byteLength);
+
+	return byteOffset;
+}
+
 GLTFBufferView* GLTFBuffer::addImage(const string& imageFilePath)
 {
 	ifstream stream(imageFilePath, ios::in | ios::ate | ios::binary);
@@ -56,44 +73,325 @@ GLTFBufferView* GLTFBuffer::addImage(const string& imageFilePath)
 
 GLTFBufferView* GLTFBuffer::allocate(size_t byteLength, bool align)
 {
-	size_t byteStart = align ? Bit::ceil4(_buffer.size()) : _buffer.size();
-	size_t newBufferSize = byteStart + byteLength;
+	size_t byteOffset = _allocate(byteLength, align);
 
-	_buffer.resize(newBufferSize);
+	auto pBufferView = _pAsset->_createBufferView();
+	pBufferView->_set(this, byteOffset, byteLength);
+	return pBufferView;
+}
+
+GLTFBufferView* GLTFBuffer::createView(size_t byteOffset, size_t byteLength, size_t byteStride /* = 0 */)
+{
+	if (byteOffset + byteLength > this->byteLength()) {
+		return nullptr;
+	}
+
+	const segment_t* pSegment = _findSegment(byteOffset);
+	if (!pSegment || byteOffset + byteLength > pSegment->byteOffset + pSegment->byteLength) {
+		return nullptr;
+	}
 
 	auto pBufferView = _pAsset->_createBufferView();
-	pBufferView->_set(this, byteStart, byteLength);
+	pBufferView->_set(this, byteOffset, byteLength, byteStride);
 	return pBufferView;
 }
 
+bool GLTFBuffer::adoptView(GLTFBufferView* pBufferView)
+{
+	size_t byteLength = pBufferView->byteLength();
+	size_t byteOffset = 0;
+
+	if (_isFallback) {
+		byteOffset = _reserve(byteLength);
+	}
+	else {
+		const char* pData = pBufferView->data();
+		if (!pData) {
+			return false;
+		}
+
+		byteOffset = _allocate(byteLength, true);
+		std::memcpy(data(byteOffset), pData, byteLength);
+	}
+
+	pBufferView->_set(this, byteOffset, byteLength, pBufferView->byteStride());
+	return true;
+}
+
+void GLTFBuffer::setMappedData(std::shared_ptr<MappedFile> pFile, size_t byteOffset, size_t byteLength)
+{
+	F_ASSERT(pFile && byteOffset + byteLength <= pFile->byteLength());
+
+	_segments.clear();
+	_blocks.clear();
+
+	_pMappedFile = pFile;
+	_externalFilePath.clear();
+	_isPending = false;
+
+	segment_t segment = { pFile->data() + byteOffset, 0, byteLength, byteLength };
+	_segments.push_back(segment);
+}
+
+void GLTFBuffer::setExternalFile(const string& filePath, size_t byteLength)
+{
+	_segments.clear();
+	_blocks.clear();
+
+	_pMappedFile.reset();
+	_externalFilePath = filePath;
+	_isPending = true;
+
+	// placeholder segment, the data pointer is set when the file is mapped
+	segment_t segment = { nullptr, 0, byteLength, byteLength };
+	_segments.push_back(segment);
+}
 
 void GLTFBuffer::setUri(const string& uri)
 {
 	_uri = uri;
 }
 
+void GLTFBuffer::setFallback(bool isFallback)
+{
+	_isFallback = isFallback;
+}
+
 bool GLTFBuffer::save(const string& bufferFilePath)
 {
+	for (auto& segment : segments()) {
+		if (!segment.pData) {
+			return false;
+		}
+	}
+
 	ofstream stream(bufferFilePath, ios::out | ios::binary);
 	if (!stream.is_open()) {
 		return false;
 	}
 
-	stream.write(_buffer.data(), _buffer.size());
+	const uint32_t zero = 0;
+	size_t byteOffset = 0;
+
+	for (auto& segment : _segments) {
+		stream.write((const char*)&zero, segment.byteOffset - byteOffset);
+		stream.write(segment.pData, segment.byteLength);
+		byteOffset = segment.byteOffset + segment.byteLength;
+	}
+
+	bool success = stream.good();
 	stream.close();
+	return success;
+}
+
+char* GLTFBuffer::data(size_t byteOffset /* = 0 */)
+{
+	const segment_t* pSegment = _findSegment(byteOffset);
+	if (!pSegment) {
+		return nullptr;
+	}
+
+	if (_isPending) {
+		_mapExternalFile();
+	}
+
+	return pSegment->pData ? pSegment->pData + (byteOffset - pSegment->byteOffset) : nullptr;
+}
+
+const char* GLTFBuffer::data(size_t byteOffset /* = 0 */) const
+{
+	return const_cast<GLTFBuffer*>(this)->data(byteOffset);
+}
+
+const GLTFBuffer::segmentVec_t& GLTFBuffer::segments() const
+{
+	if (_isPending) {
+		_mapExternalFile();
+	}
+
+	return _segments;
+}
+
+size_t GLTFBuffer::byteLength() const
+{
+	if (_segments.empty()) {
+		return 0;
+	}
+
+	const segment_t& segment = _segments.back();
+	return segment.byteOffset + segment.byteLength;
+}
+
+void GLTFBuffer::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
+{
+	GLTFMainElement::_writeProperties(writer, context);
+
+	writer.member("byteLength", byteLength());
+
+	if (!_uri.empty() && !_isFallback) {
+		writer.member("uri", _uri);
+	}
+}
+
+
+bool GLTFBuffer::_repack(const rangeVec_t& ranges, std::vector<size_t>& offsets)
+{
+	if (!_isFallback) {
+		for (auto& range : ranges) {
+			if (range.byteLength > 0 && !data(range.byteOffset)) {
+				return false;
+			}
+		}
+	}
+
+	// process ranges in ascending order, overlapping ranges form a single run
+	std::vector<size_t> order(ranges.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&ranges](size_t a, size_t b) {
+		return ranges[a].byteOffset < ranges[b].byteOffset;
+	});
+
+	struct run_t
+	{
+		size_t sourceOffset;
+		size_t byteOffset;
+		size_t byteLength;
+	};
+
+	std::vector<run_t> runs;
+	offsets.resize(ranges.size());
+	size_t byteLength = 0;
+
+	for (size_t i : order) {
+		size_t rangeStart = ranges[i].byteOffset;
+		size_t rangeEnd = rangeStart + ranges[i].byteLength;
+
+		if (runs.empty() || rangeStart >= runs.back().sourceOffset + runs.back().byteLength) {
+			runs.push_back({ rangeStart, Bit::ceil4(byteLength), 0 });
+		}
+
+		run_t& run = runs.back();
+		run.byteLength = std::max(run.byteLength, rangeEnd - run.sourceOffset);
+		offsets[i] = run.byteOffset + (rangeStart - run.sourceOffset);
+		byteLength = run.byteOffset + run.byteLength;
+	}
+
+	if (byteLength >= this->byteLength()) {
+		for (size_t i = 0; i < ranges.size(); ++i) {
+			offsets[i] = ranges[i].byteOffset;
+		}
+		return true;
+	}
+
+	if (_isFallback) {
+		_segments.clear();
+		_blocks.clear();
+
+		segment_t segment = { nullptr, 0, byteLength, byteLength };
+		_segments.push_back(segment);
+		return true;
+	}
+
+	// runs lie within a single segment, as each view does
+	std::unique_ptr<char[]> block(new char[std::max(byteLength, size_t(1))]);
+	std::memset(block.get(), 0, byteLength);
+	for (auto& run : runs) {
+		std::memcpy(block.get() + run.byteOffset, data(run.sourceOffset), run.byteLength);
+	}
+
+	_segments.clear();
+	_blocks.clear();
+	_pMappedFile.reset();
+	_externalFilePath.clear();
+	_isPending = false;
+
+	segment_t segment = { block.get(), 0, byteLength, byteLength };
+	_segments.push_back(segment);
+	_blocks.push_back(std::move(block));
+
 	return true;
 }
 
-json GLTFBuffer::toJSON() const
+size_t GLTFBuffer::_allocate(size_t byteLength, bool align)
 {
-	json result = GLTFMainElement::toJSON();
+	size_t byteEnd = this->byteLength();
+	size_t byteStart = align ? Bit::ceil4(byteEnd) : byteEnd;
 
-	result["byteLength"] = _buffer.size();
+	// the allocation must fit into the last segment, otherwise start a new one
+	segment_t* pSegment = _segments.empty() ? nullptr : &_segments.back();
+	if (!pSegment || !pSegment->pData || byteStart + byteLength > pSegment->byteOffset + pSegment->capacity) {
+		pSegment = _addSegment(byteLength);
+		byteStart = byteEnd = pSegment->byteOffset;
+	}
+
+	// zero alignment padding and new data
+	size_t segmentEnd = byteStart - pSegment->byteOffset + byteLength;
+	std::memset(pSegment->pData + pSegment->byteLength, 0, segmentEnd - pSegment->byteLength);
+	pSegment->byteLength = segmentEnd;
+
+	return byteStart;
+}
 
-	if (!_uri.empty()) {
-		result["uri"] = _uri;
+size_t GLTFBuffer::_reserve(size_t byteLength)
+{
+	size_t byteStart = Bit::ceil4(this->byteLength());
+
+	// consecutive reserved ranges share a segment without data
+	if (_segments.empty() || _segments.back().pData || _isPending) {
+		segment_t segment = { nullptr, byteStart, 0, 0 };
+		_segments.push_back(segment);
 	}
 
-	return result;
+	segment_t& segment = _segments.back();
+	segment.byteLength = byteStart + byteLength - segment.byteOffset;
+	segment.capacity = segment.byteLength;
+
+	return byteStart;
 }
 
+GLTFBuffer::segment_t* GLTFBuffer::_addSegment(size_t minCapacity)
+{
+	// segment sizes grow geometrically, large allocations get a segment of their own
+	size_t capacity = _MIN_SEGMENT_SIZE;
+	if (!_segments.empty()) {
+		capacity = std::min(_segments.back().capacity * 2, _MAX_SEGMENT_SIZE);
+	}
+
+	capacity = std::max(capacity, Bit::ceil4(minCapacity));
+
+	_blocks.emplace_back(new char[capacity]);
+
+	segment_t segment = { _blocks.back().get(), Bit::ceil4(byteLength()), 0, capacity };
+	_segments.push_back(segment);
+	return &_segments.back();
+}
+
+void GLTFBuffer::_mapExternalFile() const
+{
+	// several threads may access the data of a pending buffer at the same time
+	std::lock_guard<std::mutex> lock(_mapMutex);
+	if (!_isPending) {
+		return;
+	}
+
+	auto pFile = MappedFile::open(_externalFilePath);
+	segment_t& segment = const_cast<segment_t&>(_segments.front());
+
+	if (pFile && pFile->byteLength() >= segment.byteLength) {
+		const_cast<GLTFBuffer*>(this)->_pMappedFile = pFile;
+		segment.pData = pFile->data();
+	}
+
+	_isPending = false;
+}
+
+const GLTFBuffer::segment_t* GLTFBuffer::_findSegment(size_t byteOffset) const
+{
+	// last segment starting at or before the offset
+	auto it = std::upper_bound(_segments.begin(), _segments.end(), byteOffset,
+		[](size_t offset, const segment_t& segment) { return offset < segment.byteOffset; });
+
+	return it == _segments.begin() ? nullptr : &*(it - 1);
+}
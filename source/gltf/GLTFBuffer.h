@@ -17,41 +17,131 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
 
 
 namespace flow
 {
+	class GLTFAsset;
 	class GLTFBufferView;
+	class MappedFile;
 
+	/// Binary buffer. Owned data is stored in a list of segments which never relocate:
+	/// pointers into the buffer stay valid when more data is added, and appending never
+	/// copies existing data. Each allocation lies within a single segment. Segments start
+	/// at 4 byte aligned offsets, gaps between segments are written as zero bytes.
+	/// Buffers backed by an external file map the file on first access to their data.
 	class F_GLTF_EXPORT GLTFBuffer : public GLTFMainElement
 	{
 		friend class GLTFAsset;
+		friend class GLBContainer;
+		friend class GLTFReader;
 
 	protected:
 		GLTFBuffer(GLTFAsset* pAsset, size_t index, const std::string& name = std::string{});
 		virtual ~GLTFBuffer() { };
 
 	public:
+		/// Contiguous range of buffer data.
+		struct segment_t
+		{
+			char* pData;
+			size_t byteOffset;
+			size_t byteLength;
+			size_t capacity;
+		};
+
+		typedef std::vector<segment_t> segmentVec_t;
+
 		GLTFBufferView* addData(const char* pData, size_t byteLength, bool align = true);
+		/// Copies data to the end of the buffer without creating a view, e.g. for data
+		/// referenced by an extension. Returns the byte offset of the data.
+		size_t appendData(const char* pData, size_t byteLength, bool align = true);
 		GLTFBufferView* addImage(const std::string& imageFilePath);
 		GLTFBufferView* allocate(size_t byteLength, bool align = true);
+		/// Creates a view on an existing range of the buffer's data.
+		/// Returns nullptr if the range is out of bounds or spans several segments.
+		GLTFBufferView* createView(size_t byteOffset, size_t byteLength, size_t byteStride = 0);
+		/// Copies the data of a view of another buffer to this buffer and moves the view.
+		/// Returns false if the view's data is not available. A fallback buffer only
+		/// reserves the view's range, the data isn't copied.
+		bool adoptView(GLTFBufferView* pBufferView);
+
+		/// Backs the buffer with a range of a memory-mapped file instead of owned memory.
+		/// The buffer keeps the mapping alive. Data added later is stored in new segments
+		/// following the mapped range.
+		void setMappedData(std::shared_ptr<MappedFile> pFile, size_t byteOffset, size_t byteLength);
+
+		/// Backs the buffer with an external file, e.g. a .bin file referenced by a uri.
+		/// The file is mapped on first access to the buffer's data or segments; until
+		/// then, the buffer only knows its length. If the file can't be mapped or is
+		/// shorter than byteLength, data() returns nullptr for the file's range.
+		void setExternalFile(const std::string& filePath, size_t byteLength);
 
 		void setUri(const std::string& uri);
+		/// Marks the buffer as fallback for compressed buffer views. Only the length of a
+		/// fallback buffer is written, views moved to it keep no data.
+		void setFallback(bool isFallback);
 		bool save(const std::string& bufferFilePath);
 
-		char* data() { return _buffer.data(); }
-		const char* data() const { return _buffer.data(); }
+		/// Returns a pointer to the data at the given offset. The data is contiguous
+		/// up to the end of the segment containing the offset.
+		char* data(size_t byteOffset = 0);
+		const char* data(size_t byteOffset = 0) const;
+
+		size_t byteLength() const;
+		/// Returns the buffer's data segments in ascending order.
+		const segmentVec_t& segments() const;
 
-		size_t byteLength() const { return _buffer.size(); }
 		const std::string& uri() const { return _uri; }
+		bool isMapped() const { return _pMappedFile != nullptr; }
+		/// Returns true if the buffer's external file hasn't been mapped yet.
+		bool isPending() const { return _isPending; }
+		bool isFallback() const { return _isFallback; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
+		/// Referenced range of the buffer's data.
+		struct range_t
+		{
+			size_t byteOffset;
+			size_t byteLength;
+		};
+
+		typedef std::vector<range_t> rangeVec_t;
+
+		/// Copies the given ranges to a single new segment, dropping all unreferenced
+		/// bytes, and stores the new offset of each range in offsets. Overlapping ranges
+		/// keep their relative offsets. A fallback buffer only updates its length.
+		/// Returns false if the data of a range is not available.
+		bool _repack(const rangeVec_t& ranges, std::vector<size_t>& offsets);
+
+		/// Appends zeroed space for byteLength bytes, returns its offset.
+		size_t _allocate(size_t byteLength, bool align);
+		/// Appends an aligned range without storage, returns its offset.
+		size_t _reserve(size_t byteLength);
+		segment_t* _addSegment(size_t minCapacity);
+		const segment_t* _findSegment(size_t byteOffset) const;
+		void _mapExternalFile() const;
+
+		static const size_t _MIN_SEGMENT_SIZE = 64 * 1024;
+		static const size_t _MAX_SEGMENT_SIZE = 64 * 1024 * 1024;
+
 		GLTFAsset * _pAsset;
-		std::vector<char> _buffer;
+		segmentVec_t _segments;
+		std::vector<std::unique_ptr<char[]>> _blocks;
+
+		std::shared_ptr<MappedFile> _pMappedFile;
+		std::string _externalFilePath;
+		mutable std::atomic<bool> _isPending;
+		mutable std::mutex _mapMutex;
 
 		std::string _uri;
+		bool _isFallback;
 	};
 }
 
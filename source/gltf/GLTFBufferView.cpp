@@ -7,6 +7,9 @@
 
 #include "GLTFBuffer.h"
 #include "GLTFBufferView.h"
+#include "GLTFWriteContext.h"
+
+#include "../core/JsonWriter.h"
 
 using namespace flow;
 using std::string;
@@ -27,18 +30,23 @@ void GLTFBufferView::setTarget(GLTFBufferViewTarget target)
 	_target = target;
 }
 
+void GLTFBufferView::setByteStride(size_t byteStride)
+{
+	_byteStride = byteStride;
+}
+
 char* GLTFBufferView::data() const
 {
 	if (!_pBuffer) {
 		return nullptr;
 	}
 
-	return _pBuffer->data() + _byteOffset;
+	return _pBuffer->data(_byteOffset);
 }
 
-json GLTFBufferView::toJSON() const
+void GLTFBufferView::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
+	GLTFMainElement::_writeProperties(writer, context);
 
 	if (!_pBuffer) {
 		throw std::exception("GLTFBufferView: buffer not set");
@@ -47,20 +55,21 @@ json GLTFBufferView::toJSON() const
 		throw std::exception("GLTFBufferView: byteLength not set");
 	}
 	
-	result["buffer"] = _pBuffer->index();
-	result["byteLength"] = _byteLength;
+	// offsets are relative to the output buffer, which may hold several merged buffers
+	size_t byteOffset = context.bufferOffset(_pBuffer) + _byteOffset;
+
+	writer.member("buffer", context.bufferIndex(_pBuffer));
+	writer.member("byteLength", _byteLength);
 
-	if (_byteOffset > 0) {
-		result["byteOffset"] = _byteOffset;
+	if (byteOffset > 0) {
+		writer.member("byteOffset", byteOffset);
 	}
 	if (_byteStride > 0) {
-		result["byteStride"] = _byteStride;
+		writer.member("byteStride", _byteStride);
 	}
 	if (_target != GLTFBufferViewTarget::UNDEFINED) {
-		result["target"] = (int)_target;
+		writer.member("target", (int)_target);
 	}
-
-	return result;
 }
 
 void GLTFBufferView::_set(GLTFBuffer* pBuffer, size_t byteOffset, size_t byteLength, size_t byteStride /* = 0 */)
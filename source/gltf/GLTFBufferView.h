@@ -30,14 +30,18 @@ namespace flow
 
 	public:
 		void setTarget(GLTFBufferViewTarget target);
+		/// Sets the distance in bytes between vertices of interleaved vertex data.
+		void setByteStride(size_t byteStride);
 
 		char* data() const;
 		const GLTFBuffer* buffer() const { return _pBuffer; }
 		size_t byteOffset() const { return _byteOffset; }
 		size_t byteLength() const { return _byteLength; }
+		size_t byteStride() const { return _byteStride; }
 		GLTFBufferViewTarget target() const { return _target; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		void _set(GLTFBuffer* pBuffer, size_t byteOffset, size_t byteLength, size_t byteStride = 0);
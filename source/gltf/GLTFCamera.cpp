@@ -7,6 +7,8 @@
 
 #include "GLTFCamera.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -47,29 +49,26 @@ void GLTFPerspectiveCamera::setPerspectiveExtras(const json& jsonData)
 	_perspExtras = jsonData;
 }
 
-json GLTFPerspectiveCamera::toJSON() const
+void GLTFPerspectiveCamera::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFCamera::toJSON();
+	GLTFCamera::_writeProperties(writer, context);
 
-	result["type"] = "perspective";
+	writer.member("type", "perspective");
 
-	json perspective {
-		{ "aspect", _aspect },
-		{ "yfov", _yfov },
-		{ "zfar", _zfar },
-		{ "znear", _znear }
-	};
+	writer.key("perspective").beginObject();
+	writer.member("aspectRatio", _aspect);
+	writer.member("yfov", _yfov);
+	writer.member("zfar", _zfar);
+	writer.member("znear", _znear);
 
 	if (!_perspExtensions.empty()) {
-		perspective["extensions"] = _perspExtensions;
+		writer.member("extensions", _perspExtensions);
 	}
 	if (!_perspExtras.empty()) {
-		perspective["extras"] = _perspExtras;
+		writer.member("extras", _perspExtras);
 	}
 
-	result["perspective"] = perspective;
-
-	return result;
+	writer.endObject();
 }
 
 GLTFOrthographicCamera::GLTFOrthographicCamera(size_t index, const std::string& name /* = std::string */) :
@@ -95,27 +94,24 @@ void GLTFOrthographicCamera::setOrthographicExtras(const json& jsonData)
 	_orthoExtras = jsonData;
 }
 
-json GLTFOrthographicCamera::toJSON() const
+void GLTFOrthographicCamera::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFCamera::toJSON();
+	GLTFCamera::_writeProperties(writer, context);
 
-	result["type"] = "orthographic";
+	writer.member("type", "orthographic");
 
-	json orthographic {
-		{ "xmag", _xmag },
-		{ "ymag", _ymag },
-		{ "zfar", _zfar },
-		{ "znear", _znear }
-	};
+	writer.key("orthographic").beginObject();
+	writer.member("xmag", _xmag);
+	writer.member("ymag", _ymag);
+	writer.member("zfar", _zfar);
+	writer.member("znear", _znear);
 
 	if (!_orthoExtensions.empty()) {
-		orthographic["extensions"] = _orthoExtensions;
+		writer.member("extensions", _orthoExtensions);
 	}
 	if (!_orthoExtras.empty()) {
-		orthographic["extras"] = _orthoExtras;
+		writer.member("extras", _orthoExtras);
 	}
 
-	result["orthographic"] = orthographic;
-
-	return result;
+	writer.endObject();
 }
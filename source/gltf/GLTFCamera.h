@@ -37,6 +37,8 @@ namespace flow
 
 	class GLTFPerspectiveCamera : public GLTFCamera
 	{
+		friend class GLTFAsset;
+
 	protected:
 		GLTFPerspectiveCamera(size_t index, const std::string& name = std::string{});
 		~GLTFPerspectiveCamera() { }
@@ -49,7 +51,8 @@ namespace flow
 		float aspect() const { return _aspect; }
 		float yfov() const { return _yfov; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		float _aspect;
@@ -60,6 +63,8 @@ namespace flow
 
 	class GLTFOrthographicCamera : public GLTFCamera
 	{
+		friend class GLTFAsset;
+
 	protected:
 		GLTFOrthographicCamera(size_t index, const std::string& name = std::string{});
 		~GLTFOrthographicCamera() { }
@@ -72,7 +77,8 @@ namespace flow
 		float xmag() const { return _xmag; }
 		float ymag() const { return _ymag; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		float _xmag;
@@ -30,6 +30,16 @@ const char* GLTFBufferViewTarget::name() const
 	}
 }
 
+const char* GLTFMeshoptMode::name() const
+{
+	switch (_state) {
+		F_ENUM_NAME(ATTRIBUTES);
+		F_ENUM_NAME(TRIANGLES);
+		F_ENUM_NAME(INDICES);
+		F_ENUM_ASSERT_DEFAULT;
+	}
+}
+
 size_t GLTFAccessorType::componentCount() const
 {
 	switch (_state) {
@@ -166,3 +176,22 @@ const char* GLTFAlphaMode::name() const
 		F_ENUM_ASSERT_DEFAULT;
 	}
 }
+
+const char* GLBWriteMode::name() const
+{
+	switch (_state) {
+		F_ENUM_NAME(STREAM);
+		F_ENUM_NAME(VECTORED);
+		F_ENUM_ASSERT_DEFAULT;
+	}
+}
+
+const char* GLBSyncMode::name() const
+{
+	switch (_state) {
+		F_ENUM_NAME(NONE);
+		F_ENUM_NAME(DATA);
+		F_ENUM_NAME(FULL);
+		F_ENUM_ASSERT_DEFAULT;
+	}
+}
@@ -36,6 +36,18 @@ namespace flow
 		F_DECLARE_ENUM(F_GLTF_EXPORT, GLTFBufferViewTarget, UNDEFINED);
 	};
 
+	struct GLTFMeshoptMode
+	{
+		enum enum_type
+		{
+			ATTRIBUTES,
+			TRIANGLES,
+			INDICES
+		};
+
+		F_DECLARE_ENUM(F_GLTF_EXPORT, GLTFMeshoptMode, ATTRIBUTES);
+	};
+
 	struct GLTFAccessorType
 	{
 		enum enum_type
@@ -176,6 +188,29 @@ namespace flow
 
 		F_DECLARE_ENUM(F_GLTF_EXPORT, GLTFAlphaMode, OPAQUE);
 	};
+
+	struct GLBWriteMode
+	{
+		enum enum_type
+		{
+			STREAM,
+			VECTORED
+		};
+
+		F_DECLARE_ENUM(F_GLTF_EXPORT, GLBWriteMode, STREAM);
+	};
+
+	struct GLBSyncMode
+	{
+		enum enum_type
+		{
+			NONE,
+			DATA,
+			FULL
+		};
+
+		F_DECLARE_ENUM(F_GLTF_EXPORT, GLBSyncMode, NONE);
+	};
 }
 
  
@@ -0,0 +1,344 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFDracoEncoder.h"
+#include "GLTFAsset.h"
+#include "GLTFMesh.h"
+#include "GLTFPrimitive.h"
+#include "GLTFBuffer.h"
+#include "GLTFBufferView.h"
+#include "GLTFAccessor.h"
+
+#include "../core/ThreadPool.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef F_GLTF_DRACO
+#  include "draco/compression/encode.h"
+#  include "draco/mesh/mesh.h"
+#endif
+
+using namespace flow;
+using std::string;
+using std::vector;
+
+
+namespace
+{
+	const char* _EXTENSION_NAME = "KHR_draco_mesh_compression";
+
+	size_t _accessorByteLength(const GLTFAccessor* pAccessor)
+	{
+		return pAccessor->elementCount() * pAccessor->elementByteSize();
+	}
+
+#ifdef F_GLTF_DRACO
+	draco::GeometryAttribute::Type _dracoType(GLTFAttributeType type)
+	{
+		switch (type) {
+		case GLTFAttributeType::POSITION: return draco::GeometryAttribute::POSITION;
+		case GLTFAttributeType::NORMAL: return draco::GeometryAttribute::NORMAL;
+		case GLTFAttributeType::TEXCOORD_0:
+		case GLTFAttributeType::TEXCOORD_1: return draco::GeometryAttribute::TEX_COORD;
+		case GLTFAttributeType::COLOR_0: return draco::GeometryAttribute::COLOR;
+		default: return draco::GeometryAttribute::GENERIC;
+		}
+	}
+
+	draco::DataType _dracoDataType(GLTFAccessorComponent component)
+	{
+		switch (component) {
+		case GLTFAccessorComponent::BYTE: return draco::DT_INT8;
+		case GLTFAccessorComponent::UNSIGNED_BYTE: return draco::DT_UINT8;
+		case GLTFAccessorComponent::SHORT: return draco::DT_INT16;
+		case GLTFAccessorComponent::UNSIGNED_SHORT: return draco::DT_UINT16;
+		case GLTFAccessorComponent::INT: return draco::DT_INT32;
+		case GLTFAccessorComponent::UNSIGNED_INT: return draco::DT_UINT32;
+		default: return draco::DT_FLOAT32;
+		}
+	}
+
+	uint32_t _readIndex(const char* pData, size_t byteSize)
+	{
+		switch (byteSize) {
+		case 1: return uint8_t(*pData);
+		case 2: { uint16_t index; std::memcpy(&index, pData, 2); return index; }
+		default: { uint32_t index; std::memcpy(&index, pData, 4); return index; }
+		}
+	}
+#endif
+}
+
+GLTFDracoEncoder::GLTFDracoEncoder(GLTFAsset* pAsset) :
+	_pAsset(pAsset),
+	_positionBits(11),
+	_normalBits(8),
+	_texCoordBits(10),
+	_colorBits(8),
+	_genericBits(8),
+	_encodeSpeed(5),
+	_decodeSpeed(5),
+	_primitiveCount(0),
+	_sourceByteLength(0),
+	_resultByteLength(0)
+{
+	F_ASSERT(pAsset);
+}
+
+bool GLTFDracoEncoder::isAvailable()
+{
+#ifdef F_GLTF_DRACO
+	return true;
+#else
+	return false;
+#endif
+}
+
+void GLTFDracoEncoder::setQuantizationBits(int position, int normal, int texCoord, int color, int generic)
+{
+	_positionBits = position;
+	_normalBits = normal;
+	_texCoordBits = texCoord;
+	_colorBits = color;
+	_genericBits = generic;
+}
+
+void GLTFDracoEncoder::setSpeed(int encodeSpeed, int decodeSpeed)
+{
+	_encodeSpeed = encodeSpeed;
+	_decodeSpeed = decodeSpeed;
+}
+
+bool GLTFDracoEncoder::encode(GLTFBuffer* pBuffer)
+{
+	_primitiveCount = 0;
+	_sourceByteLength = 0;
+	_resultByteLength = 0;
+	_error.clear();
+
+	if (!isAvailable()) {
+		_error = "library built without Draco support";
+		return false;
+	}
+
+	vector<job_t> jobs;
+	_findJobs(jobs);
+
+	// check all data is available before changing anything
+	for (auto& job : jobs) {
+		for (auto& attribute : job.pPrimitive->attributes()) {
+			if (!attribute.pAccessor->data()) {
+				_error = string("attribute data not available: ") + attribute.type.name();
+				return false;
+			}
+		}
+		if (!job.pPrimitive->indices()->data()) {
+			_error = "index data not available";
+			return false;
+		}
+	}
+
+	// encode largest primitives first, so the batch doesn't end with a single long task
+	vector<size_t> order(jobs.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) {
+		return jobs[a].pPrimitive->indices()->elementCount() > jobs[b].pPrimitive->indices()->elementCount();
+	});
+
+	TaskGroup group;
+	for (size_t i : order) {
+		group.run([this, &jobs, i]() {
+			_encodeJob(jobs[i]);
+		});
+	}
+
+	group.wait();
+
+	for (auto& job : jobs) {
+		if (!job.error.empty()) {
+			_error = job.error;
+			return false;
+		}
+	}
+
+	// the accessors describe the decoded data, which has no buffer view
+	for (auto& job : jobs) {
+		GLTFPrimitive* pPrimitive = job.pPrimitive;
+
+		auto pDraco = _pAsset->createExtension<GLTFDracoExtension>();
+		pDraco->setEncodedBufferView(pBuffer->addData(job.result.data(), job.result.size()));
+
+		for (size_t i = 0; i < job.attributes.size(); ++i) {
+			auto pAccessor = const_cast<GLTFAccessor*>(pPrimitive->attributes()[i].pAccessor);
+			_sourceByteLength += _accessorByteLength(pAccessor);
+
+			pDraco->addAttribute(job.attributes[i].type, job.attributes[i].index);
+			pAccessor->setBufferView(nullptr);
+			pAccessor->setElementCount(job.pointCount);
+		}
+
+		auto pIndices = const_cast<GLTFAccessor*>(pPrimitive->indices());
+		_sourceByteLength += _accessorByteLength(pIndices);
+
+		pIndices->setBufferView(nullptr);
+		pIndices->setElementCount(job.faceCount * 3);
+
+		pPrimitive->addExtension(pDraco);
+
+		_resultByteLength += job.result.size();
+		_primitiveCount++;
+	}
+
+	if (_primitiveCount > 0) {
+		_pAsset->useExtension(_EXTENSION_NAME, true);
+	}
+
+	return true;
+}
+
+void GLTFDracoEncoder::_findJobs(vector<job_t>& jobs) const
+{
+	// accessors shared between primitives keep their data
+	vector<int> useCount(_pAsset->_accessors.size(), 0);
+
+	for (auto pMesh : _pAsset->_meshes) {
+		for (auto& primitive : pMesh->primitives()) {
+			if (primitive.indices()) {
+				useCount[primitive.indices()->index()]++;
+			}
+			for (auto& attribute : primitive.attributes()) {
+				if (attribute.pAccessor) {
+					useCount[attribute.pAccessor->index()]++;
+				}
+			}
+			for (auto& target : primitive.targets()) {
+				for (auto& attribute : target) {
+					if (attribute.pAccessor) {
+						useCount[attribute.pAccessor->index()]++;
+					}
+				}
+			}
+		}
+	}
+
+	for (auto pMesh : _pAsset->_meshes) {
+		for (auto& primitive : const_cast<GLTFMesh*>(pMesh)->primitives()) {
+			const GLTFAccessor* pIndices = primitive.indices();
+
+			bool isEligible = primitive.mode() == GLTFPrimitiveMode::TRIANGLES
+				&& primitive.targets().empty()
+				&& primitive.extensions().empty()
+				&& !primitive.attributes().empty()
+				&& pIndices && pIndices->bufferView()
+				&& useCount[pIndices->index()] == 1;
+
+			for (auto& attribute : primitive.attributes()) {
+				isEligible = isEligible
+					&& attribute.pAccessor && attribute.pAccessor->bufferView()
+					&& useCount[attribute.pAccessor->index()] == 1;
+			}
+
+			if (isEligible) {
+				job_t job;
+				job.pPrimitive = &primitive;
+				job.pointCount = 0;
+				job.faceCount = 0;
+				jobs.push_back(std::move(job));
+			}
+		}
+	}
+}
+
+void GLTFDracoEncoder::_encodeJob(job_t& job) const
+{
+#ifdef F_GLTF_DRACO
+	const GLTFPrimitive* pPrimitive = job.pPrimitive;
+	const GLTFAccessor* pIndices = pPrimitive->indices();
+	size_t pointCount = pPrimitive->attributes().front().pAccessor->elementCount();
+
+	draco::Mesh mesh;
+	mesh.set_num_points(uint32_t(pointCount));
+
+	// faces refer to points, attribute values map to points one to one
+	const char* pIndexData = pIndices->data();
+	size_t indexSize = pIndices->elementByteSize();
+	size_t indexStride = pIndices->elementStride();
+
+	for (size_t i = 0; i + 2 < pIndices->elementCount(); i += 3) {
+		draco::Mesh::Face face;
+		for (size_t k = 0; k < 3; ++k) {
+			uint32_t index = _readIndex(pIndexData + (i + k) * indexStride, indexSize);
+			if (index >= pointCount) {
+				job.error = "index out of range";
+				return;
+			}
+			face[k] = draco::PointIndex(index);
+		}
+		mesh.AddFace(face);
+	}
+
+	for (auto& attribute : pPrimitive->attributes()) {
+		const GLTFAccessor* pAccessor = attribute.pAccessor;
+		if (pAccessor->elementCount() != pointCount) {
+			job.error = string("attribute count mismatch: ") + attribute.type.name();
+			return;
+		}
+
+		draco::GeometryAttribute geometryAttribute;
+		geometryAttribute.Init(_dracoType(attribute.type), nullptr,
+			uint8_t(pAccessor->type().componentCount()), _dracoDataType(pAccessor->component()),
+			pAccessor->normalized(), int64_t(pAccessor->elementByteSize()), 0);
+
+		int attributeId = mesh.AddAttribute(geometryAttribute, true, uint32_t(pointCount));
+		draco::PointAttribute* pDracoAttribute = mesh.attribute(attributeId);
+
+		const char* pData = pAccessor->data();
+		size_t stride = pAccessor->elementStride();
+		for (size_t i = 0; i < pointCount; ++i) {
+			pDracoAttribute->SetAttributeValue(draco::AttributeValueIndex(uint32_t(i)), pData + i * stride);
+		}
+
+		job.attributes.push_back({ attribute.type, int(pDracoAttribute->unique_id()) });
+	}
+
+	draco::Encoder encoder;
+	encoder.SetSpeedOptions(_encodeSpeed, _decodeSpeed);
+	encoder.SetTrackEncodedProperties(true);
+
+	const std::pair<draco::GeometryAttribute::Type, int> quantization[] = {
+		{ draco::GeometryAttribute::POSITION, _positionBits },
+		{ draco::GeometryAttribute::NORMAL, _normalBits },
+		{ draco::GeometryAttribute::TEX_COORD, _texCoordBits },
+		{ draco::GeometryAttribute::COLOR, _colorBits },
+		{ draco::GeometryAttribute::GENERIC, _genericBits }
+	};
+
+	for (auto& entry : quantization) {
+		if (entry.second > 0) {
+			encoder.SetAttributeQuantization(entry.first, entry.second);
+		}
+	}
+
+	draco::EncoderBuffer buffer;
+	draco::Status status = encoder.EncodeMeshToBuffer(mesh, &buffer);
+	if (!status.ok()) {
+		job.error = string("Draco encoder failed: ") + status.error_msg();
+		return;
+	}
+
+	// the encoder may split non-manifold vertices, the decoded counts differ from the source
+	job.pointCount = encoder.num_encoded_points();
+	job.faceCount = encoder.num_encoded_faces();
+	job.result.assign(buffer.data(), buffer.data() + buffer.size());
+#else
+	job.error = "library built without Draco support";
+#endif
+}
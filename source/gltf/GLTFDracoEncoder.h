@@ -0,0 +1,97 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_DRACOENCODER_H
+#define _FLOWLIBS_GLTF_DRACOENCODER_H
+
+#include "library.h"
+#include "GLTFConstants.h"
+#include "GLTFDracoExtension.h"
+
+#include <string>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFAsset;
+	class GLTFBuffer;
+	class GLTFPrimitive;
+
+	/// Compresses mesh primitives with the KHR_draco_mesh_compression extension.
+	/// Requires the Draco library, see FLOW_ENABLE_DRACO in the CMake configuration;
+	/// without it, encode() fails and isAvailable() returns false.
+	///
+	/// A primitive is compressed if it is an indexed triangle list without morph targets,
+	/// and none of its accessors is shared with another primitive. The compressed data
+	/// replaces the data of the primitive's accessors: the accessors keep their type and
+	/// bounds, but lose their buffer view, which remains in the asset until removed
+	/// by GLTFAsset::compact().
+	class F_GLTF_EXPORT GLTFDracoEncoder
+	{
+	public:
+		GLTFDracoEncoder(GLTFAsset* pAsset);
+
+		/// Returns true if the library was built with Draco support.
+		static bool isAvailable();
+
+		/// Sets the number of quantization bits per attribute kind. Texture coordinates
+		/// include all TEXCOORD sets, generic attributes are tangents, joints and weights.
+		/// 0 stores the attribute without quantization. Defaults are 11, 8, 10, 8, 8.
+		void setQuantizationBits(int position, int normal, int texCoord, int color, int generic);
+		/// Sets the speed of encoding and decoding, from 0 (slow, best compression)
+		/// to 10 (fast, least compression). Defaults are 5, 5.
+		void setSpeed(int encodeSpeed, int decodeSpeed);
+
+		/// Compresses all eligible primitives, in parallel. The compressed data is added to
+		/// pBuffer. Registers KHR_draco_mesh_compression as a required extension if any
+		/// primitive was compressed. Returns false without changes if the data of a primitive
+		/// is not available or the Draco encoder fails.
+		bool encode(GLTFBuffer* pBuffer);
+
+		/// Number of compressed primitives.
+		size_t primitiveCount() const { return _primitiveCount; }
+		/// Size of the accessor data of the compressed primitives.
+		size_t sourceByteLength() const { return _sourceByteLength; }
+		/// Size of the compressed data.
+		size_t resultByteLength() const { return _resultByteLength; }
+
+		const std::string& error() const { return _error; }
+
+	private:
+		struct job_t
+		{
+			GLTFPrimitive* pPrimitive;
+			std::vector<char> result;
+			GLTFDracoExtension::attributeVec_t attributes;
+			size_t pointCount;
+			size_t faceCount;
+			std::string error;
+		};
+
+		void _findJobs(std::vector<job_t>& jobs) const;
+		void _encodeJob(job_t& job) const;
+
+		GLTFAsset* _pAsset;
+
+		int _positionBits;
+		int _normalBits;
+		int _texCoordBits;
+		int _colorBits;
+		int _genericBits;
+		int _encodeSpeed;
+		int _decodeSpeed;
+
+		size_t _primitiveCount;
+		size_t _sourceByteLength;
+		size_t _resultByteLength;
+
+		std::string _error;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_DRACOENCODER_H
@@ -7,40 +7,110 @@
 
 #include "GLTFElement.h"
 #include "GLTFExtension.h"
+#include "GLTFWriteContext.h"
+
+#include "../core/JsonWriter.h"
 
 using namespace flow;
 using std::string;
 
 
+namespace
+{
+	const GLTFElement::extensionVec_t _noExtensions;
+}
+
+GLTFElement::GLTFElement(const GLTFElement& other) :
+	_pAttachments(other._pAttachments ? new attachments_t(*other._pAttachments) : nullptr)
+{
+}
+
+GLTFElement& GLTFElement::operator=(const GLTFElement& other)
+{
+	if (this != &other) {
+		_pAttachments.reset(other._pAttachments ? new attachments_t(*other._pAttachments) : nullptr);
+	}
+
+	return *this;
+}
+
 void GLTFElement::addExtension(const GLTFExtension* pExtension)
 {
-	_extensions.push_back(pExtension);
+	_attachments()->extensions.push_back(pExtension);
 }
 
 void GLTFElement::setExtras(const json& jsonData)
 {
-	_extras = jsonData;
+	_attachments()->extras = jsonData;
+}
+
+const GLTFElement::extensionVec_t& GLTFElement::extensions() const
+{
+	return _pAttachments ? _pAttachments->extensions : _noExtensions;
+}
+
+const json GLTFElement::extras() const
+{
+	return _pAttachments ? _pAttachments->extras : json();
 }
 
 json GLTFElement::toJSON() const
 {
-	json result = json::object();
+	string text;
+	{
+		JsonWriter writer(text);
+		toJSON(writer);
+	}
 
-	if (!_extensions.empty()) {
-		json extensions;
-		for (size_t i = 0; i < _extensions.size(); ++i) {
-			extensions[_extensions[i]->name()] = _extensions[i]->toJSON();
+	return json::parse(text);
+}
+
+void GLTFElement::toJSON(JsonWriter& writer) const
+{
+	toJSON(writer, GLTFWriteContext());
+}
+
+void GLTFElement::toJSON(JsonWriter& writer, const GLTFWriteContext& context) const
+{
+	writer.beginObject();
+	_writeProperties(writer, context);
+	writer.endObject();
+}
+
+string GLTFElement::toString(int indent /* = -1 */) const
+{
+	string text;
+	JsonWriter writer(text, indent);
+	toJSON(writer);
+
+	return text;
+}
+
+void GLTFElement::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
+{
+	if (!_pAttachments) {
+		return;
+	}
+
+	const extensionVec_t& extensions = _pAttachments->extensions;
+	if (!extensions.empty()) {
+		writer.key("extensions").beginObject();
+		for (size_t i = 0; i < extensions.size(); ++i) {
+			writer.key(extensions[i]->name());
+			extensions[i]->toJSON(writer, context);
 		}
-		result["extensions"] = extensions;
+		writer.endObject();
 	}
-	if (!_extras.empty()) {
-		result["extras"] = _extras;
+	if (!_pAttachments->extras.empty()) {
+		writer.member("extras", _pAttachments->extras);
 	}
-
-	return result;
 }
 
-string GLTFElement::toString(int indent /* = -1 */) const
+GLTFElement::attachments_t* GLTFElement::_attachments()
 {
-	return toJSON().dump(indent);
+	if (!_pAttachments) {
+		_pAttachments.reset(new attachments_t());
+	}
+
+	return _pAttachments.get();
 }
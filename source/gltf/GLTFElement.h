@@ -12,11 +12,15 @@
 
 #include "../core/json.h"
 #include <string>
+#include <vector>
+#include <memory>
 
 
 namespace flow
 {
 	class GLTFExtension;
+	class JsonWriter;
+	class GLTFWriteContext;
 
 	class F_GLTF_EXPORT GLTFElement
 	{
@@ -24,20 +28,42 @@ namespace flow
 		typedef std::vector<const GLTFExtension*> extensionVec_t;
 
 		GLTFElement() {}
+		GLTFElement(const GLTFElement& other);
 		virtual ~GLTFElement() {}
 
+		GLTFElement& operator=(const GLTFElement& other);
+
 		void addExtension(const GLTFExtension* pExtension);
 		void setExtras(const json& jsonData);
 
-		const extensionVec_t& extensions() const { return _extensions; }
-		const json extras() const { return _extras; }
+		const extensionVec_t& extensions() const;
+		const json extras() const;
 
-		virtual json toJSON() const;
+		/// Returns the element as JSON DOM. Prefer toJSON(JsonWriter&) for large assets.
+		json toJSON() const;
+		/// Streams the element as JSON object to the given writer.
+		void toJSON(JsonWriter& writer) const;
+		/// Streams the element as JSON object, buffers are referenced as laid out by the context.
+		void toJSON(JsonWriter& writer, const GLTFWriteContext& context) const;
 		virtual std::string toString(int indent = -1) const;
 
 	protected:
-		extensionVec_t _extensions;
-		json _extras;
+		/// Writes the element's properties into the currently open JSON object.
+		/// Overrides call the base class implementation first.
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
+
+	private:
+		/// Extensions and extras. Most elements have neither, the block is
+		/// allocated when the first extension or extras are added.
+		struct attachments_t
+		{
+			extensionVec_t extensions;
+			json extras;
+		};
+
+		attachments_t* _attachments();
+
+		std::unique_ptr<attachments_t> _pAttachments;
 	};
 }
 
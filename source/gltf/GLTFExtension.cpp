@@ -7,9 +7,16 @@
 
 #include "GLTFExtension.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
 GLTFExtension::GLTFExtension()
 {
 }
+
+void GLTFExtension::toJSON(JsonWriter& writer, const GLTFWriteContext& /* context */) const
+{
+	writer.value(toJSON());
+}
@@ -17,6 +17,8 @@
 namespace flow
 {
 	class GLTFElement;
+	class JsonWriter;
+	class GLTFWriteContext;
 
 	class F_GLTF_EXPORT GLTFExtension
 	{
@@ -26,6 +28,9 @@ namespace flow
 
 		virtual const char* name() const = 0;
 		virtual json toJSON() const = 0;
+		/// Streams the extension payload. The default implementation writes toJSON().
+		/// Extensions referencing buffers directly override this to use the context's layout.
+		virtual void toJSON(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	protected:
 	};
@@ -0,0 +1,33 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFGenericExtension.h"
+
+using namespace flow;
+using std::string;
+
+
+GLTFGenericExtension::GLTFGenericExtension(const string& name, const json& data /* = json::object() */) :
+	_name(name),
+	_data(data)
+{
+}
+
+void GLTFGenericExtension::setData(const json& data)
+{
+	_data = data;
+}
+
+const char* GLTFGenericExtension::name() const
+{
+	return _name.c_str();
+}
+
+json GLTFGenericExtension::toJSON() const
+{
+	return _data;
+}
@@ -0,0 +1,39 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_GENERICEXTENSION_H
+#define _FLOWLIBS_GLTF_GENERICEXTENSION_H
+
+#include "library.h"
+#include "GLTFExtension.h"
+
+#include "../core/json.h"
+#include <string>
+
+namespace flow
+{
+	/// Extension with a name and an opaque JSON payload. Used to carry extensions
+	/// through a load/save round trip which have no dedicated implementation.
+	class F_GLTF_EXPORT GLTFGenericExtension : public GLTFExtension
+	{
+	public:
+		GLTFGenericExtension(const std::string& name, const json& data = json::object());
+		virtual ~GLTFGenericExtension() { }
+
+		void setData(const json& data);
+		const json& data() const { return _data; }
+
+		virtual const char* name() const;
+		virtual json toJSON() const;
+
+	private:
+		std::string _name;
+		json _data;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_GENERICEXTENSION_H
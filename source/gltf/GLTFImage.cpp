@@ -8,6 +8,8 @@
 #include "GLTFImage.h"
 #include "GLTFBufferView.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -33,19 +35,17 @@ void GLTFImage::setBufferView(const GLTFBufferView* pBufferView, GLTFMimeType mi
 	_mimeType = mimeType;
 }
 
-json GLTFImage::toJSON() const
+void GLTFImage::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
+	GLTFMainElement::_writeProperties(writer, context);
 
 	if (_pBufferView) {
-		result["bufferView"] = _pBufferView->index();
-		result["mimeType"] = _getMimeTypeName(_mimeType);
+		writer.member("bufferView", _pBufferView->index());
+		writer.member("mimeType", _getMimeTypeName(_mimeType));
 	}
 	else {
-		result["uri"] = _uri;
+		writer.member("uri", _uri);
 	}
-
-	return result;
 }
 
 const char* GLTFImage::_getMimeTypeName(GLTFMimeType mimeType) const
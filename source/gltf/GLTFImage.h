@@ -35,7 +35,8 @@ namespace flow
 		const GLTFBufferView* bufferView() const { return _pBufferView; }
 		const GLTFMimeType mimeType() const { return _mimeType; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		const char* _getMimeTypeName(GLTFMimeType mimeType) const;
@@ -7,15 +7,18 @@
 
 #include "GLTFMainElement.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
 
 GLTFMainElement::GLTFMainElement(size_t index, const string& name /* = string{} */) :
 	GLTFElement(),
-	_index(index),
-	_name(name)
+	_name(name),
+	_index(uint32_t(index))
 {
+	F_ASSERT(index <= UINT32_MAX);
 }
 
 void GLTFMainElement::setName(const string& name)
@@ -23,13 +26,17 @@ void GLTFMainElement::setName(const string& name)
 	_name = name;
 }
 
-json GLTFMainElement::toJSON() const
+void GLTFMainElement::_setIndex(size_t index)
 {
-	json result = GLTFElement::toJSON();
+	F_ASSERT(index <= UINT32_MAX);
+	_index = uint32_t(index);
+}
+
+void GLTFMainElement::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
+{
+	GLTFElement::_writeProperties(writer, context);
 
 	if (!_name.empty()) {
-		result["name"] = _name;
+		writer.member("name", _name);
 	}
-
-	return result;
 }
\ No newline at end of file
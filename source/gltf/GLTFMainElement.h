@@ -12,11 +12,14 @@
 #include "GLTFElement.h"
 
 #include <string>
+#include <cstdint>
 
 namespace flow
 {
 	class F_GLTF_EXPORT GLTFMainElement : public GLTFElement
 	{
+		friend class GLTFAsset;
+
 	protected:
 		GLTFMainElement(size_t index, const std::string& name = std::string{});
 		virtual ~GLTFMainElement() { };
@@ -27,11 +30,14 @@ namespace flow
 		const std::string& name() const { return _name; }
 		size_t index() const { return _index; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
-		size_t _index;
+		void _setIndex(size_t index);
+
 		std::string _name;
+		uint32_t _index;
 	};
 }
 
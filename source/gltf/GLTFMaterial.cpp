@@ -8,6 +8,8 @@
 #include "GLTFMaterial.h"
 #include "GLTFTexture.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -70,36 +72,38 @@ void GLTFMaterial::setDoubleSided(bool doubleSided)
 	_doubleSided = doubleSided;
 }
 
-json GLTFMaterial::toJSON() const
+void GLTFMaterial::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
+	GLTFMainElement::_writeProperties(writer, context);
 
 	if (_pPbr) {
-		result["pbrMetallicRoughness"] = _pPbr->toJSON();
+		writer.key("pbrMetallicRoughness");
+		_pPbr->toJSON(writer, context);
 	}
 	if (_normalTextureInfo.texture()) {
-		result["normalTexture"] = _normalTextureInfo.toJSON();
+		writer.key("normalTexture");
+		_normalTextureInfo.toJSON(writer, context);
 	}
 	if (_occlusionTextureInfo.texture()) {
-		result["occlusionTexture"] = _occlusionTextureInfo.toJSON();
+		writer.key("occlusionTexture");
+		_occlusionTextureInfo.toJSON(writer, context);
 	}
 	if (_emissiveTextureInfo.texture()) {
-		result["emissiveTexture"] = _emissiveTextureInfo.toJSON();
+		writer.key("emissiveTexture");
+		_emissiveTextureInfo.toJSON(writer, context);
 	}
 	if (_emissiveFactor != _DEFAULT_EMISSIVEFACTOR) {
-		result["emissiveFactor"] = _emissiveFactor.toJSON();
+		writer.key("emissiveFactor").array(_emissiveFactor.ptr(), 3);
 	}
 	if (_alphaMode != GLTFAlphaMode::OPAQUE) {
-		result["alphaMode"] = _getAlphaModeName(_alphaMode);
+		writer.member("alphaMode", _getAlphaModeName(_alphaMode));
 	}
 	if (_alphaCutoff != 0.5f) {
-		result["alphaCutoff"] = 0.5f;
+		writer.member("alphaCutoff", _alphaCutoff);
 	}
 	if (_doubleSided) {
-		result["doubleSided"] = _doubleSided;
+		writer.member("doubleSided", _doubleSided);
 	}
-
-	return result;
 }
 
 const char* GLTFMaterial::_getAlphaModeName(GLTFAlphaMode mode) const
@@ -40,7 +40,18 @@ namespace flow
 		void setAlphaCutoff(float cutoff);
 		void setDoubleSided(bool doubleSided);
 
-		virtual json toJSON() const;
+		const GLTFPBRMetallicRoughness* pbrMetallicRoughness() const { return _pPbr; }
+		const GLTFNormalTextureInfo& normalTexture() const { return _normalTextureInfo; }
+		const GLTFOcclusionTextureInfo& occlusionTexture() const { return _occlusionTextureInfo; }
+		const GLTFTextureInfo& emissiveTexture() const { return _emissiveTextureInfo; }
+
+		/// Texture infos are elements, extensions like KHR_texture_transform are added to them.
+		GLTFNormalTextureInfo& normalTexture() { return _normalTextureInfo; }
+		GLTFOcclusionTextureInfo& occlusionTexture() { return _occlusionTextureInfo; }
+		GLTFTextureInfo& emissiveTexture() { return _emissiveTextureInfo; }
+
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		const char* _getAlphaModeName(GLTFAlphaMode mode) const;
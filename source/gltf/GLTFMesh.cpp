@@ -7,6 +7,8 @@
 
 #include "GLTFMesh.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -39,20 +41,17 @@ void GLTFMesh::setMaterial(const GLTFMaterial* pMaterial)
 	}
 }
 
-json GLTFMesh::toJSON() const
+void GLTFMesh::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json primArr = json::array();
+	GLTFMainElement::_writeProperties(writer, context);
+
+	writer.key("primitives").beginArray();
 	for (auto it = _primitives.begin(); it != _primitives.end(); ++it) {
-		primArr.push_back(it->toJSON());
+		it->toJSON(writer, context);
 	}
-
-	json result = GLTFMainElement::toJSON();
-
-	result["primitives"] = primArr;
+	writer.endArray();
 
 	if (!_weights.empty()) {
-		result["weights"] = _weights;
+		writer.key("weights").array(_weights);
 	}
-
-	return result;
 }
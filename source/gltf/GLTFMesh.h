@@ -46,10 +46,13 @@ namespace flow
 
 		/// Returns a const reference to the vector of primitives in this mesh.
 		const primitiveVec_t& primitives() const { return _primitives; }
+		/// Returns a reference to the vector of primitives in this mesh.
+		primitiveVec_t& primitives() { return _primitives; }
 		/// Returns a const reference to the vector of weights in this mesh.
 		const weightVec_t& weights() const { return _weights; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		primitiveVec_t _primitives;
@@ -0,0 +1,726 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFMeshOptimizer.h"
+#include "GLTFAsset.h"
+#include "GLTFMesh.h"
+#include "GLTFPrimitive.h"
+#include "GLTFBuffer.h"
+#include "GLTFBufferView.h"
+#include "GLTFAccessor.h"
+#include "GLTFAccessorView.h"
+#include "GLTFImage.h"
+
+#include "../core/ThreadPool.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+#include <functional>
+
+using namespace flow;
+using std::string;
+using std::vector;
+
+
+namespace
+{
+	// Forsyth's scoring parameters
+	const size_t _FORSYTH_CACHE_SIZE = 32;
+	const size_t _FORSYTH_MAX_VALENCE = 64;
+	const float _CACHE_DECAY_POWER = 1.5f;
+	const float _LAST_TRIANGLE_SCORE = 0.75f;
+	const float _VALENCE_BOOST_SCALE = 2.0f;
+	const float _VALENCE_BOOST_POWER = 0.5f;
+
+	const uint32_t _NONE = ~0u;
+
+	struct scoreTables_t
+	{
+		float cache[_FORSYTH_CACHE_SIZE];
+		float valence[_FORSYTH_MAX_VALENCE];
+
+		scoreTables_t()
+		{
+			// the vertices of the last triangle get a fixed score, so triangles sharing
+			// an edge with it don't win over triangles using older cached vertices
+			for (size_t i = 0; i < _FORSYTH_CACHE_SIZE; ++i) {
+				cache[i] = i < 3 ? _LAST_TRIANGLE_SCORE : std::pow(
+					1.0f - float(i - 3) / float(_FORSYTH_CACHE_SIZE - 3), _CACHE_DECAY_POWER);
+			}
+
+			// vertices with few remaining triangles are boosted, to avoid leaving lone triangles behind
+			valence[0] = 0.0f;
+			for (size_t i = 1; i < _FORSYTH_MAX_VALENCE; ++i) {
+				valence[i] = _VALENCE_BOOST_SCALE * std::pow(float(i), -_VALENCE_BOOST_POWER);
+			}
+		}
+	};
+
+	float _vertexScore(const scoreTables_t& tables, uint32_t cachePosition, uint32_t valence)
+	{
+		if (valence == 0) {
+			return -1.0f;
+		}
+
+		float score = cachePosition < _FORSYTH_CACHE_SIZE ? tables.cache[cachePosition] : 0.0f;
+		score += valence < _FORSYTH_MAX_VALENCE ? tables.valence[valence]
+			: _VALENCE_BOOST_SCALE * std::pow(float(valence), -_VALENCE_BOOST_POWER);
+
+		return score;
+	}
+
+	// FIFO cache simulation, a vertex is cached if it was added within the last cacheSize misses
+	uint32_t _updateCache(uint32_t a, uint32_t b, uint32_t c, uint32_t cacheSize,
+		uint32_t* pTimestamps, uint32_t& timestamp)
+	{
+		uint32_t misses = 0;
+
+		if (timestamp - pTimestamps[a] > cacheSize) {
+			pTimestamps[a] = timestamp++;
+			misses++;
+		}
+		if (timestamp - pTimestamps[b] > cacheSize) {
+			pTimestamps[b] = timestamp++;
+			misses++;
+		}
+		if (timestamp - pTimestamps[c] > cacheSize) {
+			pTimestamps[c] = timestamp++;
+			misses++;
+		}
+
+		return misses;
+	}
+
+	void _finishStats(GLTFMeshOptimizer::cacheStats_t& stats)
+	{
+		stats.acmr = stats.triangleCount ? float(stats.missCount) / float(stats.triangleCount) : 0.0f;
+		stats.atvr = stats.vertexCount ? float(stats.missCount) / float(stats.vertexCount) : 0.0f;
+	}
+}
+
+const size_t GLTFMeshOptimizer::CACHE_SIZE;
+
+GLTFMeshOptimizer::GLTFMeshOptimizer(GLTFAsset* pAsset) :
+	_pAsset(pAsset),
+	_overdrawThreshold(1.05f),
+	_isFetchOptimizing(true),
+	_primitiveCount(0)
+{
+	F_ASSERT(pAsset);
+	_statsBefore = _statsAfter = cacheStats_t{ 0, 0, 0, 0.0f, 0.0f };
+}
+
+void GLTFMeshOptimizer::setOverdrawThreshold(float threshold)
+{
+	_overdrawThreshold = threshold;
+}
+
+void GLTFMeshOptimizer::setVertexFetchOptimization(bool enabled)
+{
+	_isFetchOptimizing = enabled;
+}
+
+bool GLTFMeshOptimizer::optimize(GLTFBuffer* pBuffer)
+{
+	_primitiveCount = 0;
+	_statsBefore = _statsAfter = cacheStats_t{ 0, 0, 0, 0.0f, 0.0f };
+	_error.clear();
+
+	vector<job_t> jobs;
+	_findJobs(jobs);
+
+	// check all data is available before changing anything
+	for (auto& job : jobs) {
+		const GLTFPrimitive* pPrimitive = job.pPrimitive;
+		if (!pPrimitive->indices()->data()) {
+			_error = "index data not available";
+			return false;
+		}
+		for (auto& attribute : pPrimitive->attributes()) {
+			if (!attribute.pAccessor->data()) {
+				_error = string("attribute data not available: ") + attribute.type.name();
+				return false;
+			}
+		}
+		for (auto& view : job.views) {
+			if (!view.pBufferView->data()) {
+				_error = "vertex data not available";
+				return false;
+			}
+		}
+	}
+
+	// optimize largest primitives first, so the batch doesn't end with a single long task
+	vector<size_t> order(jobs.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) {
+		return jobs[a].pPrimitive->indices()->elementCount() > jobs[b].pPrimitive->indices()->elementCount();
+	});
+
+	TaskGroup group;
+	for (size_t i : order) {
+		group.run([this, &jobs, i]() {
+			_optimizeJob(jobs[i]);
+		});
+	}
+
+	group.wait();
+
+	for (auto& job : jobs) {
+		// primitives with out of range indices are left as is
+		if (job.indices.empty()) {
+			continue;
+		}
+
+		_applyJob(job, pBuffer);
+
+		_addStats(_statsBefore, job.statsBefore);
+		_addStats(_statsAfter, job.statsAfter);
+		_primitiveCount++;
+	}
+
+	return true;
+}
+
+GLTFMeshOptimizer::cacheStats_t GLTFMeshOptimizer::analyzeVertexCache(const uint32_t* pIndices,
+	size_t indexCount, size_t vertexCount, size_t cacheSize /* = CACHE_SIZE */)
+{
+	F_ASSERT(indexCount % 3 == 0);
+
+	cacheStats_t stats = { indexCount / 3, 0, 0, 0.0f, 0.0f };
+
+	vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t timestamp = uint32_t(cacheSize) + 1;
+
+	for (size_t i = 0; i < indexCount; i += 3) {
+		stats.missCount += _updateCache(pIndices[i], pIndices[i + 1], pIndices[i + 2],
+			uint32_t(cacheSize), timestamps.data(), timestamp);
+	}
+
+	// every referenced vertex has been added to the cache at least once
+	for (size_t i = 0; i < vertexCount; ++i) {
+		stats.vertexCount += timestamps[i] != 0;
+	}
+
+	_finishStats(stats);
+	return stats;
+}
+
+void GLTFMeshOptimizer::optimizeVertexCache(uint32_t* pResult, const uint32_t* pIndices,
+	size_t indexCount, size_t vertexCount)
+{
+	F_ASSERT(indexCount % 3 == 0 && pResult != pIndices);
+
+	static const scoreTables_t tables;
+
+	size_t faceCount = indexCount / 3;
+	if (faceCount == 0) {
+		return;
+	}
+
+	// triangles adjacent to each vertex, emitted triangles are swapped to the end of the list
+	vector<uint32_t> valence(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; ++i) {
+		valence[pIndices[i]]++;
+	}
+
+	vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		offsets[i + 1] = offsets[i] + valence[i];
+	}
+
+	vector<uint32_t> adjacency(indexCount);
+	{
+		vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indexCount; ++i) {
+			adjacency[fill[pIndices[i]]++] = uint32_t(i / 3);
+		}
+	}
+
+	vector<uint32_t> cachePosition(vertexCount, _NONE);
+	vector<float> vertexScore(vertexCount);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		vertexScore[i] = _vertexScore(tables, _NONE, valence[i]);
+	}
+
+	vector<float> triangleScore(faceCount);
+	vector<char> isEmitted(faceCount, 0);
+	for (size_t i = 0; i < faceCount; ++i) {
+		triangleScore[i] = vertexScore[pIndices[i * 3]] + vertexScore[pIndices[i * 3 + 1]] + vertexScore[pIndices[i * 3 + 2]];
+	}
+
+	uint32_t cache[_FORSYTH_CACHE_SIZE + 3];
+	uint32_t newCache[_FORSYTH_CACHE_SIZE + 3];
+	size_t cacheCount = 0;
+
+	uint32_t best = 0;
+	for (size_t i = 1; i < faceCount; ++i) {
+		if (triangleScore[i] > triangleScore[best]) {
+			best = uint32_t(i);
+		}
+	}
+
+	size_t cursor = 0;
+
+	for (size_t face = 0; face < faceCount; ++face) {
+		// no candidate in the cache: continue with the next triangle not yet emitted
+		if (best == _NONE) {
+			while (isEmitted[cursor]) {
+				cursor++;
+			}
+			best = uint32_t(cursor);
+		}
+
+		const uint32_t* pTriangle = pIndices + best * 3;
+		pResult[face * 3 + 0] = pTriangle[0];
+		pResult[face * 3 + 1] = pTriangle[1];
+		pResult[face * 3 + 2] = pTriangle[2];
+		isEmitted[best] = 1;
+
+		// remove the triangle from its vertices' adjacency
+		size_t newCount = 0;
+		for (size_t k = 0; k < 3; ++k) {
+			uint32_t v = pTriangle[k];
+			uint32_t* pList = adjacency.data() + offsets[v];
+			for (uint32_t j = 0; j < valence[v]; ++j) {
+				if (pList[j] == best) {
+					pList[j] = pList[valence[v] - 1];
+					valence[v]--;
+					break;
+				}
+			}
+
+			bool isCached = false;
+			for (size_t j = 0; j < newCount; ++j) {
+				isCached = isCached || newCache[j] == v;
+			}
+			if (!isCached) {
+				newCache[newCount++] = v;
+			}
+		}
+
+		// LRU cache, the triangle's vertices move to the front
+		for (size_t i = 0; i < cacheCount; ++i) {
+			uint32_t v = cache[i];
+			if (v != pTriangle[0] && v != pTriangle[1] && v != pTriangle[2]) {
+				newCache[newCount++] = v;
+			}
+		}
+
+		// rescore vertices in the cache and those dropped from it, propagate to their triangles
+		for (size_t i = 0; i < newCount; ++i) {
+			uint32_t v = newCache[i];
+			cachePosition[v] = i < _FORSYTH_CACHE_SIZE ? uint32_t(i) : _NONE;
+
+			float score = _vertexScore(tables, cachePosition[v], valence[v]);
+			float delta = score - vertexScore[v];
+			vertexScore[v] = score;
+
+			const uint32_t* pList = adjacency.data() + offsets[v];
+			for (uint32_t j = 0; j < valence[v]; ++j) {
+				triangleScore[pList[j]] += delta;
+			}
+		}
+
+		cacheCount = std::min(newCount, _FORSYTH_CACHE_SIZE);
+		std::memcpy(cache, newCache, cacheCount * sizeof(uint32_t));
+
+		// the next triangle is the best one using a cached vertex
+		best = _NONE;
+		float bestScore = -1.0f;
+		for (size_t i = 0; i < cacheCount; ++i) {
+			uint32_t v = cache[i];
+			const uint32_t* pList = adjacency.data() + offsets[v];
+			for (uint32_t j = 0; j < valence[v]; ++j) {
+				if (triangleScore[pList[j]] > bestScore) {
+					bestScore = triangleScore[pList[j]];
+					best = pList[j];
+				}
+			}
+		}
+	}
+}
+
+void GLTFMeshOptimizer::optimizeOverdraw(uint32_t* pResult, const uint32_t* pIndices, size_t indexCount,
+	const float* pPositions, size_t vertexCount, float threshold)
+{
+	F_ASSERT(indexCount % 3 == 0 && pResult != pIndices);
+
+	size_t faceCount = indexCount / 3;
+	if (threshold < 1.0f || faceCount == 0) {
+		std::memcpy(pResult, pIndices, indexCount * sizeof(uint32_t));
+		return;
+	}
+
+	vector<uint32_t> timestamps(vertexCount, 0);
+	uint32_t timestamp = uint32_t(CACHE_SIZE) + 1;
+	const uint32_t cacheSize = uint32_t(CACHE_SIZE);
+
+	// hard boundaries: a triangle missing all three vertices starts a new patch of the mesh
+	vector<uint32_t> hardClusters;
+	for (size_t i = 0; i < faceCount; ++i) {
+		const uint32_t* pTriangle = pIndices + i * 3;
+		uint32_t misses = _updateCache(pTriangle[0], pTriangle[1], pTriangle[2], cacheSize, timestamps.data(), timestamp);
+		if (i == 0 || misses == 3) {
+			hardClusters.push_back(uint32_t(i));
+		}
+	}
+
+	// soft boundaries: patches are split wherever the running ACMR reaches the patch's ACMR
+	// times the threshold, so the clusters can be reordered without losing cache efficiency
+	vector<uint32_t> clusters;
+	for (size_t c = 0; c < hardClusters.size(); ++c) {
+		size_t start = hardClusters[c];
+		size_t end = c + 1 < hardClusters.size() ? hardClusters[c + 1] : faceCount;
+
+		timestamp += cacheSize + 1;
+		uint32_t clusterMisses = 0;
+		for (size_t i = start; i < end; ++i) {
+			const uint32_t* pTriangle = pIndices + i * 3;
+			clusterMisses += _updateCache(pTriangle[0], pTriangle[1], pTriangle[2], cacheSize, timestamps.data(), timestamp);
+		}
+
+		float clusterThreshold = threshold * float(clusterMisses) / float(end - start);
+		size_t first = clusters.size();
+		clusters.push_back(uint32_t(start));
+
+		timestamp += cacheSize + 1;
+		uint32_t runningMisses = 0;
+		uint32_t runningFaces = 0;
+
+		for (size_t i = start; i < end; ++i) {
+			const uint32_t* pTriangle = pIndices + i * 3;
+			runningMisses += _updateCache(pTriangle[0], pTriangle[1], pTriangle[2], cacheSize, timestamps.data(), timestamp);
+			runningFaces++;
+
+			if (float(runningMisses) / float(runningFaces) <= clusterThreshold) {
+				clusters.push_back(uint32_t(i + 1));
+				timestamp += cacheSize + 1;
+				runningMisses = 0;
+				runningFaces = 0;
+			}
+		}
+
+		// drop the empty cluster at the end, or merge the incomplete last cluster into its predecessor
+		if (clusters.back() == end || (runningFaces > 0 && clusters.size() - first > 1)) {
+			clusters.pop_back();
+		}
+	}
+
+	// the mesh centroid weighs vertices by their number of references
+	float meshCentroid[3] = { 0.0f, 0.0f, 0.0f };
+	for (size_t i = 0; i < indexCount; ++i) {
+		const float* p = pPositions + pIndices[i] * 3;
+		meshCentroid[0] += p[0];
+		meshCentroid[1] += p[1];
+		meshCentroid[2] += p[2];
+	}
+	for (size_t k = 0; k < 3; ++k) {
+		meshCentroid[k] /= float(indexCount);
+	}
+
+	// clusters facing away from the centroid are likely in front of the others, draw them first
+	size_t clusterCount = clusters.size();
+	vector<float> sortKeys(clusterCount);
+
+	for (size_t c = 0; c < clusterCount; ++c) {
+		size_t start = clusters[c];
+		size_t end = c + 1 < clusterCount ? clusters[c + 1] : faceCount;
+
+		float area = 0.0f;
+		float centroid[3] = { 0.0f, 0.0f, 0.0f };
+		float normal[3] = { 0.0f, 0.0f, 0.0f };
+
+		for (size_t i = start; i < end; ++i) {
+			const float* p0 = pPositions + pIndices[i * 3] * 3;
+			const float* p1 = pPositions + pIndices[i * 3 + 1] * 3;
+			const float* p2 = pPositions + pIndices[i * 3 + 2] * 3;
+
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float triangleArea = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+
+			for (size_t k = 0; k < 3; ++k) {
+				centroid[k] += (p0[k] + p1[k] + p2[k]) * (triangleArea / 3.0f);
+				normal[k] += n[k];
+			}
+			area += triangleArea;
+		}
+
+		float invArea = area > 0.0f ? 1.0f / area : 0.0f;
+		float normalLength = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		float invNormalLength = normalLength > 0.0f ? 1.0f / normalLength : 0.0f;
+
+		float key = 0.0f;
+		for (size_t k = 0; k < 3; ++k) {
+			key += (centroid[k] * invArea - meshCentroid[k]) * normal[k] * invNormalLength;
+		}
+		sortKeys[c] = key;
+	}
+
+	vector<uint32_t> order(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c) {
+		order[c] = uint32_t(c);
+	}
+
+	std::stable_sort(order.begin(), order.end(), [&sortKeys](uint32_t a, uint32_t b) {
+		return sortKeys[a] > sortKeys[b];
+	});
+
+	uint32_t* pDest = pResult;
+	for (uint32_t c : order) {
+		size_t start = clusters[c];
+		size_t end = c + 1 < clusterCount ? clusters[c + 1] : faceCount;
+		std::memcpy(pDest, pIndices + start * 3, (end - start) * 3 * sizeof(uint32_t));
+		pDest += (end - start) * 3;
+	}
+}
+
+size_t GLTFMeshOptimizer::optimizeVertexFetchRemap(uint32_t* pRemap, const uint32_t* pIndices,
+	size_t indexCount, size_t vertexCount)
+{
+	std::fill(pRemap, pRemap + vertexCount, _NONE);
+
+	uint32_t next = 0;
+	for (size_t i = 0; i < indexCount; ++i) {
+		if (pRemap[pIndices[i]] == _NONE) {
+			pRemap[pIndices[i]] = next++;
+		}
+	}
+
+	size_t referencedCount = next;
+	for (size_t i = 0; i < vertexCount; ++i) {
+		if (pRemap[i] == _NONE) {
+			pRemap[i] = next++;
+		}
+	}
+
+	return referencedCount;
+}
+
+void GLTFMeshOptimizer::_findJobs(vector<job_t>& jobs) const
+{
+	// accessors and buffer views shared between primitives keep their vertex order
+	vector<int> useCount(_pAsset->_accessors.size(), 0);
+	vector<vector<const GLTFAccessor*>> viewAccessors(_pAsset->_bufferViews.size());
+	vector<bool> isViewShared(_pAsset->_bufferViews.size(), false);
+
+	auto forEachAccessor = [](const GLTFPrimitive& primitive, const std::function<void(const GLTFAccessor*)>& fn) {
+		if (primitive.indices()) {
+			fn(primitive.indices());
+		}
+		for (auto& attribute : primitive.attributes()) {
+			fn(attribute.pAccessor);
+		}
+		for (auto& target : primitive.targets()) {
+			for (auto& attribute : target) {
+				fn(attribute.pAccessor);
+			}
+		}
+	};
+
+	for (auto pMesh : _pAsset->_meshes) {
+		for (auto& primitive : pMesh->primitives()) {
+			forEachAccessor(primitive, [&useCount](const GLTFAccessor* pAccessor) {
+				if (pAccessor) {
+					useCount[pAccessor->index()]++;
+				}
+			});
+		}
+	}
+
+	for (auto pAccessor : _pAsset->_accessors) {
+		if (pAccessor->bufferView()) {
+			viewAccessors[pAccessor->bufferView()->index()].push_back(pAccessor);
+		}
+	}
+	for (auto pImage : _pAsset->_images) {
+		if (pImage->bufferView()) {
+			isViewShared[pImage->bufferView()->index()] = true;
+		}
+	}
+
+	// views of compressed data must keep their contents
+	auto isPlainView = [](const GLTFBufferView* pBufferView) {
+		return pBufferView && pBufferView->extensions().empty() && !pBufferView->buffer()->isFallback();
+	};
+
+	for (auto pMesh : _pAsset->_meshes) {
+		for (auto& primitive : const_cast<GLTFMesh*>(pMesh)->primitives()) {
+			const GLTFAccessor* pIndices = primitive.indices();
+			const GLTFAccessor* pPositions = primitive.attributeAccessor(GLTFAttributeType::POSITION);
+
+			// extensions like Draco or meshlets describe the primitive's current data
+			bool isEligible = primitive.extensions().empty()
+				&& primitive.mode() == GLTFPrimitiveMode::TRIANGLES
+				&& pIndices && isPlainView(pIndices->bufferView())
+				&& useCount[pIndices->index()] == 1
+				&& pIndices->elementCount() > 0 && pIndices->elementCount() % 3 == 0
+				&& pIndices->type() == GLTFAccessorType::SCALAR
+				&& pPositions && isPlainView(pPositions->bufferView())
+				&& pPositions->type() == GLTFAccessorType::VEC3;
+
+			if (!isEligible) {
+				continue;
+			}
+
+			job_t job;
+			job.pPrimitive = &primitive;
+			job.vertexCount = pPositions->elementCount();
+			job.isRemapping = _isFetchOptimizing;
+
+			// vertex accessors, each must belong to this primitive only
+			vector<const GLTFAccessor*> accessors;
+			forEachAccessor(primitive, [&](const GLTFAccessor* pAccessor) {
+				if (pAccessor == pIndices) {
+					return;
+				}
+				job.isRemapping = job.isRemapping && pAccessor && isPlainView(pAccessor->bufferView())
+					&& useCount[pAccessor->index()] == 1 && pAccessor->elementCount() == job.vertexCount;
+				accessors.push_back(pAccessor);
+			});
+
+			// views holding vertex data are permuted as a whole, all of their accessors must be in the set
+			for (size_t i = 0; i < accessors.size() && job.isRemapping; ++i) {
+				GLTFBufferView* pBufferView = accessors[i]->bufferView();
+				bool isKnown = false;
+				for (auto& view : job.views) {
+					isKnown = isKnown || view.pBufferView == pBufferView;
+				}
+				if (isKnown) {
+					continue;
+				}
+
+				const vector<const GLTFAccessor*>& users = viewAccessors[pBufferView->index()];
+				viewRemap_t view = { pBufferView, size_t(-1), 0, 0, {} };
+				size_t byteEnd = 0;
+
+				job.isRemapping = !isViewShared[pBufferView->index()];
+				for (auto pUser : users) {
+					job.isRemapping = job.isRemapping
+						&& std::find(accessors.begin(), accessors.end(), pUser) != accessors.end()
+						&& (view.byteStride == 0 || pUser->elementStride() == view.byteStride);
+
+					view.byteStride = pUser->elementStride();
+					view.byteOffset = std::min(view.byteOffset, pUser->byteOffset());
+					byteEnd = std::max(byteEnd, pUser->byteOffset() + pUser->elementByteSize());
+					view.accessors.push_back(const_cast<GLTFAccessor*>(pUser));
+				}
+
+				view.vertexByteLength = byteEnd - view.byteOffset;
+				job.isRemapping = job.isRemapping
+					&& view.vertexByteLength <= view.byteStride
+					&& view.byteOffset + (job.vertexCount - 1) * view.byteStride + view.vertexByteLength
+						<= pBufferView->byteLength();
+
+				job.views.push_back(view);
+			}
+
+			if (!job.isRemapping) {
+				job.views.clear();
+			}
+
+			jobs.push_back(std::move(job));
+		}
+	}
+}
+
+void GLTFMeshOptimizer::_optimizeJob(job_t& job) const
+{
+	const GLTFPrimitive* pPrimitive = job.pPrimitive;
+	size_t vertexCount = job.vertexCount;
+
+	GLTFAccessorView<uint32_t, 1> indexView(pPrimitive->indices());
+	GLTFAccessorView<float, 3> positionView(pPrimitive->attributeAccessor(GLTFAttributeType::POSITION));
+
+	size_t indexCount = indexView.size();
+	vector<uint32_t> indices(indexCount);
+	for (size_t i = 0; i < indexCount; ++i) {
+		indices[i] = indexView.value(i, 0);
+		if (indices[i] >= vertexCount) {
+			return;
+		}
+	}
+
+	vector<float> positions(vertexCount * 3);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		positionView.get(i, &positions[i * 3]);
+	}
+
+	job.statsBefore = analyzeVertexCache(indices.data(), indexCount, vertexCount);
+
+	vector<uint32_t> cacheOrder(indexCount);
+	optimizeVertexCache(cacheOrder.data(), indices.data(), indexCount, vertexCount);
+	optimizeOverdraw(indices.data(), cacheOrder.data(), indexCount, positions.data(), vertexCount, _overdrawThreshold);
+
+	if (job.isRemapping) {
+		job.remap.resize(vertexCount);
+		optimizeVertexFetchRemap(job.remap.data(), indices.data(), indexCount, vertexCount);
+		for (size_t i = 0; i < indexCount; ++i) {
+			indices[i] = job.remap[indices[i]];
+		}
+	}
+
+	job.statsAfter = analyzeVertexCache(indices.data(), indexCount, vertexCount);
+	job.indices.swap(indices);
+}
+
+void GLTFMeshOptimizer::_applyJob(const job_t& job, GLTFBuffer* pBuffer)
+{
+	auto pIndices = const_cast<GLTFAccessor*>(job.pPrimitive->indices());
+	size_t indexCount = job.indices.size();
+	size_t indexSize = pIndices->elementByteSize();
+
+	GLTFBufferView* pIndexView = pBuffer->allocate(indexCount * indexSize);
+	pIndexView->setTarget(GLTFBufferViewTarget::ELEMENT_ARRAY_BUFFER);
+	char* pIndexData = pIndexView->data();
+
+	for (size_t i = 0; i < indexCount; ++i) {
+		uint32_t index = job.indices[i];
+		switch (indexSize) {
+		case 1: pIndexData[i] = char(index); break;
+		case 2: { uint16_t value = uint16_t(index); std::memcpy(pIndexData + i * 2, &value, 2); break; }
+		default: std::memcpy(pIndexData + i * 4, &index, 4); break;
+		}
+	}
+
+	pIndices->setBufferView(pIndexView, 0);
+
+	// bytes outside the vertex data, e.g. padding, are copied unchanged
+	for (auto& view : job.views) {
+		const GLTFBufferView* pSource = view.pBufferView;
+		GLTFBufferView* pBufferView = pBuffer->allocate(pSource->byteLength());
+		pBufferView->setByteStride(pSource->byteStride());
+		pBufferView->setTarget(pSource->target());
+
+		const char* pSourceData = pSource->data();
+		char* pData = pBufferView->data();
+		std::memcpy(pData, pSourceData, pSource->byteLength());
+
+		for (size_t i = 0; i < job.vertexCount; ++i) {
+			std::memcpy(pData + view.byteOffset + job.remap[i] * view.byteStride,
+				pSourceData + view.byteOffset + i * view.byteStride, view.vertexByteLength);
+		}
+
+		for (auto pAccessor : view.accessors) {
+			pAccessor->setBufferView(pBufferView, pAccessor->byteOffset());
+		}
+	}
+}
+
+void GLTFMeshOptimizer::_addStats(cacheStats_t& total, const cacheStats_t& stats)
+{
+	total.triangleCount += stats.triangleCount;
+	total.vertexCount += stats.vertexCount;
+	total.missCount += stats.missCount;
+	_finishStats(total);
+}
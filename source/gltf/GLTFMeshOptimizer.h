@@ -0,0 +1,138 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_MESHOPTIMIZER_H
+#define _FLOWLIBS_GLTF_MESHOPTIMIZER_H
+
+#include "library.h"
+#include "GLTFConstants.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFAsset;
+	class GLTFBuffer;
+	class GLTFBufferView;
+	class GLTFAccessor;
+	class GLTFPrimitive;
+
+	/// Reorders the triangles and vertices of indexed triangle lists for rendering
+	/// performance. Triangles are ordered for the post-transform vertex cache following
+	/// Tom Forsyth's "Linear-Speed Vertex Cache Optimisation", then clusters of triangles
+	/// are sorted to reduce overdraw, trading a bounded loss in cache efficiency.
+	/// Finally, vertices are renumbered in the order of first use, which makes vertex
+	/// fetches sequential; the data of all attributes and morph targets is permuted.
+	class F_GLTF_EXPORT GLTFMeshOptimizer
+	{
+	public:
+		/// Size of the FIFO cache simulated to compute statistics and overdraw clusters.
+		static const size_t CACHE_SIZE = 16;
+
+		/// Statistics of a simulated FIFO post-transform vertex cache.
+		struct cacheStats_t
+		{
+			size_t triangleCount;
+			/// Number of distinct vertices referenced by the triangles.
+			size_t vertexCount;
+			size_t missCount;
+			/// Average cache miss ratio, misses per triangle. 0.5 is optimal for large grids, 3 is worst.
+			float acmr;
+			/// Average transformed vertex ratio, misses per vertex. 1 is optimal.
+			float atvr;
+		};
+
+		GLTFMeshOptimizer(GLTFAsset* pAsset);
+
+		/// Sets the ACMR a cluster may exceed the cache optimized order by to reduce
+		/// overdraw. Values below 1 disable overdraw optimization. Default is 1.05.
+		void setOverdrawThreshold(float threshold);
+		/// Enables or disables renumbering vertices in the order of first use. Default is true.
+		void setVertexFetchOptimization(bool enabled);
+
+		/// Optimizes all indexed triangle list primitives in parallel. Reordered indices and
+		/// vertices are written to new buffer views in pBuffer, the original views remain
+		/// in the asset until removed by GLTFAsset::compact(). Vertices are only renumbered
+		/// if their buffer views are used by no other primitive. Primitives with extensions
+		/// are left unchanged.
+		/// Returns false if the data of a primitive is not available.
+		bool optimize(GLTFBuffer* pBuffer);
+
+		/// Number of optimized primitives.
+		size_t primitiveCount() const { return _primitiveCount; }
+		/// Cache statistics of all optimized primitives before optimization.
+		const cacheStats_t& statsBefore() const { return _statsBefore; }
+		/// Cache statistics of all optimized primitives after optimization.
+		const cacheStats_t& statsAfter() const { return _statsAfter; }
+
+		const std::string& error() const { return _error; }
+
+		/// Simulates a FIFO vertex cache of the given size on a triangle list.
+		static cacheStats_t analyzeVertexCache(const uint32_t* pIndices, size_t indexCount,
+			size_t vertexCount, size_t cacheSize = CACHE_SIZE);
+
+		/// Reorders triangles for the post-transform vertex cache using Forsyth's algorithm.
+		/// pResult receives indexCount indices and must not alias pIndices.
+		static void optimizeVertexCache(uint32_t* pResult, const uint32_t* pIndices,
+			size_t indexCount, size_t vertexCount);
+		/// Splits a cache optimized triangle list into clusters and sorts them front to back,
+		/// approximated by the cluster's distance from the mesh centroid along its normal.
+		/// Clusters are split only where their ACMR doesn't exceed threshold times the ACMR
+		/// of the input. pPositions holds 3 floats per vertex, pResult must not alias pIndices.
+		static void optimizeOverdraw(uint32_t* pResult, const uint32_t* pIndices, size_t indexCount,
+			const float* pPositions, size_t vertexCount, float threshold);
+		/// Computes a renumbering of vertices in the order of first use. pRemap receives the
+		/// new index of each vertex; unreferenced vertices follow in their original order.
+		/// Returns the number of referenced vertices.
+		static size_t optimizeVertexFetchRemap(uint32_t* pRemap, const uint32_t* pIndices,
+			size_t indexCount, size_t vertexCount);
+
+	private:
+		/// Interleaved vertex data of a buffer view, permuted as a whole.
+		struct viewRemap_t
+		{
+			GLTFBufferView* pBufferView;
+			size_t byteOffset;
+			size_t byteStride;
+			size_t vertexByteLength;
+			std::vector<GLTFAccessor*> accessors;
+		};
+
+		struct job_t
+		{
+			GLTFPrimitive* pPrimitive;
+			size_t vertexCount;
+			bool isRemapping;
+			std::vector<viewRemap_t> views;
+			std::vector<uint32_t> indices;
+			std::vector<uint32_t> remap;
+			cacheStats_t statsBefore;
+			cacheStats_t statsAfter;
+		};
+
+		void _findJobs(std::vector<job_t>& jobs) const;
+		void _optimizeJob(job_t& job) const;
+		void _applyJob(const job_t& job, GLTFBuffer* pBuffer);
+
+		static void _addStats(cacheStats_t& total, const cacheStats_t& stats);
+
+		GLTFAsset* _pAsset;
+		float _overdrawThreshold;
+		bool _isFetchOptimizing;
+
+		size_t _primitiveCount;
+		cacheStats_t _statsBefore;
+		cacheStats_t _statsAfter;
+
+		std::string _error;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_MESHOPTIMIZER_H
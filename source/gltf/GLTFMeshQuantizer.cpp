@@ -0,0 +1,484 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFMeshQuantizer.h"
+#include "GLTFAsset.h"
+#include "GLTFNode.h"
+#include "GLTFMesh.h"
+#include "GLTFPrimitive.h"
+#include "GLTFBuffer.h"
+#include "GLTFBufferView.h"
+#include "GLTFAccessor.h"
+#include "GLTFVertexBuilder.h"
+#include "GLTFBounds.h"
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(FLOW_SSE41)
+#  include <smmintrin.h>
+#  define F_QUANTIZE_SSE41
+#endif
+
+using namespace flow;
+using std::string;
+using std::vector;
+
+
+namespace
+{
+	const char* _EXTENSION_NAME = "KHR_mesh_quantization";
+
+	template<typename T>
+	inline T _encodeValue(float value, float offset, float scale)
+	{
+		float v = (value - offset) * scale;
+		v = flow::max(v, float(std::numeric_limits<T>::lowest()));
+		v = flow::min(v, float(std::numeric_limits<T>::max()));
+
+		// rounds to nearest even, as the vector conversion does
+		return T(std::lrint(v));
+	}
+
+	template<typename T>
+	void _encodeScalar(const char* pData, size_t first, size_t last, size_t componentCount, size_t byteStride,
+		const float* pOffset, const float* pScale, T* pResult, size_t resultComponentCount)
+	{
+		for (size_t i = first; i < last; ++i) {
+			float values[4];
+			std::memcpy(values, pData + i * byteStride, componentCount * sizeof(float));
+
+			T* pElement = pResult + i * resultComponentCount;
+			for (size_t j = 0; j < resultComponentCount; ++j) {
+				pElement[j] = j < componentCount ? _encodeValue<T>(values[j], pOffset[j], pScale[j]) : T(0);
+			}
+		}
+	}
+
+#ifdef F_QUANTIZE_SSE41
+
+	// stores 4 vectors of 4 32-bit integers as 16 values, or 2 vectors as 8 values, saturated to T
+	template<typename T>
+	struct _Pack;
+
+	template<> struct _Pack<int8_t>
+	{
+		static void store16(int8_t* p, __m128i a, __m128i b, __m128i c, __m128i d) {
+			_mm_storeu_si128((__m128i*)p, _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+		}
+		static void store8(int8_t* p, __m128i a, __m128i b) {
+			_mm_storel_epi64((__m128i*)p, _mm_packs_epi16(_mm_packs_epi32(a, b), _mm_setzero_si128()));
+		}
+	};
+
+	template<> struct _Pack<int16_t>
+	{
+		static void store16(int16_t* p, __m128i a, __m128i b, __m128i c, __m128i d) {
+			_mm_storeu_si128((__m128i*)p, _mm_packs_epi32(a, b));
+			_mm_storeu_si128((__m128i*)(p + 8), _mm_packs_epi32(c, d));
+		}
+		static void store8(int16_t* p, __m128i a, __m128i b) {
+			_mm_storeu_si128((__m128i*)p, _mm_packs_epi32(a, b));
+		}
+	};
+
+	template<> struct _Pack<uint16_t>
+	{
+		static void store16(uint16_t* p, __m128i a, __m128i b, __m128i c, __m128i d) {
+			_mm_storeu_si128((__m128i*)p, _mm_packus_epi32(a, b));
+			_mm_storeu_si128((__m128i*)(p + 8), _mm_packus_epi32(c, d));
+		}
+		static void store8(uint16_t* p, __m128i a, __m128i b) {
+			_mm_storeu_si128((__m128i*)p, _mm_packus_epi32(a, b));
+		}
+	};
+
+	template<typename T>
+	void _encode(const char* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+		const float* pOffset, const float* pScale, T* pResult, size_t resultComponentCount)
+	{
+		float offset4[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		float scale4[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		for (size_t j = 0; j < componentCount; ++j) {
+			offset4[j] = pOffset[j];
+			scale4[j] = pScale[j];
+		}
+
+		const __m128 offset = _mm_loadu_ps(offset4);
+		const __m128 scale = _mm_loadu_ps(scale4);
+		const __m128 lowest = _mm_set1_ps(float(std::numeric_limits<T>::lowest()));
+		const __m128 highest = _mm_set1_ps(float(std::numeric_limits<T>::max()));
+
+		// lanes beyond the element's components are cleared, they may hold the next element
+		const __m128 mask = _mm_castsi128_ps(_mm_set_epi32(componentCount > 3 ? -1 : 0,
+			componentCount > 2 ? -1 : 0, componentCount > 1 ? -1 : 0, -1));
+
+		// each element is read with a 16 byte load, which must not reach past the data
+		size_t byteLength = elementCount > 0 ? (elementCount - 1) * byteStride + componentCount * sizeof(float) : 0;
+		size_t safeCount = byteLength >= 16 ? flow::min(elementCount, (byteLength - 16) / byteStride + 1) : 0;
+
+		size_t i = 0;
+		for (; i + 4 <= safeCount; i += 4) {
+			__m128i q[4];
+			for (size_t k = 0; k < 4; ++k) {
+				__m128 v = _mm_and_ps(_mm_loadu_ps((const float*)(pData + (i + k) * byteStride)), mask);
+				v = _mm_mul_ps(_mm_sub_ps(v, offset), scale);
+				v = _mm_min_ps(_mm_max_ps(v, lowest), highest);
+				q[k] = _mm_cvtps_epi32(v);
+			}
+
+			if (resultComponentCount == 4) {
+				_Pack<T>::store16(pResult + i * 4, q[0], q[1], q[2], q[3]);
+			}
+			else {
+				_Pack<T>::store8(pResult + i * 2, _mm_unpacklo_epi64(q[0], q[1]), _mm_unpacklo_epi64(q[2], q[3]));
+			}
+		}
+
+		_encodeScalar(pData, i, elementCount, componentCount, byteStride, pOffset, pScale, pResult, resultComponentCount);
+	}
+
+#else
+
+	template<typename T>
+	void _encode(const char* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+		const float* pOffset, const float* pScale, T* pResult, size_t resultComponentCount)
+	{
+		_encodeScalar(pData, 0, elementCount, componentCount, byteStride, pOffset, pScale, pResult, resultComponentCount);
+	}
+
+#endif
+
+	// float attributes with a buffer view, Draco compressed attributes have none
+	bool _isFloatAttribute(const GLTFAccessor* pAccessor)
+	{
+		return pAccessor && pAccessor->bufferView() && pAccessor->component() == GLTFAccessorComponent::FLOAT;
+	}
+}
+
+GLTFMeshQuantizer::GLTFMeshQuantizer(GLTFAsset* pAsset) :
+	_pAsset(pAsset),
+	_highPrecisionNormals(false),
+	_accessorCount(0),
+	_sourceByteLength(0),
+	_resultByteLength(0)
+{
+	F_ASSERT(pAsset);
+}
+
+void GLTFMeshQuantizer::setHighPrecisionNormals(bool enabled)
+{
+	_highPrecisionNormals = enabled;
+}
+
+bool GLTFMeshQuantizer::quantize(GLTFBuffer* pBuffer)
+{
+	_accessorCount = 0;
+	_sourceByteLength = 0;
+	_resultByteLength = 0;
+	_error.clear();
+
+	// check all data is available before changing anything
+	for (auto pMesh : _pAsset->_meshes) {
+		for (auto& primitive : pMesh->primitives()) {
+			if (!primitive.extensions().empty()) {
+				continue;
+			}
+			for (auto& attribute : primitive.attributes()) {
+				if (_isFloatAttribute(attribute.pAccessor) && !attribute.pAccessor->data()) {
+					_error = string("attribute data not available: ") + attribute.type.name();
+					return false;
+				}
+			}
+		}
+	}
+
+	// nodes instancing each mesh, positions can only be quantized if all of them take the transform
+	vector<vector<GLTFNode*>> instances(_pAsset->_meshes.size());
+	vector<bool> canFold(_pAsset->_meshes.size(), true);
+
+	for (auto pNode : _pAsset->_nodes) {
+		auto pMeshNode = dynamic_cast<const GLTFMeshNode*>(pNode);
+		if (pMeshNode && pMeshNode->mesh()) {
+			size_t index = pMeshNode->mesh()->index();
+			instances[index].push_back(const_cast<GLTFNode*>(pNode));
+			canFold[index] = canFold[index] && pNode->children().empty();
+		}
+	}
+
+	vector<meshTransform_t> transforms(_pAsset->_meshes.size());
+
+	for (size_t i = 0; i < _pAsset->_meshes.size(); ++i) {
+		auto pMesh = const_cast<GLTFMesh*>(_pAsset->_meshes[i]);
+
+		transforms[i].isQuantized = false;
+		if (!instances[i].empty() && canFold[i]) {
+			_computeMeshTransform(pMesh, transforms[i]);
+		}
+
+		for (auto& primitive : pMesh->primitives()) {
+			_quantizePrimitive(primitive, transforms[i], pBuffer);
+		}
+
+		if (transforms[i].isQuantized) {
+			for (auto pNode : instances[i]) {
+				_foldTransform(pNode, transforms[i]);
+			}
+		}
+	}
+
+	if (_accessorCount > 0) {
+		_pAsset->useExtension(_EXTENSION_NAME, true);
+	}
+
+	return true;
+}
+
+void GLTFMeshQuantizer::encode(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	const float* pOffset, const float* pScale, int8_t* pResult, size_t resultComponentCount)
+{
+	F_ASSERT((resultComponentCount == 2 || resultComponentCount == 4) && componentCount <= resultComponentCount);
+	_encode((const char*)pData, elementCount, componentCount, byteStride, pOffset, pScale, pResult, resultComponentCount);
+}
+
+void GLTFMeshQuantizer::encode(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	const float* pOffset, const float* pScale, int16_t* pResult, size_t resultComponentCount)
+{
+	F_ASSERT((resultComponentCount == 2 || resultComponentCount == 4) && componentCount <= resultComponentCount);
+	_encode((const char*)pData, elementCount, componentCount, byteStride, pOffset, pScale, pResult, resultComponentCount);
+}
+
+void GLTFMeshQuantizer::encode(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+	const float* pOffset, const float* pScale, uint16_t* pResult, size_t resultComponentCount)
+{
+	F_ASSERT((resultComponentCount == 2 || resultComponentCount == 4) && componentCount <= resultComponentCount);
+	_encode((const char*)pData, elementCount, componentCount, byteStride, pOffset, pScale, pResult, resultComponentCount);
+}
+
+void GLTFMeshQuantizer::_quantizePrimitive(GLTFPrimitive& primitive, const meshTransform_t& transform, GLTFBuffer* pBuffer)
+{
+	// extensions like Draco or meshlets describe the primitive's current data
+	const GLTFAccessor* pFirst = primitive.attributes().empty() ? nullptr : primitive.attributes().front().pAccessor;
+	if (!pFirst || !primitive.extensions().empty()) {
+		return;
+	}
+
+	// all attributes of a primitive have the same number of elements
+	GLTFVertexBuilder builder(_pAsset, pFirst->elementCount());
+	vector<vector<char>> storage;
+	vector<const GLTFAccessor*> sources;
+
+	const float zero[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+	const float normalScale = _highPrecisionNormals ? 32767.0f : 127.0f;
+	const float normalScales[4] = { normalScale, normalScale, normalScale, normalScale };
+
+	for (auto& attribute : primitive.attributes()) {
+		const GLTFAccessor* pAccessor = attribute.pAccessor;
+		if (!_isFloatAttribute(pAccessor)) {
+			continue;
+		}
+
+		GLTFAccessorType type = pAccessor->type();
+		size_t sourceCount = sources.size();
+
+		switch (attribute.type) {
+		case GLTFAttributeType::POSITION:
+			if (transform.isQuantized && type == GLTFAccessorType::VEC3) {
+				float scale = 32767.0f / transform.halfExtent;
+				const float scales[3] = { scale, scale, scale };
+				_addStream<int16_t>(builder, storage, attribute.type, pAccessor, transform.center, scales);
+			}
+			break;
+
+		case GLTFAttributeType::NORMAL:
+		case GLTFAttributeType::TANGENT:
+			if ((attribute.type == GLTFAttributeType::NORMAL && type == GLTFAccessorType::VEC3)
+					|| (attribute.type == GLTFAttributeType::TANGENT && type == GLTFAccessorType::VEC4)) {
+				if (_highPrecisionNormals) {
+					_addStream<int16_t>(builder, storage, attribute.type, pAccessor, zero, normalScales);
+				}
+				else {
+					_addStream<int8_t>(builder, storage, attribute.type, pAccessor, zero, normalScales);
+				}
+			}
+			break;
+
+		case GLTFAttributeType::TEXCOORD_0:
+		case GLTFAttributeType::TEXCOORD_1:
+			// coordinates outside [-1, 1] would require KHR_texture_transform and stay float
+			if (type == GLTFAccessorType::VEC2) {
+				float min[2], max[2];
+				_bounds(pAccessor, 2, min, max);
+
+				if (min[0] >= 0.0f && min[1] >= 0.0f && max[0] <= 1.0f && max[1] <= 1.0f) {
+					const float scales[2] = { 65535.0f, 65535.0f };
+					_addStream<uint16_t>(builder, storage, attribute.type, pAccessor, zero, scales);
+				}
+				else if (min[0] >= -1.0f && min[1] >= -1.0f && max[0] <= 1.0f && max[1] <= 1.0f) {
+					const float scales[2] = { 32767.0f, 32767.0f };
+					_addStream<int16_t>(builder, storage, attribute.type, pAccessor, zero, scales);
+				}
+			}
+			break;
+
+		default:
+			break;
+		}
+
+		if (builder.streamCount() > sourceCount) {
+			sources.push_back(pAccessor);
+		}
+	}
+
+	if (sources.empty()) {
+		return;
+	}
+
+	GLTFBufferView* pBufferView = builder.build(pBuffer, nullptr);
+
+	for (size_t i = 0; i < sources.size(); ++i) {
+		primitive.setAttribute(builder.attribute(i), builder.accessor(i));
+		_sourceByteLength += sources[i]->elementCount() * sources[i]->elementByteSize();
+	}
+
+	_accessorCount += sources.size();
+	_resultByteLength += pBufferView->byteLength();
+}
+
+void GLTFMeshQuantizer::_computeMeshTransform(const GLTFMesh* pMesh, meshTransform_t& transform)
+{
+	float meshMin[3], meshMax[3];
+	for (size_t j = 0; j < 3; ++j) {
+		meshMin[j] = std::numeric_limits<float>::max();
+		meshMax[j] = std::numeric_limits<float>::lowest();
+	}
+
+	bool hasPositions = false;
+
+	for (auto& primitive : pMesh->primitives()) {
+		// morph target displacements would need the same scale, primitives with
+		// extensions keep their positions
+		if (!primitive.targets().empty() || !primitive.extensions().empty()) {
+			return;
+		}
+
+		const GLTFAccessor* pAccessor = primitive.attributeAccessor(GLTFAttributeType::POSITION);
+		if (!pAccessor) {
+			continue;
+		}
+
+		// all primitives share the node transform, positions must be quantized for all or none
+		float min[3], max[3];
+		if (!_isFloatAttribute(pAccessor) || pAccessor->type() != GLTFAccessorType::VEC3
+				|| !_bounds(pAccessor, 3, min, max)) {
+			return;
+		}
+
+		for (size_t j = 0; j < 3; ++j) {
+			meshMin[j] = flow::min(meshMin[j], min[j]);
+			meshMax[j] = flow::max(meshMax[j], max[j]);
+		}
+
+		hasPositions = true;
+	}
+
+	if (!hasPositions) {
+		return;
+	}
+
+	transform.halfExtent = 0.0f;
+	for (size_t j = 0; j < 3; ++j) {
+		transform.center[j] = 0.5f * (meshMin[j] + meshMax[j]);
+		transform.halfExtent = flow::max(transform.halfExtent, 0.5f * (meshMax[j] - meshMin[j]));
+	}
+
+	if (!(transform.halfExtent > 0.0f)) {
+		transform.halfExtent = 1.0f;
+	}
+
+	transform.isQuantized = true;
+}
+
+void GLTFMeshQuantizer::_foldTransform(GLTFNode* pNode, const meshTransform_t& transform)
+{
+	const float* c = transform.center;
+	const float s = transform.halfExtent;
+
+	// local * translate(center) * scale(halfExtent)
+	if (pNode->matrix()) {
+		Matrix4f dequantize;
+		dequantize[0].set(s, 0.0f, 0.0f, c[0]);
+		dequantize[1].set(0.0f, s, 0.0f, c[1]);
+		dequantize[2].set(0.0f, 0.0f, s, c[2]);
+		dequantize[3].set(0.0f, 0.0f, 0.0f, 1.0f);
+		pNode->setMatrix(*pNode->matrix() * dequantize);
+		return;
+	}
+
+	// the uniform scale commutes with the rotation, the result is a TRS transform again
+	Vector3f translation = pNode->translation() ? *pNode->translation() : Vector3f(0.0f, 0.0f, 0.0f);
+	Quaternion4f rotation = pNode->rotation() ? *pNode->rotation() : Quaternion4f(0.0f, 0.0f, 0.0f, 1.0f);
+	Vector3f scale = pNode->scale() ? *pNode->scale() : Vector3f(1.0f, 1.0f, 1.0f);
+
+	Vector3f center(scale.x * c[0], scale.y * c[1], scale.z * c[2]);
+	translation += rotation.rotate(center);
+	scale *= s;
+
+	pNode->setTRS(translation, rotation, scale);
+}
+
+template<typename T>
+void GLTFMeshQuantizer::_addStream(GLTFVertexBuilder& builder, vector<vector<char>>& storage,
+	GLTFAttributeType attribute, const GLTFAccessor* pAccessor, const float* pOffset, const float* pScale)
+{
+	size_t elementCount = pAccessor->elementCount();
+	size_t componentCount = pAccessor->type().componentCount();
+
+	// 3-component elements are padded to 4, vertex attributes must be 4 byte aligned
+	size_t resultComponentCount = componentCount == 3 ? 4 : componentCount;
+
+	storage.emplace_back(elementCount * resultComponentCount * sizeof(T));
+	T* pResult = (T*)storage.back().data();
+
+	encode((const float*)pAccessor->data(), elementCount, componentCount, pAccessor->elementStride(),
+		pOffset, pScale, pResult, resultComponentCount);
+
+	builder.addStream(attribute, pAccessor->type(), pResult, true, resultComponentCount * sizeof(T));
+}
+
+bool GLTFMeshQuantizer::_bounds(const GLTFAccessor* pAccessor, size_t componentCount, float* pMin, float* pMax)
+{
+	const char* pData = pAccessor->data();
+	size_t elementCount = pAccessor->elementCount();
+	size_t byteStride = pAccessor->elementStride();
+
+	if (!pData || elementCount == 0) {
+		return false;
+	}
+
+	if (byteStride == componentCount * sizeof(float)) {
+		GLTFBounds::compute((const float*)pData, elementCount, componentCount, pMin, pMax);
+		return true;
+	}
+
+	for (size_t j = 0; j < componentCount; ++j) {
+		pMin[j] = std::numeric_limits<float>::max();
+		pMax[j] = std::numeric_limits<float>::lowest();
+	}
+
+	for (size_t i = 0; i < elementCount; ++i) {
+		float values[4];
+		std::memcpy(values, pData + i * byteStride, componentCount * sizeof(float));
+		for (size_t j = 0; j < componentCount; ++j) {
+			pMin[j] = flow::min(pMin[j], values[j]);
+			pMax[j] = flow::max(pMax[j], values[j]);
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,104 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_MESHQUANTIZER_H
+#define _FLOWLIBS_GLTF_MESHQUANTIZER_H
+
+#include "library.h"
+#include "GLTFConstants.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFAsset;
+	class GLTFBuffer;
+	class GLTFMesh;
+	class GLTFNode;
+	class GLTFAccessor;
+	class GLTFPrimitive;
+	class GLTFVertexBuilder;
+
+	/// Converts float vertex attributes to normalized integers as permitted by the
+	/// KHR_mesh_quantization extension. Positions are stored as SHORT, normals and
+	/// tangents as BYTE, or SHORT in high precision mode, texture coordinates as
+	/// UNSIGNED_SHORT or SHORT if they lie within [0, 1] or [-1, 1].
+	///
+	/// Positions are mapped to [-1, 1] using the center and the largest half extent of the
+	/// mesh's bounds; the inverse transform is folded into every node instancing the mesh.
+	/// The scale is uniform, so normals and tangents need no adjustment. Positions stay
+	/// float if a mesh is not instanced, has morph targets or primitives with extensions,
+	/// or one of its nodes has children. Primitives with extensions are left unchanged.
+	class F_GLTF_EXPORT GLTFMeshQuantizer
+	{
+	public:
+		GLTFMeshQuantizer(GLTFAsset* pAsset);
+
+		/// Stores normals and tangents with 16 instead of 8 bits per component.
+		void setHighPrecisionNormals(bool enabled);
+
+		/// Quantizes the attributes of all meshes. The quantized attributes of a primitive
+		/// are interleaved in a single buffer view in pBuffer and replace the float accessors,
+		/// which remain in the asset until removed by GLTFAsset::compact(). Registers
+		/// KHR_mesh_quantization as a required extension if any attribute was quantized.
+		/// Returns false if an attribute's data is not available.
+		bool quantize(GLTFBuffer* pBuffer);
+
+		/// Number of quantized accessors.
+		size_t accessorCount() const { return _accessorCount; }
+		/// Size of the float data of the quantized attributes.
+		size_t sourceByteLength() const { return _sourceByteLength; }
+		/// Size of the quantized vertex data, including padding.
+		size_t resultByteLength() const { return _resultByteLength; }
+
+		const std::string& error() const { return _error; }
+
+		/// Quantizes elementCount elements of componentCount floats, read with the given
+		/// byte stride. Component j is mapped to round((value - pOffset[j]) * pScale[j]),
+		/// saturated to the range of the result type. The results are tightly packed
+		/// with resultComponentCount components per element (2 or 4, not less than
+		/// componentCount), padding components are zero. Vectorized with SSE4.1.
+		static void encode(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+			const float* pOffset, const float* pScale, int8_t* pResult, size_t resultComponentCount);
+		static void encode(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+			const float* pOffset, const float* pScale, int16_t* pResult, size_t resultComponentCount);
+		static void encode(const float* pData, size_t elementCount, size_t componentCount, size_t byteStride,
+			const float* pOffset, const float* pScale, uint16_t* pResult, size_t resultComponentCount);
+
+	private:
+		struct meshTransform_t
+		{
+			bool isQuantized;
+			float center[3];
+			float halfExtent;
+		};
+
+		void _quantizePrimitive(GLTFPrimitive& primitive, const meshTransform_t& transform, GLTFBuffer* pBuffer);
+		void _computeMeshTransform(const GLTFMesh* pMesh, meshTransform_t& transform);
+		void _foldTransform(GLTFNode* pNode, const meshTransform_t& transform);
+
+		template<typename T>
+		void _addStream(GLTFVertexBuilder& builder, std::vector<std::vector<char>>& storage,
+			GLTFAttributeType attribute, const GLTFAccessor* pAccessor, const float* pOffset, const float* pScale);
+
+		static bool _bounds(const GLTFAccessor* pAccessor, size_t componentCount, float* pMin, float* pMax);
+
+		GLTFAsset* _pAsset;
+		bool _highPrecisionNormals;
+
+		size_t _accessorCount;
+		size_t _sourceByteLength;
+		size_t _resultByteLength;
+
+		std::string _error;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_MESHQUANTIZER_H
@@ -0,0 +1,388 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFMeshletBuilder.h"
+#include "GLTFMeshletExtension.h"
+#include "GLTFAsset.h"
+#include "GLTFMesh.h"
+#include "GLTFPrimitive.h"
+#include "GLTFBuffer.h"
+#include "GLTFBufferView.h"
+#include "GLTFAccessor.h"
+#include "GLTFAccessorView.h"
+
+#include "../math/Vector3T.h"
+#include "../math/Range3T.h"
+#include "../core/ThreadPool.h"
+
+#include <cmath>
+#include <cstring>
+#include <algorithm>
+
+using namespace flow;
+using std::string;
+using std::vector;
+
+
+namespace
+{
+	const char* _EXTENSION_NAME = "FLOW_meshlets";
+
+	const uint32_t _NONE = ~0u;
+
+	// normals must lie within about 84 degrees of the cone axis for the cone to be useful
+	const float _MIN_CONE_DOT = 0.1f;
+}
+
+static_assert(sizeof(GLTFMeshletBuilder::meshlet_t) == 64, "unexpected meshlet descriptor size");
+
+GLTFMeshletBuilder::GLTFMeshletBuilder(GLTFAsset* pAsset) :
+	_pAsset(pAsset),
+	_maxVertices(64),
+	_maxTriangles(124),
+	_minTriangleCount(0),
+	_primitiveCount(0),
+	_meshletCount(0),
+	_resultByteLength(0)
+{
+	F_ASSERT(pAsset);
+}
+
+void GLTFMeshletBuilder::setLimits(size_t maxVertices, size_t maxTriangles)
+{
+	// local indices are stored as uint8
+	_maxVertices = flow::min(flow::max(maxVertices, size_t(3)), size_t(256));
+	_maxTriangles = flow::min(flow::max(maxTriangles, size_t(1)), size_t(512));
+}
+
+void GLTFMeshletBuilder::setMinTriangleCount(size_t triangleCount)
+{
+	_minTriangleCount = triangleCount;
+}
+
+bool GLTFMeshletBuilder::build(GLTFBuffer* pBuffer)
+{
+	_primitiveCount = 0;
+	_meshletCount = 0;
+	_resultByteLength = 0;
+	_error.clear();
+
+	vector<job_t> jobs;
+	_findJobs(jobs);
+
+	// check all data is available before changing anything
+	for (auto& job : jobs) {
+		const GLTFPrimitive* pPrimitive = job.pPrimitive;
+		if (!pPrimitive->indices()->data()) {
+			_error = "index data not available";
+			return false;
+		}
+		if (!pPrimitive->attributeAccessor(GLTFAttributeType::POSITION)->data()) {
+			_error = "position data not available";
+			return false;
+		}
+	}
+
+	// build largest primitives first, so the batch doesn't end with a single long task
+	vector<size_t> order(jobs.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) {
+		return jobs[a].pPrimitive->indices()->elementCount() > jobs[b].pPrimitive->indices()->elementCount();
+	});
+
+	TaskGroup group;
+	for (size_t i : order) {
+		group.run([this, &jobs, i]() {
+			_buildJob(jobs[i]);
+		});
+	}
+
+	group.wait();
+
+	vector<char> data;
+
+	for (auto& job : jobs) {
+		// primitives with out of range indices are left as is
+		if (job.meshlets.empty()) {
+			continue;
+		}
+
+		size_t meshletsByteLength = job.meshlets.size() * sizeof(meshlet_t);
+		size_t verticesByteLength = job.vertices.size() * sizeof(uint32_t);
+
+		data.assign((meshletsByteLength + verticesByteLength + job.triangles.size() + 3) & ~size_t(3), 0);
+		std::memcpy(data.data(), job.meshlets.data(), meshletsByteLength);
+		std::memcpy(data.data() + meshletsByteLength, job.vertices.data(), verticesByteLength);
+		std::memcpy(data.data() + meshletsByteLength + verticesByteLength, job.triangles.data(), job.triangles.size());
+
+		auto pExtension = _pAsset->createExtension<GLTFMeshletExtension>(
+			pBuffer->addData(data.data(), data.size()), job.meshlets.size(),
+			job.vertices.size(), job.triangles.size() / 3, _maxVertices, _maxTriangles);
+
+		job.pPrimitive->addExtension(pExtension);
+
+		_resultByteLength += data.size();
+		_meshletCount += job.meshlets.size();
+		_primitiveCount++;
+	}
+
+	if (_primitiveCount > 0) {
+		_pAsset->useExtension(_EXTENSION_NAME, false);
+	}
+
+	return true;
+}
+
+void GLTFMeshletBuilder::buildMeshlets(const uint32_t* pIndices, size_t indexCount, size_t vertexCount,
+	size_t maxVertices, size_t maxTriangles, meshletVec_t& meshlets,
+	vector<uint32_t>& vertices, vector<uint8_t>& triangles)
+{
+	F_ASSERT(indexCount % 3 == 0 && maxVertices >= 3 && maxVertices <= 256);
+
+	meshlets.clear();
+	vertices.clear();
+	triangles.clear();
+
+	size_t faceCount = indexCount / 3;
+
+	// triangles adjacent to each vertex, used triangles are swapped to the end of the list
+	vector<uint32_t> valence(vertexCount, 0);
+	for (size_t i = 0; i < indexCount; ++i) {
+		valence[pIndices[i]]++;
+	}
+
+	vector<uint32_t> offsets(vertexCount + 1, 0);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		offsets[i + 1] = offsets[i] + valence[i];
+	}
+
+	vector<uint32_t> adjacency(indexCount);
+	{
+		vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+		for (size_t i = 0; i < indexCount; ++i) {
+			adjacency[fill[pIndices[i]]++] = uint32_t(i / 3);
+		}
+	}
+
+	vector<char> isUsed(faceCount, 0);
+	vector<uint32_t> localIndex(vertexCount, _NONE);
+
+	meshlet_t meshlet;
+	std::memset(&meshlet, 0, sizeof(meshlet_t));
+
+	auto finishMeshlet = [&]() {
+		if (meshlet.triangleCount > 0) {
+			for (size_t i = meshlet.vertexOffset; i < vertices.size(); ++i) {
+				localIndex[vertices[i]] = _NONE;
+			}
+			meshlets.push_back(meshlet);
+		}
+
+		meshlet.vertexOffset = uint32_t(vertices.size());
+		meshlet.vertexCount = 0;
+		meshlet.triangleOffset = uint32_t(triangles.size() / 3);
+		meshlet.triangleCount = 0;
+	};
+
+	size_t cursor = 0;
+
+	for (size_t face = 0; face < faceCount; ++face) {
+		// prefer the triangle sharing most vertices with the meshlet
+		uint32_t best = _NONE;
+		int bestShared = -1;
+
+		for (size_t i = meshlet.vertexOffset; i < vertices.size() && bestShared < 3; ++i) {
+			uint32_t v = vertices[i];
+			const uint32_t* pList = adjacency.data() + offsets[v];
+
+			for (uint32_t j = 0; j < valence[v]; ++j) {
+				const uint32_t* pTriangle = pIndices + pList[j] * 3;
+				int shared = int(localIndex[pTriangle[0]] != _NONE)
+					+ int(localIndex[pTriangle[1]] != _NONE) + int(localIndex[pTriangle[2]] != _NONE);
+				if (shared > bestShared) {
+					bestShared = shared;
+					best = pList[j];
+				}
+			}
+		}
+
+		// no adjacent triangle: continue with the next unused triangle
+		if (best == _NONE) {
+			while (isUsed[cursor]) {
+				cursor++;
+			}
+			best = uint32_t(cursor);
+		}
+
+		const uint32_t* pTriangle = pIndices + best * 3;
+		uint32_t newVertices = 0;
+		for (size_t k = 0; k < 3; ++k) {
+			bool isDuplicate = k > 0 && pTriangle[k] == pTriangle[0];
+			isDuplicate = isDuplicate || (k > 1 && pTriangle[k] == pTriangle[1]);
+			newVertices += localIndex[pTriangle[k]] == _NONE && !isDuplicate;
+		}
+
+		if (meshlet.vertexCount + newVertices > maxVertices || meshlet.triangleCount + 1 > maxTriangles) {
+			finishMeshlet();
+		}
+
+		for (size_t k = 0; k < 3; ++k) {
+			uint32_t v = pTriangle[k];
+			if (localIndex[v] == _NONE) {
+				localIndex[v] = meshlet.vertexCount++;
+				vertices.push_back(v);
+			}
+			triangles.push_back(uint8_t(localIndex[v]));
+
+			uint32_t* pList = adjacency.data() + offsets[v];
+			for (uint32_t j = 0; j < valence[v]; ++j) {
+				if (pList[j] == best) {
+					pList[j] = pList[valence[v] - 1];
+					valence[v]--;
+					break;
+				}
+			}
+		}
+
+		meshlet.triangleCount++;
+		isUsed[best] = 1;
+	}
+
+	finishMeshlet();
+}
+
+void GLTFMeshletBuilder::computeBounds(meshlet_t& meshlet, const uint32_t* pVertices,
+	const uint8_t* pTriangles, const float* pPositions)
+{
+	pVertices += meshlet.vertexOffset;
+	pTriangles += meshlet.triangleOffset * 3;
+
+	// bounding sphere around the center of the bounding box
+	Range3f range;
+	range.invalidate();
+	for (size_t i = 0; i < meshlet.vertexCount; ++i) {
+		range.include(Vector3f(pPositions + pVertices[i] * 3));
+	}
+
+	Vector3f center = range.center();
+	float radius = 0.0f;
+	for (size_t i = 0; i < meshlet.vertexCount; ++i) {
+		radius = flow::max(radius, (Vector3f(pPositions + pVertices[i] * 3) - center).length());
+	}
+
+	center.copyTo(meshlet.center);
+	meshlet.radius = radius;
+
+	// the cone axis is the average of the triangles' unit normals
+	vector<Vector3f> normals;
+	vector<Vector3f> corners;
+	Vector3f axis(0.0f, 0.0f, 0.0f);
+
+	for (size_t i = 0; i < meshlet.triangleCount; ++i) {
+		Vector3f p0(pPositions + pVertices[pTriangles[i * 3]] * 3);
+		Vector3f p1(pPositions + pVertices[pTriangles[i * 3 + 1]] * 3);
+		Vector3f p2(pPositions + pVertices[pTriangles[i * 3 + 2]] * 3);
+
+		Vector3f normal = (p1 - p0).cross(p2 - p0);
+		float length = normal.length();
+		if (length > 0.0f) {
+			normal /= length;
+			normals.push_back(normal);
+			corners.push_back(p0);
+			axis += normal;
+		}
+	}
+
+	meshlet.coneCutoff = 1.0f;
+	meshlet.reserved = 0.0f;
+	Vector3f::zero.copyTo(meshlet.coneAxis);
+	center.copyTo(meshlet.coneApex);
+
+	float axisLength = axis.length();
+	if (axisLength == 0.0f) {
+		return;
+	}
+
+	axis /= axisLength;
+
+	float minDot = 1.0f;
+	for (auto& normal : normals) {
+		minDot = flow::min(minDot, axis.dot(normal));
+	}
+
+	if (minDot <= _MIN_CONE_DOT) {
+		return;
+	}
+
+	// the apex lies behind all triangle planes, on the axis through the sphere center
+	float maxT = 0.0f;
+	for (size_t i = 0; i < normals.size(); ++i) {
+		float t = (center - corners[i]).dot(normals[i]) / axis.dot(normals[i]);
+		maxT = flow::max(maxT, t);
+	}
+
+	axis.copyTo(meshlet.coneAxis);
+	(center - axis * maxT).copyTo(meshlet.coneApex);
+	meshlet.coneCutoff = std::sqrt(1.0f - minDot * minDot);
+}
+
+void GLTFMeshletBuilder::_findJobs(vector<job_t>& jobs) const
+{
+	for (auto pMesh : _pAsset->_meshes) {
+		for (auto& primitive : const_cast<GLTFMesh*>(pMesh)->primitives()) {
+			const GLTFAccessor* pIndices = primitive.indices();
+			const GLTFAccessor* pPositions = primitive.attributeAccessor(GLTFAttributeType::POSITION);
+
+			// primitives with extensions are compressed or already split
+			bool isEligible = primitive.mode() == GLTFPrimitiveMode::TRIANGLES
+				&& primitive.extensions().empty()
+				&& pIndices && pIndices->bufferView()
+				&& pIndices->type() == GLTFAccessorType::SCALAR
+				&& pIndices->elementCount() > 0 && pIndices->elementCount() % 3 == 0
+				&& pIndices->elementCount() / 3 >= _minTriangleCount
+				&& pPositions && pPositions->bufferView()
+				&& pPositions->type() == GLTFAccessorType::VEC3;
+
+			if (isEligible) {
+				jobs.push_back(job_t{ &primitive, {}, {}, {} });
+			}
+		}
+	}
+}
+
+void GLTFMeshletBuilder::_buildJob(job_t& job) const
+{
+	const GLTFPrimitive* pPrimitive = job.pPrimitive;
+	GLTFAccessorView<uint32_t, 1> indexView(pPrimitive->indices());
+	GLTFAccessorView<float, 3> positionView(pPrimitive->attributeAccessor(GLTFAttributeType::POSITION));
+
+	size_t vertexCount = positionView.size();
+	size_t indexCount = indexView.size();
+
+	vector<uint32_t> indices(indexCount);
+	for (size_t i = 0; i < indexCount; ++i) {
+		indices[i] = indexView.value(i, 0);
+		if (indices[i] >= vertexCount) {
+			return;
+		}
+	}
+
+	vector<float> positions(vertexCount * 3);
+	for (size_t i = 0; i < vertexCount; ++i) {
+		positionView.get(i, &positions[i * 3]);
+	}
+
+	buildMeshlets(indices.data(), indexCount, vertexCount, _maxVertices, _maxTriangles,
+		job.meshlets, job.vertices, job.triangles);
+
+	for (auto& meshlet : job.meshlets) {
+		computeBounds(meshlet, job.vertices.data(), job.triangles.data(), positions.data());
+	}
+}
@@ -0,0 +1,116 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_MESHLETBUILDER_H
+#define _FLOWLIBS_GLTF_MESHLETBUILDER_H
+
+#include "library.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFAsset;
+	class GLTFBuffer;
+	class GLTFPrimitive;
+
+	/// Splits indexed triangle list primitives into meshlets for mesh shading and cluster
+	/// culling. A meshlet references up to maxVertices vertices of the primitive and
+	/// up to maxTriangles triangles, whose corners are local indices into the meshlet's
+	/// vertices. Triangles are grown greedily from the current meshlet's vertices, a
+	/// cache optimized input order (see GLTFMeshOptimizer) gives the best results.
+	///
+	/// The meshlets of a primitive are stored in a buffer view referenced by a FLOW_meshlets
+	/// extension: meshlet_t descriptors, followed by the uint32 vertex indices, followed by
+	/// the triangles as three uint8 local indices each. Vertex indices refer to the
+	/// primitive's attributes, which must not be reordered afterwards.
+	class F_GLTF_EXPORT GLTFMeshletBuilder
+	{
+	public:
+		/// Meshlet descriptor, 64 bytes. Bounds are in the space of the POSITION attribute.
+		struct meshlet_t
+		{
+			/// Index of the first vertex in the vertex index array.
+			uint32_t vertexOffset;
+			uint32_t vertexCount;
+			/// Index of the first triangle in the triangle array.
+			uint32_t triangleOffset;
+			uint32_t triangleCount;
+			/// Bounding sphere.
+			float center[3];
+			float radius;
+			/// Normal cone: the meshlet is back-facing and can be culled for a camera at
+			/// position c if dot(normalize(coneApex - c), coneAxis) >= coneCutoff.
+			/// The cutoff is 1 if the triangles' normals vary too much for culling.
+			float coneAxis[3];
+			float coneCutoff;
+			float coneApex[3];
+			float reserved;
+		};
+
+		typedef std::vector<meshlet_t> meshletVec_t;
+
+		GLTFMeshletBuilder(GLTFAsset* pAsset);
+
+		/// Sets the maximum number of vertices (at most 256) and triangles (at most 512)
+		/// per meshlet. Default is 64 vertices and 124 triangles.
+		void setLimits(size_t maxVertices, size_t maxTriangles);
+		/// Sets the minimum number of triangles of a primitive to be split. Default is 0.
+		void setMinTriangleCount(size_t triangleCount);
+
+		/// Builds meshlets for all indexed triangle list primitives without extensions,
+		/// in parallel. The meshlet data of each primitive is added as buffer view to pBuffer.
+		/// Returns false if the data of a primitive is not available.
+		bool build(GLTFBuffer* pBuffer);
+
+		/// Number of primitives split into meshlets.
+		size_t primitiveCount() const { return _primitiveCount; }
+		/// Total number of meshlets.
+		size_t meshletCount() const { return _meshletCount; }
+		/// Size of the meshlet data added to the buffer.
+		size_t resultByteLength() const { return _resultByteLength; }
+
+		const std::string& error() const { return _error; }
+
+		/// Splits a triangle list into meshlets. Bounds are not computed.
+		static void buildMeshlets(const uint32_t* pIndices, size_t indexCount, size_t vertexCount,
+			size_t maxVertices, size_t maxTriangles, meshletVec_t& meshlets,
+			std::vector<uint32_t>& vertices, std::vector<uint8_t>& triangles);
+		/// Computes bounding sphere and normal cone of a meshlet.
+		/// pPositions holds 3 floats per vertex of the primitive.
+		static void computeBounds(meshlet_t& meshlet, const uint32_t* pVertices,
+			const uint8_t* pTriangles, const float* pPositions);
+
+	private:
+		struct job_t
+		{
+			GLTFPrimitive* pPrimitive;
+			meshletVec_t meshlets;
+			std::vector<uint32_t> vertices;
+			std::vector<uint8_t> triangles;
+		};
+
+		void _findJobs(std::vector<job_t>& jobs) const;
+		void _buildJob(job_t& job) const;
+
+		GLTFAsset* _pAsset;
+		size_t _maxVertices;
+		size_t _maxTriangles;
+		size_t _minTriangleCount;
+
+		size_t _primitiveCount;
+		size_t _meshletCount;
+		size_t _resultByteLength;
+
+		std::string _error;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_MESHLETBUILDER_H
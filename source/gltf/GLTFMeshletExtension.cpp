@@ -0,0 +1,54 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFMeshletExtension.h"
+#include "GLTFMeshletBuilder.h"
+#include "GLTFBufferView.h"
+
+using namespace flow;
+using std::string;
+
+
+GLTFMeshletExtension::GLTFMeshletExtension(const GLTFBufferView* pBufferView, size_t meshletCount,
+	size_t vertexCount, size_t triangleCount, size_t maxVertices, size_t maxTriangles) :
+	_pBufferView(pBufferView),
+	_meshletCount(meshletCount),
+	_vertexCount(vertexCount),
+	_triangleCount(triangleCount),
+	_maxVertices(maxVertices),
+	_maxTriangles(maxTriangles)
+{
+}
+
+size_t GLTFMeshletExtension::vertexByteOffset() const
+{
+	return _meshletCount * sizeof(GLTFMeshletBuilder::meshlet_t);
+}
+
+size_t GLTFMeshletExtension::triangleByteOffset() const
+{
+	return vertexByteOffset() + _vertexCount * sizeof(uint32_t);
+}
+
+const char* GLTFMeshletExtension::name() const
+{
+	return "FLOW_meshlets";
+}
+
+json GLTFMeshletExtension::toJSON() const
+{
+	return json{
+		{ "bufferView", _pBufferView->index() },
+		{ "meshletCount", _meshletCount },
+		{ "vertexCount", _vertexCount },
+		{ "vertexByteOffset", vertexByteOffset() },
+		{ "triangleCount", _triangleCount },
+		{ "triangleByteOffset", triangleByteOffset() },
+		{ "maxVertices", _maxVertices },
+		{ "maxTriangles", _maxTriangles }
+	};
+}
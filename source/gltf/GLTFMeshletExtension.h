@@ -0,0 +1,55 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_MESHLETEXTENSION_H
+#define _FLOWLIBS_GLTF_MESHLETEXTENSION_H
+
+#include "library.h"
+#include "GLTFExtension.h"
+
+#include "../core/json.h"
+#include <string>
+
+namespace flow
+{
+	class GLTFBufferView;
+
+	/// FLOW_meshlets primitive extension. Refers to a buffer view holding the meshlets
+	/// of the primitive, see GLTFMeshletBuilder for the data layout.
+	class F_GLTF_EXPORT GLTFMeshletExtension : public GLTFExtension
+	{
+	public:
+		GLTFMeshletExtension(const GLTFBufferView* pBufferView, size_t meshletCount,
+			size_t vertexCount, size_t triangleCount, size_t maxVertices, size_t maxTriangles);
+		virtual ~GLTFMeshletExtension() { }
+
+		const GLTFBufferView* bufferView() const { return _pBufferView; }
+		size_t meshletCount() const { return _meshletCount; }
+		size_t vertexCount() const { return _vertexCount; }
+		size_t triangleCount() const { return _triangleCount; }
+		size_t maxVertices() const { return _maxVertices; }
+		size_t maxTriangles() const { return _maxTriangles; }
+
+		/// Offset of the vertex index array in the buffer view.
+		size_t vertexByteOffset() const;
+		/// Offset of the triangle array in the buffer view.
+		size_t triangleByteOffset() const;
+
+		virtual const char* name() const;
+		virtual json toJSON() const;
+
+	private:
+		const GLTFBufferView* _pBufferView;
+		size_t _meshletCount;
+		size_t _vertexCount;
+		size_t _triangleCount;
+		size_t _maxVertices;
+		size_t _maxTriangles;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_MESHLETEXTENSION_H
@@ -0,0 +1,471 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFMeshoptCodec.h"
+
+#include <cstring>
+
+using namespace flow;
+
+
+namespace
+{
+	// vertex codec, version 0
+
+	const uint8_t _VERTEX_HEADER = 0xa0;
+
+	const size_t _VERTEX_BLOCK_SIZE_BYTES = 8192;
+	const size_t _VERTEX_BLOCK_MAX_SIZE = 256;
+	const size_t _BYTE_GROUP_SIZE = 16;
+	const size_t _BYTE_GROUP_DECODE_LIMIT = 24;
+	const size_t _TAIL_MAX_SIZE = 32;
+
+	size_t _vertexBlockSize(size_t vertexSize)
+	{
+		// a block must fit into the decoder's scratch buffer, sizes are multiples of a byte group
+		size_t result = (_VERTEX_BLOCK_SIZE_BYTES / vertexSize) & ~(_BYTE_GROUP_SIZE - 1);
+		return result < _VERTEX_BLOCK_MAX_SIZE ? result : _VERTEX_BLOCK_MAX_SIZE;
+	}
+
+	inline uint8_t _zigzag8(uint8_t v)
+	{
+		return uint8_t((int8_t(v) >> 7) ^ (v << 1));
+	}
+
+	// size of a byte group encoded with the given number of bits per value
+	size_t _measureGroup(const uint8_t* pGroup, int bits)
+	{
+		if (bits == 0) {
+			for (size_t i = 0; i < _BYTE_GROUP_SIZE; ++i) {
+				if (pGroup[i]) {
+					return size_t(-1);
+				}
+			}
+			return 0;
+		}
+		if (bits == 8) {
+			return _BYTE_GROUP_SIZE;
+		}
+
+		// values not fitting into the bits are marked with a sentinel and follow as full bytes
+		size_t result = _BYTE_GROUP_SIZE * bits / 8;
+		uint8_t sentinel = uint8_t((1 << bits) - 1);
+		for (size_t i = 0; i < _BYTE_GROUP_SIZE; ++i) {
+			result += pGroup[i] >= sentinel;
+		}
+		return result;
+	}
+
+	uint8_t* _encodeGroup(uint8_t* pData, const uint8_t* pGroup, int bits)
+	{
+		if (bits == 0) {
+			return pData;
+		}
+		if (bits == 8) {
+			std::memcpy(pData, pGroup, _BYTE_GROUP_SIZE);
+			return pData + _BYTE_GROUP_SIZE;
+		}
+
+		// the first value of each byte is stored in its high bits
+		size_t valuesPerByte = 8 / bits;
+		uint8_t sentinel = uint8_t((1 << bits) - 1);
+
+		for (size_t i = 0; i < _BYTE_GROUP_SIZE; i += valuesPerByte) {
+			uint8_t byte = 0;
+			for (size_t k = 0; k < valuesPerByte; ++k) {
+				uint8_t value = pGroup[i + k] >= sentinel ? sentinel : pGroup[i + k];
+				byte = uint8_t((byte << bits) | value);
+			}
+			*pData++ = byte;
+		}
+
+		for (size_t i = 0; i < _BYTE_GROUP_SIZE; ++i) {
+			if (pGroup[i] >= sentinel) {
+				*pData++ = pGroup[i];
+			}
+		}
+
+		return pData;
+	}
+
+	uint8_t* _encodeBytes(uint8_t* pData, uint8_t* pDataEnd, const uint8_t* pBuffer, size_t bufferSize)
+	{
+		// 2 bits per group select 0, 2, 4 or 8 bits per value
+		uint8_t* pHeader = pData;
+		size_t headerSize = (bufferSize / _BYTE_GROUP_SIZE + 3) / 4;
+		if (size_t(pDataEnd - pData) < headerSize) {
+			return nullptr;
+		}
+
+		std::memset(pHeader, 0, headerSize);
+		pData += headerSize;
+
+		for (size_t i = 0; i < bufferSize; i += _BYTE_GROUP_SIZE) {
+			if (size_t(pDataEnd - pData) < _BYTE_GROUP_DECODE_LIMIT) {
+				return nullptr;
+			}
+
+			int bestBitsLog2 = 3;
+			size_t bestSize = _measureGroup(pBuffer + i, 8);
+			for (int bitsLog2 = 0; bitsLog2 < 3; ++bitsLog2) {
+				size_t size = _measureGroup(pBuffer + i, bitsLog2 == 0 ? 0 : 1 << bitsLog2);
+				if (size < bestSize) {
+					bestBitsLog2 = bitsLog2;
+					bestSize = size;
+				}
+			}
+
+			size_t group = i / _BYTE_GROUP_SIZE;
+			pHeader[group / 4] |= uint8_t(bestBitsLog2 << ((group % 4) * 2));
+			pData = _encodeGroup(pData, pBuffer + i, bestBitsLog2 == 0 ? 0 : 1 << bestBitsLog2);
+		}
+
+		return pData;
+	}
+
+	uint8_t* _encodeVertexBlock(uint8_t* pData, uint8_t* pDataEnd, const uint8_t* pVertices,
+		size_t vertexCount, size_t vertexSize, uint8_t* pLastVertex)
+	{
+		// values beyond the vertex count pad the last byte group
+		uint8_t buffer[_VERTEX_BLOCK_MAX_SIZE];
+		std::memset(buffer, 0, sizeof(buffer));
+
+		size_t bufferSize = (vertexCount + _BYTE_GROUP_SIZE - 1) & ~(_BYTE_GROUP_SIZE - 1);
+
+		for (size_t k = 0; k < vertexSize; ++k) {
+			uint8_t previous = pLastVertex[k];
+			const uint8_t* pByte = pVertices + k;
+
+			for (size_t i = 0; i < vertexCount; ++i, pByte += vertexSize) {
+				buffer[i] = _zigzag8(uint8_t(*pByte - previous));
+				previous = *pByte;
+			}
+
+			pData = _encodeBytes(pData, pDataEnd, buffer, bufferSize);
+			if (!pData) {
+				return nullptr;
+			}
+		}
+
+		std::memcpy(pLastVertex, pVertices + vertexSize * (vertexCount - 1), vertexSize);
+		return pData;
+	}
+
+	// index codec, version 1
+
+	const uint8_t _INDEX_HEADER = 0xe0;
+	const int _INDEX_VERSION = 1;
+
+	typedef uint32_t vertexFifo_t[16];
+	typedef uint32_t edgeFifo_t[16][2];
+
+	const size_t _TRIANGLE_INDEX_ORDER[3][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 } };
+
+	// frequent combinations of two vertex codes, the last two entries are not used for encoding
+	const uint8_t _CODE_AUX_TABLE[16] = {
+		0x00, 0x76, 0x87, 0x56, 0x67, 0x78, 0xa9, 0x86, 0x65, 0x89, 0x68, 0x98, 0x01, 0x69, 0x00, 0x00
+	};
+
+	int _findEdge(const edgeFifo_t fifo, uint32_t a, uint32_t b, uint32_t c, size_t offset)
+	{
+		for (int i = 0; i < 16; ++i) {
+			size_t index = (offset - 1 - i) & 15;
+			uint32_t e0 = fifo[index][0];
+			uint32_t e1 = fifo[index][1];
+
+			if (e0 == a && e1 == b) {
+				return (i << 2) | 0;
+			}
+			if (e0 == b && e1 == c) {
+				return (i << 2) | 1;
+			}
+			if (e0 == c && e1 == a) {
+				return (i << 2) | 2;
+			}
+		}
+
+		return -1;
+	}
+
+	void _pushEdge(edgeFifo_t fifo, uint32_t a, uint32_t b, size_t& offset)
+	{
+		fifo[offset][0] = a;
+		fifo[offset][1] = b;
+		offset = (offset + 1) & 15;
+	}
+
+	int _findVertex(const vertexFifo_t fifo, uint32_t v, size_t offset)
+	{
+		for (int i = 0; i < 16; ++i) {
+			if (fifo[(offset - 1 - i) & 15] == v) {
+				return i;
+			}
+		}
+
+		return -1;
+	}
+
+	void _pushVertex(vertexFifo_t fifo, uint32_t v, size_t& offset)
+	{
+		fifo[offset] = v;
+		offset = (offset + 1) & 15;
+	}
+
+	void _encodeVByte(uint8_t*& pData, uint32_t v)
+	{
+		// 7 bits per byte, the high bit marks a continuation
+		do {
+			*pData++ = uint8_t((v & 127) | (v > 127 ? 128 : 0));
+			v >>= 7;
+		} while (v);
+	}
+
+	void _encodeIndex(uint8_t*& pData, uint32_t index, uint32_t last)
+	{
+		// zigzag encoded delta to the last free index
+		uint32_t d = index - last;
+		_encodeVByte(pData, (d << 1) ^ uint32_t(int32_t(d) >> 31));
+	}
+
+	int _findCodeAux(uint8_t v)
+	{
+		for (int i = 0; i < 16; ++i) {
+			if (_CODE_AUX_TABLE[i] == v) {
+				return i;
+			}
+		}
+
+		return -1;
+	}
+}
+
+size_t GLTFMeshoptCodec::encodeVertexBufferBound(size_t vertexCount, size_t vertexSize)
+{
+	size_t blockSize = _vertexBlockSize(vertexSize);
+	size_t blockCount = (vertexCount + blockSize - 1) / blockSize;
+	size_t blockHeaderSize = (blockSize / _BYTE_GROUP_SIZE + 3) / 4;
+	size_t tailSize = vertexSize < _TAIL_MAX_SIZE ? _TAIL_MAX_SIZE : vertexSize;
+
+	return 1 + blockCount * vertexSize * (blockHeaderSize + blockSize) + tailSize;
+}
+
+size_t GLTFMeshoptCodec::encodeVertexBuffer(uint8_t* pResult, size_t resultLength,
+	const uint8_t* pVertices, size_t vertexCount, size_t vertexSize)
+{
+	F_ASSERT(vertexSize > 0 && vertexSize <= 256 && vertexSize % 4 == 0);
+
+	uint8_t* pData = pResult;
+	uint8_t* pDataEnd = pResult + resultLength;
+
+	if (resultLength < 1 + vertexSize) {
+		return 0;
+	}
+
+	*pData++ = _VERTEX_HEADER;
+
+	// deltas of the first block refer to the first vertex
+	uint8_t lastVertex[256] = { 0 };
+	if (vertexCount > 0) {
+		std::memcpy(lastVertex, pVertices, vertexSize);
+	}
+
+	size_t blockSize = _vertexBlockSize(vertexSize);
+
+	for (size_t offset = 0; offset < vertexCount; offset += blockSize) {
+		size_t count = offset + blockSize < vertexCount ? blockSize : vertexCount - offset;
+		pData = _encodeVertexBlock(pData, pDataEnd, pVertices + offset * vertexSize, count, vertexSize, lastVertex);
+		if (!pData) {
+			return 0;
+		}
+	}
+
+	// the tail holds the first vertex, padded in front to at least 32 bytes,
+	// so the decoder can read byte groups without further bounds checks
+	size_t tailSize = vertexSize < _TAIL_MAX_SIZE ? _TAIL_MAX_SIZE : vertexSize;
+	if (size_t(pDataEnd - pData) < tailSize) {
+		return 0;
+	}
+
+	if (vertexSize < _TAIL_MAX_SIZE) {
+		std::memset(pData, 0, _TAIL_MAX_SIZE - vertexSize);
+		pData += _TAIL_MAX_SIZE - vertexSize;
+	}
+
+	if (vertexCount > 0) {
+		std::memcpy(pData, pVertices, vertexSize);
+	}
+	else {
+		std::memset(pData, 0, vertexSize);
+	}
+
+	pData += vertexSize;
+	return size_t(pData - pResult);
+}
+
+size_t GLTFMeshoptCodec::encodeIndexBufferBound(size_t indexCount, size_t vertexCount)
+{
+	unsigned int vertexBits = 1;
+	while (vertexBits < 32 && vertexCount > (size_t(1) << vertexBits)) {
+		vertexBits++;
+	}
+
+	// worst case per triangle: code and aux byte and 3 varint encoded index deltas
+	unsigned int vertexGroups = (vertexBits + 1 + 6) / 7;
+	return 1 + (indexCount / 3) * (2 + 3 * vertexGroups) + 16;
+}
+
+size_t GLTFMeshoptCodec::encodeIndexBuffer(uint8_t* pResult, size_t resultLength,
+	const uint32_t* pIndices, size_t indexCount)
+{
+	F_ASSERT(indexCount % 3 == 0);
+
+	// header, a code byte per triangle and the code aux table are the minimum
+	if (resultLength < 1 + indexCount / 3 + 16) {
+		return 0;
+	}
+
+	pResult[0] = uint8_t(_INDEX_HEADER | _INDEX_VERSION);
+
+	edgeFifo_t edgeFifo;
+	vertexFifo_t vertexFifo;
+	std::memset(edgeFifo, -1, sizeof(edgeFifo));
+	std::memset(vertexFifo, -1, sizeof(vertexFifo));
+
+	size_t edgeOffset = 0;
+	size_t vertexOffset = 0;
+
+	uint32_t next = 0;
+	uint32_t last = 0;
+
+	// code bytes are followed by the data section
+	uint8_t* pCode = pResult + 1;
+	uint8_t* pData = pCode + indexCount / 3;
+	uint8_t* pDataSafeEnd = pResult + resultLength - 16;
+
+	const int fecMax = 13;
+
+	for (size_t i = 0; i < indexCount; i += 3) {
+		// a triangle writes at most 16 bytes to the data section
+		if (pData > pDataSafeEnd) {
+			return 0;
+		}
+
+		int fer = _findEdge(edgeFifo, pIndices[i + 0], pIndices[i + 1], pIndices[i + 2], edgeOffset);
+
+		if (fer >= 0 && (fer >> 2) < 15) {
+			// rotate the triangle so the matching edge comes first
+			const size_t* order = _TRIANGLE_INDEX_ORDER[fer & 3];
+			uint32_t a = pIndices[i + order[0]];
+			uint32_t b = pIndices[i + order[1]];
+			uint32_t c = pIndices[i + order[2]];
+
+			int fe = fer >> 2;
+			int fc = _findVertex(vertexFifo, c, vertexOffset);
+			int fec = (fc >= 1 && fc < fecMax) ? fc : (c == next) ? (next++, 0) : 15;
+
+			// consecutive free indices, typical for strip-like sequences
+			if (fec == 15) {
+				if (c + 1 == last) {
+					fec = 13;
+					last = c;
+				}
+				if (c == last + 1) {
+					fec = 14;
+					last = c;
+				}
+			}
+
+			*pCode++ = uint8_t((fe << 4) | fec);
+
+			if (fec == 15) {
+				_encodeIndex(pData, c, last);
+				last = c;
+			}
+
+			// the first two vertices are likely in the fifo already
+			if (fec == 0 || fec >= fecMax) {
+				_pushVertex(vertexFifo, c, vertexOffset);
+			}
+
+			// the third edge is in the fifo already
+			_pushEdge(edgeFifo, c, b, edgeOffset);
+			_pushEdge(edgeFifo, a, c, edgeOffset);
+		}
+		else {
+			// rotate the triangle so the next new vertex comes first
+			int rotation = (pIndices[i + 1] == next) ? 1 : (pIndices[i + 2] == next) ? 2 : 0;
+			const size_t* order = _TRIANGLE_INDEX_ORDER[rotation];
+			uint32_t a = pIndices[i + order[0]];
+			uint32_t b = pIndices[i + order[1]];
+			uint32_t c = pIndices[i + order[2]];
+
+			// a triangle 0, 1, 2 after other vertices restarts the sequence of new vertices
+			bool reset = false;
+			if (a == 0 && b == 1 && c == 2 && next > 0) {
+				reset = true;
+				next = 0;
+				std::memset(vertexFifo, -1, sizeof(vertexFifo));
+			}
+
+			int fb = _findVertex(vertexFifo, b, vertexOffset);
+			int fc = _findVertex(vertexFifo, c, vertexOffset);
+
+			int fea = (a == next) ? (next++, 0) : 15;
+			int feb = (fb >= 0 && fb < 14) ? (fb + 1) : (b == next) ? (next++, 0) : 15;
+			int fec = (fc >= 0 && fc < 14) ? (fc + 1) : (c == next) ? (next++, 0) : 15;
+
+			// the codes of b and c are stored as a table index if possible, as a full byte otherwise
+			uint8_t codeAux = uint8_t((feb << 4) | fec);
+			int codeAuxIndex = _findCodeAux(codeAux);
+
+			if (fea == 0 && codeAuxIndex >= 0 && codeAuxIndex < 14 && !reset) {
+				*pCode++ = uint8_t((15 << 4) | codeAuxIndex);
+			}
+			else {
+				*pCode++ = uint8_t((15 << 4) | 14 | fea);
+				*pData++ = codeAux;
+			}
+
+			if (fea == 15) {
+				_encodeIndex(pData, a, last);
+				last = a;
+			}
+			if (feb == 15) {
+				_encodeIndex(pData, b, last);
+				last = b;
+			}
+			if (fec == 15) {
+				_encodeIndex(pData, c, last);
+				last = c;
+			}
+
+			if (fea == 0 || fea == 15) {
+				_pushVertex(vertexFifo, a, vertexOffset);
+			}
+			if (feb == 0 || feb == 15) {
+				_pushVertex(vertexFifo, b, vertexOffset);
+			}
+			if (fec == 0 || fec == 15) {
+				_pushVertex(vertexFifo, c, vertexOffset);
+			}
+
+			_pushEdge(edgeFifo, b, a, edgeOffset);
+			_pushEdge(edgeFifo, c, b, edgeOffset);
+			_pushEdge(edgeFifo, a, c, edgeOffset);
+		}
+	}
+
+	if (pData > pDataSafeEnd) {
+		return 0;
+	}
+
+	// the table is needed to decode aux codes, and pads the stream for the decoder
+	std::memcpy(pData, _CODE_AUX_TABLE, 16);
+	pData += 16;
+
+	return size_t(pData - pResult);
+}
@@ -0,0 +1,45 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_MESHOPTCODEC_H
+#define _FLOWLIBS_GLTF_MESHOPTCODEC_H
+
+#include "library.h"
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace flow
+{
+	/// Encoders for the vertex and index codecs of the EXT_meshopt_compression extension.
+	/// The vertex codec (version 0) stores byte-wise deltas between consecutive vertices,
+	/// packed in groups of 16 with 0, 2, 4 or 8 bits per delta. The index codec (version 1)
+	/// encodes triangles relative to FIFOs of recently used edges and vertices.
+	class F_GLTF_EXPORT GLTFMeshoptCodec
+	{
+	public:
+		/// Deleted constructor. Class provides only static methods.
+		GLTFMeshoptCodec() = delete;
+
+		/// Returns the maximum size of an encoded vertex buffer.
+		static size_t encodeVertexBufferBound(size_t vertexCount, size_t vertexSize);
+		/// Encodes vertexCount vertices of vertexSize bytes. The vertex size must be a multiple
+		/// of 4 and not exceed 256. Returns the encoded size, or 0 if resultLength is too small.
+		static size_t encodeVertexBuffer(uint8_t* pResult, size_t resultLength,
+			const uint8_t* pVertices, size_t vertexCount, size_t vertexSize);
+
+		/// Returns the maximum size of an encoded triangle list referring to vertexCount vertices.
+		static size_t encodeIndexBufferBound(size_t indexCount, size_t vertexCount);
+		/// Encodes a triangle list, indexCount must be a multiple of 3.
+		/// Returns the encoded size, or 0 if resultLength is too small.
+		static size_t encodeIndexBuffer(uint8_t* pResult, size_t resultLength,
+			const uint32_t* pIndices, size_t indexCount);
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_MESHOPTCODEC_H
@@ -0,0 +1,268 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFMeshoptEncoder.h"
+#include "GLTFMeshoptCodec.h"
+#include "GLTFMeshoptExtension.h"
+#include "GLTFAsset.h"
+#include "GLTFMesh.h"
+#include "GLTFPrimitive.h"
+#include "GLTFBuffer.h"
+#include "GLTFBufferView.h"
+#include "GLTFAccessor.h"
+#include "GLTFImage.h"
+#include "GLTFDracoExtension.h"
+
+#include "../core/ThreadPool.h"
+
+#include <cstring>
+#include <algorithm>
+
+using namespace flow;
+using std::string;
+using std::vector;
+
+
+namespace
+{
+	const char* _EXTENSION_NAME = "EXT_meshopt_compression";
+
+	// how a buffer view is used, views with more than one kind of use are not compressed
+	enum usage_t
+	{
+		_USAGE_NONE = 0,
+		_USAGE_VERTICES = 1,
+		_USAGE_INDICES = 2,
+		_USAGE_OTHER = 4
+	};
+}
+
+GLTFMeshoptEncoder::GLTFMeshoptEncoder(GLTFAsset* pAsset) :
+	_pAsset(pAsset),
+	_viewCount(0),
+	_sourceByteLength(0),
+	_resultByteLength(0)
+{
+	F_ASSERT(pAsset);
+}
+
+bool GLTFMeshoptEncoder::encode(GLTFBuffer* pBuffer)
+{
+	_viewCount = 0;
+	_sourceByteLength = 0;
+	_resultByteLength = 0;
+	_error.clear();
+
+	vector<job_t> jobs;
+	_findJobs(jobs);
+
+	// check all data is available before changing anything
+	for (auto& job : jobs) {
+		if (!job.pBufferView->data()) {
+			_error = "buffer view data not available: " + std::to_string(job.pBufferView->index());
+			return false;
+		}
+	}
+
+	// encode largest views first, so the batch doesn't end with a single long task
+	vector<size_t> order(jobs.size());
+	for (size_t i = 0; i < order.size(); ++i) {
+		order[i] = i;
+	}
+
+	std::sort(order.begin(), order.end(), [&jobs](size_t a, size_t b) {
+		return jobs[a].pBufferView->byteLength() > jobs[b].pBufferView->byteLength();
+	});
+
+	TaskGroup group;
+	for (size_t i : order) {
+		group.run([&jobs, i]() {
+			_encodeJob(jobs[i]);
+		});
+	}
+
+	group.wait();
+
+	// compressed data and fallback buffer are added in view order, the output is deterministic
+	GLTFBuffer* pFallbackBuffer = nullptr;
+
+	for (auto& job : jobs) {
+		if (job.result.empty()) {
+			continue;
+		}
+
+		if (!pFallbackBuffer) {
+			pFallbackBuffer = _pAsset->createBuffer();
+			pFallbackBuffer->setFallback(true);
+			pFallbackBuffer->addExtension(_pAsset->createExtension<GLTFMeshoptExtension>());
+		}
+
+		// the extension refers to the compressed range, which gets no buffer view of its own
+		size_t byteOffset = pBuffer->appendData((const char*)job.result.data(), job.result.size());
+		job.pBufferView->addExtension(_pAsset->createExtension<GLTFMeshoptExtension>(
+			pBuffer, byteOffset, job.result.size(), job.byteStride, job.count, job.mode));
+
+		_sourceByteLength += job.pBufferView->byteLength();
+		_resultByteLength += job.result.size();
+		_viewCount++;
+
+		pFallbackBuffer->adoptView(job.pBufferView);
+	}
+
+	if (_viewCount > 0) {
+		_pAsset->useExtension(_EXTENSION_NAME, true);
+	}
+
+	return true;
+}
+
+void GLTFMeshoptEncoder::_findJobs(vector<job_t>& jobs) const
+{
+	// usage of accessors by primitives
+	vector<int> accessorUsage(_pAsset->_accessors.size(), _USAGE_NONE);
+
+	for (auto pMesh : _pAsset->_meshes) {
+		for (auto& primitive : pMesh->primitives()) {
+			if (primitive.indices()) {
+				GLTFAccessorComponent component = primitive.indices()->component();
+				bool isTriangleList = primitive.mode() == GLTFPrimitiveMode::TRIANGLES
+					&& (component == GLTFAccessorComponent::UNSIGNED_SHORT
+						|| component == GLTFAccessorComponent::UNSIGNED_INT);
+				accessorUsage[primitive.indices()->index()] |= isTriangleList ? _USAGE_INDICES : _USAGE_OTHER;
+			}
+			for (auto& attribute : primitive.attributes()) {
+				if (attribute.pAccessor) {
+					accessorUsage[attribute.pAccessor->index()] |= _USAGE_VERTICES;
+				}
+			}
+			for (auto& target : primitive.targets()) {
+				for (auto& attribute : target) {
+					if (attribute.pAccessor) {
+						accessorUsage[attribute.pAccessor->index()] |= _USAGE_VERTICES;
+					}
+				}
+			}
+		}
+	}
+
+	// usage of buffer views, accessors not used by primitives belong to animations or skins
+	size_t viewCount = _pAsset->_bufferViews.size();
+	vector<int> viewUsage(viewCount, _USAGE_NONE);
+	vector<vector<const GLTFAccessor*>> viewAccessors(viewCount);
+
+	for (auto pAccessor : _pAsset->_accessors) {
+		if (pAccessor->bufferView()) {
+			size_t index = pAccessor->bufferView()->index();
+			int usage = accessorUsage[pAccessor->index()];
+			viewUsage[index] |= usage == _USAGE_NONE ? _USAGE_OTHER : usage;
+			viewAccessors[index].push_back(pAccessor);
+		}
+	}
+	for (auto pImage : _pAsset->_images) {
+		if (pImage->bufferView()) {
+			viewUsage[pImage->bufferView()->index()] |= _USAGE_OTHER;
+		}
+	}
+	for (auto pExtension : _pAsset->_ownedExtensions) {
+		auto pDraco = dynamic_cast<const GLTFDracoExtension*>(pExtension);
+		if (pDraco && pDraco->bufferView()) {
+			viewUsage[pDraco->bufferView()->index()] |= _USAGE_OTHER;
+		}
+	}
+
+	for (size_t i = 0; i < viewCount; ++i) {
+		auto pBufferView = const_cast<GLTFBufferView*>(_pAsset->_bufferViews[i]);
+		const vector<const GLTFAccessor*>& accessors = viewAccessors[i];
+
+		// views compressed before have an extension and lie in a fallback buffer
+		if (pBufferView->buffer()->isFallback() || !pBufferView->extensions().empty()) {
+			continue;
+		}
+
+		size_t byteLength = pBufferView->byteLength();
+
+		if (viewUsage[i] == _USAGE_VERTICES) {
+			// all accessors must agree on the stride, the view is encoded as a whole
+			size_t byteStride = pBufferView->byteStride();
+			for (auto pAccessor : accessors) {
+				if (byteStride == 0) {
+					byteStride = pAccessor->elementStride();
+				}
+				if (pAccessor->elementStride() != byteStride) {
+					byteStride = 0;
+					break;
+				}
+			}
+
+			if (byteStride > 0 && byteStride % 4 == 0 && byteStride <= 256 && byteLength % byteStride == 0) {
+				jobs.push_back({ pBufferView, GLTFMeshoptMode::ATTRIBUTES, byteStride, byteLength / byteStride, {} });
+			}
+		}
+		else if (viewUsage[i] == _USAGE_INDICES) {
+			// the codec may rotate triangles, each accessor must start at a triangle boundary
+			size_t byteStride = accessors.front()->elementByteSize();
+			bool isEligible = pBufferView->byteStride() == 0 || pBufferView->byteStride() == byteStride;
+
+			for (auto pAccessor : accessors) {
+				isEligible = isEligible
+					&& pAccessor->elementByteSize() == byteStride
+					&& pAccessor->elementStride() == byteStride
+					&& pAccessor->byteOffset() % (3 * byteStride) == 0
+					&& pAccessor->elementCount() % 3 == 0;
+			}
+
+			if (isEligible && byteLength % (3 * byteStride) == 0) {
+				jobs.push_back({ pBufferView, GLTFMeshoptMode::TRIANGLES, byteStride, byteLength / byteStride, {} });
+			}
+		}
+	}
+}
+
+void GLTFMeshoptEncoder::_encodeJob(job_t& job)
+{
+	const char* pData = job.pBufferView->data();
+	size_t byteLength = job.pBufferView->byteLength();
+	size_t resultLength = 0;
+
+	if (job.mode == GLTFMeshoptMode::ATTRIBUTES) {
+		job.result.resize(GLTFMeshoptCodec::encodeVertexBufferBound(job.count, job.byteStride));
+		resultLength = GLTFMeshoptCodec::encodeVertexBuffer(job.result.data(), job.result.size(),
+			(const uint8_t*)pData, job.count, job.byteStride);
+	}
+	else {
+		// the codec takes 32 bit indices, data in the buffer may not be aligned
+		vector<uint32_t> indices(job.count);
+		uint32_t maxIndex = 0;
+
+		if (job.byteStride == 2) {
+			for (size_t i = 0; i < job.count; ++i) {
+				uint16_t index;
+				std::memcpy(&index, pData + i * 2, 2);
+				indices[i] = index;
+			}
+		}
+		else {
+			std::memcpy(indices.data(), pData, job.count * 4);
+		}
+
+		for (size_t i = 0; i < job.count; ++i) {
+			maxIndex = std::max(maxIndex, indices[i]);
+		}
+
+		job.result.resize(GLTFMeshoptCodec::encodeIndexBufferBound(job.count, size_t(maxIndex) + 1));
+		resultLength = GLTFMeshoptCodec::encodeIndexBuffer(job.result.data(), job.result.size(),
+			indices.data(), job.count);
+	}
+
+	// keep the original if compression doesn't pay off
+	if (resultLength == 0 || resultLength >= byteLength) {
+		job.result.clear();
+	}
+	else {
+		job.result.resize(resultLength);
+	}
+}
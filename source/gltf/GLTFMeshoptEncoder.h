@@ -0,0 +1,79 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_MESHOPTENCODER_H
+#define _FLOWLIBS_GLTF_MESHOPTENCODER_H
+
+#include "library.h"
+#include "GLTFConstants.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFAsset;
+	class GLTFBuffer;
+	class GLTFBufferView;
+
+	/// Compresses buffer views with the EXT_meshopt_compression extension. Views holding
+	/// vertex attributes are encoded with the attribute codec, views holding triangle list
+	/// indices with the triangle codec. The original views are moved to a fallback buffer,
+	/// which only reserves their ranges: it is declared in the document with its length,
+	/// and the uncompressed data of the views is no longer available in memory.
+	///
+	/// A view is compressed if it is used by vertex attributes only, with a common stride
+	/// that is a multiple of 4 and at most 256 bytes, or by indices of triangle lists only,
+	/// with UNSIGNED_SHORT or UNSIGNED_INT components. Views used by other accessors or
+	/// images, and views whose encoded size isn't smaller than the original, are left as is.
+	class F_GLTF_EXPORT GLTFMeshoptEncoder
+	{
+	public:
+		GLTFMeshoptEncoder(GLTFAsset* pAsset);
+
+		/// Compresses all eligible buffer views in parallel. The compressed data is appended to
+		/// pBuffer without buffer views, each range is referenced by the extension of its view.
+		/// The original data remains in its buffer until removed by GLTFAsset::compact().
+		/// Registers EXT_meshopt_compression as a required extension if any view was compressed.
+		/// Returns false if the data of an eligible view is not available.
+		bool encode(GLTFBuffer* pBuffer);
+
+		/// Number of compressed buffer views.
+		size_t viewCount() const { return _viewCount; }
+		/// Size of the original data of the compressed views.
+		size_t sourceByteLength() const { return _sourceByteLength; }
+		/// Size of the compressed data.
+		size_t resultByteLength() const { return _resultByteLength; }
+
+		const std::string& error() const { return _error; }
+
+	private:
+		struct job_t
+		{
+			GLTFBufferView* pBufferView;
+			GLTFMeshoptMode mode;
+			size_t byteStride;
+			size_t count;
+			std::vector<uint8_t> result;
+		};
+
+		void _findJobs(std::vector<job_t>& jobs) const;
+		static void _encodeJob(job_t& job);
+
+		GLTFAsset* _pAsset;
+
+		size_t _viewCount;
+		size_t _sourceByteLength;
+		size_t _resultByteLength;
+
+		std::string _error;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_MESHOPTENCODER_H
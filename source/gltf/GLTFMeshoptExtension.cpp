@@ -0,0 +1,80 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFMeshoptExtension.h"
+#include "GLTFBuffer.h"
+#include "GLTFWriteContext.h"
+
+#include "../core/JsonWriter.h"
+
+using namespace flow;
+using std::string;
+
+
+GLTFMeshoptExtension::GLTFMeshoptExtension() :
+	_pBuffer(nullptr),
+	_byteOffset(0),
+	_byteLength(0),
+	_byteStride(0),
+	_count(0)
+{
+}
+
+GLTFMeshoptExtension::GLTFMeshoptExtension(const GLTFBuffer* pBuffer, size_t byteOffset, size_t byteLength,
+	size_t byteStride, size_t count, GLTFMeshoptMode mode) :
+	_pBuffer(pBuffer),
+	_byteOffset(byteOffset),
+	_byteLength(byteLength),
+	_byteStride(byteStride),
+	_count(count),
+	_mode(mode)
+{
+}
+
+const char* GLTFMeshoptExtension::data() const
+{
+	return _pBuffer ? _pBuffer->data(_byteOffset) : nullptr;
+}
+
+const char* GLTFMeshoptExtension::name() const
+{
+	return "EXT_meshopt_compression";
+}
+
+json GLTFMeshoptExtension::toJSON() const
+{
+	return _toJSON(GLTFWriteContext());
+}
+
+void GLTFMeshoptExtension::toJSON(JsonWriter& writer, const GLTFWriteContext& context) const
+{
+	writer.value(_toJSON(context));
+}
+
+json GLTFMeshoptExtension::_toJSON(const GLTFWriteContext& context) const
+{
+	if (isFallback()) {
+		return json{ { "fallback", true } };
+	}
+
+	// the compressed data is referenced by buffer, not by view
+	size_t byteOffset = context.bufferOffset(_pBuffer) + _byteOffset;
+
+	json result{
+		{ "buffer", context.bufferIndex(_pBuffer) },
+		{ "byteLength", _byteLength },
+		{ "byteStride", _byteStride },
+		{ "count", _count },
+		{ "mode", _mode.name() }
+	};
+
+	if (byteOffset > 0) {
+		result["byteOffset"] = byteOffset;
+	}
+
+	return result;
+}
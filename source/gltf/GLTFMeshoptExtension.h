@@ -0,0 +1,68 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_MESHOPTEXTENSION_H
+#define _FLOWLIBS_GLTF_MESHOPTEXTENSION_H
+
+#include "library.h"
+#include "GLTFExtension.h"
+#include "GLTFConstants.h"
+
+#include "../core/json.h"
+#include <string>
+
+namespace flow
+{
+	class GLTFBuffer;
+
+	/// EXT_meshopt_compression. Attached to a buffer view, it refers to the compressed
+	/// data of the view, a range of a buffer which has no buffer view of its own.
+	/// Attached to a buffer, it marks the buffer as fallback buffer of the uncompressed
+	/// views, whose data is not written.
+	class F_GLTF_EXPORT GLTFMeshoptExtension : public GLTFExtension
+	{
+		friend class GLTFAsset;
+
+	public:
+		/// Creates a fallback buffer marker.
+		GLTFMeshoptExtension();
+		/// Creates a buffer view extension referring to the compressed data.
+		GLTFMeshoptExtension(const GLTFBuffer* pBuffer, size_t byteOffset, size_t byteLength,
+			size_t byteStride, size_t count, GLTFMeshoptMode mode);
+		virtual ~GLTFMeshoptExtension() { }
+
+		bool isFallback() const { return _pBuffer == nullptr; }
+
+		/// Buffer holding the compressed data.
+		const GLTFBuffer* buffer() const { return _pBuffer; }
+		size_t byteOffset() const { return _byteOffset; }
+		size_t byteLength() const { return _byteLength; }
+		/// Returns a pointer to the compressed data, or nullptr if not available.
+		const char* data() const;
+
+		size_t byteStride() const { return _byteStride; }
+		size_t count() const { return _count; }
+		GLTFMeshoptMode mode() const { return _mode; }
+
+		virtual const char* name() const;
+		virtual json toJSON() const;
+		virtual void toJSON(JsonWriter& writer, const GLTFWriteContext& context) const;
+
+	private:
+		json _toJSON(const GLTFWriteContext& context) const;
+		void _setByteOffset(size_t byteOffset) { _byteOffset = byteOffset; }
+
+		const GLTFBuffer* _pBuffer;
+		size_t _byteOffset;
+		size_t _byteLength;
+		size_t _byteStride;
+		size_t _count;
+		GLTFMeshoptMode _mode;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_MESHOPTEXTENSION_H
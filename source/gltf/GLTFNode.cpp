@@ -10,25 +10,21 @@
 #include "GLTFSkin.h"
 #include "GLTFNode.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
 
 GLTFNode::GLTFNode(size_t index, const string& name /* = string{} */) :
 	GLTFMainElement(index, name),
-	_pMatrix(nullptr),
-	_pTranslation(nullptr),
-	_pRotation(nullptr),
-	_pScale(nullptr)
+	_flags(TransformDirty)
 {
 }
 
 GLTFNode::~GLTFNode()
 {
-	F_SAFE_DELETE(_pMatrix);
-	F_SAFE_DELETE(_pTranslation);
-	F_SAFE_DELETE(_pRotation);
-	F_SAFE_DELETE(_pScale);
+	_clearMatrix();
 }
 
 void GLTFNode::addChild(const GLTFNode* pNode)
@@ -38,79 +34,103 @@ void GLTFNode::addChild(const GLTFNode* pNode)
 
 void GLTFNode::setMatrix(const Matrix4f& matrix)
 {
-	F_SAFE_DELETE(_pMatrix);
-	F_SAFE_DELETE(_pTranslation);
-	F_SAFE_DELETE(_pRotation);
-	F_SAFE_DELETE(_pScale);
+	_markTransformDirty();
+
+	if (_flags & Matrix) {
+		*_transform.pMatrix = matrix;
+	}
+	else {
+		_transform.pMatrix = new Matrix4f(matrix);
+	}
 
-	_pMatrix = new Matrix4f(matrix);
+	_flags = Matrix | TransformDirty;
 }
 
 void GLTFNode::setTranslation(const Vector3f& translation)
 {
-	F_SAFE_DELETE(_pMatrix);
-	F_SAFE_DELETE(_pTranslation);
-
-	_pTranslation = new Vector3f(translation);
+	_markTransformDirty();
+	_clearMatrix();
+	_transform.trs.translation = translation;
+	_flags |= Translation;
 }
 
 void GLTFNode::setRotation(const Quaternion4f& rotation)
 {
-	F_SAFE_DELETE(_pMatrix);
-	F_SAFE_DELETE(_pRotation);
-
-	_pRotation = new Quaternion4f(rotation);
+	_markTransformDirty();
+	_clearMatrix();
+	_transform.trs.rotation = rotation;
+	_flags |= Rotation;
 }
 
 void GLTFNode::setScale(const Vector3f& scale)
 {
-	F_SAFE_DELETE(_pMatrix);
-	F_SAFE_DELETE(_pScale);
-
-	_pScale = new Vector3f(scale);
+	_markTransformDirty();
+	_clearMatrix();
+	_transform.trs.scale = scale;
+	_flags |= Scale;
 }
 
 void GLTFNode::setTRS(const Vector3f& translation, const Quaternion4f& rotation, const Vector3f& scale)
 {
-	F_SAFE_DELETE(_pMatrix);
-	F_SAFE_DELETE(_pTranslation);
-	F_SAFE_DELETE(_pRotation);
-	F_SAFE_DELETE(_pScale);
-
-	_pTranslation = new Vector3f(translation);
-	_pRotation = new Quaternion4f(rotation);
-	_pScale = new Vector3f(scale);
+	_markTransformDirty();
+	_clearMatrix();
+	_transform.trs.translation = translation;
+	_transform.trs.rotation = rotation;
+	_transform.trs.scale = scale;
+	_flags = Translation | Rotation | Scale | TransformDirty;
 }
 
-json GLTFNode::toJSON() const
+void GLTFNode::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
+	GLTFMainElement::_writeProperties(writer, context);
 	
 	if (!_children.empty()) {
-		auto nodeArray = json::array();
+		writer.key("children").beginArray();
 		for (auto it = _children.begin(); it != _children.end(); ++it) {
-			nodeArray.push_back((*it)->index());
+			writer.value((*it)->index());
 		}
-
-		result["children"] = nodeArray;
+		writer.endArray();
 	}
 
-	if (_pMatrix) {
-		result["matrix"] = _pMatrix->toJSON();
+	if (_flags & Matrix) {
+		float values[16];
+		_transform.pMatrix->copyTo(values, Matrix4f::ColumnMajor);
+		writer.key("matrix").array(values, 16);
 	}
 	else {
-		if (_pTranslation) {
-			result["translation"] = _pTranslation->toJSON();
+		if (_flags & Translation) {
+			writer.key("translation").array(_transform.trs.translation.ptr(), 3);
 		}
-		if (_pRotation) {
-			result["rotation"] = _pRotation->toJSON();
+		if (_flags & Rotation) {
+			writer.key("rotation").array(_transform.trs.rotation.v, 4);
 		}
-		if (_pScale) {
-			result["scale"] = _pScale->toJSON();
+		if (_flags & Scale) {
+			writer.key("scale").array(_transform.trs.scale.ptr(), 3);
 		}
 	}
+}
 
-	return result;
+void GLTFNode::_clearMatrix()
+{
+	// the matrix pointer shares storage with the TRS fields, switching to TRS drops it
+	if (_flags & Matrix) {
+		F_SAFE_DELETE(_transform.pMatrix);
+		_flags &= TransformDirty;
+	}
+}
+
+void GLTFNode::_markTransformDirty()
+{
+	if (!(_flags & TransformDirty) && _pDirtyNodes) {
+		_pDirtyNodes->push_back(this);
+	}
+
+	_flags |= TransformDirty;
+}
+
+void GLTFNode::_setTransformDirty(bool isDirty) const
+{
+	_flags = isDirty ? (_flags | TransformDirty) : (_flags & ~TransformDirty);
 }
 
 GLTFMeshNode::GLTFMeshNode(size_t index, const GLTFMesh* pMesh, const string& name /* = string{} */) :
@@ -119,11 +139,10 @@ GLTFMeshNode::GLTFMeshNode(size_t index, const GLTFMesh* pMesh, const string& na
 {
 }
 
-json GLTFMeshNode::toJSON() const
+void GLTFMeshNode::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFNode::toJSON();
-	result["mesh"] = _pMesh->index();
-	return result;
+	GLTFNode::_writeProperties(writer, context);
+	writer.member("mesh", _pMesh->index());
 }
 
 GLTFCameraNode::GLTFCameraNode(size_t index, const GLTFCamera* pCamera, const string& name /* = string{} */) :
@@ -132,11 +151,10 @@ GLTFCameraNode::GLTFCameraNode(size_t index, const GLTFCamera* pCamera, const st
 {
 }
 
-json GLTFCameraNode::toJSON() const
+void GLTFCameraNode::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFNode::toJSON();
-	result["camera"] = _pCamera->index();
-	return result;
+	GLTFNode::_writeProperties(writer, context);
+	writer.member("camera", _pCamera->index());
 }
 
 GLTFSkinNode::GLTFSkinNode(size_t index, const GLTFSkin* pSkin, const string& name /* = string{} */) :
@@ -145,9 +163,8 @@ GLTFSkinNode::GLTFSkinNode(size_t index, const GLTFSkin* pSkin, const string& na
 {
 }
 
-json GLTFSkinNode::toJSON() const
+void GLTFSkinNode::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFNode::toJSON();
-	result["skin"] = _pSkin->index();
-	return result;
+	GLTFNode::_writeProperties(writer, context);
+	writer.member("skin", _pSkin->index());
 }
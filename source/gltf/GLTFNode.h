@@ -17,6 +17,8 @@
 
 #include <string>
 #include <vector>
+#include <memory>
+#include <cstdint>
 
 
 namespace flow
@@ -28,6 +30,8 @@ namespace flow
 	class F_GLTF_EXPORT GLTFNode : public GLTFMainElement
 	{
 		friend class GLTFAsset;
+		friend class GLTFSceneEvaluator;
+		F_DISABLE_COPY(GLTFNode);
 
 	protected:
 		GLTFNode(size_t index, const std::string& name = std::string{});
@@ -44,19 +48,71 @@ namespace flow
 		void setTRS(const Vector3f& translation, const Quaternion4f& rotation, const Vector3f& scale);
 
 		const nodeVec_t& children() const { return _children; }
-		const Matrix4f* matrix() const { return _pMatrix; }
-		const Vector3f* translation() const { return _pTranslation; }
-		const Quaternion4f* rotation() const { return _pRotation; }
-		const Vector3f* scale() const { return _pScale; }
+		/// Returns the local transform matrix, or nullptr if the node has none.
+		const Matrix4f* matrix() const {
+			return (_flags & Matrix) ? _transform.pMatrix : nullptr;
+		}
+		/// Returns the local translation, or nullptr if the node has none.
+		const Vector3f* translation() const {
+			return (_flags & Translation) ? &_transform.trs.translation : nullptr;
+		}
+		/// Returns the local rotation, or nullptr if the node has none.
+		const Quaternion4f* rotation() const {
+			return (_flags & Rotation) ? &_transform.trs.rotation : nullptr;
+		}
+		/// Returns the local scale, or nullptr if the node has none.
+		const Vector3f* scale() const {
+			return (_flags & Scale) ? &_transform.trs.scale : nullptr;
+		}
+
+		/// True if the local transform changed since the node was last evaluated
+		/// by a GLTFSceneEvaluator. Set by all transform setters and on creation.
+		/// Setters of nodes tracked by an evaluator must not run concurrently.
+		bool isTransformDirty() const { return (_flags & TransformDirty) != 0; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
+		/// Bits in _flags telling which transform fields are present,
+		/// and whether the transform changed since the last evaluation.
+		enum flag_t : uint8_t
+		{
+			Matrix = 0x01,
+			Translation = 0x02,
+			Rotation = 0x04,
+			Scale = 0x08,
+			TransformDirty = 0x10
+		};
+
+		/// Inline transform storage. A node carries either a matrix or any subset
+		/// of translation, rotation and scale, never both. Most nodes use TRS,
+		/// a matrix is allocated separately to keep the inline block small.
+		union transform_t
+		{
+			struct trs_t
+			{
+				Quaternion4f rotation;
+				Vector3f translation;
+				Vector3f scale;
+			};
+
+			transform_t() { }
+
+			Matrix4f* pMatrix;
+			trs_t trs;
+		};
+
+		void _clearMatrix();
+		/// Sets the dirty flag, reporting the first change since the last evaluation.
+		void _markTransformDirty();
+		void _setTransformDirty(bool isDirty) const;
+
+		mutable uint8_t _flags;
+		transform_t _transform;
 		nodeVec_t _children;
-		Matrix4f* _pMatrix;
-		Vector3f* _pTranslation;
-		Quaternion4f* _pRotation;
-		Vector3f* _pScale;
+		/// Changed nodes of the scene evaluator tracking this node, if any.
+		mutable std::shared_ptr<nodeVec_t> _pDirtyNodes;
 	};
 
 	class F_GLTF_EXPORT GLTFMeshNode : public GLTFNode
@@ -67,7 +123,11 @@ namespace flow
 		GLTFMeshNode(size_t index, const GLTFMesh* pMesh, const std::string& name = std::string{});
 		virtual ~GLTFMeshNode() { }
 
-		virtual json toJSON() const;
+	public:
+		const GLTFMesh* mesh() const { return _pMesh; }
+
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		const GLTFMesh* _pMesh;
@@ -81,7 +141,7 @@ namespace flow
 		GLTFCameraNode(size_t index, const GLTFCamera* pCamera, const std::string& name = std::string{});
 		virtual ~GLTFCameraNode() { }
 
-		virtual json toJSON() const;
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		const GLTFCamera* _pCamera;
@@ -95,7 +155,7 @@ namespace flow
 		GLTFSkinNode(size_t index, const GLTFSkin* pSkin, const std::string& name = std::string{});
 		virtual ~GLTFSkinNode() { }
 
-		virtual json toJSON() const;
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		const GLTFSkin* _pSkin;
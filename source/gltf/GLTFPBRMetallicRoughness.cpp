@@ -7,6 +7,8 @@
 
 #include "GLTFPBRMetallicRoughness.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 
 
@@ -44,25 +46,25 @@ void GLTFPBRMetallicRoughness::setMetallicRoughnessTexture(GLTFTexture* pTexture
 	_metallicRoughnessTexture.set(pTexture, texCoords);
 }
 
-json GLTFPBRMetallicRoughness::toJSON() const
+void GLTFPBRMetallicRoughness::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFElement::toJSON();
+	GLTFElement::_writeProperties(writer, context);
 
 	if (_baseColorFactor != _DEFAULT_BASECOLORFACTOR) {
-		result["baseColorFactor"] = _baseColorFactor.toJSON();
+		writer.key("baseColorFactor").array(_baseColorFactor.ptr(), 4);
 	}
 	if (_baseColorTexture.texture()) {
-		result["baseColorTexture"] = _baseColorTexture.toJSON();
+		writer.key("baseColorTexture");
+		_baseColorTexture.toJSON(writer, context);
 	}
 	if (_metallicFactor != 1.0f) {
-		result["metallicFactor"] = _metallicFactor;
+		writer.member("metallicFactor", _metallicFactor);
 	}
 	if (_roughnessFactor != 1.0f) {
-		result["roughnessFactor"] = _roughnessFactor;
+		writer.member("roughnessFactor", _roughnessFactor);
 	}
 	if (_metallicRoughnessTexture.texture()) {
-		result["metallicRoughnessTexture"] = _metallicRoughnessTexture.toJSON();
+		writer.key("metallicRoughnessTexture");
+		_metallicRoughnessTexture.toJSON(writer, context);
 	}
-
-	return result;
 }
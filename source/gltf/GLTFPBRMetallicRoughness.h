@@ -37,7 +37,11 @@ namespace flow
 		float roughnessFactor() const { return _roughnessFactor; }
 		const GLTFTextureInfo& metallicRoughnessTexture() const { return _metallicRoughnessTexture; }
 
-		virtual json toJSON() const;
+		GLTFTextureInfo& baseColorTexture() { return _baseColorTexture; }
+		GLTFTextureInfo& metallicRoughnessTexture() { return _metallicRoughnessTexture; }
+
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		static const Vector4f _DEFAULT_BASECOLORFACTOR;
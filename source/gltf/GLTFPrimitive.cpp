@@ -9,6 +9,8 @@
 #include "GLTFAccessor.h"
 #include "GLTFMaterial.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -40,6 +42,18 @@ void GLTFPrimitive::addAttribute(GLTFAttributeType type, const GLTFAccessor* pAc
 	_attributes.push_back({ type, pAccessor });
 }
 
+void GLTFPrimitive::setAttribute(GLTFAttributeType type, const GLTFAccessor* pAccessor)
+{
+	for (auto& attribute : _attributes) {
+		if (attribute.type == type) {
+			attribute.pAccessor = pAccessor;
+			return;
+		}
+	}
+
+	_attributes.push_back({ type, pAccessor });
+}
+
 void GLTFPrimitive::addTargetAttribute(size_t index, GLTFAttributeType type, const GLTFAccessor* pAccessor)
 {
 	if (index >= _targets.size()) {
@@ -75,39 +89,36 @@ const GLTFAccessor* GLTFPrimitive::attributeAccessor(GLTFAttributeType type) con
 	return nullptr;
 }
 
-json GLTFPrimitive::toJSON() const
+void GLTFPrimitive::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFElement::toJSON();
+	GLTFElement::_writeProperties(writer, context);
 
-	result["mode"] = (int)_mode;
+	writer.member("mode", (int)_mode);
 
 	if (!_attributes.empty()) {
-		json attribDict;
+		writer.key("attributes").beginObject();
 		for (auto it = _attributes.begin(); it != _attributes.end(); ++it) {
-			attribDict[it->type.name()] = it->pAccessor->index();
+			writer.member(it->type.name(), it->pAccessor->index());
 		}
-		result["attributes"] = attribDict;
+		writer.endObject();
 	}
 
 	if (_pIndicesAccessor) {
-		result["indices"] = _pIndicesAccessor->index();
+		writer.member("indices", _pIndicesAccessor->index());
 	}
 	if (_pMaterial) {
-		result["material"] = _pMaterial->index();
+		writer.member("material", _pMaterial->index());
 	}
 
 	if (!_targets.empty()) {
-		auto targetArr = json::array();
+		writer.key("targets").beginArray();
 		for (auto tar_it = _targets.begin(); tar_it != _targets.end(); ++tar_it) {
-			auto targetDict = json();
+			writer.beginObject();
 			for (auto atr_it = tar_it->begin(); atr_it != tar_it->end(); ++atr_it) {
-				targetDict[atr_it->type.name()] = atr_it->pAccessor->index();
+				writer.member(atr_it->type.name(), atr_it->pAccessor->index());
 			}
-			targetArr.push_back(targetDict);
+			writer.endObject();
 		}
-
-		result["targets"] = targetArr;
+		writer.endArray();
 	}
-
-	return result;
 }
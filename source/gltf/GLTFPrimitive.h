@@ -41,6 +41,8 @@ namespace flow
 
 		void setIndices(const GLTFAccessor* pAccessor);
 		void addAttribute(GLTFAttributeType type, const GLTFAccessor* pAccessor);
+		/// Replaces the accessor of the given attribute, or adds the attribute if not present.
+		void setAttribute(GLTFAttributeType type, const GLTFAccessor* pAccessor);
 		void addTargetAttribute(size_t index, GLTFAttributeType type, const GLTFAccessor* pAccessor);
 
 		void addPositions(const GLTFAccessor* pAccessor);
@@ -54,7 +56,8 @@ namespace flow
 		const GLTFAccessor* attributeAccessor(GLTFAttributeType type) const;
 		const targetVec_t& targets() const { return _targets; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		GLTFPrimitiveMode _mode;
@@ -0,0 +1,984 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFReader.h"
+
+#include "GLTFAsset.h"
+#include "GLTFScene.h"
+#include "GLTFNode.h"
+#include "GLTFMesh.h"
+#include "GLTFPrimitive.h"
+#include "GLTFCamera.h"
+#include "GLTFBuffer.h"
+#include "GLTFBufferView.h"
+#include "GLTFAccessorT.h"
+#include "GLTFMaterial.h"
+#include "GLTFPBRMetallicRoughness.h"
+#include "GLTFTexture.h"
+#include "GLTFImage.h"
+#include "GLTFSampler.h"
+#include "GLTFGenericExtension.h"
+#include "GLTFDracoExtension.h"
+#include "GLTFMeshoptExtension.h"
+
+#include "../core/MappedFile.h"
+
+#include <algorithm>
+#include <cctype>
+
+using namespace flow;
+using std::string;
+using std::vector;
+
+
+namespace
+{
+	bool _findAttributeType(const string& name, GLTFAttributeType& type)
+	{
+		for (int i = GLTFAttributeType::POSITION; i <= GLTFAttributeType::WEIGHTS_0; ++i) {
+			GLTFAttributeType candidate((GLTFAttributeType::enum_type)i);
+			if (name == candidate.name()) {
+				type = candidate;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	bool _findMeshoptMode(const string& name, GLTFMeshoptMode& mode)
+	{
+		for (int i = GLTFMeshoptMode::ATTRIBUTES; i <= GLTFMeshoptMode::INDICES; ++i) {
+			GLTFMeshoptMode candidate((GLTFMeshoptMode::enum_type)i);
+			if (name == candidate.name()) {
+				mode = candidate;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	GLTFVersion _parseVersion(const string& version)
+	{
+		if (version == "1.0") {
+			return GLTFVersion::GLTF_1_0;
+		}
+		if (version == "2.0") {
+			return GLTFVersion::GLTF_2_0;
+		}
+
+		return GLTFVersion::UNDEFINED;
+	}
+
+	template<typename T>
+	T _value(const json& jsonObj, const char* pKey, T defaultValue)
+	{
+		auto it = jsonObj.find(pKey);
+		return it != jsonObj.end() ? it->get<T>() : defaultValue;
+	}
+
+	string _name(const json& jsonObj)
+	{
+		return _value<string>(jsonObj, "name", string{});
+	}
+
+	/// Decodes percent-encoded characters of a relative uri reference.
+	string _decodeUri(const string& uri)
+	{
+		string result;
+		result.reserve(uri.size());
+
+		for (size_t i = 0; i < uri.size(); ++i) {
+			if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(uri[i + 1]) && isxdigit(uri[i + 2])) {
+				result.push_back(char(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+				i += 2;
+			}
+			else {
+				result.push_back(uri[i]);
+			}
+		}
+
+		return result;
+	}
+}
+
+GLTFReader::GLTFReader(GLTFAsset* pAsset) :
+	_pAsset(pAsset),
+	_binaryOffset(0),
+	_binaryLength(0)
+{
+}
+
+void GLTFReader::setBasePath(const string& basePath)
+{
+	_basePath = basePath;
+}
+
+void GLTFReader::setBinaryChunk(std::shared_ptr<MappedFile> pFile, size_t byteOffset, size_t byteLength)
+{
+	_pBinaryFile = pFile;
+	_binaryOffset = byteOffset;
+	_binaryLength = byteLength;
+}
+
+bool GLTFReader::read(const json& document)
+{
+	_error.clear();
+
+	if (!document.is_object()) {
+		return _fail("document is not a JSON object");
+	}
+
+	// json throws on type mismatches, e.g. a string where a number is expected
+	try {
+		// not represented by the asset, they would be lost when the asset is saved again
+		if (!_value<json>(document, "skins", json::array()).empty()) {
+			return _fail("skins are not supported");
+		}
+		if (!_value<json>(document, "animations", json::array()).empty()) {
+			return _fail("animations are not supported");
+		}
+
+		if (!_readAssetInfo(document)
+			|| !_readBuffers(document)
+			|| !_readBufferViews(document)
+			|| !_readAccessors(document)
+			|| !_readSamplers(document)
+			|| !_readImages(document)
+			|| !_readTextures(document)
+			|| !_readMaterials(document)
+			|| !_readCameras(document)
+			|| !_readMeshes(document)
+			|| !_readNodes(document)
+			|| !_readScenes(document)) {
+			return false;
+		}
+
+		auto itScene = document.find("scene");
+		if (itScene != document.end()) {
+			auto pScene = _lookup(_scenes, *itScene, "scene");
+			if (!pScene) {
+				return false;
+			}
+			_pAsset->setMainScene(pScene);
+		}
+
+		_readElement(_pAsset, document);
+	}
+	catch (const std::exception& e) {
+		return _fail(string("malformed document: ") + e.what());
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readAssetInfo(const json& document)
+{
+	auto itAsset = document.find("asset");
+	if (itAsset == document.end()) {
+		return _fail("missing asset info");
+	}
+
+	const json& jsonAsset = *itAsset;
+
+	GLTFVersion version = _parseVersion(_value<string>(jsonAsset, "version", string{}));
+	if (version != GLTFVersion::GLTF_2_0) {
+		return _fail("unsupported glTF version");
+	}
+
+	GLTFVersion minVersion = _parseVersion(_value<string>(jsonAsset, "minVersion", string{}));
+	_pAsset->setVersion(version, minVersion);
+
+	if (jsonAsset.count("generator")) {
+		_pAsset->setGenerator(jsonAsset["generator"].get<string>());
+	}
+	if (jsonAsset.count("copyright")) {
+		_pAsset->setCopyright(jsonAsset["copyright"].get<string>());
+	}
+
+	// declarations only; the payloads are attached to the elements using them
+	auto itUsed = document.find("extensionsUsed");
+	if (itUsed != document.end()) {
+		json required = _value<json>(document, "extensionsRequired", json::array());
+		for (auto it = itUsed->begin(); it != itUsed->end(); ++it) {
+			string name = it->get<string>();
+			bool isRequired = std::find(required.begin(), required.end(), name) != required.end();
+			_pAsset->addExtension(new GLTFGenericExtension(name), isRequired);
+		}
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readBuffers(const json& document)
+{
+	auto itBuffers = document.find("buffers");
+	if (itBuffers == document.end()) {
+		return true;
+	}
+
+	bool binaryChunkUsed = false;
+
+	for (auto it = itBuffers->begin(); it != itBuffers->end(); ++it) {
+		const json& jsonBuffer = *it;
+		size_t byteLength = jsonBuffer.at("byteLength").get<size_t>();
+
+		auto pBuffer = _pAsset->createBuffer(_name(jsonBuffer));
+		_buffers.push_back(pBuffer);
+
+		auto itUri = jsonBuffer.find("uri");
+
+		// a meshopt fallback buffer without uri has a length but no data
+		auto itExtensions = jsonBuffer.find("extensions");
+		if (itUri == jsonBuffer.end() && itExtensions != jsonBuffer.end()
+				&& itExtensions->count("EXT_meshopt_compression")
+				&& _value<bool>((*itExtensions)["EXT_meshopt_compression"], "fallback", false)) {
+
+			pBuffer->setFallback(true);
+			pBuffer->_reserve(byteLength);
+			pBuffer->addExtension(_pAsset->createExtension<GLTFMeshoptExtension>());
+
+			json jsonCopy = jsonBuffer;
+			jsonCopy["extensions"].erase("EXT_meshopt_compression");
+			_readElement(pBuffer, jsonCopy);
+			continue;
+		}
+
+		_readElement(pBuffer, jsonBuffer);
+
+		if (itUri != jsonBuffer.end()) {
+			string uri = itUri->get<string>();
+			if (uri.compare(0, 5, "data:") == 0) {
+				return _fail("buffers with data uri are not supported");
+			}
+
+			// the file is mapped on first access to the buffer's data
+			pBuffer->setUri(uri);
+			pBuffer->setExternalFile(_basePath + _decodeUri(uri), byteLength);
+			continue;
+		}
+
+		// only the first buffer without uri may refer to the GLB binary chunk
+		if (!_pBinaryFile || binaryChunkUsed) {
+			return _fail("buffer without uri and no binary chunk available");
+		}
+		if (byteLength > _binaryLength) {
+			return _fail("buffer byteLength exceeds binary chunk");
+		}
+
+		pBuffer->setMappedData(_pBinaryFile, _binaryOffset, byteLength);
+		binaryChunkUsed = true;
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readBufferViews(const json& document)
+{
+	auto itViews = document.find("bufferViews");
+	if (itViews == document.end()) {
+		return true;
+	}
+
+	for (auto it = itViews->begin(); it != itViews->end(); ++it) {
+		const json& jsonView = *it;
+
+		auto pBuffer = _lookup(_buffers, jsonView.at("buffer"), "buffer");
+		if (!pBuffer) {
+			return false;
+		}
+
+		size_t byteOffset = _value<size_t>(jsonView, "byteOffset", 0);
+		size_t byteLength = jsonView.at("byteLength").get<size_t>();
+		size_t byteStride = _value<size_t>(jsonView, "byteStride", 0);
+
+		auto pBufferView = pBuffer->createView(byteOffset, byteLength, byteStride);
+		if (!pBufferView) {
+			return _fail("buffer view exceeds buffer");
+		}
+
+		pBufferView->setName(_name(jsonView));
+		pBufferView->setTarget((GLTFBufferViewTarget::enum_type)
+			_value<int>(jsonView, "target", GLTFBufferViewTarget::UNDEFINED));
+
+		_bufferViews.push_back(pBufferView);
+
+		// meshopt data is referenced by buffer and range; filtered data stays generic
+		GLTFMeshoptMode mode;
+		auto itExtensions = jsonView.find("extensions");
+		if (itExtensions != jsonView.end() && itExtensions->count("EXT_meshopt_compression")) {
+			const json& jsonMeshopt = (*itExtensions)["EXT_meshopt_compression"];
+			if (_value<string>(jsonMeshopt, "filter", "NONE") == "NONE"
+					&& _findMeshoptMode(jsonMeshopt.at("mode").get<string>(), mode)) {
+
+				auto pDataBuffer = _lookup(_buffers, jsonMeshopt.at("buffer"), "buffer");
+				if (!pDataBuffer) {
+					return false;
+				}
+
+				size_t dataOffset = _value<size_t>(jsonMeshopt, "byteOffset", 0);
+				size_t dataLength = jsonMeshopt.at("byteLength").get<size_t>();
+				if (dataOffset + dataLength > pDataBuffer->byteLength()) {
+					return _fail("meshopt data exceeds buffer");
+				}
+
+				pBufferView->addExtension(_pAsset->createExtension<GLTFMeshoptExtension>(
+					pDataBuffer, dataOffset, dataLength,
+					jsonMeshopt.at("byteStride").get<size_t>(),
+					jsonMeshopt.at("count").get<size_t>(), mode));
+
+				json jsonCopy = jsonView;
+				jsonCopy["extensions"].erase("EXT_meshopt_compression");
+				_readElement(pBufferView, jsonCopy);
+				continue;
+			}
+		}
+
+		_readElement(pBufferView, jsonView);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readAccessors(const json& document)
+{
+	auto itAccessors = document.find("accessors");
+	if (itAccessors == document.end()) {
+		return true;
+	}
+
+	static const GLTFAccessorType types[] = {
+		GLTFAccessorType::SCALAR, GLTFAccessorType::VEC2, GLTFAccessorType::VEC3, GLTFAccessorType::VEC4,
+		GLTFAccessorType::MAT2, GLTFAccessorType::MAT3, GLTFAccessorType::MAT4
+	};
+
+	for (auto it = itAccessors->begin(); it != itAccessors->end(); ++it) {
+		const json& jsonAccessor = *it;
+
+		if (jsonAccessor.count("sparse")) {
+			return _fail("sparse accessors are not supported");
+		}
+
+		string typeName = jsonAccessor.at("type").get<string>();
+		const GLTFAccessorType* pType = nullptr;
+		for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); ++i) {
+			if (typeName == types[i].name()) {
+				pType = &types[i];
+			}
+		}
+		if (!pType) {
+			return _fail("invalid accessor type: " + typeName);
+		}
+
+		auto component = (GLTFAccessorComponent::enum_type)jsonAccessor.at("componentType").get<int>();
+		auto pAccessor = _createAccessor(component, *pType, jsonAccessor);
+		if (!pAccessor) {
+			return _fail("invalid accessor component type");
+		}
+
+		pAccessor->setElementCount(jsonAccessor.at("count").get<size_t>());
+		pAccessor->setNormalized(_value<bool>(jsonAccessor, "normalized", false));
+
+		auto itView = jsonAccessor.find("bufferView");
+		if (itView != jsonAccessor.end()) {
+			auto pBufferView = _lookup(_bufferViews, *itView, "bufferView");
+			if (!pBufferView) {
+				return false;
+			}
+			size_t byteOffset = _value<size_t>(jsonAccessor, "byteOffset", 0);
+			size_t count = pAccessor->elementCount();
+			size_t elementSize = pAccessor->elementByteSize();
+			size_t stride = pBufferView->byteStride() ? pBufferView->byteStride() : elementSize;
+			size_t byteLength = pBufferView->byteLength();
+
+			// last element must end within the view, checked without overflow
+			if (count > 0 && (byteOffset > byteLength || elementSize > byteLength - byteOffset
+					|| (count - 1) > (byteLength - byteOffset - elementSize) / stride)) {
+				return _fail("accessor exceeds buffer view");
+			}
+
+			pAccessor->setBufferView(pBufferView, byteOffset);
+		}
+
+		_readElement(pAccessor, jsonAccessor);
+		_accessors.push_back(pAccessor);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readSamplers(const json& document)
+{
+	auto itSamplers = document.find("samplers");
+	if (itSamplers == document.end()) {
+		return true;
+	}
+
+	for (auto it = itSamplers->begin(); it != itSamplers->end(); ++it) {
+		const json& jsonSampler = *it;
+
+		auto pSampler = _pAsset->createSampler();
+		pSampler->setName(_name(jsonSampler));
+
+		pSampler->setFilter(
+			(GLTFMagFilter::enum_type)_value<int>(jsonSampler, "magFilter", pSampler->magFilter()),
+			(GLTFMinFilter::enum_type)_value<int>(jsonSampler, "minFilter", pSampler->minFilter()));
+		pSampler->setWrapMode(
+			(GLTFWrapMode::enum_type)_value<int>(jsonSampler, "wrapS", GLTFWrapMode::REPEAT),
+			(GLTFWrapMode::enum_type)_value<int>(jsonSampler, "wrapT", GLTFWrapMode::REPEAT));
+
+		_readElement(pSampler, jsonSampler);
+		_samplers.push_back(pSampler);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readImages(const json& document)
+{
+	auto itImages = document.find("images");
+	if (itImages == document.end()) {
+		return true;
+	}
+
+	for (auto it = itImages->begin(); it != itImages->end(); ++it) {
+		const json& jsonImage = *it;
+		GLTFImage* pImage = nullptr;
+
+		auto itView = jsonImage.find("bufferView");
+		if (itView != jsonImage.end()) {
+			auto pBufferView = _lookup(_bufferViews, *itView, "bufferView");
+			if (!pBufferView) {
+				return false;
+			}
+
+			string mimeType = _value<string>(jsonImage, "mimeType", string{});
+			pImage = _pAsset->createImage(pBufferView, mimeType == "image/png"
+				? GLTFMimeType::IMAGE_PNG : GLTFMimeType::IMAGE_JPEG);
+		}
+		else {
+			pImage = _pAsset->createImage(_value<string>(jsonImage, "uri", string{}));
+		}
+
+		pImage->setName(_name(jsonImage));
+		_readElement(pImage, jsonImage);
+		_images.push_back(pImage);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readTextures(const json& document)
+{
+	auto itTextures = document.find("textures");
+	if (itTextures == document.end()) {
+		return true;
+	}
+
+	for (auto it = itTextures->begin(); it != itTextures->end(); ++it) {
+		const json& jsonTexture = *it;
+
+		GLTFImage* pImage = nullptr;
+		GLTFSampler* pSampler = nullptr;
+
+		if (jsonTexture.count("source")) {
+			pImage = _lookup(_images, jsonTexture["source"], "image");
+			if (!pImage) {
+				return false;
+			}
+		}
+		if (jsonTexture.count("sampler")) {
+			pSampler = _lookup(_samplers, jsonTexture["sampler"], "sampler");
+			if (!pSampler) {
+				return false;
+			}
+		}
+
+		auto pTexture = _pAsset->createTexture(pImage, pSampler);
+		pTexture->setName(_name(jsonTexture));
+		_readElement(pTexture, jsonTexture);
+		_textures.push_back(pTexture);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readMaterials(const json& document)
+{
+	auto itMaterials = document.find("materials");
+	if (itMaterials == document.end()) {
+		return true;
+	}
+
+	GLTFTexture* pTexture;
+	size_t texCoord;
+
+	for (auto it = itMaterials->begin(); it != itMaterials->end(); ++it) {
+		const json& jsonMaterial = *it;
+		auto pMaterial = _pAsset->createMaterial(_name(jsonMaterial));
+
+		auto itPbr = jsonMaterial.find("pbrMetallicRoughness");
+		if (itPbr != jsonMaterial.end()) {
+			const json& jsonPbr = *itPbr;
+			GLTFPBRMetallicRoughness pbr;
+
+			if (jsonPbr.count("baseColorFactor")) {
+				auto factor = jsonPbr["baseColorFactor"].get<vector<float>>();
+				if (factor.size() != 4) {
+					return _fail("invalid baseColorFactor");
+				}
+				pbr.setBaseColorFactor(Vector4f(factor.data()));
+			}
+			if (jsonPbr.count("baseColorTexture")) {
+				if (!_readTextureInfo(jsonPbr["baseColorTexture"], pTexture, texCoord)) {
+					return false;
+				}
+				pbr.setBaseColorTexture(pTexture, texCoord);
+				_readElement(&pbr.baseColorTexture(), jsonPbr["baseColorTexture"]);
+			}
+			if (jsonPbr.count("metallicRoughnessTexture")) {
+				if (!_readTextureInfo(jsonPbr["metallicRoughnessTexture"], pTexture, texCoord)) {
+					return false;
+				}
+				pbr.setMetallicRoughnessTexture(pTexture, texCoord);
+				_readElement(&pbr.metallicRoughnessTexture(), jsonPbr["metallicRoughnessTexture"]);
+			}
+
+			pbr.setMetallicFactor(_value<float>(jsonPbr, "metallicFactor", 1.0f));
+			pbr.setRoughnessFactor(_value<float>(jsonPbr, "roughnessFactor", 1.0f));
+
+			_readElement(&pbr, jsonPbr);
+			pMaterial->setPBRMetallicRoughness(pbr);
+		}
+
+		if (jsonMaterial.count("normalTexture")) {
+			const json& jsonInfo = jsonMaterial["normalTexture"];
+			if (!_readTextureInfo(jsonInfo, pTexture, texCoord)) {
+				return false;
+			}
+			pMaterial->setNormalTexture(pTexture, texCoord, _value<float>(jsonInfo, "scale", 1.0f));
+			_readElement(&pMaterial->normalTexture(), jsonInfo);
+		}
+		if (jsonMaterial.count("occlusionTexture")) {
+			const json& jsonInfo = jsonMaterial["occlusionTexture"];
+			if (!_readTextureInfo(jsonInfo, pTexture, texCoord)) {
+				return false;
+			}
+			pMaterial->setOcclusionTexture(pTexture, texCoord, _value<float>(jsonInfo, "strength", 1.0f));
+			_readElement(&pMaterial->occlusionTexture(), jsonInfo);
+		}
+		if (jsonMaterial.count("emissiveTexture")) {
+			const json& jsonInfo = jsonMaterial["emissiveTexture"];
+			if (!_readTextureInfo(jsonInfo, pTexture, texCoord)) {
+				return false;
+			}
+			pMaterial->setEmissiveTexture(pTexture, texCoord);
+			_readElement(&pMaterial->emissiveTexture(), jsonInfo);
+		}
+		if (jsonMaterial.count("emissiveFactor")) {
+			auto factor = jsonMaterial["emissiveFactor"].get<vector<float>>();
+			if (factor.size() != 3) {
+				return _fail("invalid emissiveFactor");
+			}
+			pMaterial->setEmissiveFactor(Vector3f(factor.data()));
+		}
+
+		string alphaMode = _value<string>(jsonMaterial, "alphaMode", "OPAQUE");
+		pMaterial->setAlphaMode(alphaMode == "MASK" ? GLTFAlphaMode::MASK
+			: (alphaMode == "BLEND" ? GLTFAlphaMode::BLEND : GLTFAlphaMode::OPAQUE));
+		pMaterial->setAlphaCutoff(_value<float>(jsonMaterial, "alphaCutoff", 0.5f));
+		pMaterial->setDoubleSided(_value<bool>(jsonMaterial, "doubleSided", false));
+
+		_readElement(pMaterial, jsonMaterial);
+		_materials.push_back(pMaterial);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readCameras(const json& document)
+{
+	auto itCameras = document.find("cameras");
+	if (itCameras == document.end()) {
+		return true;
+	}
+
+	for (auto it = itCameras->begin(); it != itCameras->end(); ++it) {
+		const json& jsonCamera = *it;
+		string type = jsonCamera.at("type").get<string>();
+		GLTFCamera* pCamera = nullptr;
+
+		if (type == "perspective") {
+			const json& jsonPersp = jsonCamera.at("perspective");
+			auto pPersp = _pAsset->createPerspectiveCamera(_name(jsonCamera));
+			pPersp->setPerspective(_value<float>(jsonPersp, "aspectRatio", pPersp->aspect()),
+				jsonPersp.at("yfov").get<float>());
+			pPersp->setZRange(_value<float>(jsonPersp, "zfar", pPersp->zfar()),
+				jsonPersp.at("znear").get<float>());
+			pCamera = pPersp;
+		}
+		else if (type == "orthographic") {
+			const json& jsonOrtho = jsonCamera.at("orthographic");
+			auto pOrtho = _pAsset->createOrthographicCamera(_name(jsonCamera));
+			pOrtho->setOrthographic(jsonOrtho.at("xmag").get<float>(), jsonOrtho.at("ymag").get<float>());
+			pOrtho->setZRange(jsonOrtho.at("zfar").get<float>(), jsonOrtho.at("znear").get<float>());
+			pCamera = pOrtho;
+		}
+		else {
+			return _fail("invalid camera type: " + type);
+		}
+
+		_readElement(pCamera, jsonCamera);
+		_cameras.push_back(pCamera);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readMeshes(const json& document)
+{
+	auto itMeshes = document.find("meshes");
+	if (itMeshes == document.end()) {
+		return true;
+	}
+
+	for (auto it = itMeshes->begin(); it != itMeshes->end(); ++it) {
+		const json& jsonMesh = *it;
+		auto pMesh = _pAsset->createMesh(_name(jsonMesh));
+
+		const json& jsonPrimitives = jsonMesh.at("primitives");
+		for (auto itPrim = jsonPrimitives.begin(); itPrim != jsonPrimitives.end(); ++itPrim) {
+			if (!_readPrimitive(pMesh, *itPrim)) {
+				return false;
+			}
+		}
+
+		if (jsonMesh.count("weights")) {
+			auto weights = jsonMesh["weights"].get<vector<float>>();
+			for (auto weight : weights) {
+				pMesh->addWeight(weight);
+			}
+		}
+
+		_readElement(pMesh, jsonMesh);
+		_meshes.push_back(pMesh);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readNodes(const json& document)
+{
+	auto itNodes = document.find("nodes");
+	if (itNodes == document.end()) {
+		return true;
+	}
+
+	// first pass: create nodes, children may be referenced before they are defined
+	for (auto it = itNodes->begin(); it != itNodes->end(); ++it) {
+		const json& jsonNode = *it;
+		string name = _name(jsonNode);
+		GLTFNode* pNode = nullptr;
+
+		if (jsonNode.count("skin")) {
+			return _fail("node skins are not supported");
+		}
+		if (jsonNode.count("weights")) {
+			return _fail("node morph weights are not supported");
+		}
+		if (jsonNode.count("mesh") && jsonNode.count("camera")) {
+			return _fail("nodes with both mesh and camera are not supported");
+		}
+
+		if (jsonNode.count("mesh")) {
+			auto pMesh = _lookup(_meshes, jsonNode["mesh"], "mesh");
+			if (!pMesh) {
+				return false;
+			}
+			pNode = _pAsset->createMeshNode(pMesh, name);
+		}
+		else if (jsonNode.count("camera")) {
+			auto pCamera = _lookup(_cameras, jsonNode["camera"], "camera");
+			if (!pCamera) {
+				return false;
+			}
+			pNode = _pAsset->createCameraNode(pCamera, name);
+		}
+		else {
+			pNode = _pAsset->createNode(name);
+		}
+
+		if (jsonNode.count("matrix")) {
+			auto values = jsonNode["matrix"].get<vector<float>>();
+			if (values.size() != 16) {
+				return _fail("invalid node matrix");
+			}
+			pNode->setMatrix(Matrix4f(values.data(), Matrix4f::ColumnMajor));
+		}
+		if (jsonNode.count("translation")) {
+			auto values = jsonNode["translation"].get<vector<float>>();
+			if (values.size() != 3) {
+				return _fail("invalid node translation");
+			}
+			pNode->setTranslation(Vector3f(values.data()));
+		}
+		if (jsonNode.count("rotation")) {
+			auto values = jsonNode["rotation"].get<vector<float>>();
+			if (values.size() != 4) {
+				return _fail("invalid node rotation");
+			}
+			pNode->setRotation(Quaternion4f(values[0], values[1], values[2], values[3]));
+		}
+		if (jsonNode.count("scale")) {
+			auto values = jsonNode["scale"].get<vector<float>>();
+			if (values.size() != 3) {
+				return _fail("invalid node scale");
+			}
+			pNode->setScale(Vector3f(values.data()));
+		}
+
+		_readElement(pNode, jsonNode);
+		_nodes.push_back(pNode);
+	}
+
+	// second pass: hierarchy, nodes must form a forest
+	vector<char> hasParent(_nodes.size(), 0);
+	vector<vector<size_t>> children(_nodes.size());
+
+	for (size_t i = 0; i < _nodes.size(); ++i) {
+		const json& jsonNode = (*itNodes)[i];
+		auto itChildren = jsonNode.find("children");
+		if (itChildren == jsonNode.end()) {
+			continue;
+		}
+
+		for (auto it = itChildren->begin(); it != itChildren->end(); ++it) {
+			auto pChild = _lookup(_nodes, *it, "node");
+			if (!pChild) {
+				return false;
+			}
+
+			size_t childIndex = it->get<size_t>();
+			if (hasParent[childIndex]) {
+				return _fail("node has more than one parent");
+			}
+
+			hasParent[childIndex] = 1;
+			children[i].push_back(childIndex);
+			_nodes[i]->addChild(pChild);
+		}
+	}
+
+	// with at most one parent per node, nodes not reachable from a root are part of a cycle
+	vector<size_t> stack;
+	size_t reachableCount = 0;
+
+	for (size_t i = 0; i < _nodes.size(); ++i) {
+		if (!hasParent[i]) {
+			stack.push_back(i);
+		}
+	}
+
+	while (!stack.empty()) {
+		size_t index = stack.back();
+		stack.pop_back();
+		reachableCount++;
+		stack.insert(stack.end(), children[index].begin(), children[index].end());
+	}
+
+	if (reachableCount != _nodes.size()) {
+		return _fail("node hierarchy contains a cycle");
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readScenes(const json& document)
+{
+	auto itScenes = document.find("scenes");
+	if (itScenes == document.end()) {
+		return true;
+	}
+
+	for (auto it = itScenes->begin(); it != itScenes->end(); ++it) {
+		const json& jsonScene = *it;
+		auto pScene = _pAsset->createScene(_name(jsonScene));
+
+		auto itNodes = jsonScene.find("nodes");
+		if (itNodes != jsonScene.end()) {
+			for (auto itNode = itNodes->begin(); itNode != itNodes->end(); ++itNode) {
+				auto pNode = _lookup(_nodes, *itNode, "node");
+				if (!pNode) {
+					return false;
+				}
+				pScene->addNode(pNode);
+			}
+		}
+
+		_readElement(pScene, jsonScene);
+		_scenes.push_back(pScene);
+	}
+
+	return true;
+}
+
+GLTFAccessor* GLTFReader::_createAccessor(GLTFAccessorComponent component,
+	GLTFAccessorType type, const json& jsonAccessor)
+{
+	switch (component) {
+	case GLTFAccessorComponent::BYTE: return _createAccessorT<int8_t>(type, jsonAccessor);
+	case GLTFAccessorComponent::UNSIGNED_BYTE: return _createAccessorT<uint8_t>(type, jsonAccessor);
+	case GLTFAccessorComponent::SHORT: return _createAccessorT<int16_t>(type, jsonAccessor);
+	case GLTFAccessorComponent::UNSIGNED_SHORT: return _createAccessorT<uint16_t>(type, jsonAccessor);
+	case GLTFAccessorComponent::INT: return _createAccessorT<int32_t>(type, jsonAccessor);
+	case GLTFAccessorComponent::UNSIGNED_INT: return _createAccessorT<uint32_t>(type, jsonAccessor);
+	case GLTFAccessorComponent::FLOAT: return _createAccessorT<float>(type, jsonAccessor);
+	default: return nullptr;
+	}
+}
+
+template<typename T>
+GLTFAccessor* GLTFReader::_createAccessorT(GLTFAccessorType type, const json& jsonAccessor)
+{
+	string name = _name(jsonAccessor);
+	auto pAccessor = _pAsset->createAccessor<T>(type, name);
+
+	if (jsonAccessor.count("min")) {
+		pAccessor->min() = jsonAccessor["min"].get<vector<T>>();
+	}
+	if (jsonAccessor.count("max")) {
+		pAccessor->max() = jsonAccessor["max"].get<vector<T>>();
+	}
+
+	return pAccessor;
+}
+
+bool GLTFReader::_readPrimitive(GLTFMesh* pMesh, const json& jsonPrimitive)
+{
+	auto mode = (GLTFPrimitiveMode::enum_type)_value<int>(jsonPrimitive, "mode", GLTFPrimitiveMode::TRIANGLES);
+	GLTFPrimitive& primitive = pMesh->createPrimitive(mode);
+	GLTFAttributeType type;
+
+	if (jsonPrimitive.count("material")) {
+		auto pMaterial = _lookup(_materials, jsonPrimitive["material"], "material");
+		if (!pMaterial) {
+			return false;
+		}
+		primitive.setMaterial(pMaterial);
+	}
+	if (jsonPrimitive.count("indices")) {
+		auto pAccessor = _lookup(_accessors, jsonPrimitive["indices"], "accessor");
+		if (!pAccessor) {
+			return false;
+		}
+		primitive.setIndices(pAccessor);
+	}
+
+	const json& jsonAttributes = jsonPrimitive.at("attributes");
+	for (auto it = jsonAttributes.begin(); it != jsonAttributes.end(); ++it) {
+		if (!_findAttributeType(it.key(), type)) {
+			return _fail("unsupported attribute: " + it.key());
+		}
+		auto pAccessor = _lookup(_accessors, it.value(), "accessor");
+		if (!pAccessor) {
+			return false;
+		}
+		primitive.addAttribute(type, pAccessor);
+	}
+
+	auto itTargets = jsonPrimitive.find("targets");
+	if (itTargets != jsonPrimitive.end()) {
+		for (size_t i = 0; i < itTargets->size(); ++i) {
+			const json& jsonTarget = (*itTargets)[i];
+			for (auto it = jsonTarget.begin(); it != jsonTarget.end(); ++it) {
+				if (!_findAttributeType(it.key(), type)) {
+					return _fail("unsupported target attribute: " + it.key());
+				}
+				auto pAccessor = _lookup(_accessors, it.value(), "accessor");
+				if (!pAccessor) {
+					return false;
+				}
+				primitive.addTargetAttribute(i, type, pAccessor);
+			}
+		}
+	}
+
+	// Draco references a buffer view, which must be re-pointed to the loaded element
+	auto itExtensions = jsonPrimitive.find("extensions");
+	if (itExtensions != jsonPrimitive.end() && itExtensions->count("KHR_draco_mesh_compression")) {
+		const json& jsonDraco = (*itExtensions)["KHR_draco_mesh_compression"];
+		auto pBufferView = _lookup(_bufferViews, jsonDraco.at("bufferView"), "bufferView");
+		if (!pBufferView) {
+			return false;
+		}
+
+		auto pDraco = _pAsset->createExtension<GLTFDracoExtension>();
+		pDraco->setEncodedBufferView(pBufferView);
+
+		auto itAttributes = jsonDraco.find("attributes");
+		if (itAttributes != jsonDraco.end()) {
+			for (auto it = itAttributes->begin(); it != itAttributes->end(); ++it) {
+				if (_findAttributeType(it.key(), type)) {
+					pDraco->addAttribute(type, it.value().get<int>());
+				}
+			}
+		}
+
+		primitive.addExtension(pDraco);
+
+		json jsonCopy = jsonPrimitive;
+		jsonCopy["extensions"].erase("KHR_draco_mesh_compression");
+		_readElement(&primitive, jsonCopy);
+	}
+	else {
+		_readElement(&primitive, jsonPrimitive);
+	}
+
+	return true;
+}
+
+bool GLTFReader::_readTextureInfo(const json& jsonInfo, GLTFTexture*& pTexture, size_t& texCoord)
+{
+	pTexture = _lookup(_textures, jsonInfo.at("index"), "texture");
+	texCoord = _value<size_t>(jsonInfo, "texCoord", 0);
+
+	return pTexture != nullptr;
+}
+
+void GLTFReader::_readElement(GLTFElement* pElement, const json& jsonElement)
+{
+	auto itExtensions = jsonElement.find("extensions");
+	if (itExtensions != jsonElement.end()) {
+		for (auto it = itExtensions->begin(); it != itExtensions->end(); ++it) {
+			pElement->addExtension(_pAsset->createExtension<GLTFGenericExtension>(it.key(), it.value()));
+		}
+	}
+
+	auto itExtras = jsonElement.find("extras");
+	if (itExtras != jsonElement.end()) {
+		pElement->setExtras(*itExtras);
+	}
+}
+
+template<typename T>
+T* GLTFReader::_lookup(const vector<T*>& elements, const json& jsonIndex, const char* pWhat)
+{
+	size_t index = jsonIndex.get<size_t>();
+	if (index >= elements.size()) {
+		_fail(string("invalid ") + pWhat + " index: " + std::to_string(index));
+		return nullptr;
+	}
+
+	return elements[index];
+}
+
+bool GLTFReader::_fail(const string& message)
+{
+	_error = message;
+	return false;
+}
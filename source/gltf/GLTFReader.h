@@ -0,0 +1,118 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_READER_H
+#define _FLOWLIBS_GLTF_READER_H
+
+#include "library.h"
+#include "GLTFConstants.h"
+
+#include "../core/json.h"
+
+#include <string>
+#include <vector>
+#include <memory>
+
+
+namespace flow
+{
+	class GLTFAsset;
+	class GLTFElement;
+	class GLTFScene;
+	class GLTFNode;
+	class GLTFCamera;
+	class GLTFMesh;
+	class GLTFBuffer;
+	class GLTFBufferView;
+	class GLTFAccessor;
+	class GLTFMaterial;
+	class GLTFTexture;
+	class GLTFImage;
+	class GLTFSampler;
+	class MappedFile;
+
+	/// Populates a GLTFAsset from a parsed glTF 2.0 JSON document. Elements are appended
+	/// to the asset; document indices are resolved against the newly created elements.
+	/// Buffers with an external uri are resolved against the base path and mapped lazily,
+	/// on first access to their data. Embedded data uris are not supported.
+	/// Content the asset can't represent is rejected rather than dropped, read() fails for
+	/// skins, animations, sparse accessors, node morph weights, nodes with both mesh and
+	/// camera, and attributes without a GLTFAttributeType. Elements created before a
+	/// failure remain in the asset, GLTFAsset removes them again when loading fails.
+	/// Extensions without a dedicated implementation are preserved as GLTFGenericExtension.
+	/// EXT_meshopt_compression fallback buffers without uri are created as fallback buffers
+	/// without data; their views can't be read until decoded.
+	class F_GLTF_EXPORT GLTFReader
+	{
+	public:
+		GLTFReader(GLTFAsset* pAsset);
+		virtual ~GLTFReader() { }
+
+		/// Sets the directory relative uris are resolved against, including the trailing separator.
+		void setBasePath(const std::string& basePath);
+		/// Sets the mapped file region backing the buffer without uri (GLB binary chunk).
+		void setBinaryChunk(std::shared_ptr<MappedFile> pFile, size_t byteOffset, size_t byteLength);
+
+		/// Reads the given document into the asset. Returns false on error, see error().
+		bool read(const json& document);
+
+		/// Returns a description of the last error.
+		const std::string& error() const { return _error; }
+
+	private:
+		bool _readAssetInfo(const json& document);
+		bool _readBuffers(const json& document);
+		bool _readBufferViews(const json& document);
+		bool _readAccessors(const json& document);
+		bool _readSamplers(const json& document);
+		bool _readImages(const json& document);
+		bool _readTextures(const json& document);
+		bool _readMaterials(const json& document);
+		bool _readCameras(const json& document);
+		bool _readMeshes(const json& document);
+		bool _readNodes(const json& document);
+		bool _readScenes(const json& document);
+
+		GLTFAccessor* _createAccessor(GLTFAccessorComponent component,
+			GLTFAccessorType type, const json& jsonAccessor);
+
+		template<typename T>
+		GLTFAccessor* _createAccessorT(GLTFAccessorType type, const json& jsonAccessor);
+
+		bool _readPrimitive(GLTFMesh* pMesh, const json& jsonPrimitive);
+		bool _readTextureInfo(const json& jsonInfo, GLTFTexture*& pTexture, size_t& texCoord);
+		void _readElement(GLTFElement* pElement, const json& jsonElement);
+
+		template<typename T>
+		T* _lookup(const std::vector<T*>& elements, const json& jsonIndex, const char* pWhat);
+
+		bool _fail(const std::string& message);
+
+		GLTFAsset* _pAsset;
+		std::string _basePath;
+
+		std::shared_ptr<MappedFile> _pBinaryFile;
+		size_t _binaryOffset;
+		size_t _binaryLength;
+
+		std::vector<GLTFScene*> _scenes;
+		std::vector<GLTFNode*> _nodes;
+		std::vector<GLTFCamera*> _cameras;
+		std::vector<GLTFMesh*> _meshes;
+		std::vector<GLTFBuffer*> _buffers;
+		std::vector<GLTFBufferView*> _bufferViews;
+		std::vector<GLTFAccessor*> _accessors;
+		std::vector<GLTFMaterial*> _materials;
+		std::vector<GLTFTexture*> _textures;
+		std::vector<GLTFImage*> _images;
+		std::vector<GLTFSampler*> _samplers;
+
+		std::string _error;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_READER_H
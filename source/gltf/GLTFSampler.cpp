@@ -7,6 +7,8 @@
 
 #include "GLTFSampler.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -32,14 +34,12 @@ void GLTFSampler::setWrapMode(GLTFWrapMode wrapS, GLTFWrapMode wrapT)
 	_wrapT = wrapT;
 }
 
-json GLTFSampler::toJSON() const
+void GLTFSampler::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
-
-	result["magFilter"] = (int)_magFilter;
-	result["minFilter"] = (int)_minFilter;
-	result["wrapS"] = (int)_wrapS;
-	result["wrapT"] = (int)_wrapT;
+	GLTFMainElement::_writeProperties(writer, context);
 
-	return result;
+	writer.member("magFilter", (int)_magFilter);
+	writer.member("minFilter", (int)_minFilter);
+	writer.member("wrapS", (int)_wrapS);
+	writer.member("wrapT", (int)_wrapT);
 }
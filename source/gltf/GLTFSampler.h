@@ -34,7 +34,8 @@ namespace flow
 		GLTFWrapMode wrapS() const { return _wrapS; }
 		GLTFWrapMode wrapT() const { return _wrapT; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		GLTFMagFilter _magFilter;
@@ -8,6 +8,8 @@
 #include "GLTFNode.h"
 #include "GLTFScene.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -26,17 +28,15 @@ void GLTFScene::addNode(const GLTFNode* pNode)
 	_nodes.push_back(pNode);
 }
 
-json GLTFScene::toJSON() const
+void GLTFScene::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
+	GLTFMainElement::_writeProperties(writer, context);
 
 	if (!_nodes.empty()) {
-		auto nodeArray = json::array();
+		writer.key("nodes").beginArray();
 		for (auto it = _nodes.begin(); it != _nodes.end(); ++it) {
-			nodeArray.push_back((*it)->index());
+			writer.value((*it)->index());
 		}
-		result["nodes"] = nodeArray;
+		writer.endArray();
 	}
-
-	return result;
 }
@@ -34,7 +34,8 @@ namespace flow
 
 		const nodeVec_t& nodes() const { return _nodes; }
 
-		virtual json toJSON() const;
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		nodeVec_t _nodes;
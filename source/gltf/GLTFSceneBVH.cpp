@@ -0,0 +1,503 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFSceneBVH.h"
+#include "GLTFSceneEvaluator.h"
+#include "GLTFNode.h"
+
+#include "../core/ThreadPool.h"
+
+#include <cmath>
+#include <algorithm>
+
+using namespace flow;
+using std::vector;
+
+
+namespace
+{
+	/// Cost of traversing a node relative to testing an item.
+	const float _TRAVERSAL_COST = 1.0f;
+	/// Nodes at this depth become leaves, bounds the traversal stack.
+	const size_t _MAX_DEPTH = 64;
+	const size_t _STACK_SIZE = 2 * _MAX_DEPTH;
+
+	float _halfArea(const Range3f& range)
+	{
+		if (!range.isValid()) {
+			return 0.0f;
+		}
+
+		Vector3f size = range.size();
+		return size.x * size.y + size.y * size.z + size.z * size.x;
+	}
+
+	/// Slab test, returns the entry distance or a negative value if the ray misses.
+	float _enterDistance(const Range3f& range, const Vector3f& origin, const Vector3f& invDirection, float maxDistance)
+	{
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+
+		for (size_t i = 0; i < 3; ++i) {
+			float t0 = (range.lowerBound()[i] - origin[i]) * invDirection[i];
+			float t1 = (range.upperBound()[i] - origin[i]) * invDirection[i];
+			tMin = std::max(tMin, std::min(t0, t1));
+			tMax = std::min(tMax, std::max(t0, t1));
+		}
+
+		return tMin <= tMax ? tMin : -1.0f;
+	}
+
+	size_t _binIndex(float centroid, float lower, float scale)
+	{
+		size_t index = size_t((centroid - lower) * scale);
+		return std::min(index, GLTFSceneBVH::BIN_COUNT - 1);
+	}
+}
+
+const size_t GLTFSceneBVH::BIN_COUNT;
+const size_t GLTFSceneBVH::MAX_LEAF_SIZE;
+const size_t GLTFSceneBVH::PARALLEL_THRESHOLD;
+
+GLTFSceneBVH::GLTFSceneBVH() :
+	_nodeCount(0)
+{
+	_bounds.invalidate();
+}
+
+void GLTFSceneBVH::build(const GLTFSceneEvaluator& evaluator)
+{
+	_nodes.clear();
+	_items.clear();
+	_bounds.invalidate();
+
+	// world bounds are cached by the evaluator, which isn't thread-safe
+	for (size_t slot = 0; slot < evaluator.nodeCount(); ++slot) {
+		const Range3f& bounds = evaluator.worldBounds(slot);
+		if (bounds.isValid()) {
+			item_t item = { bounds, evaluator.node(slot) };
+			_items.push_back(item);
+		}
+	}
+
+	size_t itemCount = _items.size();
+	if (itemCount == 0) {
+		return;
+	}
+
+	_centroids.resize(itemCount);
+	_order.resize(itemCount);
+	for (size_t i = 0; i < itemCount; ++i) {
+		_centroids[i] = _items[i].bounds.center();
+		_order[i] = uint32_t(i);
+	}
+
+	// a binary tree has at most 2n - 1 nodes, children are allocated in pairs
+	// from the atomic counter, so node references stay valid during the build
+	_nodes.resize(2 * itemCount - 1);
+	_nodeCount = 1;
+
+	TaskGroup group;
+	_build(0, 0, itemCount, 0, group);
+	group.wait();
+
+	_nodes.resize(_nodeCount);
+	_bounds = _nodes[0].bounds;
+
+	// store items in hierarchy order, so each node covers a contiguous range
+	vector<item_t> items(itemCount);
+	for (size_t i = 0; i < itemCount; ++i) {
+		items[i] = _items[_order[i]];
+	}
+
+	_items.swap(items);
+	vector<Vector3f>().swap(_centroids);
+	vector<uint32_t>().swap(_order);
+}
+
+bool GLTFSceneBVH::raycast(const Vector3f& origin, const Vector3f& direction, hit_t& hit,
+	float maxDistance /* = std::numeric_limits<float>::max() */) const
+{
+	if (_nodes.empty()) {
+		return false;
+	}
+
+	Vector3f invDirection(1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z);
+	hit.pNode = nullptr;
+	hit.distance = maxDistance;
+
+	if (_enterDistance(_nodes[0].bounds, origin, invDirection, maxDistance) < 0.0f) {
+		return false;
+	}
+
+	// nodes on the stack have been entered at a distance within the closest hit so far
+	uint32_t stack[_STACK_SIZE];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const node_t& node = _nodes[stack[--stackSize]];
+
+		if (node.left == 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				float distance = _enterDistance(_items[i].bounds, origin, invDirection, hit.distance);
+				if (distance >= 0.0f && (!hit.pNode || distance < hit.distance)) {
+					hit.pNode = _items[i].pNode;
+					hit.distance = distance;
+				}
+			}
+			continue;
+		}
+
+		float leftDistance = _enterDistance(_nodes[node.left].bounds, origin, invDirection, hit.distance);
+		float rightDistance = _enterDistance(_nodes[node.left + 1].bounds, origin, invDirection, hit.distance);
+
+		// push the farther child first, so the nearer one is visited next
+		bool isLeftNearer = leftDistance >= 0.0f && (rightDistance < 0.0f || leftDistance <= rightDistance);
+		uint32_t nearIndex = isLeftNearer ? node.left : node.left + 1;
+		uint32_t farIndex = isLeftNearer ? node.left + 1 : node.left;
+		float farDistance = isLeftNearer ? rightDistance : leftDistance;
+		float nearDistance = isLeftNearer ? leftDistance : rightDistance;
+
+		if (farDistance >= 0.0f) {
+			stack[stackSize++] = farIndex;
+		}
+		if (nearDistance >= 0.0f) {
+			stack[stackSize++] = nearIndex;
+		}
+	}
+
+	return hit.pNode != nullptr;
+}
+
+void GLTFSceneBVH::queryBox(const Range3f& box, vector<const GLTFNode*>& result) const
+{
+	result.clear();
+
+	if (_nodes.empty() || !_nodes[0].bounds.intersects(box)) {
+		return;
+	}
+
+	uint32_t stack[_STACK_SIZE];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const node_t& node = _nodes[stack[--stackSize]];
+
+		if (box.includes(node.bounds)) {
+			_collect(node, result);
+		}
+		else if (node.left == 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				if (_items[i].bounds.intersects(box)) {
+					result.push_back(_items[i].pNode);
+				}
+			}
+		}
+		else {
+			for (uint32_t child = node.left; child < node.left + 2; ++child) {
+				if (_nodes[child].bounds.intersects(box)) {
+					stack[stackSize++] = child;
+				}
+			}
+		}
+	}
+}
+
+void GLTFSceneBVH::queryFrustum(const Vector4f* pPlanes, size_t planeCount, vector<const GLTFNode*>& result) const
+{
+	result.clear();
+
+	if (_nodes.empty()) {
+		return;
+	}
+
+	// nodes are classified against the planes: outside, intersecting or inside
+	auto classify = [pPlanes, planeCount](const Range3f& bounds) -> int {
+		const Vector3f& lower = bounds.lowerBound();
+		const Vector3f& upper = bounds.upperBound();
+		int result = 1;
+
+		for (size_t i = 0; i < planeCount; ++i) {
+			const Vector4f& plane = pPlanes[i];
+
+			// corners farthest along and against the plane normal
+			float farthest = plane.w
+				+ plane.x * (plane.x >= 0.0f ? upper.x : lower.x)
+				+ plane.y * (plane.y >= 0.0f ? upper.y : lower.y)
+				+ plane.z * (plane.z >= 0.0f ? upper.z : lower.z);
+			if (farthest < 0.0f) {
+				return -1;
+			}
+
+			float nearest = plane.w
+				+ plane.x * (plane.x >= 0.0f ? lower.x : upper.x)
+				+ plane.y * (plane.y >= 0.0f ? lower.y : upper.y)
+				+ plane.z * (plane.z >= 0.0f ? lower.z : upper.z);
+			if (nearest < 0.0f) {
+				result = 0;
+			}
+		}
+
+		return result;
+	};
+
+	uint32_t stack[_STACK_SIZE];
+	size_t stackSize = 0;
+	stack[stackSize++] = 0;
+
+	while (stackSize > 0) {
+		const node_t& node = _nodes[stack[--stackSize]];
+		int classification = classify(node.bounds);
+
+		if (classification < 0) {
+			continue;
+		}
+		if (classification > 0) {
+			_collect(node, result);
+		}
+		else if (node.left == 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				if (classify(_items[i].bounds) >= 0) {
+					result.push_back(_items[i].pNode);
+				}
+			}
+		}
+		else {
+			stack[stackSize++] = node.left;
+			stack[stackSize++] = node.left + 1;
+		}
+	}
+}
+
+void GLTFSceneBVH::frustumPlanes(const Matrix4f& viewProjection, Vector4f* pPlanes)
+{
+	// planes are sums and differences of the last row with the other rows,
+	// clip space depth ranges from -1 to 1
+	const Matrix4f& m = viewProjection;
+
+	for (size_t i = 0; i < 6; ++i) {
+		size_t row = i / 2;
+		float sign = (i % 2 == 0) ? 1.0f : -1.0f;
+
+		Vector4f& plane = pPlanes[i];
+		plane.x = m(3, 0) + sign * m(row, 0);
+		plane.y = m(3, 1) + sign * m(row, 1);
+		plane.z = m(3, 2) + sign * m(row, 2);
+		plane.w = m(3, 3) + sign * m(row, 3);
+
+		float length = std::sqrt(plane.x * plane.x + plane.y * plane.y + plane.z * plane.z);
+		if (length > 0.0f) {
+			plane.x /= length;
+			plane.y /= length;
+			plane.z /= length;
+			plane.w /= length;
+		}
+	}
+}
+
+void GLTFSceneBVH::_build(uint32_t nodeIndex, size_t first, size_t last, size_t depth, TaskGroup& group)
+{
+	node_t& node = _nodes[nodeIndex];
+	node.first = uint32_t(first);
+	node.count = uint32_t(last - first);
+	node.left = 0;
+
+	Range3f centroidBounds;
+	_computeBounds(first, last, node.bounds, centroidBounds);
+
+	size_t count = last - first;
+	if (count <= 1 || depth + 1 >= _MAX_DEPTH) {
+		return;
+	}
+
+	bin_t bins[3 * BIN_COUNT];
+	_binItems(first, last, centroidBounds, bins);
+
+	// sweep the bins of each axis from both sides, the split before bin s
+	// puts bins [0, s) to the left and [s, BIN_COUNT) to the right
+	float bestCost = std::numeric_limits<float>::max();
+	size_t bestAxis = 3;
+	size_t bestSplit = 0;
+
+	for (size_t axis = 0; axis < 3; ++axis) {
+		if (centroidBounds.size()[axis] <= 0.0f) {
+			continue;
+		}
+
+		const bin_t* pAxisBins = bins + axis * BIN_COUNT;
+		float leftCost[BIN_COUNT];
+		Range3f range;
+		range.invalidate();
+		size_t rangeCount = 0;
+
+		for (size_t b = 0; b < BIN_COUNT - 1; ++b) {
+			if (pAxisBins[b].count > 0) {
+				range.uniteWith(pAxisBins[b].bounds);
+				rangeCount += pAxisBins[b].count;
+			}
+			leftCost[b + 1] = rangeCount > 0 ? _halfArea(range) * float(rangeCount) : -1.0f;
+		}
+
+		range.invalidate();
+		rangeCount = 0;
+
+		for (size_t s = BIN_COUNT - 1; s > 0; --s) {
+			if (pAxisBins[s].count > 0) {
+				range.uniteWith(pAxisBins[s].bounds);
+				rangeCount += pAxisBins[s].count;
+			}
+			if (rangeCount == 0 || leftCost[s] < 0.0f) {
+				continue;
+			}
+
+			float cost = leftCost[s] + _halfArea(range) * float(rangeCount);
+			if (cost < bestCost) {
+				bestCost = cost;
+				bestAxis = axis;
+				bestSplit = s;
+			}
+		}
+	}
+
+	float nodeArea = _halfArea(node.bounds);
+	float leafCost = nodeArea * float(count);
+	bool isSplitBetter = bestAxis < 3 && _TRAVERSAL_COST * nodeArea + bestCost < leafCost;
+
+	if (!isSplitBetter && count <= MAX_LEAF_SIZE) {
+		return;
+	}
+
+	size_t mid = first + count / 2;
+
+	if (bestAxis < 3) {
+		float lower = centroidBounds.lowerBound()[bestAxis];
+		float scale = float(BIN_COUNT) / centroidBounds.size()[bestAxis];
+		const Vector3f* pCentroids = _centroids.data();
+		size_t axis = bestAxis;
+		size_t split = bestSplit;
+
+		auto it = std::partition(_order.begin() + first, _order.begin() + last, [=](uint32_t item) {
+			return _binIndex(pCentroids[item][axis], lower, scale) < split;
+		});
+
+		mid = size_t(it - _order.begin());
+	}
+
+	// without a usable split all centroids coincide, any partition is as good
+	if (mid == first || mid == last) {
+		mid = first + count / 2;
+	}
+
+	uint32_t left = _nodeCount.fetch_add(2);
+	node.left = left;
+
+	if (mid - first >= PARALLEL_THRESHOLD) {
+		group.run([this, left, first, mid, depth, &group]() {
+			_build(left, first, mid, depth + 1, group);
+		});
+	}
+	else {
+		_build(left, first, mid, depth + 1, group);
+	}
+
+	_build(left + 1, mid, last, depth + 1, group);
+}
+
+void GLTFSceneBVH::_computeBounds(size_t first, size_t last, Range3f& bounds, Range3f& centroidBounds) const
+{
+	auto computeChunk = [this](size_t begin, size_t end, Range3f& itemBounds, Range3f& centroids) {
+		itemBounds.invalidate();
+		centroids.invalidate();
+
+		for (size_t i = begin; i < end; ++i) {
+			uint32_t item = _order[i];
+			itemBounds.uniteWith(_items[item].bounds);
+			centroids.include(_centroids[item]);
+		}
+	};
+
+	if (last - first < PARALLEL_THRESHOLD) {
+		computeChunk(first, last, bounds, centroidBounds);
+		return;
+	}
+
+	size_t chunkCount = (last - first + PARALLEL_THRESHOLD - 1) / PARALLEL_THRESHOLD;
+	vector<Range3f> chunkBounds(2 * chunkCount);
+
+	ThreadPool::instance()->parallelFor(first, last, PARALLEL_THRESHOLD, [&](size_t begin, size_t end) {
+		size_t chunk = (begin - first) / PARALLEL_THRESHOLD;
+		computeChunk(begin, end, chunkBounds[2 * chunk], chunkBounds[2 * chunk + 1]);
+	});
+
+	bounds = chunkBounds[0];
+	centroidBounds = chunkBounds[1];
+
+	for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+		bounds.uniteWith(chunkBounds[2 * chunk]);
+		centroidBounds.uniteWith(chunkBounds[2 * chunk + 1]);
+	}
+}
+
+void GLTFSceneBVH::_binItems(size_t first, size_t last, const Range3f& centroidBounds, bin_t* pBins) const
+{
+	Vector3f lower = centroidBounds.lowerBound();
+	Vector3f size = centroidBounds.size();
+	float scale[3];
+	for (size_t axis = 0; axis < 3; ++axis) {
+		scale[axis] = size[axis] > 0.0f ? float(BIN_COUNT) / size[axis] : 0.0f;
+	}
+
+	auto binChunk = [&](size_t begin, size_t end, bin_t* pChunkBins) {
+		for (size_t b = 0; b < 3 * BIN_COUNT; ++b) {
+			pChunkBins[b].bounds.invalidate();
+			pChunkBins[b].count = 0;
+		}
+
+		for (size_t i = begin; i < end; ++i) {
+			uint32_t item = _order[i];
+			const Vector3f& centroid = _centroids[item];
+
+			for (size_t axis = 0; axis < 3; ++axis) {
+				bin_t& bin = pChunkBins[axis * BIN_COUNT + _binIndex(centroid[axis], lower[axis], scale[axis])];
+				bin.bounds.uniteWith(_items[item].bounds);
+				bin.count++;
+			}
+		}
+	};
+
+	if (last - first < PARALLEL_THRESHOLD) {
+		binChunk(first, last, pBins);
+		return;
+	}
+
+	size_t chunkCount = (last - first + PARALLEL_THRESHOLD - 1) / PARALLEL_THRESHOLD;
+	vector<bin_t> chunkBins(chunkCount * 3 * BIN_COUNT);
+
+	ThreadPool::instance()->parallelFor(first, last, PARALLEL_THRESHOLD, [&](size_t begin, size_t end) {
+		binChunk(begin, end, chunkBins.data() + (begin - first) / PARALLEL_THRESHOLD * 3 * BIN_COUNT);
+	});
+
+	for (size_t b = 0; b < 3 * BIN_COUNT; ++b) {
+		pBins[b] = chunkBins[b];
+		for (size_t chunk = 1; chunk < chunkCount; ++chunk) {
+			const bin_t& bin = chunkBins[chunk * 3 * BIN_COUNT + b];
+			if (bin.count > 0) {
+				pBins[b].bounds.uniteWith(bin.bounds);
+				pBins[b].count += bin.count;
+			}
+		}
+	}
+}
+
+void GLTFSceneBVH::_collect(const node_t& node, vector<const GLTFNode*>& result) const
+{
+	for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+		result.push_back(_items[i].pNode);
+	}
+}
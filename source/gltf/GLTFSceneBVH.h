@@ -0,0 +1,122 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_SCENEBVH_H
+#define _FLOWLIBS_GLTF_SCENEBVH_H
+
+#include "library.h"
+
+#include "math/Vector3T.h"
+#include "math/Vector4T.h"
+#include "math/Matrix4T.h"
+#include "math/Range3T.h"
+
+#include <cstdint>
+#include <atomic>
+#include <limits>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFNode;
+	class GLTFSceneEvaluator;
+	class TaskGroup;
+
+	/// Bounding volume hierarchy over the world bounds of the mesh nodes of a scene,
+	/// for culling and picking. The hierarchy is built top-down with the surface area
+	/// heuristic, evaluated for a fixed number of bins per axis. Bounds and bins of large
+	/// nodes are computed in parallel, large subtrees are built as parallel tasks.
+	/// Queries test against the world bounds of the nodes, not their triangles.
+	class F_GLTF_EXPORT GLTFSceneBVH
+	{
+	public:
+		/// Number of bins per axis the split cost is evaluated for.
+		static const size_t BIN_COUNT = 16;
+		/// Nodes with more items are always split.
+		static const size_t MAX_LEAF_SIZE = 4;
+		/// Nodes with fewer items are built by the calling thread only.
+		static const size_t PARALLEL_THRESHOLD = 4096;
+
+		/// Node of the hierarchy. Each node covers a contiguous range of items.
+		struct node_t
+		{
+			Range3f bounds;
+			uint32_t first;
+			uint32_t count;
+			/// Index of the first child, the second child follows it. 0 for leaves.
+			uint32_t left;
+		};
+
+		/// Mesh node with its world bounds.
+		struct item_t
+		{
+			Range3f bounds;
+			const GLTFNode* pNode;
+		};
+
+		/// Result of a ray query.
+		struct hit_t
+		{
+			const GLTFNode* pNode;
+			/// Distance along the ray where it enters the node's bounds, in units of the
+			/// direction's length. 0 if the origin is inside the bounds.
+			float distance;
+		};
+
+		GLTFSceneBVH();
+
+		/// Builds the hierarchy over the world bounds of all mesh nodes of the scene
+		/// evaluated by the given evaluator. Must be called again if transforms change.
+		void build(const GLTFSceneEvaluator& evaluator);
+
+		/// Finds the node whose bounds the ray enters first within maxDistance.
+		/// Returns false if the ray hits no node.
+		bool raycast(const Vector3f& origin, const Vector3f& direction, hit_t& hit,
+			float maxDistance = std::numeric_limits<float>::max()) const;
+		/// Collects the nodes whose bounds overlap the given box. The result is cleared first.
+		void queryBox(const Range3f& box, std::vector<const GLTFNode*>& result) const;
+		/// Collects the nodes whose bounds are not entirely outside one of the given planes.
+		/// Planes are given as (normal, distance) with normals pointing inside. The result
+		/// is cleared first.
+		void queryFrustum(const Vector4f* pPlanes, size_t planeCount, std::vector<const GLTFNode*>& result) const;
+
+		/// Extracts the six planes left, right, bottom, top, near, far of the frustum
+		/// of the given view projection matrix, normals pointing inside.
+		static void frustumPlanes(const Matrix4f& viewProjection, Vector4f* pPlanes);
+
+		/// Nodes of the hierarchy, the root node first. Empty if the scene has no mesh nodes.
+		const std::vector<node_t>& nodes() const { return _nodes; }
+		/// Items in hierarchy order.
+		const std::vector<item_t>& items() const { return _items; }
+		/// Union of the world bounds of all mesh nodes, invalid if there are none.
+		const Range3f& bounds() const { return _bounds; }
+
+	private:
+		struct bin_t
+		{
+			Range3f bounds;
+			uint32_t count;
+		};
+
+		void _build(uint32_t nodeIndex, size_t first, size_t last, size_t depth, TaskGroup& group);
+		void _computeBounds(size_t first, size_t last, Range3f& bounds, Range3f& centroidBounds) const;
+		void _binItems(size_t first, size_t last, const Range3f& centroidBounds, bin_t* pBins) const;
+		void _collect(const node_t& node, std::vector<const GLTFNode*>& result) const;
+
+		std::vector<node_t> _nodes;
+		std::vector<item_t> _items;
+		Range3f _bounds;
+
+		/// Build state: item centroids and item order, partitioned in place.
+		std::vector<Vector3f> _centroids;
+		std::vector<uint32_t> _order;
+		std::atomic<uint32_t> _nodeCount;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_SCENEBVH_H
@@ -0,0 +1,501 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFSceneEvaluator.h"
+#include "GLTFScene.h"
+#include "GLTFNode.h"
+#include "GLTFMesh.h"
+#include "GLTFPrimitive.h"
+#include "GLTFAccessorT.h"
+#include "GLTFAccessorView.h"
+
+#include "../core/ThreadPool.h"
+
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#if defined(FLOW_SSE41)
+#  include <smmintrin.h>
+#  define F_EVALUATOR_SSE
+#endif
+
+using namespace flow;
+using std::vector;
+
+
+namespace
+{
+	/// Number of TRS nodes composed per parallel task.
+	const size_t _COMPOSE_GRAIN_SIZE = 2048;
+
+	void _composeScalar(const float* pTx, const float* pTy, const float* pTz,
+		const float* pQx, const float* pQy, const float* pQz, const float* pQw,
+		const float* pSx, const float* pSy, const float* pSz, size_t count, Matrix4f* pResult)
+	{
+		for (size_t i = 0; i < count; ++i) {
+			float x = pQx[i], y = pQy[i], z = pQz[i], w = pQw[i];
+			float sx = pSx[i], sy = pSy[i], sz = pSz[i];
+
+			Matrix4f& m = pResult[i];
+			m[0].set((1.0f - 2.0f * (y * y + z * z)) * sx, 2.0f * (x * y - w * z) * sy, 2.0f * (x * z + w * y) * sz, pTx[i]);
+			m[1].set(2.0f * (x * y + w * z) * sx, (1.0f - 2.0f * (x * x + z * z)) * sy, 2.0f * (y * z - w * x) * sz, pTy[i]);
+			m[2].set(2.0f * (x * z - w * y) * sx, 2.0f * (y * z + w * x) * sy, (1.0f - 2.0f * (x * x + y * y)) * sz, pTz[i]);
+			m[3].set(0.0f, 0.0f, 0.0f, 1.0f);
+		}
+	}
+
+	/// Includes the min and max of a POSITION accessor with components of type T in bounds.
+	/// Returns false if the accessor has another component type or no bounds. The bounds are
+	/// stored as the accessor's values, quantized positions are mapped like GLTFAccessorView.
+	template<typename T>
+	bool _includeAccessorBounds(const GLTFAccessor* pAccessor, Range3f& bounds)
+	{
+		auto pAccessorT = dynamic_cast<const GLTFAccessorT<T>*>(pAccessor);
+		if (!pAccessorT || pAccessorT->min().size() != 3 || pAccessorT->max().size() != 3) {
+			return false;
+		}
+
+		bool normalized = pAccessor->normalized() && std::numeric_limits<T>::is_integer;
+		float min[3], max[3];
+
+		for (size_t i = 0; i < 3; ++i) {
+			min[i] = float(pAccessorT->min()[i]);
+			max[i] = float(pAccessorT->max()[i]);
+
+			// glTF 2.0 normalization, signed values are clamped to -1
+			if (normalized) {
+				min[i] = flow::max(min[i] / float(std::numeric_limits<T>::max()), -1.0f);
+				max[i] = flow::max(max[i] / float(std::numeric_limits<T>::max()), -1.0f);
+			}
+		}
+
+		bounds.include(Vector3f(min));
+		bounds.include(Vector3f(max));
+		return true;
+	}
+}
+
+const size_t GLTFSceneEvaluator::PARALLEL_THRESHOLD;
+
+GLTFSceneEvaluator::GLTFSceneEvaluator() :
+	_pScene(nullptr),
+	_pDirtyNodes(std::make_shared<vector<const GLTFNode*>>())
+{
+}
+
+void GLTFSceneEvaluator::setScene(const GLTFScene* pScene)
+{
+	_pScene = pScene;
+
+	// nodes of a previous scene keep reporting to the old list, which nobody reads
+	_pDirtyNodes = std::make_shared<vector<const GLTFNode*>>();
+
+	_nodes.clear();
+	_parents.clear();
+	_subtreeEnds.clear();
+	_slots.clear();
+	_localBounds.clear();
+	_isLocalBoundsValid.clear();
+
+	if (pScene) {
+		_flatten();
+	}
+
+	size_t nodeCount = _nodes.size();
+	_localMatrices.resize(nodeCount);
+	_worldMatrices.resize(nodeCount);
+	_worldBounds.resize(nodeCount);
+	_isBoundsValid.assign(nodeCount, 0);
+
+	_meshes.resize(nodeCount);
+	for (size_t i = 0; i < nodeCount; ++i) {
+		auto pMeshNode = dynamic_cast<const GLTFMeshNode*>(_nodes[i]);
+		_meshes[i] = pMeshNode ? pMeshNode->mesh() : nullptr;
+
+		// nodes already dirty won't report again
+		_nodes[i]->_pDirtyNodes = _pDirtyNodes;
+		if (_nodes[i]->isTransformDirty()) {
+			_pDirtyNodes->push_back(_nodes[i]);
+		}
+	}
+
+	// subtrees small enough form parallel tasks
+	size_t grainSize = flow::max(PARALLEL_THRESHOLD / 4, nodeCount / (4 * (ThreadPool::instance()->threadCount() + 1)));
+	_isTaskRoot.assign(nodeCount, 0);
+
+	for (size_t i = 0; i < nodeCount; ) {
+		if (_subtreeEnds[i] - i <= grainSize) {
+			_isTaskRoot[i] = 1;
+			i = _subtreeEnds[i];
+		}
+		else {
+			i++;
+		}
+	}
+}
+
+void GLTFSceneEvaluator::evaluate()
+{
+	size_t nodeCount = _nodes.size();
+	_gather(nullptr, nodeCount);
+	_pDirtyNodes->clear();
+	_isBoundsValid.assign(nodeCount, 0);
+
+	size_t trsCount = _trs.slots.size();
+	if (nodeCount < PARALLEL_THRESHOLD) {
+		_compose(0, trsCount);
+		_propagate(0, nodeCount);
+		return;
+	}
+
+	ThreadPool::instance()->parallelFor(0, trsCount, _COMPOSE_GRAIN_SIZE, [this](size_t first, size_t last) {
+		_compose(first, last);
+	});
+
+	TaskGroup group;
+	_schedule(0, nodeCount, group);
+	group.wait();
+}
+
+size_t GLTFSceneEvaluator::update()
+{
+	_dirtySlots.clear();
+	_dirtyRanges.clear();
+
+	for (auto pNode : *_pDirtyNodes) {
+		int32_t i = slot(pNode);
+		F_ASSERT(i >= 0);
+		_dirtySlots.push_back(uint32_t(i));
+	}
+	_pDirtyNodes->clear();
+
+	if (_dirtySlots.empty()) {
+		return 0;
+	}
+
+	// a dirty node invalidates its subtree, nested dirty nodes are covered by the outer range
+	std::sort(_dirtySlots.begin(), _dirtySlots.end());
+	uint32_t rangeEnd = 0;
+
+	for (uint32_t i : _dirtySlots) {
+		if (i >= rangeEnd) {
+			rangeEnd = _subtreeEnds[i];
+			_dirtyRanges.push_back(std::make_pair(i, rangeEnd));
+		}
+	}
+
+	_gather(_dirtySlots.data(), _dirtySlots.size());
+
+	size_t trsCount = _trs.slots.size();
+	if (trsCount < PARALLEL_THRESHOLD) {
+		_compose(0, trsCount);
+	}
+	else {
+		ThreadPool::instance()->parallelFor(0, trsCount, _COMPOSE_GRAIN_SIZE, [this](size_t first, size_t last) {
+			_compose(first, last);
+		});
+	}
+
+	size_t updateCount = 0;
+	for (auto& range : _dirtyRanges) {
+		std::fill(_isBoundsValid.begin() + range.first, _isBoundsValid.begin() + range.second, 0);
+		updateCount += range.second - range.first;
+	}
+
+	if (updateCount < PARALLEL_THRESHOLD) {
+		for (auto& range : _dirtyRanges) {
+			_propagate(range.first, range.second);
+		}
+	}
+	else {
+		TaskGroup group;
+		for (auto& range : _dirtyRanges) {
+			_schedule(range.first, range.second, group);
+		}
+		group.wait();
+	}
+
+	return updateCount;
+}
+
+int32_t GLTFSceneEvaluator::slot(const GLTFNode* pNode) const
+{
+	size_t index = pNode->index();
+	return index < _slots.size() ? _slots[index] : -1;
+}
+
+const Matrix4f& GLTFSceneEvaluator::worldMatrix(const GLTFNode* pNode) const
+{
+	int32_t i = slot(pNode);
+	F_ASSERT(i >= 0);
+	return _worldMatrices[i];
+}
+
+void GLTFSceneEvaluator::composeTRS(const float* pTx, const float* pTy, const float* pTz,
+	const float* pQx, const float* pQy, const float* pQz, const float* pQw,
+	const float* pSx, const float* pSy, const float* pSz, size_t count, Matrix4f* pResult)
+{
+	size_t i = 0;
+
+#ifdef F_EVALUATOR_SSE
+	// one node per lane, the rows of four matrices are obtained by transposing
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 lastRow = _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f);
+
+	for (; i + 4 <= count; i += 4) {
+		__m128 x = _mm_loadu_ps(pQx + i), y = _mm_loadu_ps(pQy + i);
+		__m128 z = _mm_loadu_ps(pQz + i), w = _mm_loadu_ps(pQw + i);
+		__m128 sx = _mm_loadu_ps(pSx + i), sy = _mm_loadu_ps(pSy + i), sz = _mm_loadu_ps(pSz + i);
+
+		__m128 xx = _mm_mul_ps(x, x), yy = _mm_mul_ps(y, y), zz = _mm_mul_ps(z, z);
+		__m128 xy = _mm_mul_ps(x, y), xz = _mm_mul_ps(x, z), yz = _mm_mul_ps(y, z);
+		__m128 wx = _mm_mul_ps(w, x), wy = _mm_mul_ps(w, y), wz = _mm_mul_ps(w, z);
+
+		__m128 r0 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx);
+		__m128 r1 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy);
+		__m128 r2 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz);
+		__m128 r3 = _mm_loadu_ps(pTx + i);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(pResult[i].ptr(), r0);
+		_mm_storeu_ps(pResult[i + 1].ptr(), r1);
+		_mm_storeu_ps(pResult[i + 2].ptr(), r2);
+		_mm_storeu_ps(pResult[i + 3].ptr(), r3);
+
+		r0 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx);
+		r1 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy);
+		r2 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz);
+		r3 = _mm_loadu_ps(pTy + i);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(pResult[i].ptr() + 4, r0);
+		_mm_storeu_ps(pResult[i + 1].ptr() + 4, r1);
+		_mm_storeu_ps(pResult[i + 2].ptr() + 4, r2);
+		_mm_storeu_ps(pResult[i + 3].ptr() + 4, r3);
+
+		r0 = _mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx);
+		r1 = _mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy);
+		r2 = _mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz);
+		r3 = _mm_loadu_ps(pTz + i);
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+		_mm_storeu_ps(pResult[i].ptr() + 8, r0);
+		_mm_storeu_ps(pResult[i + 1].ptr() + 8, r1);
+		_mm_storeu_ps(pResult[i + 2].ptr() + 8, r2);
+		_mm_storeu_ps(pResult[i + 3].ptr() + 8, r3);
+
+		for (size_t k = 0; k < 4; ++k) {
+			_mm_storeu_ps(pResult[i + k].ptr() + 12, lastRow);
+		}
+	}
+#endif
+
+	_composeScalar(pTx + i, pTy + i, pTz + i, pQx + i, pQy + i, pQz + i, pQw + i,
+		pSx + i, pSy + i, pSz + i, count - i, pResult + i);
+}
+
+void GLTFSceneEvaluator::_flatten()
+{
+	// depth-first with an explicit stack, hierarchies may be deep
+	vector<std::pair<const GLTFNode*, int32_t>> stack;
+	const GLTFScene::nodeVec_t& roots = _pScene->nodes();
+	for (auto it = roots.rbegin(); it != roots.rend(); ++it) {
+		stack.push_back(std::make_pair(*it, -1));
+	}
+
+	while (!stack.empty()) {
+		const GLTFNode* pNode = stack.back().first;
+		int32_t parent = stack.back().second;
+		stack.pop_back();
+
+		int32_t slot = int32_t(_nodes.size());
+		_nodes.push_back(pNode);
+		_parents.push_back(parent);
+
+		if (pNode->index() >= _slots.size()) {
+			_slots.resize(pNode->index() + 1, -1);
+		}
+		_slots[pNode->index()] = slot;
+
+		const GLTFNode::nodeVec_t& children = pNode->children();
+		for (auto it = children.rbegin(); it != children.rend(); ++it) {
+			stack.push_back(std::make_pair(*it, slot));
+		}
+	}
+
+	// children follow their parent, so subtree sizes accumulate in reverse order
+	size_t nodeCount = _nodes.size();
+	_subtreeEnds.assign(nodeCount, 1);
+	for (size_t i = nodeCount; i-- > 0; ) {
+		if (_parents[i] >= 0) {
+			_subtreeEnds[_parents[i]] += _subtreeEnds[i];
+		}
+	}
+	for (size_t i = 0; i < nodeCount; ++i) {
+		_subtreeEnds[i] += uint32_t(i);
+	}
+}
+
+void GLTFSceneEvaluator::_gather(const uint32_t* pSlots, size_t count)
+{
+	_trs.slots.clear();
+
+	for (size_t k = 0; k < count; ++k) {
+		size_t i = pSlots ? pSlots[k] : k;
+		const GLTFNode* pNode = _nodes[i];
+		pNode->_setTransformDirty(false);
+
+		if (pNode->matrix()) {
+			_localMatrices[i] = *pNode->matrix();
+		}
+		else {
+			_trs.slots.push_back(uint32_t(i));
+		}
+	}
+
+	size_t trsCount = _trs.slots.size();
+	for (auto pArray : { &_trs.tx, &_trs.ty, &_trs.tz, &_trs.qx, &_trs.qy, &_trs.qz, &_trs.qw, &_trs.sx, &_trs.sy, &_trs.sz }) {
+		pArray->resize(trsCount);
+	}
+
+	// missing components default to the identity transform
+	for (size_t k = 0; k < trsCount; ++k) {
+		const GLTFNode* pNode = _nodes[_trs.slots[k]];
+		const Vector3f* pT = pNode->translation();
+		const Quaternion4f* pR = pNode->rotation();
+		const Vector3f* pS = pNode->scale();
+
+		_trs.tx[k] = pT ? pT->x : 0.0f;
+		_trs.ty[k] = pT ? pT->y : 0.0f;
+		_trs.tz[k] = pT ? pT->z : 0.0f;
+		_trs.qx[k] = pR ? pR->x : 0.0f;
+		_trs.qy[k] = pR ? pR->y : 0.0f;
+		_trs.qz[k] = pR ? pR->z : 0.0f;
+		_trs.qw[k] = pR ? pR->w : 1.0f;
+		_trs.sx[k] = pS ? pS->x : 1.0f;
+		_trs.sy[k] = pS ? pS->y : 1.0f;
+		_trs.sz[k] = pS ? pS->z : 1.0f;
+	}
+}
+
+void GLTFSceneEvaluator::_compose(size_t first, size_t last)
+{
+	// compose into a local batch, then scatter to the slots
+	const size_t batchSize = 256;
+	Matrix4f batch[batchSize];
+
+	for (size_t k = first; k < last; k += batchSize) {
+		size_t count = flow::min(batchSize, last - k);
+		composeTRS(&_trs.tx[k], &_trs.ty[k], &_trs.tz[k], &_trs.qx[k], &_trs.qy[k], &_trs.qz[k], &_trs.qw[k],
+			&_trs.sx[k], &_trs.sy[k], &_trs.sz[k], count, batch);
+
+		for (size_t j = 0; j < count; ++j) {
+			_localMatrices[_trs.slots[k + j]] = batch[j];
+		}
+	}
+}
+
+void GLTFSceneEvaluator::_propagate(size_t first, size_t last)
+{
+	for (size_t i = first; i < last; ++i) {
+		int32_t parent = _parents[i];
+		if (parent < 0) {
+			_worldMatrices[i] = _localMatrices[i];
+		}
+		else {
+			_worldMatrices[i] = _worldMatrices[parent] * _localMatrices[i];
+		}
+	}
+}
+
+void GLTFSceneEvaluator::_schedule(size_t first, size_t last, TaskGroup& group)
+{
+	// slots above the task roots are evaluated first, as they precede them
+	for (size_t i = first; i < last; ) {
+		if (_isTaskRoot[i]) {
+			size_t end = _subtreeEnds[i];
+			group.run([this, i, end]() {
+				_propagate(i, end);
+			});
+			i = end;
+		}
+		else {
+			_propagate(i, i + 1);
+			i++;
+		}
+	}
+}
+
+const Range3f& GLTFSceneEvaluator::worldBounds(size_t slot) const
+{
+	if (_isBoundsValid[slot]) {
+		return _worldBounds[slot];
+	}
+
+	Range3f& bounds = _worldBounds[slot];
+	bounds.invalidate();
+
+	if (_meshes[slot]) {
+		const Range3f& localBounds = _meshBounds(_meshes[slot]);
+		if (localBounds.isValid()) {
+			// transform center and half extent, the extent by the absolute matrix
+			const Matrix4f& m = _worldMatrices[slot];
+			Vector3f center = localBounds.center();
+			Vector3f extent = localBounds.size() * 0.5f;
+			Vector3f worldCenter, worldExtent;
+
+			for (size_t r = 0; r < 3; ++r) {
+				worldCenter[r] = m(r, 0) * center.x + m(r, 1) * center.y + m(r, 2) * center.z + m(r, 3);
+				worldExtent[r] = std::fabs(m(r, 0)) * extent.x + std::fabs(m(r, 1)) * extent.y + std::fabs(m(r, 2)) * extent.z;
+			}
+
+			bounds.set(worldCenter - worldExtent, worldCenter + worldExtent);
+		}
+	}
+
+	_isBoundsValid[slot] = 1;
+	return bounds;
+}
+
+const Range3f& GLTFSceneEvaluator::_meshBounds(const GLTFMesh* pMesh) const
+{
+	size_t index = pMesh->index();
+	if (index >= _localBounds.size()) {
+		_localBounds.resize(index + 1);
+		_isLocalBoundsValid.resize(index + 1, 0);
+	}
+
+	Range3f& bounds = _localBounds[index];
+	if (_isLocalBoundsValid[index]) {
+		return bounds;
+	}
+
+	bounds.invalidate();
+	for (auto& primitive : pMesh->primitives()) {
+		const GLTFAccessor* pAccessor = primitive.attributeAccessor(GLTFAttributeType::POSITION);
+
+		// glTF requires min and max for positions, use them if present
+		if (_includeAccessorBounds<float>(pAccessor, bounds)
+				|| _includeAccessorBounds<int16_t>(pAccessor, bounds)
+				|| _includeAccessorBounds<uint16_t>(pAccessor, bounds)
+				|| _includeAccessorBounds<int8_t>(pAccessor, bounds)
+				|| _includeAccessorBounds<uint8_t>(pAccessor, bounds)) {
+			continue;
+		}
+
+		// otherwise positions are scanned, converted by the accessor view
+		GLTFAccessorView<float, 3> positions(pAccessor);
+		float position[3];
+
+		for (size_t i = 0; positions.isValid() && i < positions.size(); ++i) {
+			positions.get(i, position);
+			bounds.include(Vector3f(position));
+		}
+	}
+
+	_isLocalBoundsValid[index] = 1;
+	return bounds;
+}
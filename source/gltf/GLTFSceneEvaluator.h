@@ -0,0 +1,142 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_SCENEEVALUATOR_H
+#define _FLOWLIBS_GLTF_SCENEEVALUATOR_H
+
+#include "library.h"
+
+#include "math/Matrix4T.h"
+#include "math/Range3T.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFScene;
+	class GLTFNode;
+	class GLTFMesh;
+	class TaskGroup;
+
+	/// Computes world transforms of all nodes of a scene. The node hierarchy is flattened
+	/// into slots in depth-first order, so parents precede their children and each subtree
+	/// occupies a contiguous range of slots. Local transforms are gathered into structure of
+	/// arrays, TRS transforms are composed four at a time with SSE, and world matrices are
+	/// computed in a single linear pass over the parent array. Large scenes are split into
+	/// independent subtrees evaluated in parallel.
+	///
+	/// After the first evaluation, update() recomputes only the subtrees of nodes whose
+	/// transform changed, tracked by GLTFNode::isTransformDirty(). Nodes report their first
+	/// change since the last evaluation to the evaluator tracking them, so update() costs
+	/// nothing for unchanged nodes, independent of the scene size. World bounds of mesh
+	/// nodes are computed on request and cached until the node's world matrix changes.
+	/// A node reports to the evaluator its scene was last set on, so each scene should be
+	/// tracked by a single evaluator.
+	class F_GLTF_EXPORT GLTFSceneEvaluator
+	{
+		F_DISABLE_COPY(GLTFSceneEvaluator);
+
+	public:
+		/// Scenes with fewer nodes are evaluated by the calling thread only.
+		static const size_t PARALLEL_THRESHOLD = 4096;
+
+		GLTFSceneEvaluator();
+
+		/// Flattens the node hierarchy of the given scene and starts tracking changes
+		/// of its nodes. Must be called again if nodes are added to or removed from the scene.
+		void setScene(const GLTFScene* pScene);
+		/// Reads the local transforms of all nodes and computes their world matrices.
+		void evaluate();
+		/// Recomputes the local matrices of nodes with changed transforms and the world
+		/// matrices of their subtrees. Subtrees are processed in parallel if enough nodes
+		/// changed. Returns the number of recomputed world matrices.
+		size_t update();
+
+		/// Number of nodes in the flattened scene.
+		size_t nodeCount() const { return _nodes.size(); }
+		/// Node at the given slot.
+		const GLTFNode* node(size_t slot) const { return _nodes[slot]; }
+		/// Slot of the parent of each slot, -1 for root nodes.
+		const std::vector<int32_t>& parents() const { return _parents; }
+		/// Slot of the given node, or -1 if the node is not part of the scene.
+		int32_t slot(const GLTFNode* pNode) const;
+
+		/// Local matrix of the node at the given slot, valid after evaluate().
+		const Matrix4f& localMatrix(size_t slot) const { return _localMatrices[slot]; }
+		/// World matrix of the node at the given slot, valid after evaluate().
+		const Matrix4f& worldMatrix(size_t slot) const { return _worldMatrices[slot]; }
+		/// World matrix of the given node, which must be part of the scene.
+		const Matrix4f& worldMatrix(const GLTFNode* pNode) const;
+		/// Axis aligned world bounds of the mesh at the given slot, computed on first request
+		/// from the min and max of each primitive's positions, dequantized if necessary. Positions
+		/// without min and max are scanned. Invalid for nodes without mesh.
+		/// Not thread-safe, as results are cached.
+		const Range3f& worldBounds(size_t slot) const;
+
+		/// Composes count matrices translation * rotation * scale from structure of arrays.
+		/// Each array holds count values, rotations are unit quaternions.
+		static void composeTRS(const float* pTx, const float* pTy, const float* pTz,
+			const float* pQx, const float* pQy, const float* pQz, const float* pQw,
+			const float* pSx, const float* pSy, const float* pSz, size_t count, Matrix4f* pResult);
+
+	private:
+		/// Local transforms of TRS nodes, structure of arrays.
+		struct trsArrays_t
+		{
+			std::vector<float> tx, ty, tz;
+			std::vector<float> qx, qy, qz, qw;
+			std::vector<float> sx, sy, sz;
+			/// Slot of each TRS node.
+			std::vector<uint32_t> slots;
+		};
+
+		void _flatten();
+		/// Gathers the local transforms of the given slots, all slots if pSlots is null.
+		void _gather(const uint32_t* pSlots, size_t count);
+		void _compose(size_t first, size_t last);
+		void _propagate(size_t first, size_t last);
+		void _schedule(size_t first, size_t last, TaskGroup& group);
+		const Range3f& _meshBounds(const GLTFMesh* pMesh) const;
+
+		const GLTFScene* _pScene;
+
+		std::vector<const GLTFNode*> _nodes;
+		std::vector<int32_t> _parents;
+		/// One past the last slot of the subtree rooted at each slot.
+		std::vector<uint32_t> _subtreeEnds;
+		/// Slot of each node, indexed by node index.
+		std::vector<int32_t> _slots;
+
+		trsArrays_t _trs;
+		std::vector<Matrix4f> _localMatrices;
+		std::vector<Matrix4f> _worldMatrices;
+
+		/// Roots of subtrees evaluated as parallel tasks, the slots above them
+		/// are evaluated by the calling thread first.
+		std::vector<char> _isTaskRoot;
+
+		/// Mesh of each slot, null for nodes without mesh.
+		std::vector<const GLTFMesh*> _meshes;
+		mutable std::vector<Range3f> _worldBounds;
+		mutable std::vector<char> _isBoundsValid;
+		/// Local bounds of meshes, indexed by mesh index.
+		mutable std::vector<Range3f> _localBounds;
+		mutable std::vector<char> _isLocalBoundsValid;
+
+		/// Nodes changed since the last evaluation, filled by the nodes. Shared with them,
+		/// so neither the nodes nor the evaluator need to outlive the other.
+		std::shared_ptr<std::vector<const GLTFNode*>> _pDirtyNodes;
+		std::vector<uint32_t> _dirtySlots;
+		std::vector<std::pair<uint32_t, uint32_t>> _dirtyRanges;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_SCENEEVALUATOR_H
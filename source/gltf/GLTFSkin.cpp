@@ -7,6 +7,8 @@
 
 #include "GLTFSkin.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -15,8 +17,7 @@ GLTFSkin::GLTFSkin(size_t index, const string& name /* = string{} */) :
 {
 }
 
-json GLTFSkin::toJSON() const
+void GLTFSkin::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
-	return result;
+	GLTFMainElement::_writeProperties(writer, context);
 }
@@ -24,8 +24,7 @@ namespace flow
 		GLTFSkin(size_t index, const std::string& name = std::string{});
 		virtual ~GLTFSkin() { }
 
-	public:
-		virtual json toJSON() const;
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	};
 }
@@ -9,6 +9,8 @@
 #include "GLTFImage.h"
 #include "GLTFSampler.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 using std::string;
 
@@ -26,16 +28,14 @@ void GLTFTexture::setSource(const GLTFImage* pImage, const GLTFSampler* pSampler
 	_pSampler = pSampler;
 }
 
-json GLTFTexture::toJSON() const
+void GLTFTexture::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFMainElement::toJSON();
+	GLTFMainElement::_writeProperties(writer, context);
 
 	if (_pImage) {
-		result["source"] = _pImage->index();
+		writer.member("source", _pImage->index());
 	}
 	if (_pSampler) {
-		result["sampler"] = _pSampler->index();
+		writer.member("sampler", _pSampler->index());
 	}
-
-	return result;
 }
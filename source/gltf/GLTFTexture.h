@@ -32,8 +32,9 @@ namespace flow
 
 		const GLTFImage* image() const { return _pImage; }
 		const GLTFSampler* sampler() const { return _pSampler; }
-		
-		virtual json toJSON() const;
+
+	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
 
 	private:
 		const GLTFImage* _pImage;
@@ -8,6 +8,8 @@
 #include "GLTFTextureInfo.h"
 #include "GLTFTexture.h"
 
+#include "../core/JsonWriter.h"
+
 using namespace flow;
 
 
@@ -23,17 +25,15 @@ void GLTFTextureInfo::set(const GLTFTexture* pTexture, size_t texCoord /* = 0 */
 	_texCoord = texCoord;
 }
 
-json GLTFTextureInfo::toJSON() const
+void GLTFTextureInfo::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFElement::toJSON();
+	GLTFElement::_writeProperties(writer, context);
 
-	result["index"] = _pTexture->index();
+	writer.member("index", _pTexture->index());
 
 	if (_texCoord != 0) {
-		result["texCoord"] = _texCoord;
+		writer.member("texCoord", _texCoord);
 	}
-
-	return result;
 }
 
 GLTFNormalTextureInfo::GLTFNormalTextureInfo(const GLTFTexture* pTexture /* = nullptr */, size_t texCoord /* = 0 */, float scale /* = 1.0f */) :
@@ -49,15 +49,13 @@ void GLTFNormalTextureInfo::set(const GLTFTexture* pTexture, size_t texCoord /*
 	_scale = scale;
 }
 
-json GLTFNormalTextureInfo::toJSON() const
+void GLTFNormalTextureInfo::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFTextureInfo::toJSON();
+	GLTFTextureInfo::_writeProperties(writer, context);
 
 	if (_scale != 1.0f) {
-		result["scale"] = _scale;
+		writer.member("scale", _scale);
 	}
-
-	return result;
 }
 
 GLTFOcclusionTextureInfo::GLTFOcclusionTextureInfo(GLTFTexture* pTexture /* = nullptr */, size_t texCoord /* = 0 */, float strength /* = 1.0f */) :
@@ -73,13 +71,11 @@ void GLTFOcclusionTextureInfo::set(const GLTFTexture* pTexture, size_t texCoord
 	_strength = strength;
 }
 
-json GLTFOcclusionTextureInfo::toJSON() const
+void GLTFOcclusionTextureInfo::_writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const
 {
-	json result = GLTFTextureInfo::toJSON();
+	GLTFTextureInfo::_writeProperties(writer, context);
 
 	if (_strength != 1.0f) {
-		result["strength"] = _strength;
+		writer.member("strength", _strength);
 	}
-
-	return result;
 }
\ No newline at end of file
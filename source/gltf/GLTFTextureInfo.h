@@ -27,9 +27,9 @@ namespace flow
 		const GLTFTexture* texture() const { return _pTexture; }
 		size_t texCoord() const { return _texCoord; }
 
-		virtual json toJSON() const;
-
 	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
+
 		const GLTFTexture* _pTexture;
 		size_t _texCoord;
 	};
@@ -43,9 +43,9 @@ namespace flow
 		void set(const GLTFTexture* pTexture, size_t texCoord = 0, float scale = 1.0f);
 		float scale() const { return _scale; }
 
-		virtual json toJSON() const;
-
 	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
+
 		float _scale;
 	};
 
@@ -58,9 +58,9 @@ namespace flow
 		void set(const GLTFTexture* pTexture, size_t texCoord = 0, float strength = 1.0f);
 		float strength() const { return _strength; }
 
-		virtual json toJSON() const;
-
 	protected:
+		virtual void _writeProperties(JsonWriter& writer, const GLTFWriteContext& context) const;
+
 		float _strength;
 	};
 }
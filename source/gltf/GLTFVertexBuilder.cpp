@@ -0,0 +1,137 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFVertexBuilder.h"
+#include "GLTFBuffer.h"
+#include "GLTFBufferView.h"
+#include "GLTFAccessor.h"
+#include "GLTFPrimitive.h"
+
+#include "../core/Bit.h"
+#include "../core/ThreadPool.h"
+
+#include <cstring>
+
+using namespace flow;
+using std::string;
+
+
+namespace
+{
+	// copies count elements of SIZE bytes between strided source and destination
+	template<size_t SIZE>
+	void _copyStrided(char* pDest, size_t destStride, const char* pSource, size_t sourceStride, size_t count)
+	{
+		for (size_t i = 0; i < count; ++i, pDest += destStride, pSource += sourceStride) {
+			std::memcpy(pDest, pSource, SIZE);
+		}
+	}
+
+	void _copyStrided(char* pDest, size_t destStride, const char* pSource, size_t sourceStride,
+		size_t count, size_t elementByteSize)
+	{
+		// fixed sizes let the compiler replace memcpy with plain loads and stores
+		switch (elementByteSize) {
+		case 4: _copyStrided<4>(pDest, destStride, pSource, sourceStride, count); return;
+		case 6: _copyStrided<6>(pDest, destStride, pSource, sourceStride, count); return;
+		case 8: _copyStrided<8>(pDest, destStride, pSource, sourceStride, count); return;
+		case 12: _copyStrided<12>(pDest, destStride, pSource, sourceStride, count); return;
+		case 16: _copyStrided<16>(pDest, destStride, pSource, sourceStride, count); return;
+		}
+
+		for (size_t i = 0; i < count; ++i, pDest += destStride, pSource += sourceStride) {
+			std::memcpy(pDest, pSource, elementByteSize);
+		}
+	}
+}
+
+const size_t GLTFVertexBuilder::MAX_BYTE_STRIDE;
+const size_t GLTFVertexBuilder::PARALLEL_THRESHOLD;
+
+GLTFVertexBuilder::GLTFVertexBuilder(GLTFAsset* pAsset, size_t vertexCount) :
+	_pAsset(pAsset),
+	_vertexCount(vertexCount),
+	_byteStride(0)
+{
+	F_ASSERT(pAsset);
+}
+
+void GLTFVertexBuilder::addPositions(const float* pData)
+{
+	addStream(GLTFAttributeType::POSITION, GLTFAccessorType::VEC3, pData);
+}
+
+void GLTFVertexBuilder::addNormals(const float* pData)
+{
+	addStream(GLTFAttributeType::NORMAL, GLTFAccessorType::VEC3, pData);
+}
+
+void GLTFVertexBuilder::addTexCoords(const float* pData)
+{
+	addStream(GLTFAttributeType::TEXCOORD_0, GLTFAccessorType::VEC2, pData);
+}
+
+GLTFBufferView* GLTFVertexBuilder::build(GLTFBuffer* pBuffer, GLTFPrimitive* pPrimitive)
+{
+	if (_streams.empty() || _byteStride > MAX_BYTE_STRIDE) {
+		return nullptr;
+	}
+
+	// padding between attributes is zeroed by allocate
+	GLTFBufferView* pBufferView = pBuffer->allocate(_vertexCount * _byteStride, true);
+	pBufferView->setByteStride(_byteStride);
+	pBufferView->setTarget(GLTFBufferViewTarget::ARRAY_BUFFER);
+
+	char* pVertices = pBufferView->data();
+
+	if (_vertexCount < 2 * PARALLEL_THRESHOLD) {
+		_interleave(pVertices, 0, _vertexCount);
+	}
+	else {
+		ThreadPool::instance()->parallelFor(0, _vertexCount, PARALLEL_THRESHOLD, [&](size_t first, size_t last) {
+			_interleave(pVertices, first, last);
+		});
+	}
+
+	for (auto& stream : _streams) {
+		GLTFAccessor* pAccessor = stream.createAccessor(_pAsset, stream.type);
+		pAccessor->setBufferView(pBufferView, stream.byteOffset);
+		pAccessor->setElementCount(_vertexCount);
+		pAccessor->setNormalized(stream.normalized);
+
+		if (stream.attribute == GLTFAttributeType::POSITION) {
+			pAccessor->updateBounds();
+		}
+
+		if (pPrimitive) {
+			pPrimitive->addAttribute(stream.attribute, pAccessor);
+		}
+
+		stream.pAccessor = pAccessor;
+	}
+
+	return pBufferView;
+}
+
+void GLTFVertexBuilder::_addStream(const stream_t& stream)
+{
+	_streams.push_back(stream);
+
+	// attributes start at 4-byte aligned offsets, the stride is a multiple of 4
+	_streams.back().byteOffset = _byteStride;
+	_byteStride += Bit::ceil4(stream.elementByteSize);
+}
+
+void GLTFVertexBuilder::_interleave(char* pVertices, size_t first, size_t last) const
+{
+	// stream by stream: reads are sequential, writes advance by the stride
+	for (auto& stream : _streams) {
+		_copyStrided(pVertices + first * _byteStride + stream.byteOffset, _byteStride,
+			stream.pData + first * stream.sourceStride, stream.sourceStride,
+			last - first, stream.elementByteSize);
+	}
+}
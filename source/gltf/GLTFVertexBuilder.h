@@ -0,0 +1,119 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_VERTEXBUILDER_H
+#define _FLOWLIBS_GLTF_VERTEXBUILDER_H
+
+#include "library.h"
+#include "GLTFConstants.h"
+#include "GLTFAsset.h"
+#include "GLTFAccessorT.h"
+
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFBuffer;
+	class GLTFBufferView;
+	class GLTFAccessor;
+	class GLTFPrimitive;
+
+	/// Builds an interleaved vertex buffer from separate attribute streams. All streams
+	/// are written to a single buffer view with a byte stride, one accessor per stream
+	/// is created and added to a primitive. Each attribute starts at a 4-byte aligned
+	/// offset within the vertex, as required by the glTF specification.
+	class F_GLTF_EXPORT GLTFVertexBuilder
+	{
+	public:
+		/// Maximum vertex stride allowed by the glTF specification.
+		static const size_t MAX_BYTE_STRIDE = 252;
+		/// Minimum number of vertices per task when interleaving in parallel.
+		static const size_t PARALLEL_THRESHOLD = 16384;
+
+		GLTFVertexBuilder(GLTFAsset* pAsset, size_t vertexCount);
+
+		/// Adds a stream with one element of the given type per vertex. Elements are read
+		/// with the given byte stride, or tightly packed if zero. The data is copied in
+		/// build() and must stay valid until then.
+		template<typename T>
+		void addStream(GLTFAttributeType attribute, GLTFAccessorType type,
+			const T* pData, bool normalized = false, size_t byteStride = 0);
+
+		void addPositions(const float* pData);
+		void addNormals(const float* pData);
+		void addTexCoords(const float* pData);
+
+		/// Writes the interleaved vertices to the given buffer and creates the accessors.
+		/// Returns the buffer view, or null if no stream was added or the stride exceeds
+		/// MAX_BYTE_STRIDE. Bounds are computed for the position accessor.
+		GLTFBufferView* build(GLTFBuffer* pBuffer, GLTFPrimitive* pPrimitive);
+
+		/// Returns the distance in bytes between consecutive vertices.
+		size_t byteStride() const { return _byteStride; }
+		size_t vertexCount() const { return _vertexCount; }
+		size_t streamCount() const { return _streams.size(); }
+
+		/// Returns the attribute of the given stream.
+		GLTFAttributeType attribute(size_t index) const { return _streams[index].attribute; }
+		/// Returns the accessor created for the given stream, or null before build().
+		GLTFAccessor* accessor(size_t index) const { return _streams[index].pAccessor; }
+
+	private:
+		typedef GLTFAccessor* (*createFunc_t)(GLTFAsset*, GLTFAccessorType);
+
+		struct stream_t
+		{
+			GLTFAttributeType attribute;
+			GLTFAccessorType type;
+			const char* pData;
+			size_t elementByteSize;
+			size_t sourceStride;
+			size_t byteOffset;
+			bool normalized;
+			createFunc_t createAccessor;
+			GLTFAccessor* pAccessor;
+		};
+
+		template<typename T>
+		static GLTFAccessor* _createAccessor(GLTFAsset* pAsset, GLTFAccessorType type);
+
+		void _addStream(const stream_t& stream);
+		void _interleave(char* pVertices, size_t first, size_t last) const;
+
+		GLTFAsset* _pAsset;
+		size_t _vertexCount;
+		size_t _byteStride;
+		std::vector<stream_t> _streams;
+	};
+
+	template<typename T>
+	void GLTFVertexBuilder::addStream(GLTFAttributeType attribute, GLTFAccessorType type,
+		const T* pData, bool normalized /* = false */, size_t byteStride /* = 0 */)
+	{
+		stream_t stream;
+		stream.attribute = attribute;
+		stream.type = type;
+		stream.pData = (const char*)pData;
+		stream.elementByteSize = type.componentCount() * sizeof(T);
+		stream.sourceStride = byteStride > 0 ? byteStride : stream.elementByteSize;
+		stream.byteOffset = 0;
+		stream.normalized = normalized;
+		stream.createAccessor = &_createAccessor<T>;
+		stream.pAccessor = nullptr;
+
+		_addStream(stream);
+	}
+
+	template<typename T>
+	GLTFAccessor* GLTFVertexBuilder::_createAccessor(GLTFAsset* pAsset, GLTFAccessorType type)
+	{
+		return pAsset->createAccessor<T>(type);
+	}
+}
+
+#endif // _FLOWLIBS_GLTF_VERTEXBUILDER_H
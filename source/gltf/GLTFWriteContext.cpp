@@ -0,0 +1,59 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "GLTFWriteContext.h"
+#include "GLTFBuffer.h"
+
+#include "../core/Bit.h"
+
+using namespace flow;
+using std::vector;
+
+
+GLTFWriteContext::GLTFWriteContext() :
+	_isMergingBuffers(false),
+	_mergedBufferLength(0)
+{
+}
+
+size_t GLTFWriteContext::mergeBuffers(const vector<const GLTFBuffer*>& buffers)
+{
+	// fallback buffers aren't part of the binary chunk, they follow the merged buffer
+	size_t offset = 0;
+	size_t byteLength = 0;
+	size_t fallbackIndex = 1;
+
+	_bindings.clear();
+
+	for (auto pBuffer : buffers) {
+		if (pBuffer->isFallback()) {
+			_bindings[pBuffer] = binding_t{ fallbackIndex++, 0 };
+		}
+		else {
+			_bindings[pBuffer] = binding_t{ 0, offset };
+			// the last buffer doesn't need to be padded
+			byteLength = offset + pBuffer->byteLength();
+			offset += Bit::ceil4(pBuffer->byteLength());
+		}
+	}
+
+	_isMergingBuffers = true;
+	_mergedBufferLength = byteLength;
+	return byteLength;
+}
+
+size_t GLTFWriteContext::bufferIndex(const GLTFBuffer* pBuffer) const
+{
+	auto it = _bindings.find(pBuffer);
+	return it != _bindings.end() ? it->second.index : pBuffer->index();
+}
+
+size_t GLTFWriteContext::bufferOffset(const GLTFBuffer* pBuffer) const
+{
+	auto it = _bindings.find(pBuffer);
+	return it != _bindings.end() ? it->second.offset : 0;
+}
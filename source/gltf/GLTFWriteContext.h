@@ -0,0 +1,57 @@
+/**
+* Flow Libs - GLTF
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_GLTF_WRITECONTEXT_H
+#define _FLOWLIBS_GLTF_WRITECONTEXT_H
+
+#include "library.h"
+
+#include <unordered_map>
+#include <vector>
+
+
+namespace flow
+{
+	class GLTFBuffer;
+
+	/// Output layout of the buffers of an asset while it is written, passed to all
+	/// elements. By default buffers are written at their index, without offset. When
+	/// merged for a GLB binary chunk, all buffers except fallback buffers are written back
+	/// to back as buffer 0, fallback buffers follow. The asset itself isn't modified,
+	/// so an asset can be written by several threads at once.
+	class F_GLTF_EXPORT GLTFWriteContext
+	{
+	public:
+		GLTFWriteContext();
+
+		/// Binds the given buffers to consecutive 4-byte aligned offsets in output buffer 0.
+		/// Returns the length of the merged buffer.
+		size_t mergeBuffers(const std::vector<const GLTFBuffer*>& buffers);
+
+		bool isMergingBuffers() const { return _isMergingBuffers; }
+		/// Length of the merged output buffer, without padding after the last buffer.
+		size_t mergedBufferLength() const { return _mergedBufferLength; }
+
+		/// Index of the given buffer in the written document.
+		size_t bufferIndex(const GLTFBuffer* pBuffer) const;
+		/// Byte offset of the given buffer's data in its output buffer.
+		size_t bufferOffset(const GLTFBuffer* pBuffer) const;
+
+	private:
+		struct binding_t
+		{
+			size_t index;
+			size_t offset;
+		};
+
+		std::unordered_map<const GLTFBuffer*, binding_t> _bindings;
+		bool _isMergingBuffers;
+		size_t _mergedBufferLength;
+	};
+}
+
+#endif // _FLOWLIBS_GLTF_WRITECONTEXT_H
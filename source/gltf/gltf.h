@@ -20,6 +20,17 @@
 #include "GLTFBuffer.h"
 #include "GLTFBufferView.h"
 #include "GLTFAccessorT.h"
+#include "GLTFAccessorView.h"
+#include "GLTFVertexBuilder.h"
+#include "GLTFMeshQuantizer.h"
+#include "GLTFMeshOptimizer.h"
+#include "GLTFMeshletBuilder.h"
+#include "GLTFSceneEvaluator.h"
+#include "GLTFSceneBVH.h"
+#include "GLTFMeshoptEncoder.h"
+#include "GLTFDracoEncoder.h"
+#include "GLTFMeshoptExtension.h"
+#include "GLTFMeshletExtension.h"
 #include "GLTFMaterial.h"
 #include "GLTFTexture.h"
 #include "GLTFImage.h"
@@ -27,5 +38,9 @@
 #include "GLTFSkin.h"
 #include "GLTFAssetInfo.h"
 #include "GLTFAnimation.h"
+#include "GLTFGenericExtension.h"
+#include "GLTFReader.h"
+#include "GLTFWriteContext.h"
+#include "GLBContainer.h"
 
 #endif // _FLOWLIBS_GLTF_H
@@ -13,12 +13,15 @@
 #include "Vector4T.h"
 #include "QuaternionT.h"
 #include "Matrix3T.h"
+#include "Matrix4fSSE.h"
 
 #include "../core/json.h"
 
 #include <stdlib.h>
 #include <string>
+#include <vector>
 #include <math.h>
+#include <limits>
 
 
 namespace flow
@@ -126,8 +129,25 @@ namespace flow
 
 		/// Transpose the matrix.
 		Matrix4T<REAL>& transpose();
-		/// Invert the matrix using LU-decomposition (matrix must be non-singular!)
+		/// Inverts the matrix. Rigid transforms are inverted by transposition, affine transforms
+		/// by inverting the upper left 3x3 block, all other matrices by a full inverse.
+		/// Singular matrices are left unchanged.
 		Matrix4T<REAL>& invert();
+		/// Inverts a rigid transform, i.e. an orthonormal 3x3 block and a translation.
+		/// The result is undefined if the matrix is not rigid.
+		void invertRigid();
+		/// Inverts an affine transform, i.e. a matrix with a last row of (0, 0, 0, 1).
+		/// Returns false and leaves the matrix unchanged if it is singular.
+		bool invertAffine();
+		/// Inverts an arbitrary matrix using cofactor expansion.
+		/// Returns false and leaves the matrix unchanged if it is singular.
+		bool invertGeneral();
+		/// Inverts count matrices one by one, choosing the path for each matrix as invert() does.
+		/// pInverses may be identical to pMatrices. Singular matrices are copied to pInverses
+		/// unchanged. Returns the number of singular matrices, their indices are appended to
+		/// pSingular if given.
+		static size_t invertMany(const Matrix4T<REAL>* pMatrices, Matrix4T<REAL>* pInverses, size_t count,
+			std::vector<size_t>* pSingular = nullptr);
 		/// Homogenizes the matrix by dividing all elements by the last element e[2][2];
 		Matrix4T<REAL>& homogenize();
 
@@ -206,6 +226,10 @@ namespace flow
 		bool isZero() const;
 		/// Returns true if matrix is identity.
 		bool isIdentity() const;
+		/// Returns true if the last row is (0, 0, 0, 1).
+		bool isAffine() const;
+		/// Returns true if the matrix is affine and its upper left 3x3 block is orthonormal.
+		bool isRigid() const;
 		/// Extracts the upper left 3x3 rotation matrix.
 		void extractRotation(OUT Matrix3T<REAL>& rotationMatrix) const;
 		/// Calculates and returns the determinant of the matrix.
@@ -527,40 +551,136 @@ namespace flow
 	template <typename REAL>
 	Matrix4T<REAL>& Matrix4T<REAL>::invert()
 	{
-		// check if matrix is orthogonal
-		// check values of row 4
-		if (m_row[3][0] == REAL(0.0) && m_row[3][1] == REAL(0.0) && m_row[3][2] == REAL(0.0) && m_row[3][3] == REAL(1.0))
-		{
-			// check if the determinant of the upper left 3x3 block is 1 or -1, i.e. if the block is orthogonal.
+		if (isRigid())
+			invertRigid();
+		else if (isAffine())
+			invertAffine();
+		else
+			invertGeneral();
 
-			if (false)
-			{
+		return *this;
+	}
 
-				// if yes, the transpose the block
-				REAL t;
+	template <typename REAL>
+	void Matrix4T<REAL>::invertRigid()
+	{
+		// the inverse rotation is the transpose, the inverse translation is -R^T * t
+		Vector4T<REAL>* a = m_row;
+		REAL tx = a[0][3], ty = a[1][3], tz = a[2][3];
+		REAL t;
 
-				t = m_row[0][1]; m_row[0][1] = m_row[1][0]; m_row[1][0] = t;
-				t = m_row[0][2]; m_row[0][2] = m_row[2][0]; m_row[2][0] = t;
-				t = m_row[1][2]; m_row[1][2] = m_row[2][1]; m_row[2][1] = t;
+		t = a[0][1]; a[0][1] = a[1][0]; a[1][0] = t;
+		t = a[0][2]; a[0][2] = a[2][0]; a[2][0] = t;
+		t = a[1][2]; a[1][2] = a[2][1]; a[2][1] = t;
 
-				m_row[0][3] = -m_row[0][3];
-				m_row[1][3] = -m_row[1][3];
-				m_row[2][3] = -m_row[2][3];
+		a[0][3] = -(a[0][0] * tx + a[0][1] * ty + a[0][2] * tz);
+		a[1][3] = -(a[1][0] * tx + a[1][1] * ty + a[1][2] * tz);
+		a[2][3] = -(a[2][0] * tx + a[2][1] * ty + a[2][2] * tz);
+	}
 
-				return *this;
-			}
-		}
-		else
+	template <typename REAL>
+	bool Matrix4T<REAL>::invertAffine()
+	{
+		Vector4T<REAL>* a = m_row;
+
+		// the columns of the inverse 3x3 block are the cross products of its rows, divided by the determinant
+		Vector3T<REAL> r0(a[0][0], a[0][1], a[0][2]);
+		Vector3T<REAL> r1(a[1][0], a[1][1], a[1][2]);
+		Vector3T<REAL> r2(a[2][0], a[2][1], a[2][2]);
+		Vector3T<REAL> c0 = r1.cross(r2);
+		Vector3T<REAL> c1 = r2.cross(r0);
+		Vector3T<REAL> c2 = r0.cross(r1);
+
+		REAL det = r0.dot(c0);
+		if (det == REAL(0.0))
+			return false;
+
+		REAL f = REAL(1.0) / det;
+		Vector3T<REAL> t = (c0 * a[0][3] + c1 * a[1][3] + c2 * a[2][3]) * -f;
+
+		for (size_t i = 0; i < 3; i++)
+			a[i].set(c0[i] * f, c1[i] * f, c2[i] * f, t[i]);
+
+		return true;
+	}
+
+	template <typename REAL>
+	bool Matrix4T<REAL>::invertGeneral()
+	{
+		const Vector4T<REAL>* a = m_row;
+
+		// 2 by 2 sub-determinants of the upper and lower two rows
+		REAL s0 = a[0][0] * a[1][1] - a[1][0] * a[0][1];
+		REAL s1 = a[0][0] * a[1][2] - a[1][0] * a[0][2];
+		REAL s2 = a[0][0] * a[1][3] - a[1][0] * a[0][3];
+		REAL s3 = a[0][1] * a[1][2] - a[1][1] * a[0][2];
+		REAL s4 = a[0][1] * a[1][3] - a[1][1] * a[0][3];
+		REAL s5 = a[0][2] * a[1][3] - a[1][2] * a[0][3];
+
+		REAL c0 = a[2][0] * a[3][1] - a[3][0] * a[2][1];
+		REAL c1 = a[2][0] * a[3][2] - a[3][0] * a[2][2];
+		REAL c2 = a[2][0] * a[3][3] - a[3][0] * a[2][3];
+		REAL c3 = a[2][1] * a[3][2] - a[3][1] * a[2][2];
+		REAL c4 = a[2][1] * a[3][3] - a[3][1] * a[2][3];
+		REAL c5 = a[2][2] * a[3][3] - a[3][2] * a[2][3];
+
+		REAL det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+		if (det == REAL(0.0))
+			return false;
+
+		REAL f = REAL(1.0) / det;
+
+		set(( a[1][1] * c5 - a[1][2] * c4 + a[1][3] * c3) * f,
+			(-a[0][1] * c5 + a[0][2] * c4 - a[0][3] * c3) * f,
+			( a[3][1] * s5 - a[3][2] * s4 + a[3][3] * s3) * f,
+			(-a[2][1] * s5 + a[2][2] * s4 - a[2][3] * s3) * f,
+
+			(-a[1][0] * c5 + a[1][2] * c2 - a[1][3] * c1) * f,
+			( a[0][0] * c5 - a[0][2] * c2 + a[0][3] * c1) * f,
+			(-a[3][0] * s5 + a[3][2] * s2 - a[3][3] * s1) * f,
+			( a[2][0] * s5 - a[2][2] * s2 + a[2][3] * s1) * f,
+
+			( a[1][0] * c4 - a[1][1] * c2 + a[1][3] * c0) * f,
+			(-a[0][0] * c4 + a[0][1] * c2 - a[0][3] * c0) * f,
+			( a[3][0] * s4 - a[3][1] * s2 + a[3][3] * s0) * f,
+			(-a[2][0] * s4 + a[2][1] * s2 - a[2][3] * s0) * f,
+
+			(-a[1][0] * c3 + a[1][1] * c1 - a[1][2] * c0) * f,
+			( a[0][0] * c3 - a[0][1] * c1 + a[0][2] * c0) * f,
+			(-a[3][0] * s3 + a[3][1] * s1 - a[3][2] * s0) * f,
+			( a[2][0] * s3 - a[2][1] * s1 + a[2][2] * s0) * f);
+
+		return true;
+	}
+
+	template <typename REAL>
+	size_t Matrix4T<REAL>::invertMany(const Matrix4T<REAL>* pMatrices, Matrix4T<REAL>* pInverses, size_t count,
+		std::vector<size_t>* pSingular /* = nullptr */)
+	{
+		size_t singularCount = 0;
+
+		for (size_t i = 0; i < count; i++)
 		{
-			// we need a full inverse, so calculate it here (using the adjoint method)
-			F_ASSERT(false);
+			Matrix4T<REAL>& inverse = pInverses[i];
+			inverse = pMatrices[i];
+
+			bool isInverted = true;
+			if (inverse.isRigid())
+				inverse.invertRigid();
+			else if (inverse.isAffine())
+				isInverted = inverse.invertAffine();
+			else
+				isInverted = inverse.invertGeneral();
+
+			if (!isInverted)
+			{
+				singularCount++;
+				if (pSingular)
+					pSingular->push_back(i);
+			}
 		}
 
-		m_row[0][3] = -m_row[0][3];
-		m_row[1][3] = -m_row[1][3];
-		m_row[2][3] = -m_row[2][3];
-
-		return *this;
+		return singularCount;
 	}
 
 	template <typename REAL>
@@ -984,6 +1104,35 @@ namespace flow
 
 	}
 
+	template <typename REAL>
+	inline bool Matrix4T<REAL>::isAffine() const
+	{
+		return m_row[3][0] == REAL(0.0) && m_row[3][1] == REAL(0.0)
+			&& m_row[3][2] == REAL(0.0) && m_row[3][3] == REAL(1.0);
+	}
+
+	template <typename REAL>
+	bool Matrix4T<REAL>::isRigid() const
+	{
+		if (!isAffine())
+			return false;
+
+		// rows of the 3x3 block must be unit length and mutually orthogonal, within a few ulps
+		const REAL eps = REAL(16) * std::numeric_limits<REAL>::epsilon();
+
+		for (size_t i = 0; i < 3; i++)
+		{
+			for (size_t j = i; j < 3; j++)
+			{
+				REAL d = m_row[i][0] * m_row[j][0] + m_row[i][1] * m_row[j][1] + m_row[i][2] * m_row[j][2];
+				if (fabs(d - (i == j ? REAL(1.0) : REAL(0.0))) > eps)
+					return false;
+			}
+		}
+
+		return true;
+	}
+
 	template <typename REAL>
 	void Matrix4T<REAL>::extractRotation(OUT Matrix3T<REAL>& mat) const
 	{
@@ -995,8 +1144,14 @@ namespace flow
 	template <typename REAL>
 	REAL Matrix4T<REAL>::determinant() const
 	{
-		F_ASSERT(false);
-		return REAL(0.0);
+		const Vector4T<REAL>* a = m_row;
+
+		return (a[0][0] * a[1][1] - a[1][0] * a[0][1]) * (a[2][2] * a[3][3] - a[3][2] * a[2][3])
+			- (a[0][0] * a[1][2] - a[1][0] * a[0][2]) * (a[2][1] * a[3][3] - a[3][1] * a[2][3])
+			+ (a[0][0] * a[1][3] - a[1][0] * a[0][3]) * (a[2][1] * a[3][2] - a[3][1] * a[2][2])
+			+ (a[0][1] * a[1][2] - a[1][1] * a[0][2]) * (a[2][0] * a[3][3] - a[3][0] * a[2][3])
+			- (a[0][1] * a[1][3] - a[1][1] * a[0][3]) * (a[2][0] * a[3][2] - a[3][0] * a[2][2])
+			+ (a[0][2] * a[1][3] - a[1][2] * a[0][3]) * (a[2][0] * a[3][1] - a[3][0] * a[2][1]);
 	}
 
 	template <typename REAL>
@@ -1094,6 +1249,100 @@ namespace flow
 		return stream;
 	}
 
+	// Float specializations -------------------------------------------------------
+
+#ifdef F_MATH_SSE
+
+	template <>
+	inline Matrix4T<float>& Matrix4T<float>::operator*=(const Matrix4T<float>& other)
+	{
+		Matrix4fSSE::multiply(ptr(), other.ptr(), ptr());
+		return *this;
+	}
+
+	template <>
+	inline Matrix4T<float>& Matrix4T<float>::transpose()
+	{
+		Matrix4fSSE::transpose(ptr(), ptr());
+		return *this;
+	}
+
+	template <>
+	inline void Matrix4T<float>::invertRigid()
+	{
+		Matrix4fSSE::invertRigid(ptr(), ptr());
+	}
+
+	template <>
+	inline bool Matrix4T<float>::invertAffine()
+	{
+		return Matrix4fSSE::invertAffine(ptr(), ptr());
+	}
+
+	template <>
+	inline bool Matrix4T<float>::invertGeneral()
+	{
+		return Matrix4fSSE::invert(ptr(), ptr());
+	}
+
+	template <>
+	inline Matrix4T<float>& Matrix4T<float>::invert()
+	{
+		// the SSE affine inverse costs less than the orthonormality test, use it for rigid transforms too
+		if (isAffine())
+			invertAffine();
+		else
+			invertGeneral();
+
+		return *this;
+	}
+
+	template <>
+	inline size_t Matrix4T<float>::invertMany(const Matrix4T<float>* pMatrices, Matrix4T<float>* pInverses, size_t count,
+		std::vector<size_t>* pSingular /* = nullptr */)
+	{
+		// the kernels invert out of place, matrices are only copied if singular
+		size_t singularCount = 0;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			const float* pMatrix = pMatrices[i].ptr();
+			bool isInverted = pMatrices[i].isAffine()
+				? Matrix4fSSE::invertAffine(pMatrix, pInverses[i].ptr())
+				: Matrix4fSSE::invert(pMatrix, pInverses[i].ptr());
+
+			if (!isInverted)
+			{
+				pInverses[i] = pMatrices[i];
+				singularCount++;
+				if (pSingular)
+					pSingular->push_back(i);
+			}
+		}
+
+		return singularCount;
+	}
+
+	/// Matrix-vector multiplication, SSE version. The generic version
+	/// remains available as operator*<float>.
+	inline Vector4T<float> operator*(const Matrix4T<float>& mat, const Vector4T<float>& vec)
+	{
+		Vector4T<float> result;
+		Matrix4fSSE::transform(mat.ptr(), vec.ptr(), result.ptr());
+		return result;
+	}
+
+	/// Matrix-matrix multiplication, SSE/AVX version. The generic version
+	/// remains available as operator*<float>.
+	inline Matrix4T<float> operator*(const Matrix4T<float>& lhs, const Matrix4T<float>& rhs)
+	{
+		Matrix4T<float> result;
+		Matrix4fSSE::multiply(lhs.ptr(), rhs.ptr(), result.ptr());
+		return result;
+	}
+
+#endif // F_MATH_SSE
+
 	// Typedefs --------------------------------------------------------------------
 
 	/// Matrix of type float.
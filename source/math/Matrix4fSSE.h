@@ -0,0 +1,293 @@
+/**
+* Flow Libs - Math
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_MATH_MATRIX4FSSE_H
+#define _FLOWLIBS_MATH_MATRIX4FSSE_H
+
+#include "library.h"
+
+#if defined(__AVX__)
+#  include <immintrin.h>
+#  define F_MATH_SSE
+#  define F_MATH_AVX
+#elif defined(FLOW_SSE41)
+#  include <smmintrin.h>
+#  define F_MATH_SSE
+#endif
+
+#ifdef F_MATH_SSE
+
+namespace flow
+{
+	/// SSE kernels for 4 by 4 float matrices, used by the Matrix4T<float> specializations.
+	/// All functions operate on arrays of 16 floats in row-major layout, the arrays need
+	/// not be aligned. Results may alias the arguments.
+	class F_MATH_EXPORT Matrix4fSSE
+	{
+	public:
+		/// Deleted constructor. Class provides only static methods.
+		Matrix4fSSE() = delete;
+
+		/// Matrix-matrix multiplication pResult = pLhs * pRhs.
+		static void multiply(const float* pLhs, const float* pRhs, float* pResult);
+		/// Matrix-vector multiplication pResult = pMat * pVec.
+		static void transform(const float* pMat, const float* pVec, float* pResult);
+		/// Transposes the matrix.
+		static void transpose(const float* pMat, float* pResult);
+		/// Computes the inverse using the block-wise adjugate of the 2 by 2 sub-matrices.
+		/// Returns false and leaves pResult untouched if the matrix is singular.
+		static bool invert(const float* pMat, float* pResult);
+		/// Inverts an affine matrix by inverting its upper left 3 by 3 block. The last row
+		/// is assumed to be (0, 0, 0, 1). Returns false and leaves pResult untouched if singular.
+		static bool invertAffine(const float* pMat, float* pResult);
+		/// Inverts a rigid transform by transposing its orthonormal 3 by 3 block.
+		static void invertRigid(const float* pMat, float* pResult);
+
+	private:
+		template <int X, int Y, int Z, int W>
+		static __m128 _swizzle(__m128 v) {
+			return _mm_shuffle_ps(v, v, _MM_SHUFFLE(W, Z, Y, X));
+		}
+		template <int X, int Y, int Z, int W>
+		static __m128 _shuffle(__m128 a, __m128 b) {
+			return _mm_shuffle_ps(a, b, _MM_SHUFFLE(W, Z, Y, X));
+		}
+
+		/// Cross product of the xyz components, w of the result is zero.
+		static __m128 _cross(__m128 a, __m128 b);
+		/// Stores the affine matrix with 3 by 3 block columns c0, c1, c2 and translation t.
+		static void _storeAffine(__m128 c0, __m128 c1, __m128 c2, __m128 t, float* pResult);
+
+		/// 2 by 2 matrix product a * b.
+		static __m128 _mul2(__m128 a, __m128 b);
+		/// 2 by 2 matrix product adj(a) * b.
+		static __m128 _adjMul2(__m128 a, __m128 b);
+		/// 2 by 2 matrix product a * adj(b).
+		static __m128 _mulAdj2(__m128 a, __m128 b);
+	};
+
+	inline void Matrix4fSSE::multiply(const float* pLhs, const float* pRhs, float* pResult)
+	{
+#ifdef F_MATH_AVX
+		// two result rows per iteration, each 128 bit lane holds one row
+		__m256 b0 = _mm256_broadcast_ps((const __m128*)(pRhs));
+		__m256 b1 = _mm256_broadcast_ps((const __m128*)(pRhs + 4));
+		__m256 b2 = _mm256_broadcast_ps((const __m128*)(pRhs + 8));
+		__m256 b3 = _mm256_broadcast_ps((const __m128*)(pRhs + 12));
+		__m256 a01 = _mm256_loadu_ps(pLhs);
+		__m256 a23 = _mm256_loadu_ps(pLhs + 8);
+
+		__m256 r01 = _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x00), b0);
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0x55), b1));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xaa), b2));
+		r01 = _mm256_add_ps(r01, _mm256_mul_ps(_mm256_shuffle_ps(a01, a01, 0xff), b3));
+
+		__m256 r23 = _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x00), b0);
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0x55), b1));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xaa), b2));
+		r23 = _mm256_add_ps(r23, _mm256_mul_ps(_mm256_shuffle_ps(a23, a23, 0xff), b3));
+
+		_mm256_storeu_ps(pResult, r01);
+		_mm256_storeu_ps(pResult + 8, r23);
+#else
+		__m128 b[4], r[4];
+		for (int k = 0; k < 4; ++k) {
+			b[k] = _mm_loadu_ps(pRhs + 4 * k);
+		}
+
+		// result row i is the sum of the rows of rhs, weighted by the elements of lhs row i
+		for (int i = 0; i < 4; ++i) {
+			__m128 a = _mm_loadu_ps(pLhs + 4 * i);
+			r[i] = _mm_mul_ps(_swizzle<0, 0, 0, 0>(a), b[0]);
+			r[i] = _mm_add_ps(r[i], _mm_mul_ps(_swizzle<1, 1, 1, 1>(a), b[1]));
+			r[i] = _mm_add_ps(r[i], _mm_mul_ps(_swizzle<2, 2, 2, 2>(a), b[2]));
+			r[i] = _mm_add_ps(r[i], _mm_mul_ps(_swizzle<3, 3, 3, 3>(a), b[3]));
+		}
+
+		for (int i = 0; i < 4; ++i) {
+			_mm_storeu_ps(pResult + 4 * i, r[i]);
+		}
+#endif
+	}
+
+	inline void Matrix4fSSE::transform(const float* pMat, const float* pVec, float* pResult)
+	{
+		__m128 v = _mm_loadu_ps(pVec);
+		__m128 p0 = _mm_mul_ps(_mm_loadu_ps(pMat), v);
+		__m128 p1 = _mm_mul_ps(_mm_loadu_ps(pMat + 4), v);
+		__m128 p2 = _mm_mul_ps(_mm_loadu_ps(pMat + 8), v);
+		__m128 p3 = _mm_mul_ps(_mm_loadu_ps(pMat + 12), v);
+
+		// horizontal sums of the four row products
+		_mm_storeu_ps(pResult, _mm_hadd_ps(_mm_hadd_ps(p0, p1), _mm_hadd_ps(p2, p3)));
+	}
+
+	inline void Matrix4fSSE::transpose(const float* pMat, float* pResult)
+	{
+		__m128 r0 = _mm_loadu_ps(pMat);
+		__m128 r1 = _mm_loadu_ps(pMat + 4);
+		__m128 r2 = _mm_loadu_ps(pMat + 8);
+		__m128 r3 = _mm_loadu_ps(pMat + 12);
+
+		_MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+
+		_mm_storeu_ps(pResult, r0);
+		_mm_storeu_ps(pResult + 4, r1);
+		_mm_storeu_ps(pResult + 8, r2);
+		_mm_storeu_ps(pResult + 12, r3);
+	}
+
+	inline bool Matrix4fSSE::invert(const float* pMat, float* pResult)
+	{
+		__m128 r0 = _mm_loadu_ps(pMat);
+		__m128 r1 = _mm_loadu_ps(pMat + 4);
+		__m128 r2 = _mm_loadu_ps(pMat + 8);
+		__m128 r3 = _mm_loadu_ps(pMat + 12);
+
+		// 2 by 2 sub-matrices M = | A B |
+		//                         | C D |
+		__m128 A = _mm_movelh_ps(r0, r1);
+		__m128 B = _mm_movehl_ps(r1, r0);
+		__m128 C = _mm_movelh_ps(r2, r3);
+		__m128 D = _mm_movehl_ps(r3, r2);
+
+		// determinants of the sub-matrices (|A|, |B|, |C|, |D|)
+		__m128 detSub = _mm_sub_ps(
+			_mm_mul_ps(_shuffle<0, 2, 0, 2>(r0, r2), _shuffle<1, 3, 1, 3>(r1, r3)),
+			_mm_mul_ps(_shuffle<1, 3, 1, 3>(r0, r2), _shuffle<0, 2, 0, 2>(r1, r3)));
+
+		__m128 detA = _swizzle<0, 0, 0, 0>(detSub);
+		__m128 detB = _swizzle<1, 1, 1, 1>(detSub);
+		__m128 detC = _swizzle<2, 2, 2, 2>(detSub);
+		__m128 detD = _swizzle<3, 3, 3, 3>(detSub);
+
+		__m128 adjDC = _adjMul2(D, C);
+		__m128 adjAB = _adjMul2(A, B);
+
+		// adjugates of the blocks of the inverse
+		__m128 X = _mm_sub_ps(_mm_mul_ps(detD, A), _mul2(B, adjDC));
+		__m128 W = _mm_sub_ps(_mm_mul_ps(detA, D), _mul2(C, adjAB));
+		__m128 Y = _mm_sub_ps(_mm_mul_ps(detB, C), _mulAdj2(D, adjAB));
+		__m128 Z = _mm_sub_ps(_mm_mul_ps(detC, B), _mulAdj2(A, adjDC));
+
+		// |M| = |A||D| + |B||C| - tr(adj(A)B adj(D)C)
+		__m128 tr = _mm_mul_ps(adjAB, _swizzle<0, 2, 1, 3>(adjDC));
+		tr = _mm_hadd_ps(tr, tr);
+		tr = _mm_hadd_ps(tr, tr);
+
+		__m128 det = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), tr);
+		if (_mm_cvtss_f32(det) == 0.0f) {
+			return false;
+		}
+
+		__m128 invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), det);
+		X = _mm_mul_ps(X, invDet);
+		Y = _mm_mul_ps(Y, invDet);
+		Z = _mm_mul_ps(Z, invDet);
+		W = _mm_mul_ps(W, invDet);
+
+		// the shuffles apply the final adjugate and reassemble the rows
+		_mm_storeu_ps(pResult, _shuffle<3, 1, 3, 1>(X, Y));
+		_mm_storeu_ps(pResult + 4, _shuffle<2, 0, 2, 0>(X, Y));
+		_mm_storeu_ps(pResult + 8, _shuffle<3, 1, 3, 1>(Z, W));
+		_mm_storeu_ps(pResult + 12, _shuffle<2, 0, 2, 0>(Z, W));
+
+		return true;
+	}
+
+	inline bool Matrix4fSSE::invertAffine(const float* pMat, float* pResult)
+	{
+		const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		__m128 r0 = _mm_loadu_ps(pMat);
+		__m128 r1 = _mm_loadu_ps(pMat + 4);
+		__m128 r2 = _mm_loadu_ps(pMat + 8);
+
+		__m128 tx = _swizzle<3, 3, 3, 3>(r0);
+		__m128 ty = _swizzle<3, 3, 3, 3>(r1);
+		__m128 tz = _swizzle<3, 3, 3, 3>(r2);
+		r0 = _mm_and_ps(r0, mask);
+		r1 = _mm_and_ps(r1, mask);
+		r2 = _mm_and_ps(r2, mask);
+
+		// the columns of the inverse block are the cross products of the rows, divided by the determinant
+		__m128 c0 = _cross(r1, r2);
+		__m128 c1 = _cross(r2, r0);
+		__m128 c2 = _cross(r0, r1);
+
+		__m128 det = _mm_dp_ps(r0, c0, 0x7f);
+		if (_mm_cvtss_f32(det) == 0.0f) {
+			return false;
+		}
+
+		__m128 invDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+		c0 = _mm_mul_ps(c0, invDet);
+		c1 = _mm_mul_ps(c1, invDet);
+		c2 = _mm_mul_ps(c2, invDet);
+
+		__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(c0, tx), _mm_mul_ps(c1, ty)), _mm_mul_ps(c2, tz));
+		_storeAffine(c0, c1, c2, _mm_sub_ps(_mm_setzero_ps(), t), pResult);
+
+		return true;
+	}
+
+	inline void Matrix4fSSE::invertRigid(const float* pMat, float* pResult)
+	{
+		const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+		__m128 r0 = _mm_loadu_ps(pMat);
+		__m128 r1 = _mm_loadu_ps(pMat + 4);
+		__m128 r2 = _mm_loadu_ps(pMat + 8);
+
+		__m128 tx = _swizzle<3, 3, 3, 3>(r0);
+		__m128 ty = _swizzle<3, 3, 3, 3>(r1);
+		__m128 tz = _swizzle<3, 3, 3, 3>(r2);
+		r0 = _mm_and_ps(r0, mask);
+		r1 = _mm_and_ps(r1, mask);
+		r2 = _mm_and_ps(r2, mask);
+
+		// the columns of the inverse block are the rows of the block
+		__m128 t = _mm_add_ps(_mm_add_ps(_mm_mul_ps(r0, tx), _mm_mul_ps(r1, ty)), _mm_mul_ps(r2, tz));
+		_storeAffine(r0, r1, r2, _mm_sub_ps(_mm_setzero_ps(), t), pResult);
+	}
+
+	inline __m128 Matrix4fSSE::_cross(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(_swizzle<1, 2, 0, 3>(a), _swizzle<2, 0, 1, 3>(b)),
+			_mm_mul_ps(_swizzle<2, 0, 1, 3>(a), _swizzle<1, 2, 0, 3>(b)));
+	}
+
+	inline void Matrix4fSSE::_storeAffine(__m128 c0, __m128 c1, __m128 c2, __m128 t, float* pResult)
+	{
+		_MM_TRANSPOSE4_PS(c0, c1, c2, t);
+
+		_mm_storeu_ps(pResult, c0);
+		_mm_storeu_ps(pResult + 4, c1);
+		_mm_storeu_ps(pResult + 8, c2);
+		_mm_storeu_ps(pResult + 12, _mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f));
+	}
+
+	inline __m128 Matrix4fSSE::_mul2(__m128 a, __m128 b)
+	{
+		return _mm_add_ps(_mm_mul_ps(a, _swizzle<0, 3, 0, 3>(b)),
+			_mm_mul_ps(_swizzle<1, 0, 3, 2>(a), _swizzle<2, 1, 2, 1>(b)));
+	}
+
+	inline __m128 Matrix4fSSE::_adjMul2(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(_swizzle<3, 3, 0, 0>(a), b),
+			_mm_mul_ps(_swizzle<1, 1, 2, 2>(a), _swizzle<2, 3, 0, 1>(b)));
+	}
+
+	inline __m128 Matrix4fSSE::_mulAdj2(__m128 a, __m128 b)
+	{
+		return _mm_sub_ps(_mm_mul_ps(a, _swizzle<3, 0, 3, 0>(b)),
+			_mm_mul_ps(_swizzle<1, 0, 3, 2>(a), _swizzle<2, 1, 2, 1>(b)));
+	}
+}
+
+#endif // F_MATH_SSE
+
+#endif // _FLOWLIBS_MATH_MATRIX4FSSE_H
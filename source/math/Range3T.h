@@ -273,12 +273,12 @@ namespace flow
     template <typename T>
     inline bool Range3T<T>::intersects(const Range3T<T>& other) const
     {
-        return (m_lowerBound.x <= other.m_upperBound.x
+        return m_lowerBound.x <= other.m_upperBound.x
             && m_lowerBound.y <= other.m_upperBound.y
-            && m_lowerBound.z <= other.m_upperBound.z)
-            || (m_upperBound.x >= other.m_lowerBound.x
+            && m_lowerBound.z <= other.m_upperBound.z
+            && m_upperBound.x >= other.m_lowerBound.x
             && m_upperBound.y >= other.m_lowerBound.y
-            && m_upperBound.z >= other.m_lowerBound.z);
+            && m_upperBound.z >= other.m_lowerBound.z;
     }
 
     /// Writes a text representation of the range to the given stream.
@@ -0,0 +1,200 @@
+/**
+* Matrix Benchmark - SSE Matrix4f specializations versus the generic template
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "math/Math.h"
+#include "math/Matrix4T.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace flow;
+
+using std::cout;
+using std::endl;
+
+typedef std::chrono::steady_clock benchClock;
+
+const size_t matrixCount = 1024;
+const size_t repeatCount = 2000;
+
+template<typename F>
+double measure(const F& fn)
+{
+	auto startTime = benchClock::now();
+	for (size_t r = 0; r < repeatCount; ++r) {
+		fn();
+	}
+	return std::chrono::duration<double>(benchClock::now() - startTime).count()
+		/ double(repeatCount * matrixCount) * 1e9;
+}
+
+float randomValue()
+{
+	return float(std::rand()) / float(RAND_MAX) * 2.0f - 1.0f;
+}
+
+Matrix4f randomMatrix()
+{
+	Matrix4f mat;
+	float* p = mat.ptr();
+	for (size_t i = 0; i < 16; ++i) {
+		p[i] = randomValue();
+	}
+	return mat;
+}
+
+double maxError(const float* pA, const float* pB, size_t count)
+{
+	double error = 0.0;
+	for (size_t i = 0; i < count; ++i) {
+		error = flow::max(error, std::fabs(double(pA[i]) - double(pB[i])));
+	}
+	return error;
+}
+
+void report(const char* pName, double genericNs, double simdNs, double error)
+{
+	cout << std::left << std::setw(14) << pName << std::right
+		<< std::setw(12) << genericNs << std::setw(12) << simdNs
+		<< std::setw(10) << genericNs / simdNs << "x"
+		<< std::setw(14) << std::scientific << error << std::fixed << endl;
+}
+
+int main(int argc, char** ppArgv)
+{
+#ifndef F_MATH_SSE
+	cout << "SSE specializations not enabled, compile with SSE4.1 or AVX" << endl;
+	return 0;
+#else
+	std::vector<Matrix4f> lhs(matrixCount), rhs(matrixCount), result(matrixCount), reference(matrixCount);
+	std::vector<Vector4f> vectors(matrixCount), vectorResult(matrixCount), vectorReference(matrixCount);
+	std::vector<Matrix4d> lhsDouble(matrixCount), resultDouble(matrixCount);
+
+	for (size_t i = 0; i < matrixCount; ++i) {
+		lhs[i] = randomMatrix();
+		rhs[i] = randomMatrix();
+		vectors[i] = Vector4f(randomValue(), randomValue(), randomValue(), randomValue());
+		lhsDouble[i] = lhs[i];
+	}
+
+	cout << std::fixed << std::setprecision(2);
+	cout << "Matrix4f, ns per operation" << endl;
+	cout << std::left << std::setw(14) << "operation" << std::right << std::setw(12) << "generic"
+		<< std::setw(12) << "simd" << std::setw(11) << "speedup" << std::setw(14) << "max error" << endl;
+
+	// multiply and transform: the generic template is selected by explicit template arguments
+
+	double genericNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			reference[i] = operator*<float>(lhs[i], rhs[i]);
+		}
+	});
+	double simdNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			result[i] = lhs[i] * rhs[i];
+		}
+	});
+	report("multiply", genericNs, simdNs, maxError(result[0].ptr(), reference[0].ptr(), 16 * matrixCount));
+
+	genericNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			vectorReference[i] = operator*<float>(lhs[i], vectors[i]);
+		}
+	});
+	simdNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			vectorResult[i] = lhs[i] * vectors[i];
+		}
+	});
+	report("transform", genericNs, simdNs, maxError(vectorResult[0].ptr(), vectorReference[0].ptr(), 4 * matrixCount));
+
+	// transpose and inverse: the float versions are replaced, compare with the generic double version
+
+	genericNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			resultDouble[i] = lhsDouble[i];
+			resultDouble[i].transpose();
+		}
+	});
+	simdNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			result[i] = lhs[i];
+			result[i].transpose();
+		}
+	});
+	for (size_t i = 0; i < matrixCount; ++i) {
+		reference[i] = resultDouble[i];
+	}
+	report("transpose", genericNs, simdNs, maxError(result[0].ptr(), reference[0].ptr(), 16 * matrixCount));
+
+	genericNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			resultDouble[i] = lhsDouble[i];
+			resultDouble[i].invertGeneral();
+		}
+	});
+	simdNs = measure([&]() {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			result[i] = lhs[i];
+			result[i].invertGeneral();
+		}
+	});
+
+	// the error of the float inverse grows with the condition number, report it relative to M * inv(M) = I
+	double identityError = 0.0;
+	for (size_t i = 0; i < matrixCount; ++i) {
+		reference[i].setIdentity();
+		Matrix4f product = operator*<float>(lhs[i], result[i]);
+		identityError = flow::max(identityError, maxError(product.ptr(), reference[i].ptr(), 16));
+	}
+	report("inverse", genericNs, simdNs, identityError);
+
+	// invertMany dispatches by matrix kind: sets of rigid, affine and general matrices
+	for (size_t i = 0; i < matrixCount; ++i) {
+		Matrix4f& rigid = rhs[i];
+		rigid.setIdentity();
+		Vector3f axis = Vector3f(randomValue(), randomValue(), randomValue() + 2.0f).normalized();
+		float angle = randomValue() * float(F_PI);
+		float c = std::cos(angle), s = std::sin(angle), t = 1.0f - c;
+		rigid[0].set(t * axis.x * axis.x + c, t * axis.x * axis.y - s * axis.z, t * axis.x * axis.z + s * axis.y, randomValue());
+		rigid[1].set(t * axis.x * axis.y + s * axis.z, t * axis.y * axis.y + c, t * axis.y * axis.z - s * axis.x, randomValue());
+		rigid[2].set(t * axis.x * axis.z - s * axis.y, t * axis.y * axis.z + s * axis.x, t * axis.z * axis.z + c, randomValue());
+	}
+
+	const char* kindNames[] = { "many rigid", "many affine", "many general" };
+	for (size_t kind = 0; kind < 3; ++kind) {
+		for (size_t i = 0; i < matrixCount; ++i) {
+			if (kind == 0) {
+				lhs[i] = rhs[i];
+			}
+			else {
+				lhs[i] = randomMatrix();
+				if (kind == 1) {
+					lhs[i][3].set(0.0f, 0.0f, 0.0f, 1.0f);
+				}
+			}
+			lhsDouble[i] = lhs[i];
+		}
+
+		genericNs = measure([&]() { Matrix4d::invertMany(lhsDouble.data(), resultDouble.data(), matrixCount); });
+		simdNs = measure([&]() { Matrix4f::invertMany(lhs.data(), result.data(), matrixCount); });
+
+		identityError = 0.0;
+		for (size_t i = 0; i < matrixCount; ++i) {
+			Matrix4f product = operator*<float>(lhs[i], result[i]);
+			identityError = flow::max(identityError, maxError(product.ptr(), reference[i].ptr(), 16));
+		}
+		report(kindNames[kind], genericNs, simdNs, identityError);
+	}
+
+	return 0;
+#endif
+}
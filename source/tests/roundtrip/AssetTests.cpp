@@ -0,0 +1,534 @@
+/**
+* glTF Round Trip Tests - Saving, loading and asset level transformations
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "RoundTripTests.h"
+#include "MeshoptDecoder.h"
+
+#include <clocale>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+
+using namespace flow;
+
+
+namespace
+{
+	bool _equalBytes(const GLTFBuffer* pBuffer, const void* pData, size_t byteOffset, size_t byteLength)
+	{
+		const char* pBufferData = pBuffer->data(byteOffset);
+		return pBufferData && byteOffset + byteLength <= pBuffer->byteLength()
+			&& std::memcmp(pBufferData, pData, byteLength) == 0;
+	}
+
+	/// Returns true if each triangle equals the corresponding source triangle, possibly rotated.
+	bool _equalTriangles(const uint32_t* pIndices, const uint32_t* pSource, size_t indexCount)
+	{
+		for (size_t i = 0; i < indexCount; i += 3) {
+			bool found = false;
+			for (size_t r = 0; r < 3 && !found; ++r) {
+				found = pIndices[i] == pSource[i + r] && pIndices[i + 1] == pSource[i + (r + 1) % 3]
+					&& pIndices[i + 2] == pSource[i + (r + 2) % 3];
+			}
+			if (!found) {
+				return false;
+			}
+		}
+
+		return true;
+	}
+}
+
+void test::testSaveLoad()
+{
+	grid_t grid;
+	makeGrid(16, 12, 4.0f, 3.0f, Vector3f(-2.0f, -1.5f, 0.0f), grid);
+
+	GLTFAsset asset;
+	asset.setGenerator("https://github.com/framelab/flow-libs");
+	asset.setCopyright("(c) 2018 Frame Factory GmbH");
+
+	auto pBuffer = asset.createBuffer("data");
+	auto pMesh = createGridMesh<uint16_t>(asset, pBuffer, grid);
+
+	auto pMeshNode = asset.createMeshNode(pMesh, "grid");
+	pMeshNode->setTRS(Vector3f(1.0f, 2.0f, 3.0f), Quaternion4f(0.0f, 0.6f, 0.0f, 0.8f), Vector3f(2.0f, 2.0f, 2.0f));
+
+	Matrix4f matrix;
+	matrix.makeTranslation(0.5f, -0.25f, 0.125f);
+	auto pChild = asset.createNode("child");
+	pChild->setMatrix(matrix);
+	pMeshNode->addChild(pChild);
+
+	auto pScene = asset.createScene("scene");
+	pScene->addNode(pMeshNode);
+	asset.setMainScene(pScene);
+
+	// a single segment per buffer, so the buffer data can be compared as a whole
+	CHECK(asset.compact());
+
+	// binary glTF, the buffer is stored in the container
+	{
+		GLTFAsset loaded;
+		checkGLBRoundTrip(asset, loaded, "roundtrip_saveload.glb");
+
+		CHECK(loaded.buffers().size() == 1);
+		if (loaded.buffers().size() == 1) {
+			CHECK(loaded.buffers()[0]->byteLength() == pBuffer->byteLength());
+			CHECK(_equalBytes(loaded.buffers()[0], pBuffer->data(), 0, pBuffer->byteLength()));
+		}
+	}
+
+	// glTF JSON, the buffer is stored in a separate file referenced by its uri
+	{
+		const std::string bufferPath = "roundtrip_saveload.bin";
+		pBuffer->setUri(bufferPath);
+
+		CHECK(pBuffer->save(bufferPath));
+		CHECK(asset.saveGLTF("roundtrip_saveload.gltf"));
+
+		GLTFAsset loaded;
+		CHECK(loaded.loadGLTF("roundtrip_saveload.gltf"));
+		CHECK(loaded.loadError().empty());
+		CHECK(equalDocuments(asset, loaded, false));
+
+		CHECK(loaded.buffers().size() == 1);
+		if (loaded.buffers().size() == 1) {
+			CHECK(_equalBytes(loaded.buffers()[0], pBuffer->data(), 0, pBuffer->byteLength()));
+		}
+
+		GLTFAsset copy;
+		CHECK(loaded.saveGLTF("roundtrip_saveload.copy.gltf"));
+		CHECK(copy.loadGLTF("roundtrip_saveload.copy.gltf"));
+		CHECK(copy.toString() == loaded.toString());
+	}
+
+	std::remove("roundtrip_saveload.copy.gltf");
+	std::remove("roundtrip_saveload.gltf");
+	std::remove("roundtrip_saveload.bin");
+	std::remove("roundtrip_saveload.glb");
+}
+
+void test::testReaderRollback()
+{
+	// each document fails after some elements have been read
+	const char* documents[] = {
+		"{ \"asset\": { \"version\": \"2.0\" }, \"nodes\": [ { \"name\": \"a\"",
+		"{ \"asset\": { \"version\": \"2.0\" }, \"nodes\": [ { \"name\": \"a\", \"mesh\": 3 } ] }",
+		"{ \"asset\": { \"version\": \"2.0\" }, \"buffers\": [ { \"byteLength\": 4 } ], "
+			"\"bufferViews\": [ { \"buffer\": 0, \"byteOffset\": 2, \"byteLength\": 4 } ] }",
+		"{ \"asset\": { \"version\": \"2.0\" }, \"nodes\": [ { \"name\": \"a\" } ], "
+			"\"scenes\": [ { \"nodes\": [ 0 ] } ], \"scene\": 1 }",
+	};
+
+	for (bool isBinary : { true, false }) {
+		const std::string filePath = isBinary ? "roundtrip_invalid.glb" : "roundtrip_invalid.gltf";
+
+		for (const char* pDocument : documents) {
+			GLTFAsset asset;
+			asset.setGenerator("rollback");
+			auto pNode = asset.createNode("existing");
+			auto pScene = asset.createScene();
+			pScene->addNode(pNode);
+			asset.setMainScene(pScene);
+
+			const std::string before = asset.toString();
+
+			CHECK(isBinary ? writeGLB(filePath, pDocument) : writeFile(filePath, pDocument));
+			CHECK(!(isBinary ? asset.loadGLB(filePath) : asset.loadGLTF(filePath)));
+			CHECK(!asset.loadError().empty());
+			CHECK(asset.toString() == before);
+		}
+
+		std::remove(filePath.c_str());
+	}
+}
+
+void test::testTextureInfo()
+{
+	const char* pDocument = "{ \"asset\": { \"version\": \"2.0\" }, "
+		"\"extensionsUsed\": [ \"KHR_texture_transform\" ], "
+		"\"images\": [ { \"uri\": \"texture.png\" } ], \"textures\": [ { \"source\": 0 } ], "
+		"\"materials\": [ { \"pbrMetallicRoughness\": { "
+		"\"baseColorTexture\": { \"index\": 0, \"texCoord\": 1, "
+		"\"extensions\": { \"KHR_texture_transform\": { \"offset\": [ 0.5, 0.25 ], \"scale\": [ 2.0, 2.0 ] } } }, "
+		"\"metallicRoughnessTexture\": { \"index\": 0, \"extras\": { \"note\": \"mr\" } } }, "
+		"\"normalTexture\": { \"index\": 0, \"scale\": 0.5, "
+		"\"extensions\": { \"KHR_texture_transform\": { \"rotation\": 1.5 } } }, "
+		"\"occlusionTexture\": { \"index\": 0, \"strength\": 0.75, \"extras\": { \"note\": \"ao\" } }, "
+		"\"emissiveTexture\": { \"index\": 0, "
+		"\"extensions\": { \"KHR_texture_transform\": { \"texCoord\": 1 } } } } ] }";
+
+	CHECK(writeFile("roundtrip_textureinfo.gltf", pDocument));
+
+	{
+		// extensions and extras of all texture infos are read and written again
+		GLTFAsset loaded;
+		CHECK(loaded.loadGLTF("roundtrip_textureinfo.gltf"));
+		CHECK(loaded.loadError().empty());
+
+		const json source = json::parse(pDocument);
+		const json document = loaded.toJSON();
+		CHECK(document["materials"] == source["materials"]);
+		CHECK(document["extensionsUsed"] == source["extensionsUsed"]);
+
+		GLTFAsset copy;
+		CHECK(loaded.saveGLTF("roundtrip_textureinfo.copy.gltf"));
+		CHECK(copy.loadGLTF("roundtrip_textureinfo.copy.gltf"));
+		CHECK(copy.toString() == loaded.toString());
+	}
+
+	std::remove("roundtrip_textureinfo.copy.gltf");
+	std::remove("roundtrip_textureinfo.gltf");
+}
+
+void test::testNumberLocale()
+{
+	// the writer must produce '.' as decimal point whatever the locale uses
+	const char* locales[] = { "de_DE.UTF-8", "de_DE.utf8", "de_DE", "fr_FR.UTF-8", "German" };
+	const std::string previous = std::setlocale(LC_NUMERIC, nullptr);
+
+	bool hasLocale = false;
+	for (const char* pLocale : locales) {
+		if (std::setlocale(LC_NUMERIC, pLocale) && *std::localeconv()->decimal_point == ',') {
+			hasLocale = true;
+			break;
+		}
+	}
+
+	if (!hasLocale) {
+		std::setlocale(LC_NUMERIC, previous.c_str());
+		std::cout << "  skipped, no locale with decimal comma available" << std::endl;
+		return;
+	}
+
+	GLTFAsset asset;
+	auto pNode = asset.createNode("node");
+	pNode->setTRS(Vector3f(1.5f, 2.0f, -0.25f), Quaternion4f(0.0f, 0.0f, 0.0f, 1.0f), Vector3f(1.0f, 1.0f, 1.0f));
+	const std::string text = asset.toString();
+
+	std::setlocale(LC_NUMERIC, previous.c_str());
+
+	json document = json::parse(text, nullptr, false);
+	CHECK(!document.is_discarded());
+	if (!document.is_discarded()) {
+		CHECK(document["nodes"][0]["translation"] == json::array({ 1.5, 2.0, -0.25 }));
+	}
+}
+
+void test::testMergeBuffers()
+{
+	grid_t grid, otherGrid;
+	makeGrid(8, 6, 2.0f, 1.0f, Vector3f(0.0f, 0.0f, 0.0f), grid);
+	makeGrid(5, 7, 1.0f, 2.0f, Vector3f(1.0f, 1.0f, 1.0f), otherGrid);
+
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer("first");
+	auto pOtherBuffer = asset.createBuffer("second");
+	auto pMesh = createGridMesh<uint16_t>(asset, pBuffer, grid);
+	auto pOtherMesh = createGridMesh<uint32_t>(asset, pOtherBuffer, otherGrid);
+
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(pMesh));
+	pScene->addNode(asset.createMeshNode(pOtherMesh));
+	asset.setMainScene(pScene);
+
+	const json source = asset.toJSON();
+	const GLTFBuffer* buffers[2] = { pBuffer, pOtherBuffer };
+
+	{
+		CHECK(asset.saveGLB("roundtrip_merge.glb"));
+
+		GLTFAsset loaded;
+		CHECK(loaded.loadGLB("roundtrip_merge.glb"));
+		CHECK(loaded.loadError().empty());
+
+		// all views refer to the single binary chunk buffer, their data moved with them
+		json document = loaded.toJSON();
+		if (CHECK(loaded.buffers().size() == 1 && document["bufferViews"].size() == source["bufferViews"].size())) {
+			const GLTFBuffer* pLoaded = loaded.buffers()[0];
+			for (size_t i = 0; i < source["bufferViews"].size(); ++i) {
+				const json& sourceView = source["bufferViews"][i];
+				const json& view = document["bufferViews"][i];
+				size_t byteLength = sourceView["byteLength"];
+				size_t sourceOffset = sourceView.value("byteOffset", size_t(0));
+				size_t byteOffset = view.value("byteOffset", size_t(0));
+				const GLTFBuffer* pSource = buffers[size_t(sourceView["buffer"])];
+
+				CHECK(view["buffer"] == 0);
+				CHECK(view["byteLength"] == byteLength);
+				CHECK(byteOffset % 4 == 0);
+				CHECK(_equalBytes(pLoaded, pSource->data(sourceOffset), byteOffset, byteLength));
+			}
+		}
+
+		// apart from the views and buffers, the documents are the same
+		document.erase("bufferViews");
+		document.erase("buffers");
+		json expected = source;
+		expected.erase("bufferViews");
+		expected.erase("buffers");
+		CHECK(document == expected);
+	}
+
+	std::remove("roundtrip_merge.glb");
+}
+
+void test::testSeparateBuffers()
+{
+	grid_t grid;
+	makeGrid(6, 4, 2.0f, 1.0f, Vector3f(0.0f, 0.0f, 0.0f), grid);
+
+	// the fallback buffer comes first, it has no data and isn't written to the binary chunk
+	GLTFAsset asset;
+	auto pFallback = asset.createBuffer("fallback");
+	pFallback->setFallback(true);
+	pFallback->addExtension(asset.createExtension<GLTFMeshoptExtension>());
+	auto pBuffer = asset.createBuffer("data");
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(createGridMesh<uint16_t>(asset, pBuffer, grid)));
+	asset.setMainScene(pScene);
+
+	for (GLBWriteMode mode : { GLBWriteMode::STREAM, GLBWriteMode::VECTORED }) {
+		GLBContainer container(&asset);
+		container.setMergeBuffers(false);
+		container.setWriteMode(mode);
+		CHECK(container.save("roundtrip_separate.glb"));
+
+		GLTFAsset loaded;
+		CHECK(loaded.loadGLB("roundtrip_separate.glb"));
+		CHECK(loaded.loadError().empty());
+		CHECK(equalDocuments(asset, loaded, false));
+
+		if (CHECK(loaded.buffers().size() == 2)) {
+			CHECK(loaded.buffers()[0]->isFallback());
+			for (auto& segment : pBuffer->segments()) {
+				CHECK(_equalBytes(loaded.buffers()[1], segment.pData, segment.byteOffset, segment.byteLength));
+			}
+		}
+	}
+
+	// without a buffer holding data the file has no binary chunk
+	{
+		GLTFAsset fallbackAsset;
+		auto pOnlyFallback = fallbackAsset.createBuffer("fallback");
+		pOnlyFallback->setFallback(true);
+		pOnlyFallback->addExtension(fallbackAsset.createExtension<GLTFMeshoptExtension>());
+
+		for (bool merge : { true, false }) {
+			GLBContainer container(&fallbackAsset);
+			container.setMergeBuffers(merge);
+			CHECK(container.save("roundtrip_separate.glb"));
+
+			const std::string content = readFile("roundtrip_separate.glb");
+			uint32_t jsonLength = 0;
+			if (CHECK(content.size() >= 20)) {
+				std::memcpy(&jsonLength, content.data() + 12, sizeof(jsonLength));
+			}
+			CHECK(content.size() == 20 + size_t(jsonLength));
+
+			GLTFAsset loaded;
+			CHECK(loaded.loadGLB("roundtrip_separate.glb"));
+			CHECK(equalDocuments(fallbackAsset, loaded, false));
+		}
+	}
+
+	std::remove("roundtrip_separate.glb");
+}
+
+void test::testMeshoptFile()
+{
+	grid_t grid;
+	makeGrid(40, 30, 8.0f, 6.0f, Vector3f(-4.0f, -3.0f, 1.0f), grid);
+
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer();
+	auto pMesh = createGridMesh<uint16_t>(asset, pBuffer, grid);
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(pMesh));
+	asset.setMainScene(pScene);
+
+	GLTFMeshoptEncoder encoder(&asset);
+	CHECK(encoder.encode(pBuffer));
+	CHECK(encoder.viewCount() == 4);
+	CHECK(encoder.resultByteLength() < encoder.sourceByteLength());
+	CHECK(asset.compact());
+
+	{
+		GLTFAsset loaded;
+		checkGLBRoundTrip(asset, loaded, "roundtrip_meshopt.glb");
+
+		// accessors keep their creation order: positions, normals, texture coordinates, indices
+		const std::vector<uint32_t>& indices = grid.indices;
+		std::vector<uint16_t> shortIndices(indices.begin(), indices.end());
+		const void* sources[4] = {
+			grid.positions.data(), grid.normals.data(), grid.texCoords.data(), shortIndices.data()
+		};
+
+		json document = loaded.toJSON();
+		CHECK(document["accessors"].size() == 4);
+		CHECK(document["extensionsRequired"].size() == 1
+			&& document["extensionsRequired"][0] == "EXT_meshopt_compression");
+
+		for (size_t i = 0; i < 4 && i < document["accessors"].size(); ++i) {
+			size_t viewIndex = document["accessors"][i]["bufferView"];
+			const json& view = document["bufferViews"][viewIndex];
+			if (!CHECK(view.count("extensions") && view["extensions"].count("EXT_meshopt_compression"))) {
+				continue;
+			}
+
+			// the view itself refers to the fallback buffer
+			size_t fallbackIndex = view["buffer"];
+			CHECK(loaded.buffers()[fallbackIndex]->isFallback());
+			CHECK(document["buffers"][fallbackIndex]["extensions"]["EXT_meshopt_compression"]["fallback"] == true);
+
+			const json& extension = view["extensions"]["EXT_meshopt_compression"];
+			size_t bufferIndex = extension["buffer"];
+			size_t byteOffset = extension.value("byteOffset", size_t(0));
+			size_t byteLength = extension["byteLength"];
+			size_t byteStride = extension["byteStride"];
+			size_t count = extension["count"];
+			std::string mode = extension["mode"];
+
+			const GLTFBuffer* pDataBuffer = loaded.buffers()[bufferIndex];
+			CHECK(!pDataBuffer->isFallback());
+			if (!CHECK(byteOffset + byteLength <= pDataBuffer->byteLength())) {
+				continue;
+			}
+
+			const uint8_t* pData = (const uint8_t*)pDataBuffer->data(byteOffset);
+			CHECK(count == (i < 3 ? grid.vertexCount : indices.size()));
+
+			if (i < 3) {
+				CHECK(mode == "ATTRIBUTES");
+				std::vector<uint8_t> vertices(count * byteStride);
+				CHECK(MeshoptDecoder::decodeVertexBuffer(vertices.data(), count, byteStride, pData, byteLength));
+				CHECK(std::memcmp(vertices.data(), sources[i], vertices.size()) == 0);
+			}
+			else {
+				CHECK(mode == "TRIANGLES");
+				CHECK(byteStride == 2);
+				std::vector<uint32_t> decoded(count);
+				CHECK(MeshoptDecoder::decodeIndexBuffer(decoded.data(), count, pData, byteLength));
+				CHECK(_equalTriangles(decoded.data(), indices.data(), count));
+			}
+		}
+	}
+
+	std::remove("roundtrip_meshopt.glb");
+}
+
+void test::testDeduplicate()
+{
+	grid_t grid, otherGrid;
+	makeGrid(20, 10, 2.0f, 1.0f, Vector3f(0.0f, 0.0f, 0.0f), grid);
+	makeGrid(10, 20, 1.0f, 2.0f, Vector3f(0.0f, 0.0f, 0.0f), otherGrid);
+
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer();
+	auto pMeshA = createGridMesh<uint16_t>(asset, pBuffer, grid);
+	auto pMeshB = createGridMesh<uint16_t>(asset, pBuffer, grid);
+	auto pMeshC = createGridMesh<uint16_t>(asset, pBuffer, otherGrid);
+
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(pMeshA));
+	pScene->addNode(asset.createMeshNode(pMeshB));
+	pScene->addNode(asset.createMeshNode(pMeshC));
+	asset.setMainScene(pScene);
+
+	CHECK(asset.toJSON()["bufferViews"].size() == 12);
+	CHECK(asset.deduplicate());
+	CHECK(asset.toJSON()["bufferViews"].size() == 8);
+
+	const GLTFPrimitive& primitiveA = pMeshA->primitives()[0];
+	const GLTFPrimitive& primitiveB = pMeshB->primitives()[0];
+	const GLTFPrimitive& primitiveC = pMeshC->primitives()[0];
+
+	CHECK(primitiveA.indices()->bufferView() == primitiveB.indices()->bufferView());
+	CHECK(primitiveA.indices()->bufferView() != primitiveC.indices()->bufferView());
+	for (auto type : { GLTFAttributeType::POSITION, GLTFAttributeType::NORMAL, GLTFAttributeType::TEXCOORD_0 }) {
+		CHECK(primitiveA.attributeAccessor(type)->bufferView() == primitiveB.attributeAccessor(type)->bufferView());
+		CHECK(primitiveA.attributeAccessor(type)->bufferView() != primitiveC.attributeAccessor(type)->bufferView());
+	}
+
+	for (const GLTFPrimitive* pPrimitive : { &primitiveA, &primitiveB, &primitiveC }) {
+		const grid_t& source = pPrimitive == &primitiveC ? otherGrid : grid;
+		CHECK(readIndices(*pPrimitive) == source.indices);
+		CHECK(readAttribute<3>(*pPrimitive, GLTFAttributeType::POSITION) == source.positions);
+		CHECK(readAttribute<3>(*pPrimitive, GLTFAttributeType::NORMAL) == source.normals);
+		CHECK(readAttribute<2>(*pPrimitive, GLTFAttributeType::TEXCOORD_0) == source.texCoords);
+	}
+
+	// nothing left to merge
+	CHECK(asset.deduplicate());
+	CHECK(asset.toJSON()["bufferViews"].size() == 8);
+
+	{
+		GLTFAsset loaded;
+		checkGLBRoundTrip(asset, loaded, "roundtrip_dedup.glb");
+	}
+	std::remove("roundtrip_dedup.glb");
+}
+
+void test::testNarrowIndices()
+{
+	// largest indices 120, 1680 and 90600: byte, short, and too large for short
+	const size_t sizes[] = { 10, 40, 300 };
+	grid_t grids[3];
+	for (size_t i = 0; i < 3; ++i) {
+		makeGrid(sizes[i], sizes[i], 1.0f, 1.0f, Vector3f(0.0f, 0.0f, 0.0f), grids[i]);
+	}
+
+	for (bool allowUnsignedByte : { true, false }) {
+		GLTFAsset asset;
+		auto pBuffer = asset.createBuffer();
+		auto pScene = asset.createScene();
+		asset.setMainScene(pScene);
+
+		GLTFMesh* meshes[4];
+		for (size_t i = 0; i < 3; ++i) {
+			meshes[i] = createGridMesh<uint32_t>(asset, pBuffer, grids[i]);
+			pScene->addNode(asset.createMeshNode(meshes[i]));
+		}
+		meshes[3] = createGridMesh<uint16_t>(asset, pBuffer, grids[0]);
+		pScene->addNode(asset.createMeshNode(meshes[3]));
+
+		const json extras = { { "source", "grid" } };
+		const_cast<GLTFAccessor*>(meshes[0]->primitives()[0].indices())->setExtras(extras);
+
+		size_t narrowCount = asset.narrowIndices(allowUnsignedByte);
+		CHECK(narrowCount == (allowUnsignedByte ? 3u : 2u));
+		CHECK(meshes[0]->primitives()[0].indices()->extras() == extras);
+
+		GLTFAccessorComponent smallType = allowUnsignedByte
+			? GLTFAccessorComponent::UNSIGNED_BYTE : GLTFAccessorComponent::UNSIGNED_SHORT;
+		const GLTFAccessorComponent::enum_type expected[4] = {
+			smallType, GLTFAccessorComponent::UNSIGNED_SHORT,
+			GLTFAccessorComponent::UNSIGNED_INT, smallType
+		};
+
+		for (size_t i = 0; i < 4; ++i) {
+			const GLTFPrimitive& primitive = meshes[i]->primitives()[0];
+			const grid_t& grid = grids[i < 3 ? i : 0];
+
+			CHECK(primitive.indices()->component() == expected[i]);
+			CHECK(primitive.indices()->elementCount() == grid.indices.size());
+			CHECK(readIndices(primitive) == grid.indices);
+		}
+
+		CHECK(asset.compact());
+		for (size_t i = 0; i < 4; ++i) {
+			CHECK(readIndices(meshes[i]->primitives()[0]) == grids[i < 3 ? i : 0].indices);
+		}
+
+		{
+			GLTFAsset loaded;
+			checkGLBRoundTrip(asset, loaded, "roundtrip_narrow.glb");
+		}
+		std::remove("roundtrip_narrow.glb");
+	}
+}
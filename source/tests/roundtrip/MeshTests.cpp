@@ -0,0 +1,667 @@
+/**
+* glTF Round Trip Tests - Mesh codecs and transformations
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "RoundTripTests.h"
+#include "MeshoptDecoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace flow;
+
+
+namespace
+{
+	/// Encodes vertices with GLTFMeshoptCodec and checks the reference decoder restores them.
+	void _checkVertexCodec(const std::vector<uint8_t>& vertices, size_t vertexCount, size_t vertexSize)
+	{
+		std::vector<uint8_t> encoded(GLTFMeshoptCodec::encodeVertexBufferBound(vertexCount, vertexSize));
+		size_t byteLength = GLTFMeshoptCodec::encodeVertexBuffer(encoded.data(), encoded.size(),
+			vertices.data(), vertexCount, vertexSize);
+
+		if (!CHECK(byteLength > 0 && byteLength <= encoded.size())) {
+			return;
+		}
+
+		std::vector<uint8_t> decoded(vertexCount * vertexSize + 1, 0xcd);
+		CHECK(test::MeshoptDecoder::decodeVertexBuffer(decoded.data(), vertexCount, vertexSize, encoded.data(), byteLength));
+		CHECK(vertexCount == 0 || std::memcmp(decoded.data(), vertices.data(), vertexCount * vertexSize) == 0);
+		CHECK(decoded.back() == 0xcd);
+	}
+
+	/// Encodes a triangle list with GLTFMeshoptCodec and checks the reference decoder restores
+	/// each triangle, possibly rotated, in the original order.
+	void _checkIndexCodec(const std::vector<uint32_t>& indices, size_t vertexCount)
+	{
+		std::vector<uint8_t> encoded(GLTFMeshoptCodec::encodeIndexBufferBound(indices.size(), vertexCount));
+		size_t byteLength = GLTFMeshoptCodec::encodeIndexBuffer(encoded.data(), encoded.size(),
+			indices.data(), indices.size());
+
+		if (!CHECK(byteLength > 0 && byteLength <= encoded.size())) {
+			return;
+		}
+
+		std::vector<uint32_t> decoded(indices.size());
+		CHECK(test::MeshoptDecoder::decodeIndexBuffer(decoded.data(), decoded.size(), encoded.data(), byteLength));
+
+		bool isEqual = true;
+		for (size_t i = 0; i < indices.size() && isEqual; i += 3) {
+			const uint32_t* t = &indices[i];
+			const uint32_t* d = &decoded[i];
+			isEqual = (d[0] == t[0] && d[1] == t[1] && d[2] == t[2])
+				|| (d[0] == t[1] && d[1] == t[2] && d[2] == t[0])
+				|| (d[0] == t[2] && d[1] == t[0] && d[2] == t[1]);
+		}
+		CHECK(isEqual);
+	}
+
+	/// Shuffles the triangles of a list.
+	void _shuffleTriangles(std::vector<uint32_t>& indices, test::Random& random)
+	{
+		size_t triangleCount = indices.size() / 3;
+		for (size_t i = triangleCount; i > 1; --i) {
+			size_t j = random.index(uint32_t(i));
+			for (size_t k = 0; k < 3; ++k) {
+				std::swap(indices[(i - 1) * 3 + k], indices[j * 3 + k]);
+			}
+		}
+	}
+
+	/// Renumbers the vertices of a grid randomly, permuting all attributes.
+	void _shuffleVertices(test::grid_t& grid, test::Random& random)
+	{
+		std::vector<uint32_t> remap(grid.vertexCount);
+		for (size_t i = 0; i < remap.size(); ++i) {
+			remap[i] = uint32_t(i);
+		}
+		for (size_t i = remap.size(); i > 1; --i) {
+			std::swap(remap[i - 1], remap[random.index(uint32_t(i))]);
+		}
+
+		test::grid_t result = grid;
+		for (size_t i = 0; i < grid.vertexCount; ++i) {
+			std::copy_n(&grid.positions[i * 3], 3, &result.positions[remap[i] * 3]);
+			std::copy_n(&grid.normals[i * 3], 3, &result.normals[remap[i] * 3]);
+			std::copy_n(&grid.texCoords[i * 2], 2, &result.texCoords[remap[i] * 2]);
+		}
+		for (size_t i = 0; i < grid.indices.size(); ++i) {
+			result.indices[i] = remap[grid.indices[i]];
+		}
+
+		grid = result;
+	}
+
+	/// Returns 8 floats per vertex: position, normal and texture coordinates.
+	std::vector<float> _vertexAttributes(const std::vector<float>& positions,
+		const std::vector<float>& normals, const std::vector<float>& texCoords)
+	{
+		size_t vertexCount = positions.size() / 3;
+		std::vector<float> result;
+		result.reserve(vertexCount * 8);
+
+		for (size_t i = 0; i < vertexCount; ++i) {
+			result.insert(result.end(), &positions[i * 3], &positions[i * 3] + 3);
+			result.insert(result.end(), &normals[i * 3], &normals[i * 3] + 3);
+			result.insert(result.end(), &texCoords[i * 2], &texCoords[i * 2] + 2);
+		}
+
+		return result;
+	}
+
+	/// Local matrix of a node, translation * rotation * scale as defined by glTF.
+	Matrix4f _localMatrix(const GLTFNode* pNode)
+	{
+		if (pNode->matrix()) {
+			return *pNode->matrix();
+		}
+
+		Matrix4f result;
+		result.makeRotation(pNode->rotation() ? *pNode->rotation() : Quaternion4f(0.0f, 0.0f, 0.0f, 1.0f));
+
+		for (size_t r = 0; r < 3; ++r) {
+			for (size_t c = 0; c < 3; ++c) {
+				result(r, c) = result(r, c) * (pNode->scale() ? (*pNode->scale())[c] : 1.0f);
+			}
+			result(r, 3) = pNode->translation() ? (*pNode->translation())[r] : 0.0f;
+		}
+
+		return result;
+	}
+
+	/// Checks the meshlets of a triangle list: limits, local indices, every triangle exactly
+	/// once, bounding spheres containing all vertices, and normal cones culling only
+	/// meshlets whose triangles all face away from the camera.
+	void _checkMeshlets(const GLTFMeshletBuilder::meshlet_t* pMeshlets, size_t meshletCount,
+		const uint32_t* pVertices, size_t vertexCount, const uint8_t* pTriangles, size_t triangleCount,
+		const std::vector<uint32_t>& indices, const std::vector<float>& positions,
+		size_t maxVertices, size_t maxTriangles)
+	{
+		std::vector<uint32_t> meshletIndices;
+		test::Random random(7);
+
+		for (size_t m = 0; m < meshletCount; ++m) {
+			const GLTFMeshletBuilder::meshlet_t& meshlet = pMeshlets[m];
+
+			CHECK(meshlet.vertexCount > 0 && meshlet.vertexCount <= maxVertices);
+			CHECK(meshlet.triangleCount > 0 && meshlet.triangleCount <= maxTriangles);
+			if (!CHECK(meshlet.vertexOffset + meshlet.vertexCount <= vertexCount
+					&& meshlet.triangleOffset + meshlet.triangleCount <= triangleCount)) {
+				continue;
+			}
+
+			const uint32_t* pMeshletVertices = pVertices + meshlet.vertexOffset;
+			const uint8_t* pMeshletTriangles = pTriangles + meshlet.triangleOffset * 3;
+
+			bool isLocal = true;
+			for (size_t i = 0; i < meshlet.triangleCount * 3; ++i) {
+				isLocal = isLocal && pMeshletTriangles[i] < meshlet.vertexCount;
+				meshletIndices.push_back(pMeshletVertices[pMeshletTriangles[i] % meshlet.vertexCount]);
+			}
+			CHECK(isLocal);
+
+			bool isInside = true;
+			for (size_t i = 0; i < meshlet.vertexCount; ++i) {
+				const float* p = &positions[pMeshletVertices[i] * 3];
+				float dx = p[0] - meshlet.center[0];
+				float dy = p[1] - meshlet.center[1];
+				float dz = p[2] - meshlet.center[2];
+				isInside = isInside && std::sqrt(dx * dx + dy * dy + dz * dz) <= meshlet.radius * 1.0001f + 1e-5f;
+			}
+			CHECK(isInside);
+
+			if (meshlet.coneCutoff >= 1.0f) {
+				continue;
+			}
+
+			bool isConservative = true;
+			for (size_t c = 0; c < 100; ++c) {
+				float camera[3] = { random.uniform(-10.0f, 10.0f), random.uniform(-10.0f, 10.0f), random.uniform(-10.0f, 10.0f) };
+				float apex[3] = { meshlet.coneApex[0] - camera[0], meshlet.coneApex[1] - camera[1], meshlet.coneApex[2] - camera[2] };
+				float length = std::sqrt(apex[0] * apex[0] + apex[1] * apex[1] + apex[2] * apex[2]);
+				float d = (apex[0] * meshlet.coneAxis[0] + apex[1] * meshlet.coneAxis[1] + apex[2] * meshlet.coneAxis[2]) / length;
+				if (d < meshlet.coneCutoff) {
+					continue;
+				}
+
+				// culled: the camera must lie behind every triangle's plane
+				for (size_t t = 0; t < meshlet.triangleCount; ++t) {
+					const float* p0 = &positions[pMeshletVertices[pMeshletTriangles[t * 3 + 0]] * 3];
+					const float* p1 = &positions[pMeshletVertices[pMeshletTriangles[t * 3 + 1]] * 3];
+					const float* p2 = &positions[pMeshletVertices[pMeshletTriangles[t * 3 + 2]] * 3];
+					float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+					float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+					float n[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+					float v[3] = { camera[0] - p0[0], camera[1] - p0[1], camera[2] - p0[2] };
+					float nLength = std::sqrt(n[0] * n[0] + n[1] * n[1] + n[2] * n[2]);
+					float vLength = std::sqrt(v[0] * v[0] + v[1] * v[1] + v[2] * v[2]);
+					isConservative = isConservative && n[0] * v[0] + n[1] * v[1] + n[2] * v[2] <= 1e-4f * nLength * vLength;
+				}
+			}
+			CHECK(isConservative);
+		}
+
+		CHECK(meshletIndices.size() == indices.size());
+
+		std::vector<float> identity(positions.size() / 3);
+		for (size_t i = 0; i < identity.size(); ++i) {
+			identity[i] = float(i);
+		}
+		CHECK(test::canonicalTriangles(meshletIndices, identity, 1) == test::canonicalTriangles(indices, identity, 1));
+	}
+}
+
+void test::testInterleaved()
+{
+	grid_t grid;
+	makeGrid(12, 9, 3.0f, 2.0f, Vector3f(-1.5f, -1.0f, 0.5f), grid);
+
+	// positions and normals interleaved in a single buffer view
+	const size_t byteStride = 6 * sizeof(float);
+	std::vector<float> vertices(grid.vertexCount * 6);
+	for (size_t i = 0; i < grid.vertexCount; ++i) {
+		std::memcpy(&vertices[i * 6], &grid.positions[i * 3], 3 * sizeof(float));
+		std::memcpy(&vertices[i * 6 + 3], &grid.normals[i * 3], 3 * sizeof(float));
+	}
+
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer("data");
+
+	auto pPositions = asset.createAccessor<float>(GLTFAccessorType::VEC3);
+	pPositions->setInterleaved(0, byteStride);
+	pPositions->addData(pBuffer, (const char*)vertices.data(),
+		vertices.size() * sizeof(float), GLTFBufferViewTarget::ARRAY_BUFFER);
+	pPositions->setElementCount(grid.vertexCount);
+
+	auto pNormals = asset.createAccessor<float>(GLTFAccessorType::VEC3);
+	pNormals->setBufferView(pPositions->bufferView(), 3 * sizeof(float));
+	pNormals->setInterleaved(3 * sizeof(float), byteStride);
+	pNormals->setElementCount(grid.vertexCount);
+
+	auto pIndices = asset.createAccessor<uint32_t>(GLTFAccessorType::SCALAR);
+	pIndices->addIndexData(pBuffer, grid.indices.data(), grid.indices.size());
+
+	pPositions->updateBounds();
+	pNormals->updateBounds();
+	pIndices->updateBounds();
+
+	CHECK(pPositions->bufferView()->byteStride() == byteStride);
+
+	auto pMesh = asset.createMesh();
+	auto& primitive = pMesh->createPrimitive(GLTFPrimitiveMode::TRIANGLES);
+	primitive.addPositions(pPositions);
+	primitive.addNormals(pNormals);
+	primitive.setIndices(pIndices);
+
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(pMesh));
+	asset.setMainScene(pScene);
+
+	{
+		GLTFAsset loaded;
+		checkGLBRoundTrip(asset, loaded, "roundtrip_interleaved.glb");
+
+		// the stride is written with the buffer view, elements come back unchanged
+		const json document = loaded.toJSON();
+		const json& view = document["bufferViews"][0];
+		CHECK(view.value("byteStride", size_t(0)) == byteStride);
+
+		// accessors keep their creation order: positions, normals
+		for (size_t a = 0; a < 2; ++a) {
+			const json& accessor = document["accessors"][a];
+			if (!CHECK(accessor["bufferView"] == 0 && accessor["count"] == grid.vertexCount)) {
+				continue;
+			}
+
+			size_t byteOffset = view.value("byteOffset", size_t(0)) + accessor.value("byteOffset", size_t(0));
+			const char* pData = loaded.buffers()[0]->data(byteOffset);
+			std::vector<float> values(grid.vertexCount * 3);
+			for (size_t i = 0; pData && i < grid.vertexCount; ++i) {
+				std::memcpy(&values[i * 3], pData + i * byteStride, 3 * sizeof(float));
+			}
+
+			CHECK(values == (a == 0 ? grid.positions : grid.normals));
+		}
+	}
+
+	std::remove("roundtrip_interleaved.glb");
+}
+
+void test::testMeshoptCodec()
+{
+	Random random(11);
+
+	// smooth, random and constant data across block and byte group boundaries
+	const size_t vertexSizes[] = { 4, 8, 12, 16, 20, 32, 64, 100, 256 };
+	const size_t vertexCounts[] = { 0, 1, 2, 15, 16, 17, 255, 256, 257, 1000 };
+
+	for (size_t vertexSize : vertexSizes) {
+		for (size_t vertexCount : vertexCounts) {
+			std::vector<uint8_t> smooth(vertexCount * vertexSize);
+			std::vector<uint8_t> noise(vertexCount * vertexSize);
+			std::vector<uint8_t> constant(vertexCount * vertexSize, 0x5a);
+
+			for (size_t i = 0; i < vertexCount; ++i) {
+				for (size_t k = 0; k < vertexSize; k += 4) {
+					float value = std::sin(float(i) * 0.01f + float(k)) * 100.0f;
+					std::memcpy(&smooth[i * vertexSize + k], &value, 4);
+				}
+			}
+			for (uint8_t& value : noise) {
+				value = uint8_t(random.next() >> 24);
+			}
+
+			_checkVertexCodec(smooth, vertexCount, vertexSize);
+			_checkVertexCodec(noise, vertexCount, vertexSize);
+			_checkVertexCodec(constant, vertexCount, vertexSize);
+		}
+	}
+
+	grid_t grid;
+	makeGrid(60, 40, 1.0f, 1.0f, Vector3f(0.0f, 0.0f, 0.0f), grid);
+
+	// vertex data of a mesh
+	std::vector<uint8_t> positions(grid.vertexCount * 12);
+	std::memcpy(positions.data(), grid.positions.data(), positions.size());
+	_checkVertexCodec(positions, grid.vertexCount, 12);
+
+	// cache friendly, shuffled and random triangles
+	std::vector<uint32_t> indices = grid.indices;
+	_checkIndexCodec(indices, grid.vertexCount);
+
+	_shuffleTriangles(indices, random);
+	_checkIndexCodec(indices, grid.vertexCount);
+
+	std::vector<uint32_t> randomIndices(3000);
+	for (uint32_t& index : randomIndices) {
+		index = random.index(100000);
+	}
+	_checkIndexCodec(randomIndices, 100000);
+
+	// consecutive meshes each starting at vertex 0 restart the sequence of new vertices
+	std::vector<uint32_t> concatenated;
+	for (size_t i = 0; i < 3; ++i) {
+		concatenated.insert(concatenated.end(), grid.indices.begin(), grid.indices.end());
+	}
+	_checkIndexCodec(concatenated, grid.vertexCount);
+
+	std::vector<uint32_t> empty;
+	_checkIndexCodec(empty, 0);
+
+	// too small result buffers are rejected
+	uint8_t small[8];
+	CHECK(GLTFMeshoptCodec::encodeVertexBuffer(small, sizeof(small), positions.data(), grid.vertexCount, 12) == 0);
+	CHECK(GLTFMeshoptCodec::encodeIndexBuffer(small, sizeof(small), grid.indices.data(), grid.indices.size()) == 0);
+}
+
+void test::testQuantizer()
+{
+	grid_t grid, otherGrid;
+	makeGrid(50, 30, 10.0f, 6.0f, Vector3f(10.0f, -20.0f, 4.0f), grid);
+	makeGrid(10, 10, 1.0f, 1.0f, Vector3f(-0.5f, -0.5f, 0.0f), otherGrid);
+
+	float halfExtent = 0.0f;
+	for (size_t j = 0; j < 3; ++j) {
+		float lower = grid.positions[j], upper = grid.positions[j];
+		for (size_t i = 0; i < grid.vertexCount; ++i) {
+			lower = std::min(lower, grid.positions[i * 3 + j]);
+			upper = std::max(upper, grid.positions[i * 3 + j]);
+		}
+		halfExtent = std::max(halfExtent, 0.5f * (upper - lower));
+	}
+
+	for (bool isHighPrecision : { false, true }) {
+		GLTFAsset asset;
+		auto pBuffer = asset.createBuffer();
+		auto pMesh = createGridMesh<uint32_t>(asset, pBuffer, grid);
+		auto pOtherMesh = createGridMesh<uint32_t>(asset, pBuffer, otherGrid);
+
+		// two instances of the mesh, positions of the other mesh stay float as its node has a child
+		const float scale = 2.0f;
+		auto pNodeA = asset.createMeshNode(pMesh);
+		pNodeA->setTRS(Vector3f(5.0f, -3.0f, 2.0f), Quaternion4f(0.0f, 0.6f, 0.0f, 0.8f), Vector3f(scale, scale, scale));
+		auto pNodeB = asset.createMeshNode(pMesh);
+		Matrix4f matrix;
+		matrix.makeRotation(Quaternion4f(0.48f, 0.0f, 0.6f, 0.64f));
+		matrix *= scale;
+		matrix(0, 3) = -1.0f;
+		matrix(1, 3) = 7.0f;
+		matrix(2, 3) = 0.5f;
+		matrix(3, 3) = 1.0f;
+		pNodeB->setMatrix(matrix);
+		auto pOtherNode = asset.createMeshNode(pOtherMesh);
+		pOtherNode->addChild(asset.createNode());
+
+		auto pScene = asset.createScene();
+		pScene->addNode(pNodeA);
+		pScene->addNode(pNodeB);
+		pScene->addNode(pOtherNode);
+		asset.setMainScene(pScene);
+
+		const Matrix4f worldBefore[2] = { _localMatrix(pNodeA), _localMatrix(pNodeB) };
+
+		GLTFMeshQuantizer quantizer(&asset);
+		quantizer.setHighPrecisionNormals(isHighPrecision);
+		CHECK(quantizer.quantize(pBuffer));
+		CHECK(quantizer.accessorCount() == 5);
+		CHECK(quantizer.resultByteLength() < quantizer.sourceByteLength());
+
+		const GLTFPrimitive& primitive = pMesh->primitives()[0];
+		const GLTFPrimitive& otherPrimitive = pOtherMesh->primitives()[0];
+		const GLTFAccessorComponent::enum_type normalType = isHighPrecision
+			? GLTFAccessorComponent::SHORT : GLTFAccessorComponent::BYTE;
+
+		CHECK(primitive.attributeAccessor(GLTFAttributeType::POSITION)->component() == GLTFAccessorComponent::SHORT);
+		CHECK(primitive.attributeAccessor(GLTFAttributeType::NORMAL)->component() == normalType);
+		CHECK(primitive.attributeAccessor(GLTFAttributeType::TEXCOORD_0)->component() == GLTFAccessorComponent::UNSIGNED_SHORT);
+		CHECK(otherPrimitive.attributeAccessor(GLTFAttributeType::POSITION)->component() == GLTFAccessorComponent::FLOAT);
+		CHECK(otherPrimitive.attributeAccessor(GLTFAttributeType::NORMAL)->component() == normalType);
+
+		json document = asset.toJSON();
+		CHECK(document["extensionsRequired"].size() == 1
+			&& document["extensionsRequired"][0] == "KHR_mesh_quantization");
+
+		// dequantized world positions differ from the original ones by at most half a
+		// quantization step per component, plus float rounding
+		const Matrix4f worldAfter[2] = { _localMatrix(pNodeA), _localMatrix(pNodeB) };
+
+		std::vector<float> positions = readAttribute<3>(primitive, GLTFAttributeType::POSITION);
+		CHECK(positions.size() == grid.positions.size());
+		if (positions.size() == grid.positions.size()) {
+			double tolerance = std::sqrt(3.0) * 0.5 * scale * halfExtent / 32767.0 + 2e-5;
+			double maxError = 0.0;
+
+			for (size_t n = 0; n < 2; ++n) {
+				for (size_t i = 0; i < grid.vertexCount; ++i) {
+					double error = 0.0;
+					for (size_t r = 0; r < 3; ++r) {
+						double before = worldBefore[n](r, 3), after = worldAfter[n](r, 3);
+						for (size_t c = 0; c < 3; ++c) {
+							before += double(worldBefore[n](r, c)) * grid.positions[i * 3 + c];
+							after += double(worldAfter[n](r, c)) * positions[i * 3 + c];
+						}
+						error += (after - before) * (after - before);
+					}
+					maxError = std::max(maxError, std::sqrt(error));
+				}
+			}
+
+			CHECK(maxError <= tolerance);
+		}
+
+		// normals and texture coordinates are quantized in place
+		const std::vector<float> normals[2] = {
+			readAttribute<3>(primitive, GLTFAttributeType::NORMAL),
+			readAttribute<3>(otherPrimitive, GLTFAttributeType::NORMAL)
+		};
+		const std::vector<float> texCoords[2] = {
+			readAttribute<2>(primitive, GLTFAttributeType::TEXCOORD_0),
+			readAttribute<2>(otherPrimitive, GLTFAttributeType::TEXCOORD_0)
+		};
+
+		const float normalTolerance = 0.5f / (isHighPrecision ? 32767.0f : 127.0f) + 1e-6f;
+		const float texCoordTolerance = 0.5f / 65535.0f + 1e-7f;
+
+		for (size_t m = 0; m < 2; ++m) {
+			const grid_t& source = m == 0 ? grid : otherGrid;
+			if (!CHECK(normals[m].size() == source.normals.size() && texCoords[m].size() == source.texCoords.size())) {
+				continue;
+			}
+
+			float normalError = 0.0f, texCoordError = 0.0f;
+			for (size_t i = 0; i < normals[m].size(); ++i) {
+				normalError = std::max(normalError, std::fabs(normals[m][i] - source.normals[i]));
+			}
+			for (size_t i = 0; i < texCoords[m].size(); ++i) {
+				texCoordError = std::max(texCoordError, std::fabs(texCoords[m][i] - source.texCoords[i]));
+			}
+
+			CHECK(normalError <= normalTolerance);
+			CHECK(texCoordError <= texCoordTolerance);
+		}
+
+		CHECK(readIndices(primitive) == grid.indices);
+
+		// quantized data survives saving and loading
+		CHECK(asset.compact());
+		CHECK(readAttribute<3>(primitive, GLTFAttributeType::POSITION) == positions);
+
+		{
+			GLTFAsset loaded;
+			checkGLBRoundTrip(asset, loaded, "roundtrip_quantized.glb");
+		}
+		std::remove("roundtrip_quantized.glb");
+	}
+
+	// primitives with extensions like Draco describe their current data and stay unchanged
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer();
+	auto pMesh = createGridMesh<uint32_t>(asset, pBuffer, otherGrid);
+	GLTFPrimitive& primitive = pMesh->primitives()[0];
+	primitive.addExtension(asset.createExtension<GLTFGenericExtension>("KHR_draco_mesh_compression"));
+
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(pMesh));
+	pScene->addNode(asset.createMeshNode(pMesh));
+	asset.setMainScene(pScene);
+
+	GLTFMeshQuantizer quantizer(&asset);
+	CHECK(quantizer.quantize(pBuffer));
+	CHECK(quantizer.accessorCount() == 0);
+	CHECK(primitive.attributeAccessor(GLTFAttributeType::POSITION)->component() == GLTFAccessorComponent::FLOAT);
+	CHECK(primitive.attributeAccessor(GLTFAttributeType::NORMAL)->component() == GLTFAccessorComponent::FLOAT);
+	CHECK(readAttribute<3>(primitive, GLTFAttributeType::POSITION) == otherGrid.positions);
+	CHECK(!pScene->nodes()[0]->matrix() && !pScene->nodes()[0]->scale());
+}
+
+void test::testOptimizer()
+{
+	Random random(5);
+
+	grid_t grid;
+	makeGrid(40, 40, 4.0f, 4.0f, Vector3f(-2.0f, -2.0f, 0.0f), grid);
+	_shuffleVertices(grid, random);
+	_shuffleTriangles(grid.indices, random);
+
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer();
+	auto pMesh = createGridMesh<uint32_t>(asset, pBuffer, grid);
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(pMesh));
+	asset.setMainScene(pScene);
+
+	GLTFMeshOptimizer::cacheStats_t stats = GLTFMeshOptimizer::analyzeVertexCache(
+		grid.indices.data(), grid.indices.size(), grid.vertexCount);
+
+	GLTFMeshOptimizer optimizer(&asset);
+	CHECK(optimizer.optimize(pBuffer));
+	CHECK(optimizer.primitiveCount() == 1);
+	CHECK(optimizer.statsBefore().missCount == stats.missCount);
+	CHECK(optimizer.statsAfter().acmr < optimizer.statsBefore().acmr);
+
+	const GLTFPrimitive& primitive = pMesh->primitives()[0];
+	std::vector<uint32_t> indices = readIndices(primitive);
+	std::vector<float> vertices = _vertexAttributes(
+		readAttribute<3>(primitive, GLTFAttributeType::POSITION),
+		readAttribute<3>(primitive, GLTFAttributeType::NORMAL),
+		readAttribute<2>(primitive, GLTFAttributeType::TEXCOORD_0));
+
+	if (!CHECK(indices.size() == grid.indices.size() && vertices.size() == grid.vertexCount * 8)) {
+		return;
+	}
+
+	// the same triangles over the same vertices, only reordered
+	std::vector<float> sourceVertices = _vertexAttributes(grid.positions, grid.normals, grid.texCoords);
+	CHECK(canonicalTriangles(indices, vertices, 8) == canonicalTriangles(grid.indices, sourceVertices, 8));
+
+	GLTFMeshOptimizer::cacheStats_t result = GLTFMeshOptimizer::analyzeVertexCache(
+		indices.data(), indices.size(), grid.vertexCount);
+	CHECK(result.missCount == optimizer.statsAfter().missCount);
+
+	// vertices are numbered in the order of first use
+	uint32_t next = 0;
+	bool isSequential = true;
+	for (uint32_t index : indices) {
+		isSequential = isSequential && index <= next;
+		next = std::max(next, index + 1);
+	}
+	CHECK(isSequential);
+
+	CHECK(asset.compact());
+	CHECK(readIndices(primitive) == indices);
+
+	{
+		GLTFAsset loaded;
+		checkGLBRoundTrip(asset, loaded, "roundtrip_optimized.glb");
+	}
+	std::remove("roundtrip_optimized.glb");
+
+	// primitives with extensions like Draco describe their current data and stay unchanged
+	GLTFAsset extensionAsset;
+	auto pExtensionBuffer = extensionAsset.createBuffer();
+	auto pExtensionMesh = createGridMesh<uint32_t>(extensionAsset, pExtensionBuffer, grid);
+	GLTFPrimitive& extensionPrimitive = pExtensionMesh->primitives()[0];
+	extensionPrimitive.addExtension(extensionAsset.createExtension<GLTFGenericExtension>("KHR_draco_mesh_compression"));
+
+	GLTFMeshOptimizer extensionOptimizer(&extensionAsset);
+	CHECK(extensionOptimizer.optimize(pExtensionBuffer));
+	CHECK(extensionOptimizer.primitiveCount() == 0);
+	CHECK(readIndices(extensionPrimitive) == grid.indices);
+	CHECK(readAttribute<3>(extensionPrimitive, GLTFAttributeType::POSITION) == grid.positions);
+}
+
+void test::testMeshlets()
+{
+	grid_t grid;
+	makeGrid(50, 50, 5.0f, 5.0f, Vector3f(-2.5f, -2.5f, 0.0f), grid);
+
+	const size_t limits[][2] = { { 64, 124 }, { 128, 256 }, { 256, 512 }, { 3, 1 }, { 16, 8 } };
+
+	for (const auto& limit : limits) {
+		GLTFMeshletBuilder::meshletVec_t meshlets;
+		std::vector<uint32_t> vertices;
+		std::vector<uint8_t> triangles;
+
+		GLTFMeshletBuilder::buildMeshlets(grid.indices.data(), grid.indices.size(), grid.vertexCount,
+			limit[0], limit[1], meshlets, vertices, triangles);
+
+		for (auto& meshlet : meshlets) {
+			GLTFMeshletBuilder::computeBounds(meshlet, vertices.data(), triangles.data(), grid.positions.data());
+		}
+
+		_checkMeshlets(meshlets.data(), meshlets.size(), vertices.data(), vertices.size(),
+			triangles.data(), triangles.size() / 3, grid.indices, grid.positions, limit[0], limit[1]);
+	}
+
+	// meshlets stored with the asset
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer();
+	auto pMesh = createGridMesh<uint16_t>(asset, pBuffer, grid);
+	auto pScene = asset.createScene();
+	pScene->addNode(asset.createMeshNode(pMesh));
+	asset.setMainScene(pScene);
+
+	GLTFMeshletBuilder builder(&asset);
+	builder.setLimits(64, 124);
+	CHECK(builder.build(pBuffer));
+	CHECK(builder.primitiveCount() == 1);
+	CHECK(asset.compact());
+
+	const GLTFPrimitive& primitive = pMesh->primitives()[0];
+	if (!CHECK(primitive.extensions().size() == 1)) {
+		return;
+	}
+
+	auto pExtension = dynamic_cast<const GLTFMeshletExtension*>(primitive.extensions()[0]);
+	if (!CHECK(pExtension && pExtension->bufferView() && pExtension->bufferView()->data())) {
+		return;
+	}
+
+	CHECK(pExtension->meshletCount() == builder.meshletCount());
+	CHECK(pExtension->maxVertices() == 64 && pExtension->maxTriangles() == 124);
+
+	const char* pData = pExtension->bufferView()->data();
+	_checkMeshlets((const GLTFMeshletBuilder::meshlet_t*)pData, pExtension->meshletCount(),
+		(const uint32_t*)(pData + pExtension->vertexByteOffset()), pExtension->vertexCount(),
+		(const uint8_t*)(pData + pExtension->triangleByteOffset()), pExtension->triangleCount(),
+		grid.indices, grid.positions, 64, 124);
+
+	// primitives with meshlets are neither optimized nor quantized, as this would invalidate them
+	GLTFMeshOptimizer optimizer(&asset);
+	CHECK(optimizer.optimize(pBuffer));
+	CHECK(optimizer.primitiveCount() == 0);
+	GLTFMeshQuantizer quantizer(&asset);
+	CHECK(quantizer.quantize(pBuffer));
+	CHECK(quantizer.accessorCount() == 0);
+
+	{
+		GLTFAsset loaded;
+		checkGLBRoundTrip(asset, loaded, "roundtrip_meshlets.glb");
+	}
+	std::remove("roundtrip_meshlets.glb");
+}
@@ -0,0 +1,254 @@
+/**
+* glTF Round Trip Tests
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "MeshoptDecoder.h"
+
+#include <vector>
+#include <cstring>
+
+using namespace flow;
+
+
+namespace
+{
+	// reads bytes front to back, reading past the end sets the error flag
+	struct reader_t
+	{
+		const uint8_t* pData;
+		const uint8_t* pEnd;
+		bool failed;
+
+		uint8_t byte()
+		{
+			if (pData >= pEnd) {
+				failed = true;
+				return 0;
+			}
+			return *pData++;
+		}
+
+		uint32_t vbyte()
+		{
+			uint32_t result = 0;
+			for (int shift = 0; shift < 35; shift += 7) {
+				uint8_t group = byte();
+				result |= uint32_t(group & 127) << shift;
+				if (!(group & 128)) {
+					break;
+				}
+			}
+			return result;
+		}
+	};
+
+	uint32_t _decodeIndex(reader_t& data, uint32_t last)
+	{
+		uint32_t v = data.vbyte();
+		uint32_t d = (v >> 1) ^ (0u - (v & 1));
+		return last + d;
+	}
+
+	void _decodeGroup(reader_t& data, int mode, uint8_t* pGroup)
+	{
+		if (mode == 0) {
+			std::memset(pGroup, 0, 16);
+			return;
+		}
+		if (mode == 3) {
+			for (size_t i = 0; i < 16; ++i) {
+				pGroup[i] = data.byte();
+			}
+			return;
+		}
+
+		// 2 or 4 bits per value, the first value in the high bits of each byte;
+		// values equal to the sentinel follow as full bytes
+		int bits = mode == 1 ? 2 : 4;
+		size_t perByte = 8 / bits;
+		uint8_t sentinel = uint8_t((1 << bits) - 1);
+
+		for (size_t i = 0; i < 16; i += perByte) {
+			uint8_t byte = data.byte();
+			for (size_t k = 0; k < perByte; ++k) {
+				pGroup[i + k] = uint8_t(byte >> (8 - bits * (k + 1))) & sentinel;
+			}
+		}
+		for (size_t i = 0; i < 16; ++i) {
+			if (pGroup[i] == sentinel) {
+				pGroup[i] = data.byte();
+			}
+		}
+	}
+}
+
+bool test::MeshoptDecoder::decodeVertexBuffer(uint8_t* pResult, size_t vertexCount, size_t vertexSize,
+	const uint8_t* pData, size_t byteLength)
+{
+	size_t tailSize = vertexSize < 32 ? 32 : vertexSize;
+	if (vertexSize == 0 || vertexSize > 256 || vertexSize % 4 != 0 || byteLength < 1 + tailSize) {
+		return false;
+	}
+	if (pData[0] != 0xa0) {
+		return false;
+	}
+
+	reader_t data = { pData + 1, pData + byteLength - tailSize, false };
+
+	std::vector<uint8_t> lastVertex(pData + byteLength - vertexSize, pData + byteLength);
+
+	size_t blockSize = (8192 / vertexSize) & ~size_t(15);
+	if (blockSize > 256) {
+		blockSize = 256;
+	}
+
+	std::vector<uint8_t> buffer(blockSize);
+
+	for (size_t offset = 0; offset < vertexCount; offset += blockSize) {
+		size_t count = vertexCount - offset < blockSize ? vertexCount - offset : blockSize;
+		size_t groupCount = (count + 15) / 16;
+		size_t headerSize = (groupCount + 3) / 4;
+
+		for (size_t k = 0; k < vertexSize; ++k) {
+			std::vector<uint8_t> header(headerSize);
+			for (size_t i = 0; i < headerSize; ++i) {
+				header[i] = data.byte();
+			}
+
+			for (size_t group = 0; group < groupCount; ++group) {
+				int mode = (header[group / 4] >> ((group % 4) * 2)) & 3;
+				_decodeGroup(data, mode, &buffer[group * 16]);
+			}
+
+			uint8_t previous = lastVertex[k];
+			for (size_t i = 0; i < count; ++i) {
+				uint8_t v = buffer[i];
+				uint8_t delta = uint8_t((v >> 1) ^ (0u - (v & 1)));
+				previous = uint8_t(previous + delta);
+				pResult[(offset + i) * vertexSize + k] = previous;
+			}
+		}
+
+		std::memcpy(lastVertex.data(), pResult + (offset + count - 1) * vertexSize, vertexSize);
+	}
+
+	return !data.failed && data.pData == data.pEnd;
+}
+
+bool test::MeshoptDecoder::decodeIndexBuffer(uint32_t* pResult, size_t indexCount,
+	const uint8_t* pData, size_t byteLength)
+{
+	size_t triangleCount = indexCount / 3;
+	if (indexCount % 3 != 0 || byteLength < 1 + triangleCount + 16) {
+		return false;
+	}
+	if (pData[0] != 0xe1) {
+		return false;
+	}
+
+	const uint8_t* pCode = pData + 1;
+	const uint8_t* pCodeAuxTable = pData + byteLength - 16;
+	reader_t data = { pCode + triangleCount, pCodeAuxTable, false };
+
+	uint32_t edgeFifo[16][2];
+	uint32_t vertexFifo[16];
+	std::memset(edgeFifo, 0, sizeof(edgeFifo));
+	std::memset(vertexFifo, 0, sizeof(vertexFifo));
+	size_t edgeOffset = 0;
+	size_t vertexOffset = 0;
+
+	uint32_t next = 0;
+	uint32_t last = 0;
+
+	auto pushEdge = [&](uint32_t a, uint32_t b) {
+		edgeFifo[edgeOffset][0] = a;
+		edgeFifo[edgeOffset][1] = b;
+		edgeOffset = (edgeOffset + 1) & 15;
+	};
+	auto pushVertex = [&](uint32_t v, bool condition) {
+		if (condition) {
+			vertexFifo[vertexOffset] = v;
+			vertexOffset = (vertexOffset + 1) & 15;
+		}
+	};
+
+	for (size_t i = 0; i < triangleCount; ++i) {
+		uint8_t code = pCode[i];
+		uint32_t a, b, c;
+
+		if (code < 0xf0) {
+			// edge from the fifo, third vertex from the vertex fifo, new or explicit
+			int fe = code >> 4;
+			a = edgeFifo[(edgeOffset - 1 - fe) & 15][0];
+			b = edgeFifo[(edgeOffset - 1 - fe) & 15][1];
+
+			int fec = code & 15;
+			if (fec < 13) {
+				c = fec == 0 ? next++ : vertexFifo[(vertexOffset - 1 - fec) & 15];
+				pushVertex(c, fec == 0);
+			}
+			else {
+				// 13 and 14 are the last explicit index -1 and +1
+				c = fec == 15 ? _decodeIndex(data, last) : (fec == 13 ? last - 1 : last + 1);
+				last = c;
+				pushVertex(c, true);
+			}
+
+			pushEdge(c, b);
+			pushEdge(a, c);
+		}
+		else {
+			int fea, feb, fec;
+			if (code < 0xfe) {
+				uint8_t codeAux = pCodeAuxTable[code & 15];
+				fea = 0;
+				feb = codeAux >> 4;
+				fec = codeAux & 15;
+			}
+			else {
+				uint8_t codeAux = data.byte();
+				fea = code == 0xfe ? 0 : 15;
+				feb = codeAux >> 4;
+				fec = codeAux & 15;
+				if (codeAux == 0) {
+					next = 0;
+				}
+			}
+
+			// vertex fifo references are relative to the state before this triangle
+			uint32_t fifoB = vertexFifo[(vertexOffset - feb) & 15];
+			uint32_t fifoC = vertexFifo[(vertexOffset - fec) & 15];
+
+			a = fea == 0 ? next++ : 0;
+			b = feb == 0 ? next++ : fifoB;
+			c = fec == 0 ? next++ : fifoC;
+
+			if (fea == 15) {
+				last = a = _decodeIndex(data, last);
+			}
+			if (feb == 15) {
+				last = b = _decodeIndex(data, last);
+			}
+			if (fec == 15) {
+				last = c = _decodeIndex(data, last);
+			}
+
+			pushVertex(a, true);
+			pushVertex(b, feb == 0 || feb == 15);
+			pushVertex(c, fec == 0 || fec == 15);
+
+			pushEdge(b, a);
+			pushEdge(c, b);
+			pushEdge(a, c);
+		}
+
+		pResult[i * 3 + 0] = a;
+		pResult[i * 3 + 1] = b;
+		pResult[i * 3 + 2] = c;
+	}
+
+	return !data.failed && data.pData == data.pEnd;
+}
@@ -0,0 +1,36 @@
+/**
+* glTF Round Trip Tests
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_TESTS_MESHOPTDECODER_H
+#define _FLOWLIBS_TESTS_MESHOPTDECODER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace flow
+{
+	namespace test
+	{
+		/// Straightforward decoders for the EXT_meshopt_compression bitstreams, written after
+		/// the extension specification independently of GLTFMeshoptCodec to verify its output.
+		/// Each function returns false if the data is malformed or not consumed exactly.
+		class MeshoptDecoder
+		{
+		public:
+			MeshoptDecoder() = delete;
+
+			/// Decodes vertexCount vertices of vertexSize bytes, attribute codec version 0.
+			static bool decodeVertexBuffer(uint8_t* pResult, size_t vertexCount, size_t vertexSize,
+				const uint8_t* pData, size_t byteLength);
+			/// Decodes a triangle list, triangle codec version 1.
+			static bool decodeIndexBuffer(uint32_t* pResult, size_t indexCount,
+				const uint8_t* pData, size_t byteLength);
+		};
+	}
+}
+
+#endif // _FLOWLIBS_TESTS_MESHOPTDECODER_H
@@ -0,0 +1,164 @@
+/**
+* glTF Round Trip Tests
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#ifndef _FLOWLIBS_TESTS_ROUNDTRIPTESTS_H
+#define _FLOWLIBS_TESTS_ROUNDTRIPTESTS_H
+
+#include "gltf/gltf.h"
+#include "gltf/GLTFMeshoptCodec.h"
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+/// Records a failed condition with its location, execution continues.
+#define CHECK(condition) flow::test::check((condition), #condition, __FILE__, __LINE__)
+
+namespace flow
+{
+	namespace test
+	{
+		/// Returns condition. Prints the expression and its location if it is false.
+		bool check(bool condition, const char* pExpression, const char* pFile, int line);
+		/// Number of failed checks so far.
+		size_t failureCount();
+
+		/// Deterministic pseudo random numbers, xorshift32.
+		class Random
+		{
+		public:
+			Random(uint32_t seed = 2463534242u) : _state(seed) { }
+
+			uint32_t next();
+			/// Returns an integer in [0, count).
+			uint32_t index(uint32_t count) { return next() % count; }
+			/// Returns a float in [min, max].
+			float uniform(float min, float max);
+			/// Returns a random unit quaternion.
+			Quaternion4f rotation();
+
+		private:
+			uint32_t _state;
+		};
+
+		/// Indexed triangle grid in the xy plane with a wave along z.
+		struct grid_t
+		{
+			size_t vertexCount;
+			/// 3 floats per vertex.
+			std::vector<float> positions;
+			/// 3 floats per vertex, unit length.
+			std::vector<float> normals;
+			/// 2 floats per vertex in [0, 1].
+			std::vector<float> texCoords;
+			std::vector<uint32_t> indices;
+		};
+
+		/// Creates a grid of columns x rows quads, spanning the given size and offset by origin.
+		void makeGrid(size_t columns, size_t rows, float sizeX, float sizeY, const Vector3f& origin, grid_t& grid);
+
+		/// Adds a mesh with a single triangle list primitive built from the grid to the asset.
+		/// Positions, normals and texture coordinates are stored in separate buffer views,
+		/// indices as T. Bounds of all accessors are computed.
+		template<typename T>
+		GLTFMesh* createGridMesh(GLTFAsset& asset, GLTFBuffer* pBuffer, const grid_t& grid);
+
+		/// Returns the indices of the primitive as 32 bit values.
+		std::vector<uint32_t> readIndices(const GLTFPrimitive& primitive);
+		/// Returns the given attribute of the primitive as N floats per element.
+		template<size_t N>
+		std::vector<float> readAttribute(const GLTFPrimitive& primitive, GLTFAttributeType type);
+
+		/// Returns the triangles of a list as sorted tuples of attribute values, each triangle
+		/// rotated to start with its smallest corner, so index order and vertex order are ignored.
+		std::vector<std::vector<float>> canonicalTriangles(const std::vector<uint32_t>& indices,
+			const std::vector<float>& attributes, size_t componentCount);
+
+		/// Returns true if both assets have the same JSON document, ignoring the order of object keys.
+		/// If isBinary is set, the name of the first buffer is ignored, as the merged buffer
+		/// of a GLB file's binary chunk has no name.
+		bool equalDocuments(const GLTFAsset& asset, const GLTFAsset& loaded, bool isBinary);
+		/// Saves the asset as GLB and loads it into loaded, checking both have the same document.
+		/// Saving and loading the loaded asset must reproduce it exactly.
+		void checkGLBRoundTrip(GLTFAsset& asset, GLTFAsset& loaded, const std::string& filePath);
+
+		/// Reads a whole file.
+		std::string readFile(const std::string& filePath);
+		/// Writes a whole file.
+		bool writeFile(const std::string& filePath, const std::string& content);
+		/// Writes a GLB file with the given JSON document and no binary chunk.
+		bool writeGLB(const std::string& filePath, const std::string& document);
+
+		void testSaveLoad();
+		void testReaderRollback();
+		void testTextureInfo();
+		void testNumberLocale();
+		void testMergeBuffers();
+		void testSeparateBuffers();
+		void testInterleaved();
+		void testQuantizer();
+		void testMeshoptCodec();
+		void testMeshoptFile();
+		void testDeduplicate();
+		void testOptimizer();
+		void testNarrowIndices();
+		void testMeshlets();
+		void testEvaluator();
+		void testSceneBVH();
+
+		// template implementation
+
+		template<typename T>
+		GLTFMesh* createGridMesh(GLTFAsset& asset, GLTFBuffer* pBuffer, const grid_t& grid)
+		{
+			auto pPositions = asset.createAccessor<float>(GLTFAccessorType::VEC3);
+			pPositions->addVertexData(pBuffer, grid.positions.data(), grid.vertexCount);
+			auto pNormals = asset.createAccessor<float>(GLTFAccessorType::VEC3);
+			pNormals->addVertexData(pBuffer, grid.normals.data(), grid.vertexCount);
+			auto pTexCoords = asset.createAccessor<float>(GLTFAccessorType::VEC2);
+			pTexCoords->addVertexData(pBuffer, grid.texCoords.data(), grid.vertexCount);
+
+			std::vector<T> indices(grid.indices.begin(), grid.indices.end());
+			auto pIndices = asset.createAccessor<T>(GLTFAccessorType::SCALAR);
+			pIndices->addIndexData(pBuffer, indices.data(), indices.size());
+
+			pPositions->updateBounds();
+			pNormals->updateBounds();
+			pTexCoords->updateBounds();
+			pIndices->updateBounds();
+
+			auto pMesh = asset.createMesh();
+			auto& primitive = pMesh->createPrimitive(GLTFPrimitiveMode::TRIANGLES);
+			primitive.addPositions(pPositions);
+			primitive.addNormals(pNormals);
+			primitive.addTexCoords(pTexCoords);
+			primitive.setIndices(pIndices);
+
+			return pMesh;
+		}
+
+		template<size_t N>
+		std::vector<float> readAttribute(const GLTFPrimitive& primitive, GLTFAttributeType type)
+		{
+			std::vector<float> result;
+
+			GLTFAccessorView<float, N> view(primitive.attributeAccessor(type));
+			if (!view.isValid()) {
+				return result;
+			}
+
+			result.resize(view.size() * N);
+			for (size_t i = 0; i < view.size(); ++i) {
+				view.get(i, &result[i * N]);
+			}
+
+			return result;
+		}
+	}
+}
+
+#endif // _FLOWLIBS_TESTS_ROUNDTRIPTESTS_H
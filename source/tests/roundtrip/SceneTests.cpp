@@ -0,0 +1,540 @@
+/**
+* glTF Round Trip Tests - Scene evaluation and culling
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "RoundTripTests.h"
+#include "math/Range3T.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <set>
+
+using namespace flow;
+
+
+namespace
+{
+	/// Affine matrix in double precision, row major, for reference computations.
+	struct matrix_t
+	{
+		double m[3][4];
+	};
+
+	matrix_t _identity()
+	{
+		matrix_t result = { { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 } } };
+		return result;
+	}
+
+	matrix_t _multiply(const matrix_t& lhs, const matrix_t& rhs)
+	{
+		matrix_t result;
+		for (size_t r = 0; r < 3; ++r) {
+			for (size_t c = 0; c < 4; ++c) {
+				result.m[r][c] = lhs.m[r][0] * rhs.m[0][c] + lhs.m[r][1] * rhs.m[1][c] + lhs.m[r][2] * rhs.m[2][c];
+			}
+			result.m[r][3] += lhs.m[r][3];
+		}
+		return result;
+	}
+
+	/// Local matrix of a node, translation * rotation * scale as defined by glTF.
+	matrix_t _localMatrix(const GLTFNode* pNode)
+	{
+		matrix_t result = _identity();
+
+		if (pNode->matrix()) {
+			const Matrix4f& matrix = *pNode->matrix();
+			for (size_t r = 0; r < 3; ++r) {
+				for (size_t c = 0; c < 4; ++c) {
+					result.m[r][c] = matrix(r, c);
+				}
+			}
+			return result;
+		}
+
+		if (const Quaternion4f* pRotation = pNode->rotation()) {
+			double x = pRotation->x, y = pRotation->y, z = pRotation->z, w = pRotation->w;
+			double rotation[3][3] = {
+				{ 1 - 2 * (y * y + z * z), 2 * (x * y - z * w), 2 * (x * z + y * w) },
+				{ 2 * (x * y + z * w), 1 - 2 * (x * x + z * z), 2 * (y * z - x * w) },
+				{ 2 * (x * z - y * w), 2 * (y * z + x * w), 1 - 2 * (x * x + y * y) }
+			};
+			for (size_t r = 0; r < 3; ++r) {
+				for (size_t c = 0; c < 3; ++c) {
+					result.m[r][c] = rotation[r][c];
+				}
+			}
+		}
+		if (const Vector3f* pScale = pNode->scale()) {
+			for (size_t r = 0; r < 3; ++r) {
+				result.m[r][0] *= pScale->x;
+				result.m[r][1] *= pScale->y;
+				result.m[r][2] *= pScale->z;
+			}
+		}
+		if (const Vector3f* pTranslation = pNode->translation()) {
+			result.m[0][3] = pTranslation->x;
+			result.m[1][3] = pTranslation->y;
+			result.m[2][3] = pTranslation->z;
+		}
+
+		return result;
+	}
+
+	/// World matrices of all nodes, computed recursively from the roots.
+	void _worldMatrices(const GLTFNode* pNode, const matrix_t& parent, std::vector<const GLTFNode*>& nodes,
+		std::vector<matrix_t>& matrices)
+	{
+		matrix_t world = _multiply(parent, _localMatrix(pNode));
+		nodes.push_back(pNode);
+		matrices.push_back(world);
+
+		for (const GLTFNode* pChild : pNode->children()) {
+			_worldMatrices(pChild, world, nodes, matrices);
+		}
+	}
+
+	/// Compares the evaluator's world matrices and mesh bounds with a recursive
+	/// double precision reference. Mesh bounds are the bounds of the transformed box.
+	void _checkEvaluator(const GLTFSceneEvaluator& evaluator, const GLTFScene* pScene, const Range3f& meshBounds)
+	{
+		std::vector<const GLTFNode*> nodes;
+		std::vector<matrix_t> matrices;
+		for (const GLTFNode* pRoot : pScene->nodes()) {
+			_worldMatrices(pRoot, _identity(), nodes, matrices);
+		}
+
+		if (!CHECK(evaluator.nodeCount() == nodes.size())) {
+			return;
+		}
+
+		double maxMatrixError = 0.0;
+		double maxBoundsError = 0.0;
+		bool isComplete = true;
+
+		for (size_t i = 0; i < nodes.size(); ++i) {
+			int32_t slot = evaluator.slot(nodes[i]);
+			if (slot < 0) {
+				isComplete = false;
+				continue;
+			}
+
+			const matrix_t& reference = matrices[i];
+			const Matrix4f& world = evaluator.worldMatrix(size_t(slot));
+
+			double magnitude = 1.0;
+			for (size_t r = 0; r < 3; ++r) {
+				for (size_t c = 0; c < 4; ++c) {
+					magnitude = std::max(magnitude, std::fabs(reference.m[r][c]));
+				}
+			}
+			for (size_t r = 0; r < 3; ++r) {
+				for (size_t c = 0; c < 4; ++c) {
+					maxMatrixError = std::max(maxMatrixError, std::fabs(world(r, c) - reference.m[r][c]) / magnitude);
+				}
+			}
+			isComplete = isComplete && world(3, 0) == 0.0f && world(3, 1) == 0.0f
+				&& world(3, 2) == 0.0f && world(3, 3) == 1.0f;
+
+			if (!dynamic_cast<const GLTFMeshNode*>(nodes[i])) {
+				isComplete = isComplete && !evaluator.worldBounds(size_t(slot)).isValid();
+				continue;
+			}
+
+			double lower[3], upper[3];
+			for (size_t r = 0; r < 3; ++r) {
+				lower[r] = upper[r] = reference.m[r][3];
+				for (size_t c = 0; c < 3; ++c) {
+					double a = reference.m[r][c] * meshBounds.lowerBound()[c];
+					double b = reference.m[r][c] * meshBounds.upperBound()[c];
+					lower[r] += std::min(a, b);
+					upper[r] += std::max(a, b);
+				}
+			}
+
+			const Range3f& bounds = evaluator.worldBounds(size_t(slot));
+			for (size_t r = 0; r < 3; ++r) {
+				maxBoundsError = std::max(maxBoundsError, std::fabs(bounds.lowerBound()[r] - lower[r]) / magnitude);
+				maxBoundsError = std::max(maxBoundsError, std::fabs(bounds.upperBound()[r] - upper[r]) / magnitude);
+			}
+		}
+
+		CHECK(isComplete);
+		CHECK(maxMatrixError < 1e-4);
+		CHECK(maxBoundsError < 1e-4);
+	}
+
+	/// Adds a mesh node showing a cube with the given bounds.
+	GLTFMesh* _createBoxMesh(GLTFAsset& asset, GLTFBuffer* pBuffer, const Range3f& bounds)
+	{
+		float positions[24];
+		for (size_t i = 0; i < 8; ++i) {
+			positions[i * 3 + 0] = (i & 1) ? bounds.upperBound().x : bounds.lowerBound().x;
+			positions[i * 3 + 1] = (i & 2) ? bounds.upperBound().y : bounds.lowerBound().y;
+			positions[i * 3 + 2] = (i & 4) ? bounds.upperBound().z : bounds.lowerBound().z;
+		}
+		const uint16_t indices[36] = {
+			0, 2, 1, 1, 2, 3, 4, 5, 6, 5, 7, 6, 0, 1, 4, 1, 5, 4,
+			2, 6, 3, 3, 6, 7, 0, 4, 2, 2, 4, 6, 1, 3, 5, 3, 7, 5
+		};
+
+		auto pPositions = asset.createAccessor<float>(GLTFAccessorType::VEC3);
+		pPositions->addVertexData(pBuffer, positions, 8);
+		pPositions->updateBounds();
+		auto pIndices = asset.createAccessor<uint16_t>(GLTFAccessorType::SCALAR);
+		pIndices->addIndexData(pBuffer, indices, 36);
+
+		auto pMesh = asset.createMesh();
+		auto& primitive = pMesh->createPrimitive(GLTFPrimitiveMode::TRIANGLES);
+		primitive.addPositions(pPositions);
+		primitive.setIndices(pIndices);
+		return pMesh;
+	}
+
+	/// Sets a random transform: none, translation only, TRS, or an affine matrix.
+	void _setRandomTransform(GLTFNode* pNode, test::Random& random)
+	{
+		Vector3f translation(random.uniform(-5.0f, 5.0f), random.uniform(-5.0f, 5.0f), random.uniform(-5.0f, 5.0f));
+		Vector3f scale(random.uniform(0.8f, 1.25f), random.uniform(0.8f, 1.25f), random.uniform(0.8f, 1.25f));
+
+		switch (random.index(4)) {
+		case 0:
+			break;
+		case 1:
+			pNode->setTranslation(translation);
+			break;
+		case 2:
+			pNode->setTRS(translation, random.rotation(), scale);
+			break;
+		default: {
+			Matrix4f matrix;
+			matrix.makeRotation(random.rotation());
+			for (size_t r = 0; r < 3; ++r) {
+				for (size_t c = 0; c < 3; ++c) {
+					matrix(r, c) = matrix(r, c) * scale[c] + random.uniform(-0.1f, 0.1f);
+				}
+				matrix(r, 3) = translation[r];
+			}
+			pNode->setMatrix(matrix);
+			break;
+		}
+		}
+	}
+
+	/// Same slab test as the hierarchy, so distances can be compared exactly.
+	float _enterDistance(const Range3f& bounds, const Vector3f& origin, const Vector3f& direction, float maxDistance)
+	{
+		float tMin = 0.0f;
+		float tMax = maxDistance;
+
+		for (size_t i = 0; i < 3; ++i) {
+			float invDirection = 1.0f / direction[i];
+			float t0 = (bounds.lowerBound()[i] - origin[i]) * invDirection;
+			float t1 = (bounds.upperBound()[i] - origin[i]) * invDirection;
+			tMin = std::max(tMin, std::min(t0, t1));
+			tMax = std::min(tMax, std::max(t0, t1));
+		}
+
+		return tMin <= tMax ? tMin : -1.0f;
+	}
+
+	bool _overlaps(const Range3f& a, const Range3f& b)
+	{
+		for (size_t i = 0; i < 3; ++i) {
+			if (a.lowerBound()[i] > b.upperBound()[i] || a.upperBound()[i] < b.lowerBound()[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool _isInsideFrustum(const Range3f& bounds, const Vector4f* pPlanes)
+	{
+		for (size_t i = 0; i < 6; ++i) {
+			const Vector4f& plane = pPlanes[i];
+			float distance = plane.w
+				+ plane.x * (plane.x >= 0.0f ? bounds.upperBound().x : bounds.lowerBound().x)
+				+ plane.y * (plane.y >= 0.0f ? bounds.upperBound().y : bounds.lowerBound().y)
+				+ plane.z * (plane.z >= 0.0f ? bounds.upperBound().z : bounds.lowerBound().z);
+			if (distance < 0.0f) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/// Returns true if both lists hold the same nodes, each node once.
+	bool _isSameSet(const std::vector<const GLTFNode*>& a, const std::vector<const GLTFNode*>& b)
+	{
+		std::set<const GLTFNode*> setA(a.begin(), a.end());
+		std::set<const GLTFNode*> setB(b.begin(), b.end());
+		return setA.size() == a.size() && setB.size() == b.size() && setA == setB;
+	}
+
+	/// Checks that every node's bounds contain its children or items.
+	bool _isNested(const GLTFSceneBVH& bvh, size_t nodeIndex)
+	{
+		const GLTFSceneBVH::node_t& node = bvh.nodes()[nodeIndex];
+		auto contains = [&node](const Range3f& bounds) {
+			for (size_t i = 0; i < 3; ++i) {
+				if (bounds.lowerBound()[i] < node.bounds.lowerBound()[i] || bounds.upperBound()[i] > node.bounds.upperBound()[i]) {
+					return false;
+				}
+			}
+			return true;
+		};
+
+		if (node.left == 0) {
+			bool result = node.count > 0 && node.count <= GLTFSceneBVH::MAX_LEAF_SIZE;
+			for (size_t i = node.first; i < node.first + node.count; ++i) {
+				result = result && contains(bvh.items()[i].bounds);
+			}
+			return result;
+		}
+
+		const GLTFSceneBVH::node_t& left = bvh.nodes()[node.left];
+		const GLTFSceneBVH::node_t& right = bvh.nodes()[node.left + 1];
+		return contains(left.bounds) && contains(right.bounds)
+			&& left.first == node.first && right.first == left.first + left.count
+			&& left.count + right.count == node.count
+			&& _isNested(bvh, node.left) && _isNested(bvh, node.left + 1);
+	}
+}
+
+void test::testEvaluator()
+{
+	Random random(3);
+
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer();
+	const Range3f meshBounds(-1.0f, -0.5f, -0.25f, 1.0f, 0.5f, 0.25f);
+	auto pMesh = _createBoxMesh(asset, pBuffer, meshBounds);
+	auto pScene = asset.createScene();
+	asset.setMainScene(pScene);
+
+	// more nodes than evaluated by a single thread; each node is a root or the child of
+	// a random earlier node, every third node shows the mesh
+	const size_t nodeCount = GLTFSceneEvaluator::PARALLEL_THRESHOLD + 2000;
+	std::vector<GLTFNode*> nodes;
+
+	for (size_t i = 0; i < nodeCount; ++i) {
+		GLTFNode* pNode = (i % 3 == 0) ? asset.createMeshNode(pMesh) : asset.createNode();
+		_setRandomTransform(pNode, random);
+
+		if (i < 20 || random.index(100) == 0) {
+			pScene->addNode(pNode);
+		}
+		else {
+			nodes[random.index(uint32_t(i))]->addChild(pNode);
+		}
+		nodes.push_back(pNode);
+	}
+
+	GLTFSceneEvaluator evaluator;
+	evaluator.setScene(pScene);
+	evaluator.evaluate();
+	_checkEvaluator(evaluator, pScene, meshBounds);
+	CHECK(evaluator.update() == 0);
+
+	// a few changes are updated by the calling thread, many in parallel
+	for (size_t changeCount : { size_t(10), size_t(1000) }) {
+		for (size_t i = 0; i < changeCount; ++i) {
+			GLTFNode* pNode = nodes[random.index(uint32_t(nodeCount))];
+			switch (random.index(3)) {
+			case 0:
+				pNode->setTranslation(Vector3f(random.uniform(-5.0f, 5.0f), random.uniform(-5.0f, 5.0f), random.uniform(-5.0f, 5.0f)));
+				break;
+			case 1:
+				pNode->setRotation(random.rotation());
+				break;
+			default:
+				_setRandomTransform(pNode, random);
+				break;
+			}
+		}
+
+		CHECK(evaluator.update() > 0);
+		_checkEvaluator(evaluator, pScene, meshBounds);
+		CHECK(evaluator.update() == 0);
+	}
+
+	// incremental updates match a full evaluation; the reference takes over tracking the nodes
+	GLTFSceneEvaluator reference;
+	reference.setScene(pScene);
+	reference.evaluate();
+
+	bool isEqual = true;
+	for (size_t slot = 0; slot < evaluator.nodeCount(); ++slot) {
+		const Matrix4f& a = evaluator.worldMatrix(slot);
+		const Matrix4f& b = reference.worldMatrix(slot);
+		for (size_t k = 0; k < 16; ++k) {
+			isEqual = isEqual && std::fabs(a.ptr()[k] - b.ptr()[k]) <= 1e-5f * (1.0f + std::fabs(b.ptr()[k]));
+		}
+	}
+	CHECK(isEqual);
+}
+
+void test::testSceneBVH()
+{
+	Random random(9);
+
+	GLTFAsset asset;
+	auto pBuffer = asset.createBuffer();
+	auto pMesh = _createBoxMesh(asset, pBuffer, Range3f(-1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f));
+	auto pScene = asset.createScene();
+	asset.setMainScene(pScene);
+
+	// enough mesh nodes for a parallel build, and a node without mesh
+	const size_t meshNodeCount = GLTFSceneBVH::PARALLEL_THRESHOLD + 1000;
+	for (size_t i = 0; i < meshNodeCount; ++i) {
+		auto pNode = asset.createMeshNode(pMesh);
+		float scale = random.uniform(0.5f, 3.0f);
+		pNode->setTRS(Vector3f(random.uniform(-100.0f, 100.0f), random.uniform(-100.0f, 100.0f), random.uniform(-100.0f, 100.0f)),
+			random.rotation(), Vector3f(scale, scale, scale));
+		pScene->addNode(pNode);
+	}
+	pScene->addNode(asset.createNode());
+
+	GLTFSceneEvaluator evaluator;
+	evaluator.setScene(pScene);
+	evaluator.evaluate();
+
+	GLTFSceneBVH bvh;
+	bvh.build(evaluator);
+
+	// brute force reference: all mesh nodes with their world bounds
+	std::vector<GLTFSceneBVH::item_t> items;
+	Range3f bounds;
+	bounds.invalidate();
+	for (size_t slot = 0; slot < evaluator.nodeCount(); ++slot) {
+		if (evaluator.worldBounds(slot).isValid()) {
+			items.push_back({ evaluator.worldBounds(slot), evaluator.node(slot) });
+			bounds.include(evaluator.worldBounds(slot).lowerBound());
+			bounds.include(evaluator.worldBounds(slot).upperBound());
+		}
+	}
+
+	CHECK(items.size() == meshNodeCount);
+	if (!CHECK(bvh.items().size() == items.size() && !bvh.nodes().empty())) {
+		return;
+	}
+
+	std::vector<const GLTFNode*> expected, result;
+	for (const auto& item : items) {
+		expected.push_back(item.pNode);
+	}
+	for (const auto& item : bvh.items()) {
+		result.push_back(item.pNode);
+	}
+	CHECK(_isSameSet(result, expected));
+
+	CHECK(bvh.bounds().lowerBound() == bounds.lowerBound() && bvh.bounds().upperBound() == bounds.upperBound());
+	CHECK(bvh.nodes()[0].first == 0 && bvh.nodes()[0].count == items.size());
+	CHECK(_isNested(bvh, 0));
+
+	// ranges intersect if they overlap on all axes, touching ranges included
+	const Range3f unit(0.0f, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+	CHECK(unit.intersects(Range3f(0.5f, 0.5f, 0.5f, 2.0f, 2.0f, 2.0f)));
+	CHECK(unit.intersects(Range3f(1.0f, 1.0f, 1.0f, 2.0f, 2.0f, 2.0f)));
+	CHECK(!unit.intersects(Range3f(2.0f, -1.0f, -1.0f, 3.0f, 0.5f, 0.5f)));
+	CHECK(!unit.intersects(Range3f(-1.0f, -1.0f, 1.5f, 0.5f, 0.5f, 2.0f)));
+
+	// boxes
+	size_t boxHitCount = 0;
+	for (size_t i = 0; i < 200; ++i) {
+		Vector3f center(random.uniform(-120.0f, 120.0f), random.uniform(-120.0f, 120.0f), random.uniform(-120.0f, 120.0f));
+		float size = random.uniform(1.0f, 30.0f);
+		Range3f box(center.x - size, center.y - size, center.z - size, center.x + size, center.y + size, center.z + size);
+
+		expected.clear();
+		for (const auto& item : items) {
+			bool overlaps = _overlaps(item.bounds, box);
+			CHECK(item.bounds.intersects(box) == overlaps);
+			if (overlaps) {
+				expected.push_back(item.pNode);
+			}
+		}
+
+		result.assign(1, nullptr);
+		bvh.queryBox(box, result);
+		CHECK(_isSameSet(result, expected));
+		boxHitCount += expected.size();
+	}
+	CHECK(boxHitCount > 0);
+
+	// rays, some limited in distance, some starting inside a node's bounds
+	size_t rayHitCount = 0;
+	for (size_t i = 0; i < 300; ++i) {
+		Vector3f origin(random.uniform(-150.0f, 150.0f), random.uniform(-150.0f, 150.0f), random.uniform(-150.0f, 150.0f));
+		if (i % 10 == 0) {
+			origin = items[random.index(uint32_t(items.size()))].bounds.center();
+		}
+		Vector3f direction(random.uniform(-2.0f, 2.0f), random.uniform(-2.0f, 2.0f), random.uniform(-2.0f, 2.0f));
+		float maxDistance = (i % 3 == 0) ? random.uniform(1.0f, 100.0f) : std::numeric_limits<float>::max();
+
+		bool isHit = false;
+		float nearest = maxDistance;
+		for (const auto& item : items) {
+			float distance = _enterDistance(item.bounds, origin, direction, maxDistance);
+			if (distance >= 0.0f && (!isHit || distance < nearest)) {
+				isHit = true;
+				nearest = distance;
+			}
+		}
+
+		GLTFSceneBVH::hit_t hit;
+		bool result = bvh.raycast(origin, direction, hit, maxDistance);
+		CHECK(result == isHit);
+
+		if (result && isHit) {
+			CHECK(hit.distance == nearest);
+			const Range3f& hitBounds = evaluator.worldBounds(size_t(evaluator.slot(hit.pNode)));
+			CHECK(_enterDistance(hitBounds, origin, direction, maxDistance) == hit.distance);
+			CHECK(i % 10 != 0 || hit.distance == 0.0f);
+			rayHitCount++;
+		}
+	}
+	CHECK(rayHitCount > 0);
+
+	// frustums of cameras at the origin looking in random directions
+	// right handed perspective projection, vertical field of view 1 radian, aspect 1.5, depth 1 to 200
+	const float focal = 1.0f / std::tan(0.5f), zNear = 1.0f, zFar = 200.0f;
+	Matrix4f projection;
+	projection.setZero();
+	projection(0, 0) = focal / 1.5f;
+	projection(1, 1) = focal;
+	projection(2, 2) = (zFar + zNear) / (zNear - zFar);
+	projection(2, 3) = 2.0f * zFar * zNear / (zNear - zFar);
+	projection(3, 2) = -1.0f;
+
+	Vector4f planes[6];
+	GLTFSceneBVH::frustumPlanes(projection, planes);
+	CHECK(_isInsideFrustum(Range3f(-0.1f, -0.1f, -10.1f, 0.1f, 0.1f, -9.9f), planes));
+	CHECK(!_isInsideFrustum(Range3f(-0.1f, -0.1f, 9.9f, 0.1f, 0.1f, 10.1f), planes));
+	CHECK(!_isInsideFrustum(Range3f(-0.1f, -0.1f, -300.1f, 0.1f, 0.1f, -299.9f), planes));
+
+	size_t frustumHitCount = 0;
+	for (size_t i = 0; i < 20; ++i) {
+		Matrix4f view;
+		view.makeRotation(random.rotation());
+		GLTFSceneBVH::frustumPlanes(projection * view, planes);
+
+		expected.clear();
+		for (const auto& item : items) {
+			if (_isInsideFrustum(item.bounds, planes)) {
+				expected.push_back(item.pNode);
+			}
+		}
+
+		result.assign(1, nullptr);
+		bvh.queryFrustum(planes, 6, result);
+		CHECK(_isSameSet(result, expected));
+		frustumHitCount += expected.size();
+	}
+	CHECK(frustumHitCount > 0);
+}
@@ -0,0 +1,216 @@
+/**
+* glTF Round Trip Tests
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "RoundTripTests.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include <cstdio>
+
+using namespace flow;
+
+
+namespace
+{
+	size_t _failureCount = 0;
+}
+
+bool test::check(bool condition, const char* pExpression, const char* pFile, int line)
+{
+	if (!condition) {
+		_failureCount++;
+		std::cout << "  FAILED: " << pExpression << " (" << pFile << ":" << line << ")" << std::endl;
+	}
+
+	return condition;
+}
+
+size_t test::failureCount()
+{
+	return _failureCount;
+}
+
+uint32_t test::Random::next()
+{
+	_state ^= _state << 13;
+	_state ^= _state >> 17;
+	_state ^= _state << 5;
+	return _state;
+}
+
+float test::Random::uniform(float min, float max)
+{
+	return min + (max - min) * float(next() >> 8) * (1.0f / 16777215.0f);
+}
+
+Quaternion4f test::Random::rotation()
+{
+	float x = uniform(-1.0f, 1.0f);
+	float y = uniform(-1.0f, 1.0f);
+	float z = uniform(-1.0f, 1.0f);
+	float w = uniform(-1.0f, 1.0f);
+	float length = std::sqrt(x * x + y * y + z * z + w * w);
+	if (length < 1e-3f) {
+		return Quaternion4f(0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	return Quaternion4f(x / length, y / length, z / length, w / length);
+}
+
+void test::makeGrid(size_t columns, size_t rows, float sizeX, float sizeY, const Vector3f& origin, grid_t& grid)
+{
+	grid.vertexCount = (columns + 1) * (rows + 1);
+	grid.positions.clear();
+	grid.normals.clear();
+	grid.texCoords.clear();
+	grid.indices.clear();
+
+	for (size_t y = 0; y <= rows; ++y) {
+		for (size_t x = 0; x <= columns; ++x) {
+			float u = float(x) / float(columns);
+			float v = float(y) / float(rows);
+
+			// z = 0.25 sin(6u) cos(4v), the normal follows from the partial derivatives
+			float dzdx = 0.25f * 6.0f * std::cos(6.0f * u) * std::cos(4.0f * v) / sizeX;
+			float dzdy = -0.25f * 4.0f * std::sin(6.0f * u) * std::sin(4.0f * v) / sizeY;
+			float length = std::sqrt(dzdx * dzdx + dzdy * dzdy + 1.0f);
+
+			grid.positions.push_back(origin.x + u * sizeX);
+			grid.positions.push_back(origin.y + v * sizeY);
+			grid.positions.push_back(origin.z + 0.25f * std::sin(6.0f * u) * std::cos(4.0f * v));
+
+			grid.normals.push_back(-dzdx / length);
+			grid.normals.push_back(-dzdy / length);
+			grid.normals.push_back(1.0f / length);
+
+			grid.texCoords.push_back(u);
+			grid.texCoords.push_back(v);
+		}
+	}
+
+	for (size_t y = 0; y < rows; ++y) {
+		for (size_t x = 0; x < columns; ++x) {
+			uint32_t i0 = uint32_t(y * (columns + 1) + x);
+			uint32_t i1 = i0 + 1;
+			uint32_t i2 = i0 + uint32_t(columns + 1);
+			uint32_t i3 = i2 + 1;
+
+			grid.indices.insert(grid.indices.end(), { i0, i1, i3, i0, i3, i2 });
+		}
+	}
+}
+
+std::vector<uint32_t> test::readIndices(const GLTFPrimitive& primitive)
+{
+	std::vector<uint32_t> result;
+
+	GLTFAccessorView<uint32_t, 1> view(primitive.indices());
+	if (!view.isValid()) {
+		return result;
+	}
+
+	result.resize(view.size());
+	for (size_t i = 0; i < view.size(); ++i) {
+		view.get(i, &result[i]);
+	}
+
+	return result;
+}
+
+std::vector<std::vector<float>> test::canonicalTriangles(const std::vector<uint32_t>& indices,
+	const std::vector<float>& attributes, size_t componentCount)
+{
+	std::vector<std::vector<float>> result;
+
+	for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+		std::vector<float> corners[3];
+		for (size_t k = 0; k < 3; ++k) {
+			const float* pValues = &attributes[indices[i + k] * componentCount];
+			corners[k].assign(pValues, pValues + componentCount);
+		}
+
+		// rotation keeps the winding
+		size_t first = 0;
+		for (size_t k = 1; k < 3; ++k) {
+			if (corners[k] < corners[first]) {
+				first = k;
+			}
+		}
+
+		std::vector<float> triangle;
+		for (size_t k = 0; k < 3; ++k) {
+			const std::vector<float>& corner = corners[(first + k) % 3];
+			triangle.insert(triangle.end(), corner.begin(), corner.end());
+		}
+
+		result.push_back(triangle);
+	}
+
+	std::sort(result.begin(), result.end());
+	return result;
+}
+
+bool test::equalDocuments(const GLTFAsset& asset, const GLTFAsset& loaded, bool isBinary)
+{
+	json document = asset.toJSON();
+	if (isBinary && document.count("buffers") && !document["buffers"].empty()) {
+		document["buffers"][0].erase("name");
+	}
+
+	return document == loaded.toJSON();
+}
+
+void test::checkGLBRoundTrip(GLTFAsset& asset, GLTFAsset& loaded, const std::string& filePath)
+{
+	const std::string copyPath = filePath + ".copy.glb";
+
+	CHECK(asset.saveGLB(filePath));
+	CHECK(loaded.loadGLB(filePath));
+	CHECK(loaded.loadError().empty());
+	CHECK(equalDocuments(asset, loaded, true));
+
+	{
+		GLTFAsset copy;
+		CHECK(loaded.saveGLB(copyPath));
+		CHECK(copy.loadGLB(copyPath));
+		CHECK(copy.toString() == loaded.toString());
+	}
+
+	std::remove(copyPath.c_str());
+}
+
+std::string test::readFile(const std::string& filePath)
+{
+	std::ifstream stream(filePath, std::ios::in | std::ios::binary);
+	return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+bool test::writeFile(const std::string& filePath, const std::string& content)
+{
+	std::ofstream stream(filePath, std::ios::out | std::ios::binary);
+	if (!stream.is_open()) {
+		return false;
+	}
+
+	stream.write(content.data(), content.size());
+	return stream.good();
+}
+
+bool test::writeGLB(const std::string& filePath, const std::string& document)
+{
+	std::string chunk = document;
+	chunk.resize((chunk.size() + 3) & ~size_t(3), ' ');
+
+	// header: magic, version, total length; chunk: length, type JSON
+	const uint32_t header[5] = {
+		0x46546c67, 2, uint32_t(12 + 8 + chunk.size()), uint32_t(chunk.size()), 0x4e4f534a
+	};
+
+	return writeFile(filePath, std::string((const char*)header, sizeof(header)) + chunk);
+}
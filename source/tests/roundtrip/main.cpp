@@ -0,0 +1,50 @@
+/**
+* glTF Round Trip Tests - Writes, reads and transforms assets and checks the results
+* against the source data, reference decoders and brute force computations.
+* Returns the number of failed checks.
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "RoundTripTests.h"
+
+#include <iostream>
+
+using namespace flow;
+
+using std::cout;
+using std::endl;
+
+typedef void (*testFunction)();
+
+int main(int argc, char** ppArgv)
+{
+	const struct { const char* pName; testFunction function; } tests[] = {
+		{ "save and load", test::testSaveLoad },
+		{ "reader rollback", test::testReaderRollback },
+		{ "texture info", test::testTextureInfo },
+		{ "number locale", test::testNumberLocale },
+		{ "merge buffers", test::testMergeBuffers },
+		{ "separate buffers", test::testSeparateBuffers },
+		{ "interleaved", test::testInterleaved },
+		{ "quantizer", test::testQuantizer },
+		{ "meshopt codec", test::testMeshoptCodec },
+		{ "meshopt file", test::testMeshoptFile },
+		{ "deduplicate", test::testDeduplicate },
+		{ "optimizer", test::testOptimizer },
+		{ "narrow indices", test::testNarrowIndices },
+		{ "meshlets", test::testMeshlets },
+		{ "scene evaluator", test::testEvaluator },
+		{ "scene bvh", test::testSceneBVH },
+	};
+
+	for (const auto& entry : tests) {
+		size_t failureCount = test::failureCount();
+		entry.function();
+		cout << (test::failureCount() == failureCount ? "passed: " : "FAILED: ") << entry.pName << endl;
+	}
+
+	cout << test::failureCount() << " failed checks" << endl;
+	return int(test::failureCount());
+}
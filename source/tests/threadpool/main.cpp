@@ -0,0 +1,111 @@
+/**
+* Thread Pool Benchmark - Task spawn overhead and parallel scaling
+*
+* @author Ralph Wiedemeier <ralph@framefactory.io>
+* @copyright (c) 2018 Frame Factory GmbH.
+*/
+
+#include "core/ThreadPool.h"
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include <atomic>
+
+using namespace flow;
+
+using std::cout;
+using std::endl;
+
+typedef std::chrono::steady_clock benchClock;
+
+template<typename F>
+double measure(const F& fn)
+{
+	auto startTime = benchClock::now();
+	fn();
+	return std::chrono::duration<double>(benchClock::now() - startTime).count();
+}
+
+/// Compute-bound work item, the result is accumulated so it can't be optimized away.
+double work(size_t index)
+{
+	double sum = 0.0;
+	for (size_t i = 1; i <= 2000; ++i) {
+		sum += std::sqrt(double(index + i)) * std::sin(double(i));
+	}
+	return sum;
+}
+
+void benchmarkSpawn(ThreadPool& pool)
+{
+	const size_t taskCount = 200000;
+	std::atomic<size_t> counter(0);
+
+	double seconds = measure([&]() {
+		TaskGroup group(&pool);
+		for (size_t i = 0; i < taskCount; ++i) {
+			group.run([&counter]() { ++counter; });
+		}
+		group.wait();
+	});
+
+	cout << "task group:   " << std::setw(10) << seconds / taskCount * 1e9 << " ns per task" << endl;
+
+	seconds = measure([&]() {
+		pool.parallelFor(0, taskCount, 1, [&counter](size_t first, size_t last) {
+			counter += last - first;
+		});
+	});
+
+	cout << "parallel for: " << std::setw(10) << seconds / taskCount * 1e9 << " ns per range" << endl;
+
+	if (counter != 2 * taskCount) {
+		cout << "error: expected " << 2 * taskCount << " executed tasks, got " << counter << endl;
+	}
+}
+
+int main(int argc, char** ppArgv)
+{
+	size_t maxThreads = argc > 1 ? size_t(std::atoi(ppArgv[1])) : 0;
+	if (maxThreads == 0) {
+		maxThreads = flow::max(size_t(std::thread::hardware_concurrency()), size_t(1));
+	}
+
+	cout << std::fixed << std::setprecision(1);
+
+	cout << "Spawn overhead (" << maxThreads << " threads)" << endl;
+	{
+		ThreadPool pool(maxThreads);
+		benchmarkSpawn(pool);
+	}
+
+	const size_t itemCount = 1 << 14;
+	std::vector<double> results(itemCount);
+
+	auto kernel = [&results](size_t first, size_t last) {
+		for (size_t i = first; i < last; ++i) {
+			results[i] = work(i);
+		}
+	};
+
+	double serialSeconds = measure([&]() { kernel(0, itemCount); });
+
+	cout << endl << "Scaling (" << itemCount << " items)" << endl;
+	cout << "threads " << std::setw(10) << "ms" << std::setw(10) << "speedup" << endl;
+	cout << std::setw(7) << 1 << std::setw(11) << serialSeconds * 1e3 << std::setw(10) << 1.0 << endl;
+
+	// the calling thread takes part in the work, so the pool gets one thread less
+	for (size_t threadCount = 2; threadCount <= maxThreads; ++threadCount) {
+		ThreadPool pool(threadCount - 1);
+		double seconds = measure([&]() { pool.parallelFor(0, itemCount, 64, kernel); });
+
+		cout << std::setw(7) << threadCount << std::setw(11) << seconds * 1e3
+			<< std::setw(10) << serialSeconds / seconds << endl;
+	}
+
+	return 0;
+}